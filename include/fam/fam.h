@@ -110,6 +110,23 @@ typedef enum {
     RAID5
 } Fam_Redundancy_Level;
 
+/**
+ * Flags accepted by fam_map(). Flags may be or-ed together; they are hints,
+ * and are ignored where the underlying memory does not support them.
+ */
+typedef enum {
+    /** Map the data item without any advice */
+    FAM_MAP_DEFAULT = 0,
+    /** Populate the page tables for the whole data item at map time */
+    FAM_MAP_PREFAULT = 0x1,
+    /** Back the mapping with transparent huge pages */
+    FAM_MAP_HUGEPAGE = 0x2,
+    /** Data item will be accessed sequentially */
+    FAM_MAP_SEQUENTIAL = 0x4,
+    /** Data item will be accessed in random order */
+    FAM_MAP_RANDOM = 0x8
+} Fam_Map_Flags;
+
 /**
  * FAM Global descriptor represents both the region and data item in FAM.
  */
@@ -123,6 +140,29 @@ typedef struct {
     uint64_t offset;
 } Fam_Global_Descriptor;
 
+/**
+ * Layout of a region spread across several memory servers. The region is
+ * made of stripeCount member regions of the same name, one per memory
+ * server. Data items of a striped region are cut in stripes of stripeSize
+ * bytes dealt round robin to the members; those of a mirrored (RAID1) region
+ * have a whole copy on every member. A RAID5 region adds a parity stripe to
+ * every row of stripeCount - 1 data stripes, on a member changing with the
+ * row. A region on a single memory server has a stripeCount of 1.
+ */
+typedef struct {
+    /** Bytes of a data item placed on one member before moving to the next */
+    uint64_t stripeSize;
+    /** Number of member regions */
+    uint32_t stripeCount;
+    /** Position of a member region among the members of its region */
+    uint32_t stripeIndex;
+    /** NONE if striped, RAID1 if mirrored, RAID5 if striped with parity */
+    Fam_Redundancy_Level redundancyLevel;
+} Fam_Stripe_Layout;
+
+/** Smallest stripe size of a striped region */
+#define FAM_STRIPE_SIZE_MIN 4096
+
 /**
  * Structure defining a FAM descriptor. Descriptors are PE independent data
  * structures that enable the OpenFAM library to uniquely locate an area of
@@ -145,6 +185,10 @@ class Fam_Descriptor {
     void bind_key(uint64_t tempKey);
     // get keys
     uint64_t get_key();
+    // set and get the time, in ns of the monotonic clock, up to which the key
+    // is known to be registered, if its memory server holds keys on a lease
+    void set_key_expiry(uint64_t expiry);
+    uint64_t get_key_expiry();
     // get context
     void *get_context();
     // set context
@@ -157,6 +201,15 @@ class Fam_Descriptor {
     uint64_t get_size();
     // get memory server id
     uint64_t get_memserver_id();
+    // set stripe layout of the region holding the data item
+    void set_layout(Fam_Stripe_Layout stripeLayout);
+    // get stripe layout
+    Fam_Stripe_Layout get_layout();
+    // set the parts of a striped data item on each member region; the
+    // descriptor takes ownership of them, NULL for members holding no stripe
+    void set_stripes(Fam_Descriptor **stripes);
+    // get the part on a member region; the descriptor itself if not striped
+    Fam_Descriptor *get_stripe(uint64_t index);
 
   private:
     class FamDescriptorImpl_;
@@ -192,6 +245,15 @@ class Fam_Region_Descriptor {
     uint64_t get_size();
     // get memory server id
     uint64_t get_memserver_id();
+    // set stripe layout
+    void set_layout(Fam_Stripe_Layout stripeLayout);
+    // get stripe layout
+    Fam_Stripe_Layout get_layout();
+    // set the member regions of a striped region; the descriptor takes
+    // ownership of them
+    void set_stripes(Fam_Region_Descriptor **stripes);
+    // get a member region; the descriptor itself if not striped
+    Fam_Region_Descriptor *get_stripe(uint64_t index);
 
   private:
     class FamRegionDescriptorImpl_;
@@ -208,6 +270,47 @@ typedef struct {
     void *base;
 } Fam_Region_Item_Info;
 
+/**
+ * Exported form of the member of a striped or mirrored region, or of the part
+ * of a data item on it. The memory server is identified by the region id.
+ */
+typedef struct {
+    /** 1 if the member holds a part of the data item, else 0 */
+    uint64_t present;
+    Fam_Global_Descriptor gDescriptor;
+    /** Access key of a data item part, FAM_KEY_UNINITIALIZED if not known */
+    uint64_t key;
+    uint64_t size;
+} Fam_Exported_Member;
+
+// Most members a striped or mirrored descriptor can be exported with
+#define FAM_EXPORT_MAX_MEMBERS 64
+
+/**
+ * Self-contained binary form of a region or data item descriptor. It can be
+ * copied as is to another PE of the same job, e.g. with MPI, and turned back
+ * into a descriptor there by fam_import without asking the memory server.
+ * The memory server is identified by the region id.
+ */
+typedef struct {
+    /** Layout version, FAM_EXPORT_VERSION */
+    uint32_t version;
+    /** 1 for a region descriptor, 0 for a data item descriptor */
+    uint32_t isRegion;
+    Fam_Global_Descriptor gDescriptor;
+    /** Access key of a data item, FAM_KEY_UNINITIALIZED if not known yet */
+    uint64_t key;
+    uint64_t size;
+    /** Stripe layout of the region */
+    Fam_Stripe_Layout layout;
+    /** Number of members, 0 unless the descriptor is striped or mirrored */
+    uint64_t memberCount;
+    /** The members of a striped or mirrored descriptor, in member order */
+    Fam_Exported_Member members[FAM_EXPORT_MAX_MEMBERS];
+} Fam_Exported_Descriptor;
+
+#define FAM_EXPORT_VERSION 2
+
 /**
  * Structure defining FAM options. This structure holds system wide information
  * required to initialize the OpenFAM library and the associated program using
@@ -237,6 +340,24 @@ typedef struct {
     char *numConsumer;
     /** FAM runtime - Default, pmix*/
     char *runtime;
+    /** Atomic model for NVMM allocator - FAM_ATOMIC_LIBRARY (default), or
+     * FAM_ATOMIC_CPU when FAM is cache coherent shared memory */
+    char *famAtomicModel;
+    /** Lease in milliseconds of region and data item metadata cached by the
+     * Grpc allocator; "0" (default) disables the cache */
+    char *metadataCacheLease;
+    /** FAM connect model - FAM_CONNECT_EAGER (default) connects to all memory
+     * servers in fam_initialize, FAM_CONNECT_LAZY to each on first use */
+    char *famConnectModel;
+    /** Memory server of new regions - FAM_PLACEMENT_HASH (default) of the
+     * name, FAM_PLACEMENT_CONSISTENT_HASH, FAM_PLACEMENT_CAPACITY (most free
+     * space) or FAM_PLACEMENT_ROUND_ROBIN */
+    char *regionPlacement;
+    /** Redundancy of regions - FAM_REDUNDANCY_MEMSERVER (default) leaves the
+     * redundancy level to the memory server of the region,
+     * FAM_REDUNDANCY_ACROSS_MEMSERVERS mirrors RAID1 regions on two memory
+     * servers and stripes RAID5 regions with parity across all of them */
+    char *famRedundancyModel;
 } Fam_Options;
 
 class fam {
@@ -309,6 +430,78 @@ class fam {
      */
     Fam_Descriptor *fam_lookup(const char *itemName, const char *regionName);
 
+    /**
+     * look up several data items of the same region in FAM by name, with a
+     * single request to the memory server holding the region.
+     * @param itemNames - names of the data items
+     * @param regionName - name of the region containing the data items
+     * @param nItems - number of data items to look up
+     * @param items - array of nItems entries filled with the descriptors of
+     * the data items, in the order of itemNames. Either all the data items are
+     * found, or an exception is thrown and no descriptor is returned.
+     * @see #fam_lookup
+     */
+    void fam_lookup_batch(const char **itemNames, const char *regionName,
+                          uint64_t nItems, Fam_Descriptor **items);
+
+    /**
+     * Collective version of fam_lookup_region: PE 0 looks the region up and
+     * hands the result to the other PEs, so the memory server sees a single
+     * request however many PEs the job has. Must be called by all PEs.
+     * @param name - name of the region.
+     * @return - The descriptor to the region.
+     * @see #fam_lookup_region
+     */
+    Fam_Region_Descriptor *fam_lookup_region_shared(const char *name);
+
+    /**
+     * Collective version of fam_lookup: PE 0 looks the data item up, gets its
+     * access key and hands the result to the other PEs. Must be called by all
+     * PEs. If the lookup fails on PE 0, every PE throws.
+     * @param itemName - name of the data item
+     * @param regionName - name of the region containing the data item
+     * @return descriptor to the data item
+     * @see #fam_lookup
+     */
+    Fam_Descriptor *fam_lookup_shared(const char *itemName,
+                                      const char *regionName);
+
+    /**
+     * Write the binary form of a data item descriptor.
+     * @param descriptor - descriptor to export
+     * @param exported - filled with the exported form
+     * @see #fam_import
+     */
+    void fam_export(Fam_Descriptor *descriptor,
+                    Fam_Exported_Descriptor *exported);
+
+    /**
+     * Write the binary form of a region descriptor.
+     * @param descriptor - descriptor to export
+     * @param exported - filled with the exported form
+     * @see #fam_import_region
+     */
+    void fam_export(Fam_Region_Descriptor *descriptor,
+                    Fam_Exported_Descriptor *exported);
+
+    /**
+     * Build a data item descriptor from its binary form, which may come from
+     * another PE of the job.
+     * @param exported - exported form written by fam_export
+     * @return descriptor to the data item
+     * @see #fam_export
+     */
+    Fam_Descriptor *fam_import(Fam_Exported_Descriptor *exported);
+
+    /**
+     * Build a region descriptor from its binary form, which may come from
+     * another PE of the job.
+     * @param exported - exported form written by fam_export
+     * @return descriptor to the region
+     * @see #fam_export
+     */
+    Fam_Region_Descriptor *fam_import_region(Fam_Exported_Descriptor *exported);
+
     // ALLOCATION Group
 
     /**
@@ -323,7 +516,13 @@ class fam {
      * and may impose system-wide (or user-dependent) limits on individual and
      * total size allocated to a given user.
      * @param permissions - access permissions to be used for the region
-     * @param redundancyLevel - desired redundancy level for the region
+     * @param redundancyLevel - desired redundancy level for the region. With
+     * the FAM_REDUNDANCY_MODEL option set to FAM_REDUNDANCY_ACROSS_MEMSERVERS,
+     * a RAID1 region is mirrored on two memory servers when there are several:
+     * puts and atomics reach both copies, gets are served by either. Mapping,
+     * exporting and copying into a mirrored data item are not supported.
+     * With the same option, a RAID5 region is striped with parity across all
+     * memory servers when there are at least three.
      * @return - Region_Descriptor for the created region
      * @see #fam_resize_region
      * @see #fam_destroy_region
@@ -332,6 +531,50 @@ class fam {
     fam_create_region(const char *name, uint64_t size, mode_t permissions,
                       Fam_Redundancy_Level redundancyLevel, ...);
 
+    /**
+     * Allocate a region of FAM on a given memory server instead of the one
+     * chosen by the REGION_PLACEMENT option. The region is found by
+     * fam_lookup_region like any other.
+     * @param name - name of the region
+     * @param size - size (in bytes) requested for the region
+     * @param permissions - access permissions to be used for the region
+     * @param redundancyLevel - desired redundancy level for the region
+     * @param memoryServerId - id of the memory server to create the region on
+     * @return - Region_Descriptor for the created region
+     * @see #fam_create_region
+     */
+    Fam_Region_Descriptor *
+    fam_create_region_on(const char *name, uint64_t size, mode_t permissions,
+                         Fam_Redundancy_Level redundancyLevel,
+                         uint64_t memoryServerId);
+
+    /**
+     * Allocate a region of FAM striped across several memory servers. Data
+     * items of the region are cut in stripes of stripeSize bytes, dealt
+     * round robin to the memory servers, so that accesses to a large data
+     * item draw on the bandwidth of all of them. Data items smaller than
+     * stripeCount stripes only use the first ones. The region is found by
+     * fam_lookup_region like any other.
+     * @param name - name of the region
+     * @param size - size (in bytes) requested for the region, split evenly
+     * between the memory servers
+     * @param permissions - access permissions to be used for the region
+     * @param redundancyLevel - desired redundancy level for the region;
+     * striped regions are not mirrored, so RAID1 is refused. With RAID5, one
+     * stripe of every row of stripeCount stripes holds the XOR of the
+     * others, and at least three memory servers are needed
+     * @param stripeCount - number of memory servers to stripe across
+     * @param stripeSize - bytes placed on a memory server before moving to
+     * the next one; a power of 2, at least FAM_STRIPE_SIZE_MIN
+     * @return - Region_Descriptor for the created region
+     * @see #fam_create_region
+     */
+    Fam_Region_Descriptor *
+    fam_create_region_striped(const char *name, uint64_t size,
+                              mode_t permissions,
+                              Fam_Redundancy_Level redundancyLevel,
+                              uint64_t stripeCount, uint64_t stripeSize);
+
     /**
      * Destroy a region, and all contents within the region. Note that this
      * method call will trigger a delayed free operation to permit other
@@ -357,6 +600,22 @@ class fam {
      */
     int fam_resize_region(Fam_Region_Descriptor *descriptor, uint64_t nbytes);
 
+    /**
+     * Let a previously created region grow on its own, up to a limit. When
+     * little free space is left in the region, the memory server resizes it
+     * in the background; an allocation that does not fit grows the region
+     * before it fails. Descriptors to existing data items stay valid.
+     * @param descriptor - descriptor associated with the previously created
+     * region
+     * @param growLimit - size up to which the region may grow, 0 to turn
+     * growth off
+     * @return - 0 on success, 1 for unsuccessful completion, negative number on
+     * an exception
+     * @see #fam_resize_region
+     */
+    int fam_set_region_growth(Fam_Region_Descriptor *descriptor,
+                              uint64_t growLimit);
+
     /**
      * Allocate some unnamed space within a region. Allocates an area of FAM
      * within a region
@@ -382,6 +641,35 @@ class fam {
      */
     void fam_deallocate(Fam_Descriptor *descriptor);
 
+    /**
+     * Allocate several data items within a region with a single request to
+     * the memory server. Either all the data items are allocated, or an
+     * exception is thrown and none of them is.
+     * @param names - names of the data items; the array itself or any of its
+     * entries may be NULL for unnamed data items
+     * @param nbytes - sizes of the data items in bytes
+     * @param accessPermissions - permissions associated with the data items
+     * @param region - descriptor of the region within which the data items
+     * are allocated
+     * @param nItems - number of data items to allocate
+     * @param items - array of nItems entries filled with the descriptors of
+     * the data items, in the order of names and nbytes
+     * @see #fam_deallocate_batch()
+     */
+    void fam_allocate_batch(const char **names, uint64_t *nbytes,
+                            mode_t accessPermissions,
+                            Fam_Region_Descriptor *region, uint64_t nItems,
+                            Fam_Descriptor **items);
+
+    /**
+     * Deallocate several data items, with one request per region. Within a
+     * region either all the data items are deallocated or none of them is.
+     * @param items - descriptors of the data items
+     * @param nItems - number of data items to deallocate
+     * @see #fam_allocate_batch()
+     */
+    void fam_deallocate_batch(Fam_Descriptor **items, uint64_t nItems);
+
     /**
      * Change permissions associated with a data item descriptor.
      * @param descriptor - descriptor associated with some data item
@@ -488,6 +776,17 @@ class fam {
      */
     void *fam_map(Fam_Descriptor *descriptor);
 
+    /**
+     * Map a data item in FAM to the local virtual address space, and return its
+     * pointer, applying the given mapping hints.
+     * @param descriptor - descriptor to be mapped
+     * @param mapFlags - or-ed combination of Fam_Map_Flags
+     * @return pointer within the process virtual address space that can be used
+     * to directly access the data item in FAM
+     * @see #fam_unmap()
+     */
+    void *fam_map(Fam_Descriptor *descriptor, uint32_t mapFlags);
+
     /**
      * Unmap a data item in FAM from the local virtual address space.
      * @param local - pointer within the process virtual address space to be
@@ -675,11 +974,37 @@ class fam {
     void *fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
                    Fam_Descriptor **dest, uint64_t destOffset, uint64_t nbytes);
 
+    /**
+     * Copy data from one FAM-resident data item into an existing FAM-resident
+     * data item. Unlike the variant above, no destination data item is
+     * allocated, so only the given range of the destination is written.
+     * @param src - valid descriptor to source data item in FAM.
+     * @param srcOffset - byte offset within the space defined by the src
+     * descriptor from which memory should be copied.
+     * @param dest - valid descriptor to an existing destination data item in
+     * FAM, which must be writable. It may reside on another memory server than
+     * src, in which case the source server writes the data into it directly.
+     * @param destOffset - byte offset within the space defined by the dest
+     * descriptor to which memory should be copied.
+     * @param nbytes - number of bytes to be copied
+     */
+    void *fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
+                   Fam_Descriptor *dest, uint64_t destOffset, uint64_t nbytes);
+
     /**
      * Wait for copy operation correspond to the wait object passed to complete
      * @param waitObj - unique tag to copy operation
      */
     void fam_copy_wait(void *waitObj);
+
+    /**
+     * Report how far a copy operation has got, without waiting for it.
+     * Large copies progress in chunks, so the value grows in steps.
+     * @param waitObj - unique tag to copy operation, as returned by fam_copy
+     * @return - number of bytes already copied; a copy that has not started
+     * yet reports 0. The wait object stays valid until fam_copy_wait().
+     */
+    uint64_t fam_copy_progress(void *waitObj);
     // ATOMICS Group
 
     // NON fetching routines
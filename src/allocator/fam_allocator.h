@@ -48,15 +48,22 @@ class Fam_Allocator {
     virtual Fam_Region_Descriptor *
     create_region(const char *name, uint64_t nbytes, mode_t permissions,
                   Fam_Redundancy_Level redundancyLevel,
-                  uint64_t memoryServerId) = 0;
+                  uint64_t memoryServerId, Fam_Stripe_Layout layout) = 0;
     virtual void destroy_region(Fam_Region_Descriptor *descriptor) = 0;
     virtual int resize_region(Fam_Region_Descriptor *descriptor,
                               uint64_t nbytes) = 0;
+    virtual int set_region_growth(Fam_Region_Descriptor *descriptor,
+                                  uint64_t growLimit) = 0;
 
     virtual Fam_Descriptor *allocate(const char *name, uint64_t nbytes,
                                      mode_t accessPermissions,
                                      Fam_Region_Descriptor *region) = 0;
     virtual void deallocate(Fam_Descriptor *descriptor) = 0;
+    virtual void allocate_batch(const char **names, uint64_t *nbytes,
+                                uint64_t nItems, mode_t accessPermissions,
+                                Fam_Region_Descriptor *region,
+                                Fam_Descriptor **items) = 0;
+    virtual void deallocate_batch(Fam_Descriptor **items, uint64_t nItems) = 0;
 
     virtual int change_permission(Fam_Region_Descriptor *descriptor,
                                   mode_t accessPermissions) = 0;
@@ -66,18 +73,32 @@ class Fam_Allocator {
                                                  uint64_t memoryServerId) = 0;
     virtual Fam_Descriptor *lookup(const char *itemName, const char *regionName,
                                    uint64_t memoryServerId) = 0;
+    virtual void lookup_batch(const char **itemNames, const char *regionName,
+                              uint64_t nItems, uint64_t memoryServerId,
+                              Fam_Descriptor **items) = 0;
     virtual Fam_Region_Item_Info
     check_permission_get_info(Fam_Region_Descriptor *descriptor) = 0;
     virtual Fam_Region_Item_Info
     check_permission_get_info(Fam_Descriptor *descriptor) = 0;
+    // Have the memory server of a data item register it again, should it
+    // have dropped the registration; cached metadata is not used
+    virtual void refresh_registration(Fam_Descriptor *descriptor) = 0;
+    // Whether keys of the memory server are held on a lease, that is, have
+    // to be refreshed once they were held for FAM_MR_KEY_LEASE_MS
+    virtual bool keys_leased(uint64_t memoryServerId) = 0;
 
     virtual void *copy(Fam_Descriptor *src, uint64_t srcOffset,
                        Fam_Descriptor **dest, uint64_t destOffset,
                        uint64_t nbytes) = 0;
 
+    virtual void *copy(Fam_Descriptor *src, uint64_t srcOffset,
+                       Fam_Descriptor *dest, uint64_t destOffset,
+                       uint64_t nbytes) = 0;
+
     virtual void wait_for_copy(void *waitObj) = 0;
+    virtual uint64_t copy_progress(void *waitObj) = 0;
 
-    virtual void *fam_map(Fam_Descriptor *descriptor) = 0;
+    virtual void *fam_map(Fam_Descriptor *descriptor, uint32_t mapFlags) = 0;
     virtual void fam_unmap(void *local, Fam_Descriptor *descriptor) = 0;
 
     virtual void acquire_CAS_lock(Fam_Descriptor *descriptor) = 0;
@@ -85,6 +106,9 @@ class Fam_Allocator {
 
     virtual int get_addr_size(size_t *addrSize, uint64_t nodeId) = 0;
     virtual int get_addr(void *addr, size_t addrSize, uint64_t nodeId) = 0;
+
+    virtual void get_memserver_info(uint64_t memoryServerId,
+                                    uint64_t &capacity, uint64_t &used) = 0;
 };
 
 } // namespace openfam
@@ -29,8 +29,10 @@
  */
 
 #include <iostream>
+#include <map>
 #include <stdint.h>   // needed
 #include <sys/stat.h> // needed for mode_t
+#include <vector>
 
 #include "allocator/fam_allocator_grpc.h"
 
@@ -47,7 +49,9 @@ using namespace std;
 
 
 namespace openfam {
-Fam_Allocator_Grpc::Fam_Allocator_Grpc(MemServerMap name, uint64_t port) {
+Fam_Allocator_Grpc::Fam_Allocator_Grpc(MemServerMap name, uint64_t port,
+                                       uint64_t cacheLeaseMs,
+                                       bool lazyConnect) {
     if (name.size() == 0) {
         throw Fam_Allocator_Exception(FAM_ERR_RPC_CLIENT_NOTFOUND,
                                       "server name not found");
@@ -55,9 +59,15 @@ Fam_Allocator_Grpc::Fam_Allocator_Grpc(MemServerMap name, uint64_t port) {
     rpcClients = new RpcClientMap();
 
     for (auto obj = name.begin(); obj != name.end(); ++obj) {
-        Fam_Rpc_Client *client = new Fam_Rpc_Client((obj->second).c_str(), port);
+        Fam_Rpc_Client *client =
+            new Fam_Rpc_Client((obj->second).c_str(), port, false);
         rpcClients->insert({ obj->first, client });
     }
+    metadataCache = new Fam_Metadata_Cache(cacheLeaseMs);
+
+    // Lazily, each memory server is connected by its first request
+    if (!lazyConnect)
+        connect_all();
 }
 
 Fam_Allocator_Grpc::~Fam_Allocator_Grpc() {
@@ -68,27 +78,59 @@ Fam_Allocator_Grpc::~Fam_Allocator_Grpc() {
         rpcClients->clear();
     }
     delete rpcClients;
+    delete metadataCache;
 }
 
 void Fam_Allocator_Grpc::allocator_initialize() {}
 
 void Fam_Allocator_Grpc::allocator_finalize() {}
 
+/*
+ * Send the start signal to all memory servers at once and then collect the
+ * replies, so that connecting costs about one round trip whatever the number
+ * of memory servers.
+ */
+void Fam_Allocator_Grpc::connect_all() {
+    ::grpc::CompletionQueue connectCq;
+    void *tag;
+    bool ok;
+
+    for (auto obj : *rpcClients)
+        obj.second->start_connect(&connectCq);
+    for (size_t i = 0; i < rpcClients->size(); i++) {
+        if (!connectCq.Next(&tag, &ok))
+            break;
+    }
+    connectCq.Shutdown();
+    while (connectCq.Next(&tag, &ok))
+        ;
+
+    for (auto obj : *rpcClients)
+        obj.second->finish_connect();
+}
+
 Fam_Rpc_Client *Fam_Allocator_Grpc::get_rpc_client(uint64_t memoryServerId) {
     auto obj = rpcClients->find(memoryServerId);
     if (obj == rpcClients->end()) {
         throw Fam_Allocator_Exception(FAM_ERR_RPC_CLIENT_NOTFOUND,
                                       "RPC client not found");
     }
-    return obj->second;
+    Fam_Rpc_Client *client = obj->second;
+    if (!client->is_connected()) {
+        std::lock_guard<std::mutex> guard(connectLock);
+        if (!client->is_connected())
+            client->connect();
+    }
+    return client;
 }
 
 Fam_Region_Descriptor *Fam_Allocator_Grpc::create_region(
     const char *name, uint64_t nbytes, mode_t permissions,
-    Fam_Redundancy_Level redundancyLevel, uint64_t memoryServerId = 0) {
+    Fam_Redundancy_Level redundancyLevel, uint64_t memoryServerId,
+    Fam_Stripe_Layout layout) {
     Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
     return rpcClient->create_region(name, nbytes, permissions, redundancyLevel,
-                                    memoryServerId);
+                                    memoryServerId, layout);
 }
 
 void Fam_Allocator_Grpc::destroy_region(Fam_Region_Descriptor *descriptor) {
@@ -102,6 +144,12 @@ int Fam_Allocator_Grpc::resize_region(Fam_Region_Descriptor *descriptor,
     return rpcClient->resize_region(descriptor, nbytes);
 }
 
+int Fam_Allocator_Grpc::set_region_growth(Fam_Region_Descriptor *descriptor,
+                                          uint64_t growLimit) {
+    Fam_Rpc_Client *rpcClient = get_rpc_client(descriptor->get_memserver_id());
+    return rpcClient->set_region_growth(descriptor, growLimit);
+}
+
 Fam_Descriptor *Fam_Allocator_Grpc::allocate(const char *name, uint64_t nbytes,
                                              mode_t accessPermissions,
                                              Fam_Region_Descriptor *region) {
@@ -114,6 +162,32 @@ void Fam_Allocator_Grpc::deallocate(Fam_Descriptor *descriptor) {
     return rpcClient->deallocate(descriptor);
 }
 
+void Fam_Allocator_Grpc::allocate_batch(const char **names, uint64_t *nbytes,
+                                        uint64_t nItems,
+                                        mode_t accessPermissions,
+                                        Fam_Region_Descriptor *region,
+                                        Fam_Descriptor **items) {
+    Fam_Rpc_Client *rpcClient = get_rpc_client(region->get_memserver_id());
+    return rpcClient->allocate_batch(names, nbytes, nItems, accessPermissions,
+                                     region, items);
+}
+
+void Fam_Allocator_Grpc::deallocate_batch(Fam_Descriptor **items,
+                                          uint64_t nItems) {
+    // The regionId embeds the memory server id, so grouping by it sends one
+    // request per region on the memory server owning it
+    map<uint64_t, vector<Fam_Descriptor *>> regionItems;
+    for (uint64_t i = 0; i < nItems; i++)
+        regionItems[items[i]->get_global_descriptor().regionId].push_back(
+            items[i]);
+
+    for (auto &batch : regionItems) {
+        Fam_Rpc_Client *rpcClient =
+            get_rpc_client(batch.second[0]->get_memserver_id());
+        rpcClient->deallocate_batch(batch.second.data(), batch.second.size());
+    }
+}
+
 int Fam_Allocator_Grpc::change_permission(Fam_Region_Descriptor *descriptor,
                                           mode_t accessPermissions) {
     Fam_Rpc_Client *rpcClient = get_rpc_client(descriptor->get_memserver_id());
@@ -130,14 +204,66 @@ Fam_Region_Descriptor *
 Fam_Allocator_Grpc::lookup_region(const char *name,
                                   uint64_t memoryServerId = 0) {
     Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
-    return rpcClient->lookup_region(name, memoryServerId);
+    Fam_Global_Descriptor globalDescriptor;
+    Fam_Stripe_Layout layout;
+    uint64_t size, version;
+
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+    if (metadataCache->find_region(memoryServerId, name, globalDescriptor,
+                                   size, layout)) {
+        Fam_Region_Descriptor *region =
+            new Fam_Region_Descriptor(globalDescriptor, size);
+        region->set_layout(layout);
+        return region;
+    }
+
+    Fam_Region_Descriptor *region =
+        rpcClient->lookup_region(name, memoryServerId, &version);
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+    metadataCache->insert_region(memoryServerId, version, name,
+                                 region->get_global_descriptor(),
+                                 region->get_size(), region->get_layout());
+    return region;
 }
 
 Fam_Descriptor *Fam_Allocator_Grpc::lookup(const char *itemName,
                                            const char *regionName,
                                            uint64_t memoryServerId = 0) {
     Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
-    return rpcClient->lookup(itemName, regionName, memoryServerId);
+    Fam_Global_Descriptor globalDescriptor;
+    Fam_Stripe_Layout layout;
+    uint64_t size, key, version;
+
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+    if (metadataCache->find_item(memoryServerId, itemName, regionName,
+                                 globalDescriptor, size, key, layout)) {
+        Fam_Descriptor *dataItem = new Fam_Descriptor(globalDescriptor, size);
+        dataItem->bind_key(key);
+        dataItem->set_layout(layout);
+        return dataItem;
+    }
+
+    Fam_Descriptor *dataItem =
+        rpcClient->lookup(itemName, regionName, memoryServerId, &version);
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+    metadataCache->insert_item(memoryServerId, version, itemName, regionName,
+                               dataItem->get_global_descriptor(),
+                               dataItem->get_size(), dataItem->get_key(),
+                               dataItem->get_layout());
+    return dataItem;
+}
+
+void Fam_Allocator_Grpc::lookup_batch(const char **itemNames,
+                                      const char *regionName, uint64_t nItems,
+                                      uint64_t memoryServerId,
+                                      Fam_Descriptor **items) {
+    Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
+    return rpcClient->lookup_batch(itemNames, regionName, nItems,
+                                   memoryServerId, items);
 }
 
 Fam_Region_Item_Info Fam_Allocator_Grpc::check_permission_get_info(
@@ -148,8 +274,42 @@ Fam_Region_Item_Info Fam_Allocator_Grpc::check_permission_get_info(
 
 Fam_Region_Item_Info
 Fam_Allocator_Grpc::check_permission_get_info(Fam_Descriptor *descriptor) {
-    Fam_Rpc_Client *rpcClient = get_rpc_client(descriptor->get_memserver_id());
-    return rpcClient->check_permission_get_info(descriptor);
+    uint64_t memoryServerId = descriptor->get_memserver_id();
+    Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
+    Fam_Global_Descriptor globalDescriptor =
+        descriptor->get_global_descriptor();
+    Fam_Region_Item_Info itemInfo;
+    uint64_t version;
+
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+    if (metadataCache->find_item_info(memoryServerId, globalDescriptor,
+                                      itemInfo))
+        return itemInfo;
+
+    itemInfo = rpcClient->check_permission_get_info(descriptor, &version);
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+    metadataCache->insert_item_info(memoryServerId, version, globalDescriptor,
+                                    itemInfo);
+    return itemInfo;
+}
+
+/*
+ * The memory server registers the data item while checking the permission.
+ */
+void Fam_Allocator_Grpc::refresh_registration(Fam_Descriptor *descriptor) {
+    uint64_t memoryServerId = descriptor->get_memserver_id();
+    Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
+    uint64_t version;
+
+    (void)rpcClient->check_permission_get_info(descriptor, &version);
+    metadataCache->set_version(memoryServerId,
+                               rpcClient->get_metadata_version());
+}
+
+bool Fam_Allocator_Grpc::keys_leased(uint64_t memoryServerId) {
+    return get_rpc_client(memoryServerId)->keys_leased();
 }
 
 void *Fam_Allocator_Grpc::copy(Fam_Descriptor *src, uint64_t srcOffset,
@@ -159,13 +319,34 @@ void *Fam_Allocator_Grpc::copy(Fam_Descriptor *src, uint64_t srcOffset,
     return rpcClient->copy(src, srcOffset, dest, destOffset, nbytes);
 }
 
+void *Fam_Allocator_Grpc::copy(Fam_Descriptor *src, uint64_t srcOffset,
+                               Fam_Descriptor *dest, uint64_t destOffset,
+                               uint64_t nbytes) {
+    Fam_Rpc_Client *rpcClient = get_rpc_client(src->get_memserver_id());
+    if (src->get_memserver_id() != dest->get_memserver_id()) {
+        // The source server writes straight into the destination server
+        Fam_Rpc_Client *destClient = get_rpc_client(dest->get_memserver_id());
+        return rpcClient->copy(src, srcOffset, dest, destOffset, nbytes,
+                               destClient->get_addr(),
+                               destClient->get_addr_size());
+    }
+    return rpcClient->copy(src, srcOffset, dest, destOffset, nbytes);
+}
+
 void Fam_Allocator_Grpc::wait_for_copy(void *waitObj) {
     uint64_t memoryServerId = ((Fam_Copy_Tag *)waitObj)->memServerId;
     Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
     return rpcClient->wait_for_copy(waitObj);
 }
 
-void *Fam_Allocator_Grpc::fam_map(Fam_Descriptor *descriptor) {
+uint64_t Fam_Allocator_Grpc::copy_progress(void *waitObj) {
+    uint64_t memoryServerId = ((Fam_Copy_Tag *)waitObj)->memServerId;
+    Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
+    return rpcClient->copy_progress(waitObj);
+}
+
+void *Fam_Allocator_Grpc::fam_map(Fam_Descriptor *descriptor,
+                                  uint32_t mapFlags) {
     FAM_UNIMPLEMENTED_GRPC();
     return NULL;
 }
@@ -206,4 +387,11 @@ int Fam_Allocator_Grpc::get_addr(void *addr, size_t addrSize,
     return 0;
 }
 
+void Fam_Allocator_Grpc::get_memserver_info(uint64_t memoryServerId,
+                                            uint64_t &capacity,
+                                            uint64_t &used) {
+    Fam_Rpc_Client *rpcClient = get_rpc_client(memoryServerId);
+    rpcClient->get_memserver_info(capacity, used);
+}
+
 } // namespace openfam
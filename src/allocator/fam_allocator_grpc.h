@@ -30,7 +30,10 @@
 #ifndef FAM_ALLOCATOR_GRPC_H_
 #define FAM_ALLOCATOR_GRPC_H_
 
+#include <mutex>
+
 #include "allocator/fam_allocator.h"
+#include "allocator/fam_metadata_cache.h"
 #include "rpc/fam_rpc_client.h"
 
 namespace openfam {
@@ -40,7 +43,8 @@ using MemServerMap = std::map<uint64_t, std::string>;
 
 class Fam_Allocator_Grpc : public Fam_Allocator {
   public:
-    Fam_Allocator_Grpc(MemServerMap name, uint64_t port);
+    Fam_Allocator_Grpc(MemServerMap name, uint64_t port,
+                       uint64_t cacheLeaseMs = 0, bool lazyConnect = false);
 
     ~Fam_Allocator_Grpc();
 
@@ -53,14 +57,21 @@ class Fam_Allocator_Grpc : public Fam_Allocator {
     Fam_Region_Descriptor *create_region(const char *name, uint64_t nbytes,
                                          mode_t permissions,
                                          Fam_Redundancy_Level redundancyLevel,
-                                         uint64_t memoryServerId);
+                                         uint64_t memoryServerId,
+                                         Fam_Stripe_Layout layout);
     void destroy_region(Fam_Region_Descriptor *descriptor);
     int resize_region(Fam_Region_Descriptor *descriptor, uint64_t nbytes);
+    int set_region_growth(Fam_Region_Descriptor *descriptor,
+                          uint64_t growLimit);
 
     Fam_Descriptor *allocate(const char *name, uint64_t nbytes,
                              mode_t accessPermissions,
                              Fam_Region_Descriptor *region);
     void deallocate(Fam_Descriptor *descriptor);
+    void allocate_batch(const char **names, uint64_t *nbytes, uint64_t nItems,
+                        mode_t accessPermissions, Fam_Region_Descriptor *region,
+                        Fam_Descriptor **items);
+    void deallocate_batch(Fam_Descriptor **items, uint64_t nItems);
 
     int change_permission(Fam_Region_Descriptor *descriptor,
                           mode_t accessPermissions);
@@ -69,22 +80,33 @@ class Fam_Allocator_Grpc : public Fam_Allocator {
                                          uint64_t memoryServerId);
     Fam_Descriptor *lookup(const char *itemName, const char *regionName,
                            uint64_t memoryServerId);
+    void lookup_batch(const char **itemNames, const char *regionName,
+                      uint64_t nItems, uint64_t memoryServerId,
+                      Fam_Descriptor **items);
     Fam_Region_Item_Info
     check_permission_get_info(Fam_Region_Descriptor *descriptor);
     Fam_Region_Item_Info check_permission_get_info(Fam_Descriptor *descriptor);
+    void refresh_registration(Fam_Descriptor *descriptor);
+    bool keys_leased(uint64_t memoryServerId);
 
     void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor **dest,
                uint64_t destOffset, uint64_t nbytes);
 
+    void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor *dest,
+               uint64_t destOffset, uint64_t nbytes);
+
     void wait_for_copy(void *waitObj);
 
+    uint64_t copy_progress(void *waitObj);
+
     /**
      * fam_map - Map a data item in FAM to the process virtual address space.
      * @param descriptor - Descriptor associated with the data item in FAM.
+     * @param mapFlags - or-ed combination of Fam_Map_Flags.
      * @return - A pointer in the PE’s virtual address space that can be used
      * to directly manipulate contents of FAM.
      */
-    virtual void *fam_map(Fam_Descriptor *descriptor);
+    virtual void *fam_map(Fam_Descriptor *descriptor, uint32_t mapFlags);
 
     /**
      * fam_unmap - Unmap a data item in FAM from the process virtual
@@ -112,8 +134,16 @@ class Fam_Allocator_Grpc : public Fam_Allocator {
 
     virtual int get_addr(void *addr, size_t addrSize, uint64_t nodeId);
 
+    virtual void get_memserver_info(uint64_t memoryServerId,
+                                    uint64_t &capacity, uint64_t &used);
+
   private:
+    void connect_all();
+
     RpcClientMap *rpcClients;
+    Fam_Metadata_Cache *metadataCache;
+    // Serializes connecting to memory servers on first use
+    std::mutex connectLock;
 };
 
 } // namespace openfam
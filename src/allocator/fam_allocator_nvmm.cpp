@@ -28,6 +28,7 @@
  *
  */
 #include <iostream>
+#include <map>
 #include <stdint.h>   // needed
 #include <sys/stat.h> // needed for mode_t
 
@@ -51,11 +52,12 @@ void Fam_Allocator_NVMM::allocator_finalize() {
 
 Fam_Region_Descriptor *Fam_Allocator_NVMM::create_region(
     const char *name, uint64_t nbytes, mode_t permissions,
-    Fam_Redundancy_Level redundancyLevel, uint64_t memoryServerId) {
+    Fam_Redundancy_Level redundancyLevel, uint64_t memoryServerId,
+    Fam_Stripe_Layout layout) {
     uint64_t regionId;
     try {
         allocator->create_region(name, regionId, (size_t)nbytes, permissions,
-                                 uid, gid);
+                                 uid, gid, layout);
     }
     catch (Memserver_Exception &e) {
         throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
@@ -68,6 +70,7 @@ Fam_Region_Descriptor *Fam_Allocator_NVMM::create_region(
 
     Fam_Region_Descriptor *region =
         new Fam_Region_Descriptor(globalDescriptor, nbytes);
+    region->set_layout(layout);
     return region;
 }
 
@@ -104,6 +107,20 @@ int Fam_Allocator_NVMM::resize_region(Fam_Region_Descriptor *descriptor,
     return ret;
 }
 
+int Fam_Allocator_NVMM::set_region_growth(Fam_Region_Descriptor *descriptor,
+                                          uint64_t growLimit) {
+    Fam_Global_Descriptor globalDescriptor =
+        descriptor->get_global_descriptor();
+
+    try {
+        return allocator->set_region_growth(globalDescriptor.regionId, uid,
+                                            gid, growLimit);
+    } catch (Memserver_Exception &e) {
+        throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
+                                      e.fam_error_msg());
+    }
+}
+
 Fam_Descriptor *Fam_Allocator_NVMM::allocate(const char *name, uint64_t nbytes,
                                              mode_t accessPermissions,
                                              Fam_Region_Descriptor *region) {
@@ -111,7 +128,6 @@ Fam_Descriptor *Fam_Allocator_NVMM::allocate(const char *name, uint64_t nbytes,
     Fam_Global_Descriptor globalDescriptor = region->get_global_descriptor();
     Fam_DataItem_Metadata dataitem;
     uint64_t offset;
-    uint64_t key;
     void *localPointer;
     try {
         allocator->allocate(name, globalDescriptor.regionId, nbytes, offset,
@@ -123,20 +139,37 @@ Fam_Descriptor *Fam_Allocator_NVMM::allocate(const char *name, uint64_t nbytes,
                                       e.fam_error_msg());
     }
 
-    globalDescriptor.offset = offset;
-    Fam_Descriptor *dataItemDesc = new Fam_Descriptor(globalDescriptor, nbytes);
-    if (allocator->check_dataitem_permission(dataitem, 1, uid, gid)) {
-        key = FAM_WRITE_KEY_SHM | FAM_READ_KEY_SHM;
-    } else if (allocator->check_dataitem_permission(dataitem, 0, uid, gid)) {
-        key = FAM_READ_KEY_SHM;
-    } else {
-        throw Fam_Allocator_Exception(FAM_ERR_NOPERM,
-                                      "Not permitted to use this dataitem");
+    return get_descriptor(dataitem, localPointer);
+}
+
+void Fam_Allocator_NVMM::allocate_batch(const char **names, uint64_t *nbytes,
+                                        uint64_t nItems,
+                                        mode_t accessPermissions,
+                                        Fam_Region_Descriptor *region,
+                                        Fam_Descriptor **items) {
+    Fam_Global_Descriptor globalDescriptor = region->get_global_descriptor();
+    vector<string> itemNames;
+    vector<size_t> sizes;
+    vector<Fam_DataItem_Metadata> dataitems;
+    vector<void *> localPointers;
+
+    for (uint64_t i = 0; i < nItems; i++) {
+        itemNames.push_back((names && names[i]) ? names[i] : "");
+        sizes.push_back(nbytes[i]);
     }
-    dataItemDesc->set_base_address(localPointer);
-    dataItemDesc->bind_key(key);
 
-    return dataItemDesc;
+    try {
+        allocator->allocate_batch(itemNames, globalDescriptor.regionId, sizes,
+                                  accessPermissions, uid, gid, dataitems,
+                                  localPointers);
+    }
+    catch (Memserver_Exception &e) {
+        throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
+                                      e.fam_error_msg());
+    }
+
+    for (uint64_t i = 0; i < nItems; i++)
+        items[i] = get_descriptor(dataitems[i], localPointers[i]);
 }
 
 void Fam_Allocator_NVMM::deallocate(Fam_Descriptor *descriptor) {
@@ -154,6 +187,27 @@ void Fam_Allocator_NVMM::deallocate(Fam_Descriptor *descriptor) {
     return;
 }
 
+void Fam_Allocator_NVMM::deallocate_batch(Fam_Descriptor **items,
+                                          uint64_t nItems) {
+    // Data items may come from several regions; one batch per region
+    map<uint64_t, vector<uint64_t>> offsets;
+    for (uint64_t i = 0; i < nItems; i++) {
+        Fam_Global_Descriptor globalDescriptor =
+            items[i]->get_global_descriptor();
+        offsets[globalDescriptor.regionId].push_back(globalDescriptor.offset);
+    }
+
+    try {
+        for (auto &regionOffsets : offsets)
+            allocator->deallocate_batch(regionOffsets.first,
+                                        regionOffsets.second, uid, gid);
+    }
+    catch (Memserver_Exception &e) {
+        throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
+                                      e.fam_error_msg());
+    }
+}
+
 int Fam_Allocator_NVMM::change_permission(Fam_Region_Descriptor *descriptor,
                                           mode_t accessPermissions) {
 
@@ -207,6 +261,9 @@ Fam_Allocator_NVMM::lookup_region(const char *name, uint64_t memoryServerId) {
         globalDescriptor.offset = region.offset;
         Fam_Region_Descriptor *regionDesc =
             new Fam_Region_Descriptor(globalDescriptor, region.size);
+        regionDesc->set_layout(
+            {region.stripeSize, region.stripeCount, region.stripeIndex,
+             (Fam_Redundancy_Level)region.redundancyLevel});
         return regionDesc;
     } else {
         throw Fam_Allocator_Exception(FAM_ERR_NOPERM,
@@ -218,7 +275,6 @@ Fam_Descriptor *Fam_Allocator_NVMM::lookup(const char *itemName,
                                            const char *regionName,
                                            uint64_t memoryServerId) {
     Fam_DataItem_Metadata dataitem;
-    uint64_t key;
     try {
         allocator->get_dataitem(itemName, regionName, uid, gid, dataitem);
     }
@@ -227,23 +283,54 @@ Fam_Descriptor *Fam_Allocator_NVMM::lookup(const char *itemName,
                                       e.fam_error_msg());
     }
 
-    if (allocator->check_dataitem_permission(dataitem, 0, uid, gid)) {
-        Fam_Global_Descriptor globalDescriptor;
-        globalDescriptor.regionId = dataitem.regionId;
-        globalDescriptor.offset = dataitem.offset;
-        Fam_Descriptor *dataItemDesc =
-            new Fam_Descriptor(globalDescriptor, dataitem.size);
-        if (allocator->check_dataitem_permission(dataitem, 1, uid, gid)) {
-            key = FAM_WRITE_KEY_SHM | FAM_READ_KEY_SHM;
-        } else if (allocator->check_dataitem_permission(dataitem, 0, uid,
-                                                        gid)) {
-            key = FAM_READ_KEY_SHM;
-        } else {
-            throw Fam_Allocator_Exception(FAM_ERR_NOPERM,
-                                          "Not permitted to use this dataitem");
-        }
+    return get_descriptor(dataitem, NULL);
+}
+
+void Fam_Allocator_NVMM::lookup_batch(const char **itemNames,
+                                      const char *regionName, uint64_t nItems,
+                                      uint64_t memoryServerId,
+                                      Fam_Descriptor **items) {
+    vector<string> names(itemNames, itemNames + nItems);
+    vector<Fam_DataItem_Metadata> dataitems;
+    try {
+        allocator->get_dataitem_batch(names, regionName, uid, gid, dataitems);
+    }
+    catch (Memserver_Exception &e) {
+        throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
+                                      e.fam_error_msg());
+    }
+
+    uint64_t i = 0;
+    try {
+        for (; i < nItems; i++)
+            items[i] = get_descriptor(dataitems[i], NULL);
+    }
+    catch (Fam_Allocator_Exception &e) {
+        while (i > 0)
+            delete items[--i];
+        throw;
+    }
+}
+
+/*
+ * Build the descriptor of a data item for this process. The key reflects the
+ * permission of the caller, and the base address is the local pointer to the
+ * data item, looked up when localPointer is NULL.
+ */
+Fam_Descriptor *
+Fam_Allocator_NVMM::get_descriptor(Fam_DataItem_Metadata &dataitem,
+                                   void *localPointer) {
+    uint64_t key;
+    if (allocator->check_dataitem_permission(dataitem, 1, uid, gid)) {
+        key = FAM_WRITE_KEY_SHM | FAM_READ_KEY_SHM;
+    } else if (allocator->check_dataitem_permission(dataitem, 0, uid, gid)) {
+        key = FAM_READ_KEY_SHM;
+    } else {
+        throw Fam_Allocator_Exception(FAM_ERR_NOPERM,
+                                      "Not permitted to use this dataitem");
+    }
 
-        void *localPointer;
+    if (localPointer == NULL) {
         try {
             localPointer = allocator->get_local_pointer(dataitem.regionId,
                                                         dataitem.offset);
@@ -252,14 +339,16 @@ Fam_Descriptor *Fam_Allocator_NVMM::lookup(const char *itemName,
             throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
                                           e.fam_error_msg());
         }
-
-        dataItemDesc->set_base_address(localPointer);
-        dataItemDesc->bind_key(key);
-        return dataItemDesc;
-    } else {
-        throw Fam_Allocator_Exception(FAM_ERR_NOPERM,
-                                      "Not permitted to use this dataitem");
     }
+
+    Fam_Global_Descriptor globalDescriptor;
+    globalDescriptor.regionId = dataitem.regionId;
+    globalDescriptor.offset = dataitem.offset;
+    Fam_Descriptor *dataItemDesc =
+        new Fam_Descriptor(globalDescriptor, dataitem.size);
+    dataItemDesc->set_base_address(localPointer);
+    dataItemDesc->bind_key(key);
+    return dataItemDesc;
 }
 
 Fam_Region_Item_Info Fam_Allocator_NVMM::check_permission_get_info(
@@ -334,11 +423,20 @@ Fam_Allocator_NVMM::check_permission_get_info(Fam_Descriptor *descriptor) {
     return itemInfo;
 }
 
-void *Fam_Allocator_NVMM::fam_map(Fam_Descriptor *descriptor) {
+/*
+ * Data items are accessed through shared memory, without registrations.
+ */
+void Fam_Allocator_NVMM::refresh_registration(Fam_Descriptor *descriptor) {
+    return;
+}
+
+void *Fam_Allocator_NVMM::fam_map(Fam_Descriptor *descriptor,
+                                  uint32_t mapFlags) {
     Fam_Global_Descriptor globalDescriptor =
         descriptor->get_global_descriptor();
     Fam_DataItem_Metadata dataitem;
     void *localPtr = NULL;
+    bool writable = false;
 
     // find if dataitem present
     try {
@@ -359,6 +457,7 @@ void *Fam_Allocator_NVMM::fam_map(Fam_Descriptor *descriptor) {
             throw Fam_Allocator_Exception((enum Fam_Error)e.fam_error(),
                                           e.fam_error_msg());
         }
+        writable = true;
     } else if (allocator->check_dataitem_permission(dataitem, 0, uid, gid)) {
         try {
             localPtr = allocator->get_local_pointer(globalDescriptor.regionId,
@@ -373,6 +472,8 @@ void *Fam_Allocator_NVMM::fam_map(Fam_Descriptor *descriptor) {
                                       "Not permitted to use this dataitem");
     }
 
+    allocator->advise_mapping(localPtr, dataitem.size, mapFlags, writable);
+
     return localPtr;
 }
 
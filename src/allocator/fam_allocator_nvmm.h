@@ -48,14 +48,21 @@ class Fam_Allocator_NVMM : public Fam_Allocator {
     Fam_Region_Descriptor *create_region(const char *name, uint64_t nbytes,
                                          mode_t permissions,
                                          Fam_Redundancy_Level redundancyLevel,
-                                         uint64_t memoryServerId);
+                                         uint64_t memoryServerId,
+                                         Fam_Stripe_Layout layout);
     void destroy_region(Fam_Region_Descriptor *descriptor);
     int resize_region(Fam_Region_Descriptor *descriptor, uint64_t nbytes);
+    int set_region_growth(Fam_Region_Descriptor *descriptor,
+                          uint64_t growLimit);
 
     Fam_Descriptor *allocate(const char *name, uint64_t nbytes,
                              mode_t accessPermissions,
                              Fam_Region_Descriptor *region);
     void deallocate(Fam_Descriptor *descriptor);
+    void allocate_batch(const char **names, uint64_t *nbytes, uint64_t nItems,
+                        mode_t accessPermissions, Fam_Region_Descriptor *region,
+                        Fam_Descriptor **items);
+    void deallocate_batch(Fam_Descriptor **items, uint64_t nItems);
 
     int change_permission(Fam_Region_Descriptor *descriptor,
                           mode_t accessPermissions);
@@ -65,22 +72,37 @@ class Fam_Allocator_NVMM : public Fam_Allocator {
                                          uint64_t memoryServerId);
     Fam_Descriptor *lookup(const char *itemName, const char *regionName,
                            uint64_t memoryServerId);
+    void lookup_batch(const char **itemNames, const char *regionName,
+                      uint64_t nItems, uint64_t memoryServerId,
+                      Fam_Descriptor **items);
     Fam_Region_Item_Info
     check_permission_get_info(Fam_Region_Descriptor *descriptor);
     Fam_Region_Item_Info check_permission_get_info(Fam_Descriptor *descriptor);
+    void refresh_registration(Fam_Descriptor *descriptor);
+    bool keys_leased(uint64_t memoryServerId) { return false; }
+    // In the shared memory model, Fam_Ops_NVMM copies data items itself
     void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor **dest,
                uint64_t destOffset, uint64_t nbytes) {
-        return NULL;
+        throw Fam_Allocator_Exception(FAM_ERR_UNIMPL,
+                                      "copy is not supported by the allocator");
+    }
+
+    void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor *dest,
+               uint64_t destOffset, uint64_t nbytes) {
+        throw Fam_Allocator_Exception(FAM_ERR_UNIMPL,
+                                      "copy is not supported by the allocator");
     }
 
     void wait_for_copy(void *waitObj) {}
+    uint64_t copy_progress(void *waitObj) { return 0; }
     /**
      * fam_map - Map a data item in FAM to the process virtual address space.
      * @param descriptor - Descriptor associated with the data item in FAM.
+     * @param mapFlags - or-ed combination of Fam_Map_Flags.
      * @return - A pointer in the PE’s virtual address space that can be used
      * to directly manipulate contents of FAM.
      */
-    void *fam_map(Fam_Descriptor *descriptor);
+    void *fam_map(Fam_Descriptor *descriptor, uint32_t mapFlags);
 
     /**
      * fam_unmap - Unmap a data item in FAM from the process virtual
@@ -92,6 +114,10 @@ class Fam_Allocator_NVMM : public Fam_Allocator {
     void fam_unmap(void *local, Fam_Descriptor *descriptor);
     int get_addr_size(size_t *addrSize, uint64_t nodeId) { return 0; }
     int get_addr(void *addr, size_t addrSize, uint64_t nodeId) { return 0; }
+    void get_memserver_info(uint64_t memoryServerId, uint64_t &capacity,
+                            uint64_t &used) {
+        allocator->get_memserver_info(capacity, used);
+    }
 
     /**
      * acquire_CAS_lock - Acquire the mutex lock to perform
@@ -107,6 +133,8 @@ class Fam_Allocator_NVMM : public Fam_Allocator {
     void release_CAS_lock(Fam_Descriptor *descriptor) {}
 
   private:
+    Fam_Descriptor *get_descriptor(Fam_DataItem_Metadata &dataitem,
+                                   void *localPointer);
     Memserver_Allocator *allocator;
     uint32_t uid;
     uint32_t gid;
@@ -0,0 +1,203 @@
+/*
+ * fam_metadata_cache.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#include "allocator/fam_metadata_cache.h"
+
+namespace openfam {
+
+Fam_Metadata_Cache::Fam_Metadata_Cache(uint64_t leaseMs) : leaseMs(leaseMs) {}
+
+void Fam_Metadata_Cache::set_version(uint64_t memoryServerId,
+                                     uint64_t version) {
+    if (!enabled())
+        return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Server_Cache &server = servers[memoryServerId];
+    if (version <= server.version)
+        return;
+    server.version = version;
+    server.regions.clear();
+    server.items.clear();
+    server.itemInfos.clear();
+}
+
+/*
+ * Return the entries of a memory server if it is still at version, NULL
+ * otherwise. Called with the lock held.
+ */
+Fam_Metadata_Cache::Server_Cache *
+Fam_Metadata_Cache::get_server(uint64_t memoryServerId, uint64_t version) {
+    auto obj = servers.find(memoryServerId);
+    if ((obj == servers.end()) || (obj->second.version != version))
+        return NULL;
+    return &obj->second;
+}
+
+template <typename Key>
+bool Fam_Metadata_Cache::find(std::map<Key, Cache_Entry> &entries,
+                              const Key &key, Cache_Entry &entry) {
+    auto obj = entries.find(key);
+    if (obj == entries.end())
+        return false;
+    if (obj->second.expiry <= std::chrono::steady_clock::now()) {
+        entries.erase(obj);
+        return false;
+    }
+    entry = obj->second;
+    return true;
+}
+
+template <typename Key>
+void Fam_Metadata_Cache::insert(std::map<Key, Cache_Entry> &entries,
+                                const Key &key, Cache_Entry &entry) {
+    if (entries.size() >= FAM_METADATA_CACHE_MAX_ENTRIES)
+        entries.clear();
+    entry.expiry = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(leaseMs);
+    entries[key] = entry;
+}
+
+bool Fam_Metadata_Cache::find_region(uint64_t memoryServerId, const char *name,
+                                     Fam_Global_Descriptor &globalDescriptor,
+                                     uint64_t &size,
+                                     Fam_Stripe_Layout &layout) {
+    if (!enabled())
+        return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Cache_Entry entry;
+    if (!find(servers[memoryServerId].regions, std::string(name), entry))
+        return false;
+    globalDescriptor = entry.globalDescriptor;
+    size = entry.info.size;
+    layout = entry.layout;
+    return true;
+}
+
+bool Fam_Metadata_Cache::find_item(uint64_t memoryServerId,
+                                   const char *itemName,
+                                   const char *regionName,
+                                   Fam_Global_Descriptor &globalDescriptor,
+                                   uint64_t &size, uint64_t &key,
+                                   Fam_Stripe_Layout &layout) {
+    if (!enabled())
+        return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Cache_Entry entry;
+    if (!find(servers[memoryServerId].items,
+              std::make_pair(std::string(regionName), std::string(itemName)),
+              entry))
+        return false;
+    globalDescriptor = entry.globalDescriptor;
+    size = entry.info.size;
+    key = entry.info.key;
+    layout = entry.layout;
+    return true;
+}
+
+bool Fam_Metadata_Cache::find_item_info(uint64_t memoryServerId,
+                                        Fam_Global_Descriptor globalDescriptor,
+                                        Fam_Region_Item_Info &info) {
+    if (!enabled())
+        return false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Cache_Entry entry;
+    if (!find(servers[memoryServerId].itemInfos,
+              std::make_pair(globalDescriptor.regionId,
+                             globalDescriptor.offset),
+              entry))
+        return false;
+    info = entry.info;
+    return true;
+}
+
+void Fam_Metadata_Cache::insert_region(uint64_t memoryServerId,
+                                       uint64_t version, const char *name,
+                                       Fam_Global_Descriptor globalDescriptor,
+                                       uint64_t size,
+                                       Fam_Stripe_Layout layout) {
+    if (!enabled())
+        return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Server_Cache *server = get_server(memoryServerId, version);
+    if (!server)
+        return;
+    Cache_Entry entry = {};
+    entry.globalDescriptor = globalDescriptor;
+    entry.info.size = size;
+    entry.layout = layout;
+    insert(server->regions, std::string(name), entry);
+}
+
+void Fam_Metadata_Cache::insert_item(uint64_t memoryServerId, uint64_t version,
+                                     const char *itemName,
+                                     const char *regionName,
+                                     Fam_Global_Descriptor globalDescriptor,
+                                     uint64_t size, uint64_t key,
+                                     Fam_Stripe_Layout layout) {
+    if (!enabled())
+        return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Server_Cache *server = get_server(memoryServerId, version);
+    if (!server)
+        return;
+    Cache_Entry entry = {};
+    entry.globalDescriptor = globalDescriptor;
+    entry.info.size = size;
+    entry.info.key = key;
+    entry.layout = layout;
+    insert(server->items,
+           std::make_pair(std::string(regionName), std::string(itemName)),
+           entry);
+}
+
+void Fam_Metadata_Cache::insert_item_info(
+    uint64_t memoryServerId, uint64_t version,
+    Fam_Global_Descriptor globalDescriptor, Fam_Region_Item_Info info) {
+    if (!enabled())
+        return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    Server_Cache *server = get_server(memoryServerId, version);
+    if (!server)
+        return;
+    Cache_Entry entry = {};
+    entry.globalDescriptor = globalDescriptor;
+    entry.info = info;
+    insert(server->itemInfos,
+           std::make_pair(globalDescriptor.regionId, globalDescriptor.offset),
+           entry);
+}
+
+} // namespace openfam
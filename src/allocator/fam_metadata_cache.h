@@ -0,0 +1,128 @@
+/*
+ * fam_metadata_cache.h
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#ifndef FAM_METADATA_CACHE_H_
+#define FAM_METADATA_CACHE_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <utility>
+
+#include "fam/fam.h"
+
+// Entries kept per memory server and kind of lookup before starting over
+#define FAM_METADATA_CACHE_MAX_ENTRIES 65536
+
+namespace openfam {
+
+/*
+ * Client side cache of region and data item metadata, so that repeated
+ * lookups and the permission check on first access of a descriptor do not
+ * each cost a round trip to the memory server.
+ *
+ * Every memory server numbers its metadata changes and returns the current
+ * number with each reply. An entry is served only while its lease has not
+ * run out and no newer number has been seen from its memory server, so
+ * changes made through this client take effect at once and those of other
+ * clients after at most one lease. A lease of 0 disables the cache.
+ */
+class Fam_Metadata_Cache {
+  public:
+    Fam_Metadata_Cache(uint64_t leaseMs);
+
+    bool enabled() { return leaseMs != 0; }
+
+    /*
+     * Record the latest version seen from a memory server, dropping its
+     * entries if the version moved on.
+     */
+    void set_version(uint64_t memoryServerId, uint64_t version);
+
+    bool find_region(uint64_t memoryServerId, const char *name,
+                     Fam_Global_Descriptor &globalDescriptor, uint64_t &size,
+                     Fam_Stripe_Layout &layout);
+    bool find_item(uint64_t memoryServerId, const char *itemName,
+                   const char *regionName,
+                   Fam_Global_Descriptor &globalDescriptor, uint64_t &size,
+                   uint64_t &key, Fam_Stripe_Layout &layout);
+    bool find_item_info(uint64_t memoryServerId,
+                        Fam_Global_Descriptor globalDescriptor,
+                        Fam_Region_Item_Info &info);
+
+    /*
+     * The insert functions take the version the memory server sent with the
+     * entry. It is dropped if a newer version has been seen already, as the
+     * entry may then predate that change.
+     */
+    void insert_region(uint64_t memoryServerId, uint64_t version,
+                       const char *name, Fam_Global_Descriptor globalDescriptor,
+                       uint64_t size, Fam_Stripe_Layout layout);
+    void insert_item(uint64_t memoryServerId, uint64_t version,
+                     const char *itemName, const char *regionName,
+                     Fam_Global_Descriptor globalDescriptor, uint64_t size,
+                     uint64_t key, Fam_Stripe_Layout layout);
+    void insert_item_info(uint64_t memoryServerId, uint64_t version,
+                          Fam_Global_Descriptor globalDescriptor,
+                          Fam_Region_Item_Info info);
+
+  private:
+    struct Cache_Entry {
+        Fam_Global_Descriptor globalDescriptor;
+        Fam_Region_Item_Info info;
+        Fam_Stripe_Layout layout;
+        std::chrono::steady_clock::time_point expiry;
+    };
+
+    struct Server_Cache {
+        Server_Cache() : version(0) {}
+        uint64_t version;
+        std::map<std::string, Cache_Entry> regions;
+        std::map<std::pair<std::string, std::string>, Cache_Entry> items;
+        std::map<std::pair<uint64_t, uint64_t>, Cache_Entry> itemInfos;
+    };
+
+    template <typename Key>
+    bool find(std::map<Key, Cache_Entry> &entries, const Key &key,
+              Cache_Entry &entry);
+    template <typename Key>
+    void insert(std::map<Key, Cache_Entry> &entries, const Key &key,
+                Cache_Entry &entry);
+    Server_Cache *get_server(uint64_t memoryServerId, uint64_t version);
+
+    uint64_t leaseMs;
+    std::mutex lock;
+    std::map<uint64_t, Server_Cache> servers;
+};
+
+} // namespace openfam
+
+#endif /* end of FAM_METADATA_CACHE_H_ */
@@ -0,0 +1,148 @@
+/*
+ * fam_region_placement.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#include <functional>
+#include <unistd.h>
+
+#include "allocator/fam_region_placement.h"
+#include "fam/fam_exception.h"
+
+namespace openfam {
+
+Fam_Region_Placement *
+Fam_Region_Placement::create(Fam_Region_Placement_Policy policy,
+                             uint64_t memoryServerCount,
+                             Fam_Allocator *allocator) {
+    switch (policy) {
+    case FAM_PLACEMENT_CONSISTENT_HASH:
+        return new Fam_Consistent_Hash_Placement(memoryServerCount);
+    case FAM_PLACEMENT_CAPACITY:
+        return new Fam_Capacity_Placement(memoryServerCount, allocator);
+    case FAM_PLACEMENT_ROUND_ROBIN:
+        return new Fam_Round_Robin_Placement(memoryServerCount);
+    default:
+        return new Fam_Hash_Placement(memoryServerCount);
+    }
+}
+
+/*
+ * The remembered location, if any, then the home server, then the others.
+ */
+std::vector<uint64_t> Fam_Region_Placement::get_lookup_order(const char *name) {
+    std::vector<uint64_t> order;
+    {
+        std::lock_guard<std::mutex> guard(locationLock);
+        auto location = locations.find(name);
+        if (location != locations.end())
+            order.push_back(location->second);
+    }
+
+    uint64_t home = get_home_server(name);
+    if (order.empty() || (order[0] != home))
+        order.push_back(home);
+    for (uint64_t i = 0; i < memoryServerCount; i++) {
+        if ((i != home) && (i != order[0]))
+            order.push_back(i);
+    }
+    return order;
+}
+
+void Fam_Region_Placement::set_location(const char *name,
+                                        uint64_t memoryServerId) {
+    std::lock_guard<std::mutex> guard(locationLock);
+    if (memoryServerId == get_home_server(name)) {
+        locations.erase(name);
+        return;
+    }
+    if (locations.size() >= FAM_PLACEMENT_MAX_LOCATIONS)
+        locations.clear();
+    locations[name] = memoryServerId;
+}
+
+uint64_t Fam_Hash_Placement::get_home_server(const char *name) {
+    return std::hash<std::string>{}(name) % memoryServerCount;
+}
+
+Fam_Consistent_Hash_Placement::Fam_Consistent_Hash_Placement(
+    uint64_t memoryServerCount)
+    : Fam_Region_Placement(memoryServerCount) {
+    for (uint64_t id = 0; id < memoryServerCount; id++) {
+        for (int point = 0; point < FAM_PLACEMENT_RING_POINTS; point++) {
+            std::string key = std::to_string(id) + "#" + std::to_string(point);
+            ring[std::hash<std::string>{}(key)] = id;
+        }
+    }
+}
+
+uint64_t Fam_Consistent_Hash_Placement::get_home_server(const char *name) {
+    auto point = ring.lower_bound(std::hash<std::string>{}(name));
+    if (point == ring.end())
+        point = ring.begin();
+    return point->second;
+}
+
+Fam_Round_Robin_Placement::Fam_Round_Robin_Placement(
+    uint64_t memoryServerCount)
+    : Fam_Hash_Placement(memoryServerCount) {
+    next.store((uint64_t)getpid());
+}
+
+uint64_t Fam_Round_Robin_Placement::place_region(const char *name,
+                                                 uint64_t nbytes) {
+    return next.fetch_add(1) % memoryServerCount;
+}
+
+uint64_t Fam_Capacity_Placement::place_region(const char *name,
+                                              uint64_t nbytes) {
+    uint64_t home = get_home_server(name);
+    uint64_t best = home;
+    uint64_t bestFree = 0;
+
+    for (uint64_t i = 0; i < memoryServerCount; i++) {
+        uint64_t id = (home + i) % memoryServerCount;
+        uint64_t capacity, used, freeBytes;
+        try {
+            allocator->get_memserver_info(id, capacity, used);
+        } catch (Fam_Exception &e) {
+            // An unreachable memory server is no candidate
+            continue;
+        }
+        if (capacity == 0)
+            freeBytes = UINT64_MAX - used;
+        else
+            freeBytes = (capacity > used) ? capacity - used : 0;
+        if (freeBytes > bestFree) {
+            best = id;
+            bestFree = freeBytes;
+        }
+    }
+    return best;
+}
+
+} // namespace openfam
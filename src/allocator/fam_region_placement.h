@@ -0,0 +1,154 @@
+/*
+ * fam_region_placement.h
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#ifndef FAM_REGION_PLACEMENT_H_
+#define FAM_REGION_PLACEMENT_H_
+
+#include <map>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+
+#include "allocator/fam_allocator.h"
+#include "common/fam_options.h"
+
+// Points of each memory server on the consistent hash ring
+#define FAM_PLACEMENT_RING_POINTS 64
+// Region names remembered on a memory server other than their home server
+#define FAM_PLACEMENT_MAX_LOCATIONS 65536
+
+namespace openfam {
+
+/*
+ * Chooses the memory server a new region is created on.
+ *
+ * Every region name has a home server, where lookups by name go first.
+ * Policies that may create a region elsewhere, and regions created on an
+ * explicitly given memory server, are found by asking the other memory
+ * servers in turn. Where a region was found is remembered, so that only the
+ * first lookup of such a region pays for the search.
+ */
+class Fam_Region_Placement {
+  public:
+    Fam_Region_Placement(uint64_t memoryServerCount)
+        : memoryServerCount(memoryServerCount) {}
+    virtual ~Fam_Region_Placement() {}
+
+    static Fam_Region_Placement *create(Fam_Region_Placement_Policy policy,
+                                        uint64_t memoryServerCount,
+                                        Fam_Allocator *allocator);
+
+    // Memory server looked up first for the region of this name
+    virtual uint64_t get_home_server(const char *name) = 0;
+
+    // Memory server to create a region of nbytes on
+    virtual uint64_t place_region(const char *name, uint64_t nbytes) {
+        return get_home_server(name);
+    }
+
+    // Memory servers to look the region up on, in order
+    std::vector<uint64_t> get_lookup_order(const char *name);
+
+    // Remember the memory server the region of this name lives on
+    void set_location(const char *name, uint64_t memoryServerId);
+
+    uint64_t get_memory_server_count() { return memoryServerCount; }
+
+  protected:
+    uint64_t memoryServerCount;
+
+  private:
+    std::map<std::string, uint64_t> locations;
+    std::mutex locationLock;
+};
+
+/*
+ * Hash of the name modulo the number of memory servers
+ */
+class Fam_Hash_Placement : public Fam_Region_Placement {
+  public:
+    Fam_Hash_Placement(uint64_t memoryServerCount)
+        : Fam_Region_Placement(memoryServerCount) {}
+
+    uint64_t get_home_server(const char *name);
+};
+
+/*
+ * Consistent hashing: each memory server owns the arcs of a hash ring ending
+ * at its points, so adding a memory server moves only the regions on the
+ * arcs it takes over.
+ */
+class Fam_Consistent_Hash_Placement : public Fam_Region_Placement {
+  public:
+    Fam_Consistent_Hash_Placement(uint64_t memoryServerCount);
+
+    uint64_t get_home_server(const char *name);
+
+  private:
+    std::map<uint64_t, uint64_t> ring;
+};
+
+/*
+ * Memory servers in turn, starting at one picked by the process id so that
+ * processes starting together do not all begin with the same server.
+ */
+class Fam_Round_Robin_Placement : public Fam_Hash_Placement {
+  public:
+    Fam_Round_Robin_Placement(uint64_t memoryServerCount);
+
+    uint64_t place_region(const char *name, uint64_t nbytes);
+
+  private:
+    boost::atomic_uint64_t next;
+};
+
+/*
+ * Memory server with the most free space, as reported by the memory servers
+ * when the region is created: capacity less the bytes of their regions. A
+ * memory server without capacity counts as unlimited, less its regions.
+ * Ties go to the home server of the name.
+ */
+class Fam_Capacity_Placement : public Fam_Hash_Placement {
+  public:
+    Fam_Capacity_Placement(uint64_t memoryServerCount,
+                           Fam_Allocator *allocator)
+        : Fam_Hash_Placement(memoryServerCount), allocator(allocator) {}
+
+    uint64_t place_region(const char *name, uint64_t nbytes);
+
+  private:
+    Fam_Allocator *allocator;
+};
+
+} // namespace openfam
+
+#endif /* end of FAM_REGION_PLACEMENT_H_ */
@@ -30,41 +30,318 @@
 #include "allocator/memserver_allocator.h"
 
 namespace openfam {
-Memserver_Allocator::Memserver_Allocator() {
+Memserver_Allocator::Memserver_Allocator(uint64_t numCopyThreads,
+                                         uint64_t slabMaxObjSize,
+                                         uint64_t numWarmHeaps,
+                                         uint64_t capacity)
+    : slabMaxObjSize(slabMaxObjSize), mergeStop(false), mergeRequested(0),
+      mergeDone(0), numWarmHeaps(numWarmHeaps), warmBytes(0),
+      heapPoolStop(false), capacity(capacity) {
     StartNVMM();
-    heapMap = new HeapMap();
+    heapMap = new boost::atomic<Heap *>[ShelfId::kMaxPoolCount];
+    slabMap = new boost::atomic<Memserver_Slab *>[ShelfId::kMaxPoolCount];
+    freedBytes = new boost::atomic_uint64_t[ShelfId::kMaxPoolCount];
+    usedBytes = new boost::atomic_uint64_t[ShelfId::kMaxPoolCount];
+    growRequest = new boost::atomic_uint64_t[ShelfId::kMaxPoolCount];
+    for (uint64_t i = 0; i < ShelfId::kMaxPoolCount; i++) {
+        heapMap[i].store(NULL);
+        slabMap[i].store(NULL);
+        freedBytes[i].store(0);
+        usedBytes[i].store(0);
+        growRequest[i].store(0);
+    }
     memoryManager = MemoryManager::GetInstance();
     metadataManager = FAM_Metadata_Manager::GetInstance();
     (void)pthread_mutex_init(&heapMapLock, NULL);
+    (void)pthread_mutex_init(&slabMapLock, NULL);
     init_poolId_bmap();
+    count_region_bytes();
+    copyPool = new Memserver_Copy_Pool(numCopyThreads);
+    merger = std::thread(&Memserver_Allocator::run_merger, this);
+    if (numWarmHeaps) {
+        reclaim_unused_heaps();
+        heapKeeper = std::thread(&Memserver_Allocator::run_heap_keeper, this);
+    }
 }
 
 Memserver_Allocator::~Memserver_Allocator() {
-    delete heapMap;
+    stop_merger();
+    stop_heap_keeper();
+    delete copyPool;
+    for (uint64_t i = 0; i < ShelfId::kMaxPoolCount; i++)
+        delete slabMap[i].load();
+    delete[] slabMap;
+    delete[] freedBytes;
+    delete[] usedBytes;
+    delete[] growRequest;
+    delete[] heapMap;
     pthread_mutex_destroy(&heapMapLock);
+    pthread_mutex_destroy(&slabMapLock);
 }
 
 void Memserver_Allocator::memserver_allocator_finalize() {
-    HeapMap::iterator it = heapMap->begin();
-    Heap *heap = 0;
-
-    while (it != heapMap->end()) {
-        heap = it->second;
-        if (heap->IsOpen())
+    stop_merger();
+    stop_heap_keeper();
+    for (uint64_t i = 0; i < ShelfId::kMaxPoolCount; i++) {
+        Heap *heap = heapMap[i].load();
+        if (heap && heap->IsOpen())
             heap->Close();
-        it++;
     }
 }
 
 /*
  * Initalize the region Id bitmap address.
- * Size of bitmap is Max poolId's supported / 8 bytes.
+ * Size of bitmap is Max poolId's supported / 8 bytes, so that no id
+ * beyond the NVMM pool count is ever handed out.
  * Get the Bitmap address reserved from the root shelf.
  */
 void Memserver_Allocator::init_poolId_bmap() {
     bmap = new bitmap();
-    bmap->size = (ShelfId::kMaxPoolCount * BITSIZE) / sizeof(uint64_t);
+    bmap->size =
+        ((ShelfId::kMaxPoolCount + BITSIZE - 1) / BITSIZE) * sizeof(uint64_t);
     bmap->map = memoryManager->GetRegionIdBitmapAddr();
+    // Without a summary, which only fails for lack of memory, the searches
+    // for a free id just read every word of the bitmap
+    (void)bitmap_init_summary(bmap);
+}
+
+/*
+ * Add up the sizes of the regions left by earlier runs of the server.
+ */
+void Memserver_Allocator::count_region_bytes() {
+    regionBytes.store(0);
+    for (uint64_t poolId = MEMSERVER_REGIONID_START;
+         poolId < ShelfId::kMaxPoolCount; poolId++) {
+        Fam_Region_Metadata region;
+        if (bitmap_get(bmap, poolId) &&
+            (metadataManager->metadata_find_region(poolId, region) ==
+             META_NO_ERROR))
+            regionBytes.fetch_add(region.size);
+    }
+}
+
+/*
+ * Report the capacity of the server and the bytes taken by its regions, for
+ * clients placing new regions.
+ */
+void Memserver_Allocator::get_memserver_info(uint64_t &capacity,
+                                             uint64_t &used) {
+    capacity = this->capacity;
+    used = regionBytes.load();
+}
+
+/*
+ * Reserve a pool id and create and open an NVMM heap of nbytes with it.
+ */
+Heap *Memserver_Allocator::create_heap(size_t nbytes, PoolId &poolId) {
+    ostringstream message;
+    message << "Error While creating region : ";
+
+    poolId = get_free_poolId();
+    if (poolId == (PoolId)NO_FREE_POOLID) {
+        message << "No free pool ID";
+        throw Memserver_Exception(NO_FREE_POOLID, message.str().c_str());
+    }
+
+    int ret = memoryManager->CreateHeap(poolId, nbytes, MIN_OBJ_SIZE);
+    if (ret != NO_ERROR) {
+        // Reset the poolId bit in the bitmap
+        bitmap_reset(bmap, poolId);
+        message << "Heap not created";
+        throw Memserver_Exception(HEAP_NOT_CREATED, message.str().c_str());
+    }
+    Heap *heap = 0;
+    ret = memoryManager->FindHeap(poolId, &heap);
+    if (ret != NO_ERROR) {
+        message << "Heap not found";
+        // Reset the poolId bit in the bitmap
+        bitmap_reset(bmap, poolId);
+        delete heap;
+        throw Memserver_Exception(HEAP_NOT_FOUND, message.str().c_str());
+    }
+    ret = heap->Open();
+    if (ret != NO_ERROR) {
+        message << "Can not open heap";
+        // Reset the poolId bit in the bitmap
+        bitmap_reset(bmap, poolId);
+        delete heap;
+        throw Memserver_Exception(HEAP_NOT_OPENED, message.str().c_str());
+    }
+    return heap;
+}
+
+/*
+ * Close and destroy the heap of a pool id and release the id. heap may be
+ * NULL if it was never opened.
+ */
+int Memserver_Allocator::destroy_heap(PoolId poolId, Heap *heap) {
+    if (heap) {
+        if (heap->Close() != NO_ERROR)
+            return HEAP_NOT_CLOSED;
+        delete heap;
+    }
+    if (memoryManager->DestroyHeap(poolId) != NO_ERROR)
+        return HEAP_NOT_DESTROYED;
+    // Reset the regionId bit in the bitmap
+    bitmap_reset(bmap, poolId);
+    return ALLOC_NO_ERROR;
+}
+
+/*
+ * Hand out a heap of nbytes from the warm pool, if there is one, and record
+ * nbytes as a size to keep heaps of. Returns NULL if the pool has none.
+ */
+Heap *Memserver_Allocator::take_warm_heap(size_t nbytes, PoolId &poolId) {
+    if (!numWarmHeaps)
+        return NULL;
+
+    Heap *heap = NULL;
+    std::lock_guard<std::mutex> guard(heapPoolLock);
+
+    auto sizeObj = std::find(warmSizes.begin(), warmSizes.end(), nbytes);
+    if (sizeObj != warmSizes.end())
+        warmSizes.erase(sizeObj);
+    warmSizes.push_front(nbytes);
+    if (warmSizes.size() > MEMSERVER_WARM_HEAP_SIZES) {
+        // The least recently asked for size is dropped with its heaps
+        auto &dropped = warmHeaps[warmSizes.back()];
+        reclaimHeaps.insert(reclaimHeaps.end(), dropped.begin(),
+                            dropped.end());
+        warmBytes -= dropped.size() * warmSizes.back();
+        warmHeaps.erase(warmSizes.back());
+        warmSizes.pop_back();
+    }
+
+    auto &ready = warmHeaps[nbytes];
+    if (!ready.empty()) {
+        poolId = ready.front().first;
+        heap = ready.front().second;
+        ready.pop_front();
+        warmBytes -= nbytes;
+    }
+    heapPoolCond.notify_one();
+    return heap;
+}
+
+/*
+ * Returns a size whose warm pool is below numWarmHeaps and that a heap can
+ * be added for within the limit of the pool, or 0 if none is. Called with
+ * heapPoolLock held.
+ */
+size_t Memserver_Allocator::get_warm_heap_size() {
+    uint64_t limit = get_warm_heap_limit();
+    for (auto size : warmSizes) {
+        if ((warmHeaps[size].size() < numWarmHeaps) &&
+            (warmBytes + size <= limit))
+            return size;
+    }
+    return 0;
+}
+
+/*
+ * Returns the bytes the warm heap pool may take: a share of the capacity
+ * not used by regions, so that it never keeps regions from being created.
+ */
+uint64_t Memserver_Allocator::get_warm_heap_limit() {
+    if (!capacity)
+        return MEMSERVER_WARM_HEAP_MAX_BYTES;
+    uint64_t used = regionBytes.load();
+    if (used >= capacity)
+        return 0;
+    return (capacity - used) / MEMSERVER_WARM_HEAP_SHARE;
+}
+
+/*
+ * Destroy the heaps of destroyed regions and keep the warm pool filled.
+ */
+void Memserver_Allocator::run_heap_keeper() {
+    std::unique_lock<std::mutex> guard(heapPoolLock);
+    while (true) {
+        heapPoolCond.wait(guard, [this] {
+            return heapPoolStop || !reclaimHeaps.empty() ||
+                   get_warm_heap_size();
+        });
+        if (heapPoolStop)
+            break;
+
+        if (!reclaimHeaps.empty()) {
+            std::pair<PoolId, Heap *> reclaim = reclaimHeaps.front();
+            reclaimHeaps.pop_front();
+            guard.unlock();
+            // A heap that cannot be destroyed keeps its pool id reserved,
+            // and reclaim_unused_heaps() destroys it on the next start
+            (void)destroy_heap(reclaim.first, reclaim.second);
+            guard.lock();
+            continue;
+        }
+
+        size_t size = get_warm_heap_size();
+        warmBytes += size;
+        guard.unlock();
+        PoolId poolId;
+        Heap *heap = NULL;
+        try {
+            heap = create_heap(size, poolId);
+        } catch (Memserver_Exception &e) {
+            // Out of pool ids or space; create_region reports it if a region
+            // of this size cannot be created either
+        }
+        guard.lock();
+
+        if (!heap) {
+            // Retried once the size is asked for again
+            warmBytes -= size;
+            auto sizeObj = std::find(warmSizes.begin(), warmSizes.end(), size);
+            if (sizeObj != warmSizes.end())
+                warmSizes.erase(sizeObj);
+        } else if (std::find(warmSizes.begin(), warmSizes.end(), size) ==
+                   warmSizes.end()) {
+            warmBytes -= size;
+            reclaimHeaps.push_back({poolId, heap});
+        } else {
+            warmHeaps[size].push_back({poolId, heap});
+        }
+    }
+}
+
+/*
+ * Stop the heap keeper and destroy what it still holds: the heaps waiting
+ * to be destroyed and the warm pool.
+ */
+void Memserver_Allocator::stop_heap_keeper() {
+    {
+        std::lock_guard<std::mutex> guard(heapPoolLock);
+        heapPoolStop = true;
+    }
+    heapPoolCond.notify_all();
+    if (heapKeeper.joinable())
+        heapKeeper.join();
+
+    for (auto &ready : warmHeaps)
+        reclaimHeaps.insert(reclaimHeaps.end(), ready.second.begin(),
+                            ready.second.end());
+    warmHeaps.clear();
+    warmBytes = 0;
+    for (auto &reclaim : reclaimHeaps)
+        (void)destroy_heap(reclaim.first, reclaim.second);
+    reclaimHeaps.clear();
+}
+
+/*
+ * Destroy the heaps left over by warm pools of an earlier run that did not
+ * shut down cleanly: their pool ids are reserved, but no region uses them.
+ * Done before any request is served, so no region can be half created.
+ */
+void Memserver_Allocator::reclaim_unused_heaps() {
+    for (uint64_t poolId = MEMSERVER_REGIONID_START;
+         poolId < ShelfId::kMaxPoolCount; poolId++) {
+        Fam_Region_Metadata region;
+        if (!bitmap_get(bmap, poolId) ||
+            (metadataManager->metadata_find_region(poolId, region) ==
+             META_NO_ERROR))
+            continue;
+        (void)destroy_heap((PoolId)poolId, NULL);
+    }
 }
 
 /*
@@ -74,10 +351,12 @@ void Memserver_Allocator::init_poolId_bmap() {
  * nbytes - size of region in bytes
  * permission - Permission for the region
  * uid/gid - user id and group id
+ * layout - stripe layout, if the region is a member of a striped region
  */
 int Memserver_Allocator::create_region(string name, uint64_t &regionId,
                                        size_t nbytes, mode_t permission,
-                                       uint32_t uid, uint32_t gid) {
+                                       uint32_t uid, uint32_t gid,
+                                       Fam_Stripe_Layout layout) {
     ostringstream message;
     message << "Error While creating region : ";
 
@@ -87,66 +366,34 @@ int Memserver_Allocator::create_region(string name, uint64_t &regionId,
         throw Memserver_Exception(REGION_NAME_TOO_LONG, message.str().c_str());
     }
 
-    // Obtain free regionId from NVMM
-    size_t tmpSize;
-
-    // TODO: Obtain free regionId from NVMM
-    PoolId poolId = get_free_poolId();
-    if (poolId == (PoolId)NO_FREE_POOLID) {
-        message << "No free pool ID";
-        throw Memserver_Exception(NO_FREE_POOLID, message.str().c_str());
-    }
     // Checking if the region is already exist, if exists return error
     Fam_Region_Metadata region;
     int ret = metadataManager->metadata_find_region(name, region);
     if (ret == META_NO_ERROR) {
         message << "Region already exist";
-        // Reset the poolId bit in the bitmap
-        bitmap_reset(bmap, poolId);
         throw Memserver_Exception(REGION_EXIST, message.str().c_str());
     }
     // Else Create region using NVMM and set the fields in reponse to
     // appropriate value
+    size_t tmpSize;
 
     if (nbytes < MIN_REGION_SIZE)
         tmpSize = MIN_REGION_SIZE;
     else
         tmpSize = nbytes;
 
-    ret = memoryManager->CreateHeap(poolId, tmpSize, MIN_OBJ_SIZE);
-    if (ret != NO_ERROR) {
-        // Reset the poolId bit in the bitmap
-        bitmap_reset(bmap, poolId);
-        message << "Heap not created";
-        throw Memserver_Exception(HEAP_NOT_CREATED, message.str().c_str());
-    }
-    Heap *heap = 0;
-    ret = memoryManager->FindHeap(poolId, &heap);
-    if (ret != NO_ERROR) {
-        message << "Heap not found";
-        // Reset the poolId bit in the bitmap
-        bitmap_reset(bmap, poolId);
-        delete heap;
-        throw Memserver_Exception(HEAP_NOT_FOUND, message.str().c_str());
-    }
-    ret = heap->Open();
-    if (ret != NO_ERROR) {
-        message << "Can not open heap";
-        // Reset the poolId bit in the bitmap
-        bitmap_reset(bmap, poolId);
-        delete heap;
-        throw Memserver_Exception(HEAP_NOT_OPENED, message.str().c_str());
-    }
+    // A heap of this size from the warm pool saves creating one
+    PoolId poolId;
+    Heap *heap = take_warm_heap(tmpSize, poolId);
+    if (!heap)
+        heap = create_heap(tmpSize, poolId);
     regionId = (uint64_t)poolId;
 
-    pthread_mutex_lock(&heapMapLock);
-
-    auto heapObj = heapMap->find(regionId);
-    if (heapObj == heapMap->end()) {
-        heapMap->insert({regionId, heap});
-    } else {
+    freedBytes[regionId].store(0);
+    usedBytes[regionId].store(0);
+    growRequest[regionId].store(0);
+    if (!insert_heap(regionId, heap)) {
         message << "Can not insert heap. regionId already found in map";
-        pthread_mutex_unlock(&heapMapLock);
         // Reset the poolId bit in the bitmap
         bitmap_reset(bmap, regionId);
         delete heap;
@@ -157,8 +404,6 @@ int Memserver_Allocator::create_region(string name, uint64_t &regionId,
         throw Memserver_Exception(RBT_HEAP_NOT_INSERTED, message.str().c_str());
     }
 
-    pthread_mutex_unlock(&heapMapLock);
-
     // Register the region into metadata service
     region.regionId = regionId;
     strncpy(region.name, name.c_str(), metadataManager->metadata_maxkeylen());
@@ -167,6 +412,16 @@ int Memserver_Allocator::create_region(string name, uint64_t &regionId,
     region.uid = uid;
     region.gid = gid;
     region.size = nbytes;
+    region.stripeSize = layout.stripeSize;
+    region.stripeCount = layout.stripeCount ? layout.stripeCount : 1;
+    region.stripeIndex = layout.stripeIndex;
+    region.redundancyLevel = layout.redundancyLevel;
+    region.growLimit = 0;
+    region.baseSize = nbytes;
+    // Slabs are set up with the region; 0 if disabled or out of space
+    region.slabRoot = 0;
+    if (slabMaxObjSize)
+        region.slabRoot = Memserver_Slab::create_root(heap, MIN_OBJ_SIZE);
     ret = metadataManager->metadata_insert_region(regionId, name, &region);
     if (ret != META_NO_ERROR) {
         message << "Can not insert region into metadata service, ";
@@ -175,14 +430,8 @@ int Memserver_Allocator::create_region(string name, uint64_t &regionId,
             message << "Can not close heap, ";
         }
 
-        HeapMap::iterator it = get_heap(regionId, heap);
-        if (it != heapMap->end()) {
-            pthread_mutex_lock(&heapMapLock);
-            heapMap->erase(it);
-            pthread_mutex_unlock(&heapMapLock);
-        } else {
+        if (remove_heap(regionId) == NULL)
             message << "Can not remove heap from map";
-        }
 
         // Reset the regionId bit in the bitmap
         bitmap_reset(bmap, regionId);
@@ -193,6 +442,7 @@ int Memserver_Allocator::create_region(string name, uint64_t &regionId,
         }
         throw Memserver_Exception(REGION_NOT_INSERTED, message.str().c_str());
     }
+    regionBytes.fetch_add(nbytes);
 
     return ALLOC_NO_ERROR;
 }
@@ -207,6 +457,8 @@ int Memserver_Allocator::destroy_region(uint64_t regionId, uint32_t uid,
                                         uint32_t gid) {
     ostringstream message;
     message << "Error While destroy region : ";
+    // No resize of the region is under way until it is gone
+    std::unique_lock<std::mutex> guard(resizeLock);
     // Check with metadata service if the region exist, if not return error
     Fam_Region_Metadata region;
     int ret = metadataManager->metadata_find_region(regionId, region);
@@ -230,15 +482,14 @@ int Memserver_Allocator::destroy_region(uint64_t regionId, uint32_t uid,
 
     // destroy region using NVMM
     // Even if heap is not found in map, continue with DestroyHeap
-    Heap *heap = 0;
-
-    HeapMap::iterator it = get_heap(regionId, heap);
+    Heap *heap = remove_heap(regionId);
 
-    if (it != heapMap->end()) {
-        pthread_mutex_lock(&heapMapLock);
-        heapMap->erase(it);
-        pthread_mutex_unlock(&heapMapLock);
+    pthread_mutex_lock(&slabMapLock);
+    delete slabMap[regionId].exchange(NULL);
+    pthread_mutex_unlock(&slabMapLock);
 
+    // With the heap keeper, the heap is closed and destroyed in the background
+    if (heap && !numWarmHeaps) {
         ret = heap->Close();
         if (ret != NO_ERROR) {
             message << "Can not close heap";
@@ -253,9 +504,24 @@ int Memserver_Allocator::destroy_region(uint64_t regionId, uint32_t uid,
     // metadata_delete_region after DestroyHeap will result in SIGSEGV.
     ret = metadataManager->metadata_delete_region(regionId);
     if (ret != META_NO_ERROR) {
+        if (heap && numWarmHeaps) {
+            heap->Close();
+            delete heap;
+        }
         message << "Can not remove region from metadata service";
         throw Memserver_Exception(REGION_NOT_REMOVED, message.str().c_str());
     }
+    regionBytes.fetch_sub(region.size);
+    guard.unlock();
+
+    if (numWarmHeaps) {
+        {
+            std::lock_guard<std::mutex> guard(heapPoolLock);
+            reclaimHeaps.push_back({(PoolId)regionId, heap});
+        }
+        heapPoolCond.notify_one();
+        return ALLOC_NO_ERROR;
+    }
 
     ret = memoryManager->DestroyHeap((PoolId)regionId);
     if (ret != NO_ERROR) {
@@ -278,6 +544,8 @@ int Memserver_Allocator::resize_region(uint64_t regionId, uint32_t uid,
                                        uint32_t gid, size_t nbytes) {
     ostringstream message;
     message << "Error while resizing the region";
+    // Resizes, explicit or in the background, are done one at a time
+    std::lock_guard<std::mutex> guard(resizeLock);
     // Check with metadata service if the region exist, if not return error
     Fam_Region_Metadata region;
     int ret = metadataManager->metadata_find_region(regionId, region);
@@ -295,68 +563,101 @@ int Memserver_Allocator::resize_region(uint64_t regionId, uint32_t uid,
     }
 
     // Get the heap and open it if not open already
-    Heap *heap = 0;
-    HeapMap::iterator it = get_heap(regionId, heap);
+    Heap *heap = get_heap(regionId);
 
-    if (it == heapMap->end()) {
+    if (heap == NULL) {
         ret = open_heap(regionId);
         if (ret != ALLOC_NO_ERROR) {
             message << "Opening of heap failed";
             throw Memserver_Exception(HEAP_NOT_OPENED, message.str().c_str());
         }
-        it = get_heap(regionId, heap);
-        if (it == heapMap->end()) {
+        heap = get_heap(regionId);
+        if (heap == NULL) {
             message << "Can not find heap in map";
             throw Memserver_Exception(RBT_HEAP_NOT_FOUND,
                                       message.str().c_str());
         }
     }
 
+    resize_heap(heap, region, nbytes);
+
+    return ALLOC_NO_ERROR;
+}
+
+/*
+ * Resize the heap of a region and record the new size. Called with
+ * resizeLock held. Allocations from the heap go on meanwhile.
+ */
+void Memserver_Allocator::resize_heap(Heap *heap, Fam_Region_Metadata &region,
+                                      size_t nbytes) {
+    ostringstream message;
+    message << "Error while resizing the region";
+
     // Call NVMM to resize the heap
-    ret = heap->Resize(nbytes);
+    int ret = heap->Resize(nbytes);
     if (ret != NO_ERROR) {
         message << "heap resize failed";
         throw Memserver_Exception(RESIZE_FAILED, message.str().c_str());
     }
 
+    uint64_t oldSize = region.size;
     region.size = nbytes;
     // Update the size in the metadata service
-    ret = metadataManager->metadata_modify_region(regionId, &region);
+    ret = metadataManager->metadata_modify_region(region.regionId, &region);
     if (ret != META_NO_ERROR) {
         message << "Can not modify metadata service, ";
         throw Memserver_Exception(REGION_NOT_MODIFIED, message.str().c_str());
     }
-
-    return ALLOC_NO_ERROR;
+    regionBytes.fetch_add(nbytes - oldSize);
 }
 
 /*
- * Allocate a data item in a region
- * name - name of the data item
- * regionId - Region id of the region in which data item to be allocated
- * nbytes - size of the data item
- * offset - offset of data item in the region
- * dataitem - dataitem descriptor
- * localpointer - local pointer for dataitem offset
+ * Let a region grow in the background, up to growLimit bytes, whenever its
+ * free space runs low. A growLimit not above the region size stops growth.
  */
-int Memserver_Allocator::allocate(string name, uint64_t regionId, size_t nbytes,
-                                  uint64_t &offset, mode_t permission,
-                                  uint32_t uid, uint32_t gid,
-                                  Fam_DataItem_Metadata &dataitem,
-                                  void *&localPointer) {
+int Memserver_Allocator::set_region_growth(uint64_t regionId, uint32_t uid,
+                                           uint32_t gid, size_t growLimit) {
     ostringstream message;
-    message << "Error While allocating dataitem : ";
+    message << "Error while setting the growth of the region";
+    std::lock_guard<std::mutex> guard(resizeLock);
+    Fam_Region_Metadata region;
+    int ret = metadataManager->metadata_find_region(regionId, region);
+    if (ret != META_NO_ERROR) {
+        message << "Region does not exist";
+        throw Memserver_Exception(REGION_NOT_FOUND, message.str().c_str());
+    }
 
-    // Check if the name size is bigger than MAX_KEY_LEN supported
-    if (name.size() > metadataManager->metadata_maxkeylen()) {
-        message << "Name too long";
-        throw Memserver_Exception(DATAITEM_NAME_TOO_LONG,
+    bool isPermitted = metadataManager->metadata_check_permissions(
+        &region, META_REGION_ITEM_WRITE, uid, gid);
+    if (!isPermitted) {
+        message << "Region resize not permitted";
+        throw Memserver_Exception(REGION_RESIZE_NOT_PERMITTED,
                                   message.str().c_str());
     }
 
-    size_t tmpSize;
+    region.growLimit = growLimit;
+    ret = metadataManager->metadata_modify_region(regionId, &region);
+    if (ret != META_NO_ERROR) {
+        message << "Can not modify metadata service, ";
+        throw Memserver_Exception(REGION_NOT_MODIFIED, message.str().c_str());
+    }
+    return ALLOC_NO_ERROR;
+}
+
+void Memserver_Allocator::set_resize_hook(std::function<void(uint64_t)> hook) {
+    resizeHook = hook;
+}
+
+/*
+ * Check that the region exists and that uid/gid may create data items in it.
+ */
+void Memserver_Allocator::check_allocate_permission(
+    uint64_t regionId, uint32_t uid, uint32_t gid,
+    Fam_Region_Metadata &region) {
+    ostringstream message;
+    message << "Error While allocating dataitem : ";
+
     // Check with metadata service if the region exist, if not return error
-    Fam_Region_Metadata region;
     int ret = metadataManager->metadata_find_region(regionId, region);
     if (ret != META_NO_ERROR) {
         message << "Region does not exist";
@@ -375,58 +676,97 @@ int Memserver_Allocator::allocate(string name, uint64_t regionId, size_t nbytes,
                                       message.str().c_str());
         }
     }
+}
 
-    // Check with metadata service if data item with the requested name
-    // is already exist, if exists return error
-    if (name != "") {
-        ret = metadataManager->metadata_find_dataitem(name, regionId, dataitem);
-        if (ret == META_NO_ERROR) {
-            message << "Dataitem with the name provided already exist";
-            throw Memserver_Exception(DATAITEM_EXIST, message.str().c_str());
-        }
-    }
-
-    // Call NVMM to create a new data item
-    Heap *heap = 0;
+/*
+ * Returns the heap of a region, opening it if it is not open yet.
+ */
+Heap *Memserver_Allocator::find_heap(uint64_t regionId) {
+    ostringstream message;
+    message << "Error While opening heap : ";
+    Heap *heap = get_heap(regionId);
 
-    HeapMap::iterator it = get_heap(regionId, heap);
-    if (it == heapMap->end()) {
-        ret = open_heap(regionId);
+    if (heap == NULL) {
+        int ret = open_heap(regionId);
         if (ret != ALLOC_NO_ERROR) {
             message << "Opening of heap failed";
             throw Memserver_Exception(HEAP_NOT_OPENED, message.str().c_str());
         }
-        it = get_heap(regionId, heap);
-        if (it == heapMap->end()) {
+        heap = get_heap(regionId);
+        if (heap == NULL) {
             message << "Can not find heap in map";
             throw Memserver_Exception(RBT_HEAP_NOT_FOUND,
                                       message.str().c_str());
         }
     }
+    return heap;
+}
+
+/*
+ * Allocate one data item from an open heap and register it with the metadata
+ * service. The region permission must already have been checked.
+ */
+void Memserver_Allocator::allocate_dataitem(Heap *heap, string name,
+                                            uint64_t regionId, size_t nbytes,
+                                            uint64_t &offset, mode_t permission,
+                                            uint32_t uid, uint32_t gid,
+                                            Fam_DataItem_Metadata &dataitem,
+                                            void *&localPointer) {
+    ostringstream message;
+    message << "Error While allocating dataitem : ";
+
+    // Check if the name size is bigger than MAX_KEY_LEN supported
+    if (name.size() > metadataManager->metadata_maxkeylen()) {
+        message << "Name too long";
+        throw Memserver_Exception(DATAITEM_NAME_TOO_LONG,
+                                  message.str().c_str());
+    }
+
+    // Check with metadata service if data item with the requested name
+    // is already exist, if exists return error
+    int ret;
+    if (name != "") {
+        ret = metadataManager->metadata_find_dataitem(name, regionId, dataitem);
+        if (ret == META_NO_ERROR) {
+            message << "Dataitem with the name provided already exist";
+            throw Memserver_Exception(DATAITEM_EXIST, message.str().c_str());
+        }
+    }
 
     // If the requested siz is lessar than MIN_OBJ_SIZE,
     // allocate data item of size MIN_OBJ_SIZE
+    size_t tmpSize;
     if (nbytes < MIN_OBJ_SIZE)
         tmpSize = MIN_OBJ_SIZE;
     else
         tmpSize = nbytes;
 
-    offset = heap->AllocOffset(tmpSize);
-    if (!offset) {
-        try {
-            heap->Merge();
-        } catch (...) {
-            message << "Heap Merge() failed";
-            throw Memserver_Exception(HEAP_MERGE_FAILED, message.str().c_str());
-        }
+    offset = 0;
+    if (tmpSize <= slabMaxObjSize) {
+        Memserver_Slab *slab = get_slab(regionId, heap);
+        if (slab)
+            offset = slab->alloc(tmpSize);
+    }
+    // Larger data items, or a slab without room, come from the heap itself
+    if (!offset)
         offset = heap->AllocOffset(tmpSize);
-        if (!offset) {
-            message << "alloc() failed";
-            throw Memserver_Exception(HEAP_ALLOCATE_FAILED,
-                                      message.str().c_str());
-        }
+    // Free space is merged in the background. Only if some was freed since
+    // the last merge can another one help, and then it is waited for.
+    if (!offset && wait_for_merge(regionId))
+        offset = heap->AllocOffset(tmpSize);
+    // A region with a growth limit is grown as long as that helps
+    while (!offset && wait_for_growth(regionId, tmpSize))
+        offset = heap->AllocOffset(tmpSize);
+    if (!offset) {
+        message << "alloc() failed";
+        throw Memserver_Exception(HEAP_ALLOCATE_FAILED, message.str().c_str());
     }
 
+    // Counted before the data item is registered, as free_offset() takes it
+    // off again if that fails
+    if (regionId < ShelfId::kMaxPoolCount)
+        usedBytes[regionId].fetch_add(tmpSize);
+
     // Register the data item with metadata service
     localPointer = heap->OffsetToLocal(offset);
     uint64_t dataitemId = offset / MIN_OBJ_SIZE;
@@ -445,19 +785,97 @@ int Memserver_Allocator::allocate(string name, uint64_t regionId, size_t nbytes,
                                                         &dataitem, name);
     if (ret != META_NO_ERROR) {
         message << "Can not insert dataitem into metadata service";
-        heap->Free(offset);
+        free_offset(heap, regionId, offset, tmpSize);
         throw Memserver_Exception(DATAITEM_NOT_INSERTED, message.str().c_str());
     }
+}
+
+/*
+ * Allocate a data item in a region
+ * name - name of the data item
+ * regionId - Region id of the region in which data item to be allocated
+ * nbytes - size of the data item
+ * offset - offset of data item in the region
+ * dataitem - dataitem descriptor
+ * localpointer - local pointer for dataitem offset
+ */
+int Memserver_Allocator::allocate(string name, uint64_t regionId, size_t nbytes,
+                                  uint64_t &offset, mode_t permission,
+                                  uint32_t uid, uint32_t gid,
+                                  Fam_DataItem_Metadata &dataitem,
+                                  void *&localPointer) {
+    Fam_Region_Metadata region;
+    check_allocate_permission(regionId, uid, gid, region);
+
+    // Call NVMM to create a new data item
+    Heap *heap = find_heap(regionId);
+
+    allocate_dataitem(heap, name, regionId, nbytes, offset, permission, uid,
+                      gid, dataitem, localPointer);
+    check_growth(region);
 
     return ALLOC_NO_ERROR;
 }
 
 /*
- *
- * Deallocates a dataitem in a region at the given offset.
+ * Allocate a batch of data items in a region. The region is looked up and
+ * its heap is opened once for the whole batch. Either all data items are
+ * allocated, or none: on failure the ones already allocated are released.
+ * names - names of the data items ("" for unnamed ones)
+ * sizes - sizes of the data items
+ * dataitems, localPointers - filled in for each data item
  */
-int Memserver_Allocator::deallocate(uint64_t regionId, uint64_t offset,
-                                    uint32_t uid, uint32_t gid) {
+int Memserver_Allocator::allocate_batch(
+    const vector<string> &names, uint64_t regionId,
+    const vector<size_t> &sizes, mode_t permission, uint32_t uid, uint32_t gid,
+    vector<Fam_DataItem_Metadata> &dataitems, vector<void *> &localPointers) {
+    ostringstream message;
+    message << "Error While allocating dataitems : ";
+    if (names.size() != sizes.size()) {
+        message << "Number of names and sizes do not match";
+        throw Memserver_Exception(INVALID_ARGUMENT, message.str().c_str());
+    }
+
+    Fam_Region_Metadata region;
+    check_allocate_permission(regionId, uid, gid, region);
+
+    Heap *heap = find_heap(regionId);
+
+    dataitems.resize(names.size());
+    localPointers.resize(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        uint64_t offset;
+        try {
+            allocate_dataitem(heap, names[i], regionId, sizes[i], offset,
+                              permission, uid, gid, dataitems[i],
+                              localPointers[i]);
+        } catch (Memserver_Exception &e) {
+            // Freed with the size allocate_dataitem() allocated and counted
+            for (size_t j = 0; j < i; j++) {
+                uint64_t size =
+                    std::max(dataitems[j].size, (uint64_t)MIN_OBJ_SIZE);
+                metadataManager->metadata_delete_dataitem(
+                    dataitems[j].offset / MIN_OBJ_SIZE, regionId);
+                free_offset(heap, regionId, dataitems[j].offset, size);
+            }
+            dataitems.clear();
+            localPointers.clear();
+            throw;
+        }
+    }
+    check_growth(region);
+
+    return ALLOC_NO_ERROR;
+}
+
+/*
+ * Check that the data item exists and that uid/gid may deallocate it.
+ * Returns the size of the data item.
+ */
+uint64_t Memserver_Allocator::check_deallocate_permission(uint64_t regionId,
+                                                          uint64_t offset,
+                                                          uint32_t uid,
+                                                          uint32_t gid) {
     ostringstream message;
     message << "Error While deallocating dataitem : ";
     // Check with metadata service if data item with the requested name
@@ -483,34 +901,315 @@ int Memserver_Allocator::deallocate(uint64_t regionId, uint64_t offset,
                                       message.str().c_str());
         }
     }
+    return dataitem.size;
+}
+
+/*
+ * Remove a data item from the metadata service and free it in the heap.
+ */
+void Memserver_Allocator::deallocate_dataitem(Heap *heap, uint64_t regionId,
+                                              uint64_t offset,
+                                              uint64_t nbytes) {
+    ostringstream message;
+    message << "Error While deallocating dataitem : ";
+    uint64_t dataitemId = offset / MIN_OBJ_SIZE;
 
     // Remove data item from metadata service
-    ret = metadataManager->metadata_delete_dataitem(dataitemId, regionId);
+    int ret = metadataManager->metadata_delete_dataitem(dataitemId, regionId);
     if (ret != META_NO_ERROR) {
         message << "Can not remove dataitem from metadata service";
         throw Memserver_Exception(DATAITEM_NOT_REMOVED, message.str().c_str());
     }
     // call NVMM to destroy the data item
-    Heap *heap = 0;
+    free_offset(heap, regionId, offset, nbytes);
+}
 
-    HeapMap::iterator it = get_heap(regionId, heap);
-    if (it != heapMap->end()) {
-        heap->Free(offset);
-    } else {
-        // Heap not found in map. Get the heap from NVMM
-        ret = open_heap(regionId);
-        if (ret != ALLOC_NO_ERROR) {
-            message << "Opening of heap failed";
-            throw Memserver_Exception(HEAP_NOT_OPENED, message.str().c_str());
+/*
+ * Release the space of a data item to the slab it came from, or to the heap.
+ * A burst of frees to the heap starts a background merge at once.
+ */
+void Memserver_Allocator::free_offset(Heap *heap, uint64_t regionId,
+                                      uint64_t offset, uint64_t nbytes) {
+    release_used(regionId, std::max(nbytes, (uint64_t)MIN_OBJ_SIZE));
+    Memserver_Slab *slab = get_slab(regionId, heap);
+    if (slab && slab->free(offset))
+        return;
+
+    heap->Free(offset);
+    if (regionId >= ShelfId::kMaxPoolCount)
+        return;
+    uint64_t freed = freedBytes[regionId].fetch_add(nbytes) + nbytes;
+    if ((freed >= MEMSERVER_MERGE_BURST) &&
+        (freed - nbytes < MEMSERVER_MERGE_BURST)) {
+        std::lock_guard<std::mutex> guard(mergeLock);
+        (void)request_pass(regionId);
+    }
+}
+
+/*
+ * Merge the free lists of heaps in the background: every interval those
+ * with at least MEMSERVER_MERGE_THRESHOLD bytes freed since their last
+ * merge, and at once when a burst of frees or a failed allocation asks for
+ * it. Each pass then grows the regions asking for it.
+ */
+void Memserver_Allocator::run_merger() {
+    std::unique_lock<std::mutex> guard(mergeLock);
+    while (true) {
+        // A request posted during the last pass is served at once
+        mergeCond.wait_for(
+            guard, std::chrono::milliseconds(MEMSERVER_MERGE_INTERVAL_MS),
+            [this] { return mergeStop || (mergeRequested != mergeDone); });
+        if (mergeStop)
+            break;
+        uint64_t requested = mergeRequested;
+        std::set<uint64_t> regions;
+        regions.swap(mergeRegions);
+        guard.unlock();
+
+        merge_heaps(regions);
+        grow_regions();
+
+        guard.lock();
+        mergeDone = requested;
+        mergeDoneCond.notify_all();
+    }
+}
+
+/*
+ * Merge the heaps with at least MEMSERVER_MERGE_THRESHOLD bytes freed, and
+ * those of regions with any freed space.
+ */
+void Memserver_Allocator::merge_heaps(const std::set<uint64_t> &regions) {
+    for (uint64_t regionId = 0; regionId < ShelfId::kMaxPoolCount;
+         regionId++) {
+        uint64_t freed = freedBytes[regionId].load();
+        if (!freed || ((freed < MEMSERVER_MERGE_THRESHOLD) &&
+                       (regions.find(regionId) == regions.end())))
+            continue;
+
+        Heap *heap = hold_heap(regionId);
+        if (!heap)
+            continue;
+        // What is freed during the merge is left for the next one
+        freedBytes[regionId].fetch_sub(freed);
+        try {
+            heap->Merge();
+        } catch (...) {
+            // Counted again for the next pass to retry; an allocation
+            // waiting for this one fails with HEAP_ALLOCATE_FAILED
+            freedBytes[regionId].fetch_add(freed);
         }
-        it = get_heap(regionId, heap);
-        if (it == heapMap->end()) {
-            message << "Can not find heap in map";
-            throw Memserver_Exception(RBT_HEAP_NOT_FOUND,
-                                      message.str().c_str());
+        release_heap();
+    }
+}
+
+/*
+ * Have the merger run a pass that merges the heap of a region, and wait for
+ * it. Returns false at once if nothing was freed in the region since its
+ * last merge, as merging could not help then.
+ */
+bool Memserver_Allocator::wait_for_merge(uint64_t regionId) {
+    if ((regionId >= ShelfId::kMaxPoolCount) ||
+        (freedBytes[regionId].load() == 0))
+        return false;
+
+    wait_for_pass(regionId);
+    return true;
+}
+
+/*
+ * Post a request for a pass of the merger, also merging the heap of
+ * mergeRegionId if that is a region id. Called with mergeLock held; returns
+ * the ticket that mergeDone reaches once the pass is complete.
+ */
+uint64_t Memserver_Allocator::request_pass(uint64_t mergeRegionId) {
+    if (mergeRegionId < ShelfId::kMaxPoolCount)
+        mergeRegions.insert(mergeRegionId);
+    mergeCond.notify_one();
+    return ++mergeRequested;
+}
+
+/*
+ * Have the merger run a pass at once and wait for it to complete.
+ */
+void Memserver_Allocator::wait_for_pass(uint64_t mergeRegionId) {
+    std::unique_lock<std::mutex> guard(mergeLock);
+    if (mergeStop)
+        return;
+    uint64_t ticket = request_pass(mergeRegionId);
+    mergeDoneCond.wait(guard,
+                       [&] { return mergeStop || (mergeDone >= ticket); });
+}
+
+/*
+ * Ask for a region with a growth limit to be grown once its free space falls
+ * below the watermark. Only the first request since the last growth wakes
+ * the merger; the allocation goes on without waiting for it.
+ */
+void Memserver_Allocator::check_growth(Fam_Region_Metadata &region) {
+    if ((region.growLimit <= region.size) ||
+        (region.regionId >= ShelfId::kMaxPoolCount))
+        return;
+    uint64_t used = usedBytes[region.regionId].load();
+    if ((used < region.size) &&
+        (region.size - used >= region.size / MEMSERVER_GROW_WATERMARK))
+        return;
+    if (growRequest[region.regionId].fetch_add(1) == 0) {
+        std::lock_guard<std::mutex> guard(mergeLock);
+        (void)request_pass();
+    }
+}
+
+/*
+ * Grow a region by at least nbytes, within its growth limit, and wait for
+ * it. Returns false if the region cannot grow, or did not.
+ */
+bool Memserver_Allocator::wait_for_growth(uint64_t regionId, uint64_t nbytes) {
+    Fam_Region_Metadata region;
+    if ((regionId >= ShelfId::kMaxPoolCount) ||
+        (metadataManager->metadata_find_region(regionId, region) !=
+         META_NO_ERROR) ||
+        (region.growLimit <= region.size))
+        return false;
+
+    uint64_t oldSize = region.size;
+    growRequest[regionId].fetch_add(nbytes);
+    wait_for_pass();
+    return (metadataManager->metadata_find_region(regionId, region) ==
+            META_NO_ERROR) &&
+           (region.size > oldSize);
+}
+
+/*
+ * Grow the regions asked for, each to twice its size or by the bytes asked
+ * for if that is more, within its growth limit. Holding the heap keeps the
+ * region from being destroyed meanwhile, without keeping other regions from
+ * being created or destroyed; allocations from its heap go on, as they look
+ * it up without locking.
+ */
+void Memserver_Allocator::grow_regions() {
+    for (uint64_t regionId = 0; regionId < ShelfId::kMaxPoolCount;
+         regionId++) {
+        uint64_t requested = growRequest[regionId].exchange(0);
+        if (requested == 0)
+            continue;
+
+        bool grown = false;
+        {
+            std::lock_guard<std::mutex> guard(resizeLock);
+            Fam_Region_Metadata region;
+            if ((metadataManager->metadata_find_region(regionId, region) !=
+                 META_NO_ERROR) ||
+                (region.growLimit <= region.size))
+                continue;
+            uint64_t nbytes =
+                std::max(region.size * 2, region.size + requested);
+            if (nbytes > region.growLimit)
+                nbytes = region.growLimit;
+
+            Heap *heap = hold_heap(regionId);
+            if (!heap)
+                continue;
+            try {
+                resize_heap(heap, region, nbytes);
+                grown = true;
+            } catch (Memserver_Exception &e) {
+                // The region keeps its size; an allocation waiting for the
+                // growth then fails with HEAP_ALLOCATE_FAILED
+            }
+            release_heap();
         }
-        heap->Free(offset);
+
+        if (grown && resizeHook)
+            resizeHook(regionId);
     }
+}
+
+/*
+ * Take nbytes off the bytes used in a region. What was allocated before its
+ * heap was opened is not counted, so the count stops at 0.
+ */
+void Memserver_Allocator::release_used(uint64_t regionId, uint64_t nbytes) {
+    if (regionId >= ShelfId::kMaxPoolCount)
+        return;
+    uint64_t used = usedBytes[regionId].load();
+    while (!usedBytes[regionId].compare_exchange_weak(
+        used, (used > nbytes) ? used - nbytes : 0))
+        ;
+}
+
+void Memserver_Allocator::stop_merger() {
+    {
+        std::lock_guard<std::mutex> guard(mergeLock);
+        mergeStop = true;
+    }
+    mergeCond.notify_all();
+    mergeDoneCond.notify_all();
+    if (merger.joinable())
+        merger.join();
+}
+
+/*
+ * Returns the slabs of a region, loading them from the heap on first use.
+ * A region created without slabs gets an empty Memserver_Slab, so that the
+ * metadata is only looked up once.
+ */
+Memserver_Slab *Memserver_Allocator::get_slab(uint64_t regionId, Heap *heap) {
+    if (regionId >= ShelfId::kMaxPoolCount)
+        return NULL;
+    Memserver_Slab *slab = slabMap[regionId].load(boost::memory_order_acquire);
+    if (slab)
+        return slab;
+
+    Fam_Region_Metadata region;
+    if (metadataManager->metadata_find_region(regionId, region) !=
+        META_NO_ERROR)
+        return NULL;
+
+    pthread_mutex_lock(&slabMapLock);
+    slab = slabMap[regionId].load();
+    if (!slab) {
+        slab = new Memserver_Slab(heap, region.slabRoot, MIN_OBJ_SIZE,
+                                  slabMaxObjSize);
+        slabMap[regionId].store(slab, boost::memory_order_release);
+    }
+    pthread_mutex_unlock(&slabMapLock);
+    return slab;
+}
+
+/*
+ *
+ * Deallocates a dataitem in a region at the given offset.
+ */
+int Memserver_Allocator::deallocate(uint64_t regionId, uint64_t offset,
+                                    uint32_t uid, uint32_t gid) {
+    uint64_t nbytes = check_deallocate_permission(regionId, offset, uid, gid);
+
+    Heap *heap = find_heap(regionId);
+
+    deallocate_dataitem(heap, regionId, offset, nbytes);
+
+    return ALLOC_NO_ERROR;
+}
+
+/*
+ * Deallocates a batch of data items of one region. Every data item is
+ * checked before any of them is removed, so a missing data item or a
+ * permission error leaves the whole batch allocated.
+ */
+int Memserver_Allocator::deallocate_batch(uint64_t regionId,
+                                          const vector<uint64_t> &offsets,
+                                          uint32_t uid, uint32_t gid) {
+    vector<uint64_t> sizes;
+    for (auto offset : offsets)
+        sizes.push_back(
+            check_deallocate_permission(regionId, offset, uid, gid));
+
+    Heap *heap = find_heap(regionId);
+
+    for (size_t i = 0; i < offsets.size(); i++)
+        deallocate_dataitem(heap, regionId, offsets[i], sizes[i]);
+
     return ALLOC_NO_ERROR;
 }
 
@@ -522,6 +1221,8 @@ int Memserver_Allocator::change_region_permission(uint64_t regionId,
                                                   uint32_t uid, uint32_t gid) {
     ostringstream message;
     message << "Error While changing region permission : ";
+    // Not to be lost to a resize writing back the metadata it read before
+    std::lock_guard<std::mutex> guard(resizeLock);
     // Check with metadata service if region with the requested Id
     // is already exist, if not return error
     Fam_Region_Metadata region;
@@ -670,6 +1371,32 @@ int Memserver_Allocator::get_dataitem(uint64_t regionId, uint64_t offset,
     return ALLOC_NO_ERROR;
 }
 
+/*
+ * dataitem lookup of several names in one region. The region is looked up
+ * only once; permissions are checked by the caller, as for get_dataitem.
+ */
+int Memserver_Allocator::get_dataitem_batch(
+    const vector<string> &itemNames, string regionName, uint32_t uid,
+    uint32_t gid, vector<Fam_DataItem_Metadata> &dataitems) {
+    ostringstream message;
+    message << "Error While locating dataitem : ";
+    Fam_Region_Metadata region;
+    get_region(regionName, uid, gid, region);
+
+    dataitems.resize(itemNames.size());
+    for (size_t i = 0; i < itemNames.size(); i++) {
+        int ret = metadataManager->metadata_find_dataitem(
+            itemNames[i], region.regionId, dataitems[i]);
+        if (ret != META_NO_ERROR) {
+            message << "could not find the dataitem " << itemNames[i];
+            throw Memserver_Exception(DATAITEM_NOT_FOUND,
+                                      message.str().c_str());
+        }
+    }
+
+    return ALLOC_NO_ERROR;
+}
+
 /*
  * Check if the given uid/gid has read or rw permissions for
  * a given dataitem.
@@ -691,18 +1418,17 @@ void *Memserver_Allocator::get_local_pointer(uint64_t regionId,
                                              uint64_t offset) {
     ostringstream message;
     message << "Error While getting localpointer to dataitem : ";
-    Heap *heap = 0;
+    Heap *heap = get_heap(regionId);
     int ret;
 
-    HeapMap::iterator it = get_heap(regionId, heap);
-    if (it == heapMap->end()) {
+    if (heap == NULL) {
         ret = open_heap(regionId);
         if (ret != ALLOC_NO_ERROR) {
             message << "Opening of heap failed";
             throw Memserver_Exception(HEAP_NOT_OPENED, message.str().c_str());
         }
-        it = get_heap(regionId, heap);
-        if (it == heapMap->end()) {
+        heap = get_heap(regionId);
+        if (heap == NULL) {
             message << "Can not find heap in map";
             throw Memserver_Exception(NO_LOCAL_POINTER, message.str().c_str());
         }
@@ -716,9 +1442,7 @@ int Memserver_Allocator::open_heap(uint64_t regionId) {
     Heap *heap = 0;
 
     // Check if the heap is already open
-
-    get_heap(regionId, heap);
-    if (heap == NULL) {
+    if (get_heap(regionId) == NULL) {
 
         // Heap is not open, open it now
         int ret = memoryManager->FindHeap((PoolId)regionId, &heap);
@@ -730,52 +1454,47 @@ int Memserver_Allocator::open_heap(uint64_t regionId) {
         }
         heap->Open();
 
-        pthread_mutex_lock(&heapMapLock);
-
         // Heap opened now, Add this into map for future references.
-        auto heapObj = heapMap->find(regionId);
-        if (heapObj == heapMap->end()) {
-            heapMap->insert({regionId, heap});
-        } else {
-            message << "Can not insert heap. regionId already found in map";
-            pthread_mutex_unlock(&heapMapLock);
+        // If another thread opened it meanwhile, that heap is used instead.
+        if (!insert_heap(regionId, heap)) {
             heap->Close();
             delete heap;
-            throw Memserver_Exception(RBT_HEAP_NOT_INSERTED,
-                                      message.str().c_str());
+        } else {
+            // What was freed before the heap was opened is not known, so
+            // have the next background pass merge it
+            freedBytes[regionId].store(MEMSERVER_MERGE_THRESHOLD);
         }
 
-        pthread_mutex_unlock(&heapMapLock);
-
         return ALLOC_NO_ERROR;
     }
     return ALLOC_NO_ERROR;
 }
 
-int Memserver_Allocator::copy(uint64_t regionId, uint64_t srcOffset,
-                              uint64_t srcCopyStart, uint64_t destOffset,
-                              uint64_t destCopyStart, uint32_t uid,
-                              uint32_t gid, size_t nbytes) {
+int Memserver_Allocator::copy(uint64_t srcRegionId, uint64_t srcOffset,
+                              uint64_t srcCopyStart, uint64_t destRegionId,
+                              uint64_t destOffset, uint64_t destCopyStart,
+                              uint32_t uid, uint32_t gid, size_t nbytes,
+                              boost::atomic_uint64_t *progress) {
     ostringstream message;
     message << "Error While copying from dataitem : ";
-    Fam_DataItem_Metadata srcDataitem;
     Fam_DataItem_Metadata destDataitem;
     void *srcStart;
     void *destStart;
 
-    get_dataitem(regionId, srcOffset, uid, gid, srcDataitem);
+    srcStart = get_copy_source(srcRegionId, srcOffset, srcCopyStart, uid, gid,
+                               nbytes);
 
-    get_dataitem(regionId, destOffset, uid, gid, destDataitem);
+    get_dataitem(destRegionId, destOffset, uid, gid, destDataitem);
 
-    if ((srcCopyStart + nbytes) < srcDataitem.size)
-        srcStart = get_local_pointer(regionId, srcOffset + srcCopyStart);
-    else {
-        message << "Source offset or size is beyond dataitem boundary";
-        throw Memserver_Exception(OUT_OF_RANGE, message.str().c_str());
+    // The destination may be an existing data item owned by someone else, so
+    // both ends are checked rather than trusting the client.
+    if (!check_dataitem_permission(destDataitem, 1, uid, gid)) {
+        message << "Not permitted to write into destination dataitem";
+        throw Memserver_Exception(NO_PERMISSION, message.str().c_str());
     }
 
-    if ((destCopyStart + nbytes) < destDataitem.size)
-        destStart = get_local_pointer(regionId, destOffset + destCopyStart);
+    if ((destCopyStart + nbytes) <= destDataitem.size)
+        destStart = get_local_pointer(destRegionId, destOffset + destCopyStart);
     else {
         message << "Destination offset or size is beyond dataitem boundary";
         throw Memserver_Exception(OUT_OF_RANGE, message.str().c_str());
@@ -786,23 +1505,106 @@ int Memserver_Allocator::copy(uint64_t regionId, uint64_t srcOffset,
             << "Failed to get local pointer to source or destination dataitem";
         throw Memserver_Exception(NULL_POINTER_ACCESS, message.str().c_str());
     } else {
-        fam_memcpy(destStart, srcStart, nbytes);
+        copyPool->copy(destStart, srcStart, nbytes, progress);
         return ALLOC_NO_ERROR;
     }
 }
 
-HeapMap::iterator Memserver_Allocator::get_heap(uint64_t regionId,
-                                                Heap *&heap) {
+/*
+ * Check that the caller may read nbytes from srcCopyStart in the source data
+ * item and return the local address of that range. Used on its own when the
+ * destination lives on another memory server and is written over the fabric.
+ */
+void *Memserver_Allocator::get_copy_source(uint64_t srcRegionId,
+                                           uint64_t srcOffset,
+                                           uint64_t srcCopyStart, uint32_t uid,
+                                           uint32_t gid, size_t nbytes) {
+    ostringstream message;
+    message << "Error While copying from dataitem : ";
+    Fam_DataItem_Metadata srcDataitem;
+    void *srcStart;
+
+    get_dataitem(srcRegionId, srcOffset, uid, gid, srcDataitem);
+
+    if (!check_dataitem_permission(srcDataitem, 0, uid, gid)) {
+        message << "Not permitted to read from source dataitem";
+        throw Memserver_Exception(NO_PERMISSION, message.str().c_str());
+    }
+
+    if ((srcCopyStart + nbytes) <= srcDataitem.size)
+        srcStart = get_local_pointer(srcRegionId, srcOffset + srcCopyStart);
+    else {
+        message << "Source offset or size is beyond dataitem boundary";
+        throw Memserver_Exception(OUT_OF_RANGE, message.str().c_str());
+    }
+
+    if (srcStart == NULL) {
+        message << "Failed to get local pointer to source dataitem";
+        throw Memserver_Exception(NULL_POINTER_ACCESS, message.str().c_str());
+    }
+    return srcStart;
+}
+
+/*
+ * Returns the open heap of a region, or NULL. Region ids come from the pool
+ * id bitmap, so any other id simply has no heap.
+ */
+Heap *Memserver_Allocator::get_heap(uint64_t regionId) {
+    if (regionId >= ShelfId::kMaxPoolCount)
+        return NULL;
+    return heapMap[regionId].load(boost::memory_order_acquire);
+}
+
+/*
+ * Publish the open heap of a region. Returns false if the region has a heap
+ * already.
+ */
+bool Memserver_Allocator::insert_heap(uint64_t regionId, Heap *heap) {
+    if (regionId >= ShelfId::kMaxPoolCount)
+        return false;
+
     pthread_mutex_lock(&heapMapLock);
+    bool inserted = (heapMap[regionId].load() == NULL);
+    if (inserted)
+        heapMap[regionId].store(heap, boost::memory_order_release);
+    pthread_mutex_unlock(&heapMapLock);
+    return inserted;
+}
+
+/*
+ * Unpublish the heap of a region and return it, or NULL if it had none.
+ */
+Heap *Memserver_Allocator::remove_heap(uint64_t regionId) {
+    if (regionId >= ShelfId::kMaxPoolCount)
+        return NULL;
 
-    auto heapObj = heapMap->find(regionId);
-    if (heapObj != heapMap->end()) {
-        heap = heapObj->second;
+    pthread_mutex_lock(&heapMapLock);
+    Heap *heap = heapMap[regionId].exchange(NULL);
+    pthread_mutex_unlock(&heapMapLock);
+    // Wait for the merger to be done with the heap
+    if (heap) {
+        heapHoldLock.lock();
+        heapHoldLock.unlock();
     }
+    return heap;
+}
+
+/*
+ * Returns the open heap of a region, or NULL, for the merger to work on
+ * without holding heapMapLock. Until release_heap(), the region cannot be
+ * destroyed, as remove_heap() waits for it.
+ */
+Heap *Memserver_Allocator::hold_heap(uint64_t regionId) {
+    pthread_mutex_lock(&heapMapLock);
+    Heap *heap = heapMap[regionId].load();
+    if (heap)
+        heapHoldLock.lock();
     pthread_mutex_unlock(&heapMapLock);
-    return heapObj;
+    return heap;
 }
 
+void Memserver_Allocator::release_heap() { heapHoldLock.unlock(); }
+
 /*
  * Allocate the first free region id to be allocated.
  */
@@ -818,4 +1620,47 @@ PoolId Memserver_Allocator::get_free_poolId() {
     return (PoolId)freePoolId;
 }
 
+/*
+ * Apply fam_map() hints (Fam_Map_Flags) to the pages backing a data item.
+ * The shelf is already mapped by NVMM, so the hints are given with madvise.
+ * They are advisory only; failures, e.g. when transparent huge pages are
+ * disabled, leave the mapping as it is.
+ */
+void Memserver_Allocator::advise_mapping(void *localPointer, size_t nbytes,
+                                         uint32_t mapFlags, bool writable) {
+    if ((mapFlags == FAM_MAP_DEFAULT) || (localPointer == NULL) ||
+        (nbytes == 0))
+        return;
+
+    uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t start = (uint64_t)localPointer & ~(pageSize - 1);
+    uint64_t end = ((uint64_t)localPointer + nbytes + pageSize - 1) &
+                   ~(pageSize - 1);
+    void *addr = (void *)start;
+    size_t len = (size_t)(end - start);
+
+#ifdef MADV_HUGEPAGE
+    if (mapFlags & FAM_MAP_HUGEPAGE)
+        (void)madvise(addr, len, MADV_HUGEPAGE);
+#endif
+
+    if (mapFlags & FAM_MAP_SEQUENTIAL)
+        (void)madvise(addr, len, MADV_SEQUENTIAL);
+    else if (mapFlags & FAM_MAP_RANDOM)
+        (void)madvise(addr, len, MADV_RANDOM);
+
+    if (mapFlags & FAM_MAP_PREFAULT) {
+#if defined(MADV_POPULATE_READ) && defined(MADV_POPULATE_WRITE)
+        if (madvise(addr, len,
+                    writable ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0)
+            return;
+#endif
+        // Older kernels: start readahead, then touch every page
+        (void)madvise(addr, len, MADV_WILLNEED);
+        volatile char *page = (volatile char *)addr;
+        for (uint64_t off = 0; off < len; off += pageSize)
+            (void)page[off];
+    }
+}
+
 } // namespace openfam
@@ -30,10 +30,23 @@
 #ifndef MEMSERVER_ALLOCATOR_H_
 #define MEMSERVER_ALLOCATOR_H_
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <pthread.h>
+#include <set>
+#include <sys/mman.h>
 #include <sys/types.h> // needed for mode_t
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
+#include <boost/atomic.hpp>
 #include <nvmm/error_code.h>
 #include <nvmm/global_ptr.h>
 #include <nvmm/heap.h>
@@ -41,6 +54,8 @@
 #include <nvmm/memory_manager.h>
 #include <nvmm/shelf_id.h>
 
+#include "allocator/memserver_copy_pool.h"
+#include "allocator/memserver_slab.h"
 #include "bitmap-manager/bitmap.h"
 #include "common/fam_internal.h"
 #include "common/memserver_exception.h"
@@ -49,6 +64,23 @@
 
 #define MIN_OBJ_SIZE 128
 #define MIN_REGION_SIZE (1UL << 20)
+// Interval of the background merge of heap free lists
+#define MEMSERVER_MERGE_INTERVAL_MS 1000
+// Bytes freed in a region since its last merge that make the next
+// background pass merge its heap
+#define MEMSERVER_MERGE_THRESHOLD (1UL << 20)
+// Bytes freed in a region that start a background pass at once
+#define MEMSERVER_MERGE_BURST (64UL << 20)
+// Number of distinct region sizes the warm heap pool keeps heaps of
+#define MEMSERVER_WARM_HEAP_SIZES 4
+// The warm heap pool takes at most 1/MEMSERVER_WARM_HEAP_SHARE of the
+// capacity not used by regions, or MEMSERVER_WARM_HEAP_MAX_BYTES if the
+// capacity is not limited
+#define MEMSERVER_WARM_HEAP_SHARE 4
+#define MEMSERVER_WARM_HEAP_MAX_BYTES (4UL << 30)
+// A region with a growth limit is grown in the background once its free
+// space falls below 1/MEMSERVER_GROW_WATERMARK of its size
+#define MEMSERVER_GROW_WATERMARK 8
 
 using namespace std;
 using namespace nvmm;
@@ -56,24 +88,46 @@ using namespace metadata;
 
 namespace openfam {
 
-using HeapMap = std::map<uint64_t, Heap *>;
-
 class Memserver_Allocator {
   public:
-    Memserver_Allocator();
+    // numCopyThreads - threads helping the caller of copy(); with none the
+    // caller copies alone
+    // slabMaxObjSize - data items up to this size are served from per-region
+    // slabs; 0 allocates every data item from the NVMM heap
+    // numWarmHeaps - heaps created ahead for each of the region sizes most
+    // recently asked for, with destroyed heaps reclaimed in the background;
+    // 0 creates and destroys every heap on the request
+    // capacity - bytes offered to regions, reported to clients placing
+    // regions by free space; 0 if not limited
+    Memserver_Allocator(uint64_t numCopyThreads = 0,
+                        uint64_t slabMaxObjSize = 0,
+                        uint64_t numWarmHeaps = 0, uint64_t capacity = 0);
     ~Memserver_Allocator();
     void memserver_allocator_finalize();
     int create_region(string name, uint64_t &regionId, size_t nbytes,
-                      mode_t permission, uint32_t uid, uint32_t gid);
+                      mode_t permission, uint32_t uid, uint32_t gid,
+                      Fam_Stripe_Layout layout = {0, 1, 0, NONE});
     int destroy_region(uint64_t regionId, uint32_t uid, uint32_t gid);
     int resize_region(uint64_t regionId, uint32_t uid, uint32_t gid,
                       size_t nbytes);
+    int set_region_growth(uint64_t regionId, uint32_t uid, uint32_t gid,
+                          size_t growLimit);
+    // hook - called with the region id after a region is grown in the
+    // background
+    void set_resize_hook(std::function<void(uint64_t)> hook);
     int allocate(string name, uint64_t regionId, size_t nbytes,
                  uint64_t &offset, mode_t permission, uint32_t uid,
                  uint32_t gid, Fam_DataItem_Metadata &dataitem,
                  void *&localPointer);
     int deallocate(uint64_t regionId, uint64_t offset, uint32_t uid,
                    uint32_t gid);
+    int allocate_batch(const vector<string> &names, uint64_t regionId,
+                       const vector<size_t> &sizes, mode_t permission,
+                       uint32_t uid, uint32_t gid,
+                       vector<Fam_DataItem_Metadata> &dataitems,
+                       vector<void *> &localPointers);
+    int deallocate_batch(uint64_t regionId, const vector<uint64_t> &offsets,
+                         uint32_t uid, uint32_t gid);
     int change_region_permission(uint64_t regionId, mode_t permission,
                                  uint32_t uid, uint32_t gid);
     int change_dataitem_permission(uint64_t regionId, uint64_t offset,
@@ -89,23 +143,118 @@ class Memserver_Allocator {
                      uint32_t gid, Fam_DataItem_Metadata &dataitem);
     int get_dataitem(uint64_t regionId, uint64_t offset, uint32_t uid,
                      uint32_t gid, Fam_DataItem_Metadata &dataitem);
+    int get_dataitem_batch(const vector<string> &itemNames, string regionName,
+                           uint32_t uid, uint32_t gid,
+                           vector<Fam_DataItem_Metadata> &dataitems);
     bool check_dataitem_permission(Fam_DataItem_Metadata dataitem, bool op,
                                    uint32_t uid, uint32_t gid);
     void *get_local_pointer(uint64_t regionId, uint64_t offset);
     int open_heap(uint64_t regionId);
-    int copy(uint64_t regionId, uint64_t srcOffset, uint64_t srcCopyStart,
-             uint64_t destOffset, uint64_t destCopyStart, uint32_t uid,
-             uint32_t gid, size_t nbytes);
+    void advise_mapping(void *localPointer, size_t nbytes, uint32_t mapFlags,
+                        bool writable);
+    int copy(uint64_t srcRegionId, uint64_t srcOffset, uint64_t srcCopyStart,
+             uint64_t destRegionId, uint64_t destOffset, uint64_t destCopyStart,
+             uint32_t uid, uint32_t gid, size_t nbytes,
+             boost::atomic_uint64_t *progress = NULL);
+    void *get_copy_source(uint64_t srcRegionId, uint64_t srcOffset,
+                          uint64_t srcCopyStart, uint32_t uid, uint32_t gid,
+                          size_t nbytes);
+    void get_memserver_info(uint64_t &capacity, uint64_t &used);
 
   private:
     MemoryManager *memoryManager;
     FAM_Metadata_Manager *metadataManager;
-    HeapMap *heapMap;
+    // Open heaps indexed by region id. Looked up without locking; entries
+    // only change on region create, destroy and open, under heapMapLock.
+    boost::atomic<Heap *> *heapMap;
     pthread_mutex_t heapMapLock;
-    HeapMap::iterator get_heap(uint64_t regionId, Heap *&heap);
+    Memserver_Copy_Pool *copyPool;
+    Heap *get_heap(uint64_t regionId);
+    bool insert_heap(uint64_t regionId, Heap *heap);
+    Heap *remove_heap(uint64_t regionId);
+    // Held by the merger while it works on a heap outside heapMapLock;
+    // remove_heap() waits for it
+    std::mutex heapHoldLock;
+    Heap *hold_heap(uint64_t regionId);
+    void release_heap();
+    // Slabs of each region, indexed like heapMap and created on first use
+    boost::atomic<Memserver_Slab *> *slabMap;
+    pthread_mutex_t slabMapLock;
+    uint64_t slabMaxObjSize;
+    Memserver_Slab *get_slab(uint64_t regionId, Heap *heap);
+    void free_offset(Heap *heap, uint64_t regionId, uint64_t offset,
+                     uint64_t nbytes);
+    // Background merging of the heap free lists. freedBytes counts, per
+    // region, what went back to the heap since its last merge; mergeRegions
+    // holds the regions to merge on the next pass whatever was freed.
+    boost::atomic_uint64_t *freedBytes;
+    std::thread merger;
+    std::mutex mergeLock;
+    std::condition_variable mergeCond;
+    std::condition_variable mergeDoneCond;
+    bool mergeStop;
+    uint64_t mergeRequested;
+    uint64_t mergeDone;
+    std::set<uint64_t> mergeRegions;
+    void run_merger();
+    void merge_heaps(const std::set<uint64_t> &regions);
+    bool wait_for_merge(uint64_t regionId);
+    uint64_t request_pass(uint64_t mergeRegionId = ShelfId::kMaxPoolCount);
+    void wait_for_pass(uint64_t mergeRegionId = ShelfId::kMaxPoolCount);
+    void stop_merger();
+    // Growth of regions with a growth limit, also done by the merger.
+    // usedBytes counts, per region, what was allocated since its heap was
+    // opened; growRequest, the bytes asked for since the last growth.
+    boost::atomic_uint64_t *usedBytes;
+    boost::atomic_uint64_t *growRequest;
+    // Orders every read-modify-write of region metadata: resizes, growth
+    // limits, permission changes and destruction
+    std::mutex resizeLock;
+    std::function<void(uint64_t)> resizeHook;
+    void resize_heap(Heap *heap, Fam_Region_Metadata &region, size_t nbytes);
+    void check_growth(Fam_Region_Metadata &region);
+    bool wait_for_growth(uint64_t regionId, uint64_t nbytes);
+    void grow_regions();
+    void release_used(uint64_t regionId, uint64_t nbytes);
+    // Heap keeper: a pool of created and opened heaps by size, handed out
+    // by create_region, and the heaps of destroyed regions to destroy.
+    // warmBytes counts the bytes of the pool and of the heap being created.
+    uint64_t numWarmHeaps;
+    uint64_t warmBytes;
+    std::deque<size_t> warmSizes;
+    std::map<size_t, std::deque<std::pair<PoolId, Heap *>>> warmHeaps;
+    std::deque<std::pair<PoolId, Heap *>> reclaimHeaps;
+    std::thread heapKeeper;
+    std::mutex heapPoolLock;
+    std::condition_variable heapPoolCond;
+    bool heapPoolStop;
+    Heap *create_heap(size_t nbytes, PoolId &poolId);
+    int destroy_heap(PoolId poolId, Heap *heap);
+    Heap *take_warm_heap(size_t nbytes, PoolId &poolId);
+    size_t get_warm_heap_size();
+    uint64_t get_warm_heap_limit();
+    void run_heap_keeper();
+    void stop_heap_keeper();
+    void reclaim_unused_heaps();
+    Heap *find_heap(uint64_t regionId);
+    void check_allocate_permission(uint64_t regionId, uint32_t uid,
+                                   uint32_t gid, Fam_Region_Metadata &region);
+    void allocate_dataitem(Heap *heap, string name, uint64_t regionId,
+                           size_t nbytes, uint64_t &offset, mode_t permission,
+                           uint32_t uid, uint32_t gid,
+                           Fam_DataItem_Metadata &dataitem,
+                           void *&localPointer);
+    uint64_t check_deallocate_permission(uint64_t regionId, uint64_t offset,
+                                         uint32_t uid, uint32_t gid);
+    void deallocate_dataitem(Heap *heap, uint64_t regionId, uint64_t offset,
+                             uint64_t nbytes);
     PoolId get_free_poolId();
     bitmap *bmap;
     void init_poolId_bmap();
+    // Bytes offered to regions and bytes of the regions on this server
+    uint64_t capacity;
+    boost::atomic_uint64_t regionBytes;
+    void count_region_bytes();
 };
 
 } // namespace openfam
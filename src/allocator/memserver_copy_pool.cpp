@@ -0,0 +1,180 @@
+/*
+ * memserver_copy_pool.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#include <fstream>
+#include <pthread.h>
+#include <sstream>
+
+#include "allocator/memserver_copy_pool.h"
+
+namespace openfam {
+
+/*
+ * Parse a sysfs cpu list such as "0-7,16-23" into a cpu set.
+ * Returns false when the list names no cpu.
+ */
+static bool parse_cpulist(const string &cpulist, cpu_set_t &cpus) {
+    bool found = false;
+    istringstream ranges(cpulist);
+    string range;
+
+    CPU_ZERO(&cpus);
+    while (getline(ranges, range, ',')) {
+        istringstream bounds(range);
+        int first, last;
+        char dash;
+        if (!(bounds >> first))
+            continue;
+        last = first;
+        if ((bounds >> dash) && (dash == '-') && !(bounds >> last))
+            continue;
+        for (int cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); cpu++) {
+            CPU_SET(cpu, &cpus);
+            found = true;
+        }
+    }
+    return found;
+}
+
+Memserver_Copy_Pool::Memserver_Copy_Pool(uint64_t numThreads,
+                                         uint64_t chunkSize)
+    : chunkSize(chunkSize), stop(false) {
+    if (this->chunkSize == 0)
+        this->chunkSize = FAM_COPY_CHUNK_SIZE;
+
+    // Collect the cpus of each NUMA node; no sysfs means no placement
+    for (int node = 0;; node++) {
+        ostringstream path;
+        path << "/sys/devices/system/node/node" << node << "/cpulist";
+        ifstream file(path.str().c_str());
+        string cpulist;
+        cpu_set_t cpus;
+        if (!file || !getline(file, cpulist))
+            break;
+        if (parse_cpulist(cpulist, cpus))
+            numaNodes.push_back(cpus);
+    }
+
+    for (uint64_t i = 0; i < numThreads; i++)
+        workers.push_back(std::thread(&Memserver_Copy_Pool::run, this, i));
+}
+
+Memserver_Copy_Pool::~Memserver_Copy_Pool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stop = true;
+    }
+    cond.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void Memserver_Copy_Pool::copy(void *dest, void *src, uint64_t nbytes,
+                               boost::atomic_uint64_t *progress) {
+    if (nbytes == 0)
+        return;
+
+    std::shared_ptr<Copy_Job> job = std::make_shared<Copy_Job>();
+    job->dest = (char *)dest;
+    job->src = (char *)src;
+    job->nbytes = nbytes;
+    job->numChunks = (nbytes + chunkSize - 1) / chunkSize;
+    job->nextChunk.store(0);
+    job->doneChunks.store(0);
+    job->progress = progress;
+
+    // The caller copies too, so only chunks beyond the first need helpers
+    uint64_t numHelpers = job->numChunks - 1;
+    if (numHelpers > workers.size())
+        numHelpers = workers.size();
+    if (numHelpers > 0) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (uint64_t i = 0; i < numHelpers; i++)
+                pending.push_back(job);
+        }
+        cond.notify_all();
+    }
+
+    copy_chunks(job.get());
+
+    std::unique_lock<std::mutex> guard(job->doneLock);
+    job->doneCond.wait(guard, [&job] {
+        return job->doneChunks.load() == job->numChunks;
+    });
+}
+
+void Memserver_Copy_Pool::copy_chunks(Copy_Job *job) {
+    uint64_t chunk;
+    while ((chunk = job->nextChunk.fetch_add(1)) < job->numChunks) {
+        uint64_t start = chunk * chunkSize;
+        uint64_t size = job->nbytes - start;
+        if (size > chunkSize)
+            size = chunkSize;
+
+        openfam_persistent_copy(job->dest + start, job->src + start, size);
+
+        if (job->progress)
+            job->progress->fetch_add(size);
+        if (job->doneChunks.fetch_add(1) + 1 == job->numChunks) {
+            std::lock_guard<std::mutex> guard(job->doneLock);
+            job->doneCond.notify_all();
+        }
+    }
+}
+
+void Memserver_Copy_Pool::run(uint64_t threadId) {
+    bind_to_numa_node(threadId);
+    while (true) {
+        std::shared_ptr<Copy_Job> job;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            cond.wait(guard, [this] { return stop || !pending.empty(); });
+            if (pending.empty())
+                return;
+            job = pending.front();
+            pending.pop_front();
+        }
+        // A job whose chunks were all claimed already is simply dropped
+        copy_chunks(job.get());
+    }
+}
+
+/*
+ * Threads are placed round robin over the NUMA nodes. A failure to set the
+ * affinity is not an error, the thread just runs wherever it is scheduled.
+ */
+void Memserver_Copy_Pool::bind_to_numa_node(uint64_t threadId) {
+    if (numaNodes.size() < 2)
+        return;
+    cpu_set_t &cpus = numaNodes[threadId % numaNodes.size()];
+    (void)pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+}
+
+} // namespace openfam
@@ -0,0 +1,102 @@
+/*
+ * memserver_copy_pool.h
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#ifndef MEMSERVER_COPY_POOL_H_
+#define MEMSERVER_COPY_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sched.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include <boost/atomic.hpp>
+
+#include "common/fam_internal.h"
+
+// Number of threads copying data items on a memory server
+#define MEMSERVER_DEFAULT_COPY_THREADS 4
+
+using namespace std;
+
+namespace openfam {
+
+/*
+ * Pool of threads doing the data movement of fam_copy on the memory server.
+ * A copy is cut into chunks which the pool threads and the calling thread
+ * claim one at a time, so a large copy uses several cores while small ones
+ * are done by the caller alone. The threads are spread over the NUMA nodes
+ * of the host so that a large copy draws on the bandwidth of every socket.
+ */
+class Memserver_Copy_Pool {
+  public:
+    Memserver_Copy_Pool(uint64_t numThreads,
+                        uint64_t chunkSize = FAM_COPY_CHUNK_SIZE);
+    ~Memserver_Copy_Pool();
+
+    /*
+     * Copy nbytes from src to dest and make the destination persistent.
+     * Blocks until the whole range is copied. If progress is not NULL, it is
+     * advanced by the size of each chunk as soon as that chunk is done.
+     */
+    void copy(void *dest, void *src, uint64_t nbytes,
+              boost::atomic_uint64_t *progress);
+
+  private:
+    struct Copy_Job {
+        char *dest;
+        char *src;
+        uint64_t nbytes;
+        uint64_t numChunks;
+        boost::atomic_uint64_t nextChunk;
+        boost::atomic_uint64_t doneChunks;
+        boost::atomic_uint64_t *progress;
+        std::mutex doneLock;
+        std::condition_variable doneCond;
+    };
+
+    void run(uint64_t threadId);
+    void copy_chunks(Copy_Job *job);
+    void bind_to_numa_node(uint64_t threadId);
+
+    uint64_t chunkSize;
+    std::vector<cpu_set_t> numaNodes;
+    bool stop;
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<std::shared_ptr<Copy_Job>> pending;
+    std::vector<std::thread> workers;
+};
+
+} // namespace openfam
+
+#endif /* end of MEMSERVER_COPY_POOL_H_ */
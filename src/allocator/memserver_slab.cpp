@@ -0,0 +1,217 @@
+/*
+ * memserver_slab.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#include "allocator/memserver_slab.h"
+#include "common/fam_internal.h"
+
+namespace openfam {
+
+/*
+ * Header at the start of every chunk. The slots it covers are never handed
+ * out. The bitmap is sized for the smallest class.
+ */
+struct Memserver_Slab::Chunk_Header {
+    uint64_t magic;
+    uint64_t objSize;
+    uint64_t next;
+    uint64_t inUse[1];
+};
+
+static uint64_t header_size(uint64_t minObjSize) {
+    uint64_t numWords = (MEMSERVER_SLAB_CHUNK_SIZE / minObjSize + 63) / 64;
+    return 3 * sizeof(uint64_t) + numWords * sizeof(uint64_t);
+}
+
+Memserver_Slab::Memserver_Slab(Heap *heap, uint64_t rootOffset,
+                               uint64_t minObjSize, uint64_t maxObjSize)
+    : heap(heap), minObjSize(minObjSize), maxObjSize(maxObjSize) {
+    if (this->maxObjSize > MEMSERVER_SLAB_MAX_OBJ_SIZE)
+        this->maxObjSize = MEMSERVER_SLAB_MAX_OBJ_SIZE;
+
+    // Classes up to the largest possible size, so that chunks of a larger
+    // maxObjSize used before a restart can still be freed
+    for (uint64_t size = minObjSize; size <= MEMSERVER_SLAB_MAX_OBJ_SIZE;
+         size *= 2) {
+        Size_Class *sizeClass = new Size_Class();
+        sizeClass->objSize = size;
+        classes.push_back(sizeClass);
+    }
+
+    root = NULL;
+    if (rootOffset)
+        root = (Slab_Root *)heap->OffsetToLocal(rootOffset);
+    (void)pthread_rwlock_init(&chunkLock, NULL);
+    load_chunks();
+}
+
+Memserver_Slab::~Memserver_Slab() {
+    for (auto sizeClass : classes)
+        delete sizeClass;
+    pthread_rwlock_destroy(&chunkLock);
+}
+
+uint64_t Memserver_Slab::create_root(Heap *heap, uint64_t minObjSize) {
+    uint64_t rootOffset = heap->AllocOffset(minObjSize);
+    if (!rootOffset)
+        return 0;
+
+    Slab_Root *newRoot = (Slab_Root *)heap->OffsetToLocal(rootOffset);
+    newRoot->chunkHead = 0;
+    newRoot->magic = MEMSERVER_SLAB_MAGIC;
+    openfam_persist(newRoot, sizeof(Slab_Root));
+    return rootOffset;
+}
+
+/*
+ * Rebuild the chunk map and the free lists from the chunks in the heap.
+ */
+void Memserver_Slab::load_chunks() {
+    if (!root || (root->magic != MEMSERVER_SLAB_MAGIC))
+        return;
+
+    for (uint64_t offset = root->chunkHead; offset;) {
+        Chunk_Header *chunk = (Chunk_Header *)heap->OffsetToLocal(offset);
+        if (chunk->magic != MEMSERVER_SLAB_MAGIC)
+            break;
+        chunks.insert({offset, chunk});
+        add_free_objects(offset, chunk);
+        offset = chunk->next;
+    }
+}
+
+void Memserver_Slab::add_free_objects(uint64_t chunkOffset,
+                                      Chunk_Header *chunk) {
+    uint64_t objSize = chunk->objSize;
+    uint64_t firstSlot = (header_size(minObjSize) + objSize - 1) / objSize;
+    uint64_t numSlots = MEMSERVER_SLAB_CHUNK_SIZE / objSize;
+
+    for (auto sizeClass : classes) {
+        if (sizeClass->objSize != objSize)
+            continue;
+        // Pushed in reverse so that the chunk is used from its start
+        for (uint64_t slot = numSlots; slot-- > firstSlot;) {
+            if (!(chunk->inUse[slot / 64] & (1UL << (slot % 64))))
+                sizeClass->freeList.push_back(chunkOffset + slot * objSize);
+        }
+        return;
+    }
+}
+
+/*
+ * Take a new chunk for a size class from the heap. Called with the lock of
+ * the size class held.
+ */
+bool Memserver_Slab::add_chunk(Size_Class *sizeClass) {
+    uint64_t chunkOffset = heap->AllocOffset(MEMSERVER_SLAB_CHUNK_SIZE);
+    if (!chunkOffset)
+        return false;
+
+    Chunk_Header *chunk = (Chunk_Header *)heap->OffsetToLocal(chunkOffset);
+    memset(chunk, 0, header_size(minObjSize));
+    chunk->objSize = sizeClass->objSize;
+    chunk->magic = MEMSERVER_SLAB_MAGIC;
+
+    // Link the chunk before publishing it, so that a crash in between only
+    // leaks it
+    (void)pthread_rwlock_wrlock(&chunkLock);
+    chunk->next = root->chunkHead;
+    openfam_persist(chunk, header_size(minObjSize));
+    root->chunkHead = chunkOffset;
+    openfam_persist(&root->chunkHead, sizeof(uint64_t));
+    chunks.insert({chunkOffset, chunk});
+    (void)pthread_rwlock_unlock(&chunkLock);
+
+    add_free_objects(chunkOffset, chunk);
+    return true;
+}
+
+void Memserver_Slab::set_in_use(Chunk_Header *chunk, uint64_t slot,
+                                bool inUse) {
+    uint64_t *word = &chunk->inUse[slot / 64];
+    if (inUse)
+        *word |= (1UL << (slot % 64));
+    else
+        *word &= ~(1UL << (slot % 64));
+    openfam_persist(word, sizeof(uint64_t));
+}
+
+uint64_t Memserver_Slab::alloc(size_t nbytes) {
+    if (!root || (root->magic != MEMSERVER_SLAB_MAGIC) ||
+        (nbytes > maxObjSize))
+        return 0;
+
+    Size_Class *sizeClass = NULL;
+    for (auto candidate : classes) {
+        if (candidate->objSize >= nbytes) {
+            sizeClass = candidate;
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(sizeClass->lock);
+    if (sizeClass->freeList.empty() && !add_chunk(sizeClass))
+        return 0;
+
+    uint64_t offset = sizeClass->freeList.back();
+    sizeClass->freeList.pop_back();
+
+    (void)pthread_rwlock_rdlock(&chunkLock);
+    auto chunkObj = --chunks.upper_bound(offset);
+    (void)pthread_rwlock_unlock(&chunkLock);
+    uint64_t slot = (offset - chunkObj->first) / sizeClass->objSize;
+    set_in_use(chunkObj->second, slot, true);
+    return offset;
+}
+
+bool Memserver_Slab::free(uint64_t offset) {
+    (void)pthread_rwlock_rdlock(&chunkLock);
+    auto chunkObj = chunks.upper_bound(offset);
+    bool found = (chunkObj != chunks.begin());
+    if (found) {
+        --chunkObj;
+        found = (offset - chunkObj->first) < MEMSERVER_SLAB_CHUNK_SIZE;
+    }
+    (void)pthread_rwlock_unlock(&chunkLock);
+    if (!found)
+        return false;
+
+    uint64_t chunkOffset = chunkObj->first;
+    Chunk_Header *chunk = chunkObj->second;
+    for (auto sizeClass : classes) {
+        if (sizeClass->objSize != chunk->objSize)
+            continue;
+        std::lock_guard<std::mutex> guard(sizeClass->lock);
+        set_in_use(chunk, (offset - chunkOffset) / chunk->objSize, false);
+        sizeClass->freeList.push_back(offset);
+        break;
+    }
+    return true;
+}
+
+} // namespace openfam
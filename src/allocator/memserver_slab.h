@@ -0,0 +1,113 @@
+/*
+ * memserver_slab.h
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#ifndef MEMSERVER_SLAB_H_
+#define MEMSERVER_SLAB_H_
+
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include <nvmm/heap.h>
+
+// Slab chunks are carved from the region heap in this size
+#define MEMSERVER_SLAB_CHUNK_SIZE (1UL << 20)
+// Largest object size served from slabs; a chunk holds at least 8 of them
+#define MEMSERVER_SLAB_MAX_OBJ_SIZE (MEMSERVER_SLAB_CHUNK_SIZE / 8)
+#define MEMSERVER_SLAB_MAGIC 0x4f70656e536c6162UL
+
+using namespace nvmm;
+
+namespace openfam {
+
+/*
+ * Size-class allocator over the heap of one region.
+ *
+ * Objects up to maxObjSize are served from chunks of MEMSERVER_SLAB_CHUNK_SIZE
+ * taken from the NVMM heap, one size class per chunk. Classes are the powers
+ * of two from minObjSize, so every object keeps a distinct data item id. Each
+ * class has its own lock and free list, so small allocations neither contend
+ * inside NVMM nor fragment the heap.
+ *
+ * The state lives in the heap: a chunk starts with a header holding its
+ * object size and a bitmap of the objects in use, and the chunks of a region
+ * are linked from a root block, whose offset is kept in the region metadata.
+ * Free lists are rebuilt from the bitmaps when the region is next opened.
+ */
+class Memserver_Slab {
+  public:
+    // rootOffset 0 gives a region without slabs: nothing is allocated from
+    // them and no offset is theirs
+    Memserver_Slab(Heap *heap, uint64_t rootOffset, uint64_t minObjSize,
+                   uint64_t maxObjSize);
+    ~Memserver_Slab();
+
+    // Allocate and initialize a root block; returns its offset, 0 on failure
+    static uint64_t create_root(Heap *heap, uint64_t minObjSize);
+
+    // Offset of a new object of nbytes, 0 if nbytes is above maxObjSize or
+    // no chunk could be taken from the heap
+    uint64_t alloc(size_t nbytes);
+
+    // Free the object at offset; false if it does not belong to a slab
+    bool free(uint64_t offset);
+
+  private:
+    struct Slab_Root {
+        uint64_t magic;
+        uint64_t chunkHead;
+    };
+    struct Chunk_Header;
+    struct Size_Class {
+        std::mutex lock;
+        uint64_t objSize;
+        std::vector<uint64_t> freeList;
+    };
+
+    void load_chunks();
+    void add_free_objects(uint64_t chunkOffset, Chunk_Header *chunk);
+    bool add_chunk(Size_Class *sizeClass);
+    void set_in_use(Chunk_Header *chunk, uint64_t slot, bool inUse);
+
+    Heap *heap;
+    Slab_Root *root;
+    uint64_t minObjSize;
+    uint64_t maxObjSize;
+    std::vector<Size_Class *> classes;
+
+    // Chunks by offset, to tell slab objects from other data items on free
+    pthread_rwlock_t chunkLock;
+    std::map<uint64_t, Chunk_Header *> chunks;
+};
+
+} // namespace openfam
+
+#endif /* end of MEMSERVER_SLAB_H_ */
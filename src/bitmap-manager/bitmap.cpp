@@ -35,6 +35,11 @@ using namespace std;
 static bool get(uint64_t, uint64_t);
 static void set(uint64_t *, uint64_t);
 static void reset(uint64_t *, uint64_t);
+static void update_summary(bitmap *, uint64_t);
+
+/* Word of the last reservation of this thread in hintMap */
+static thread_local bitmap *hintMap = NULL;
+static thread_local uint64_t hintWord = 0;
 
 /* Registers the bitmap with fam_atomic and initialize the bitmap to 0*/
 int bitmap_init(bitmap *bmap) {
@@ -50,12 +55,40 @@ int bitmap_init(bitmap *bmap) {
     for (uint64_t i = 0; i < size / sizeof(int64_t); i++) {
         fam_atomic_64_write((int64_t *)bmap->map + i, 0);
     }
+    return bitmap_init_summary(bmap);
+}
+
+/*
+ * Build the summary of an existing bitmap. The summary only reflects the
+ * changes made by this process, so it is a hint: words filled elsewhere are
+ * found full when read, and bitmap_find_and_reserve() rescans the whole map
+ * before giving up, in case bits were freed elsewhere.
+ */
+int bitmap_init_summary(bitmap *bmap) {
+    uint64_t numWords = bmap->size / sizeof(uint64_t);
+    uint64_t *summary = (uint64_t *)calloc((numWords + BITSIZE - 1) / BITSIZE,
+                                           sizeof(uint64_t));
+    if (!summary) {
+        cout << "unable to allocate bitmap summary" << endl;
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < numWords; i++) {
+        if ((uint64_t)fam_atomic_64_read((int64_t *)bmap->map + i) ==
+            BITMAP_FULL_WORD)
+            set(&summary[i / BITSIZE], i % BITSIZE);
+    }
+
+    free(bmap->summary);
+    bmap->summary = summary;
     return 0;
 }
 
 void bitmap_free(bitmap *bmap) {
 
     fam_atomic_unregister_region(bmap->map, bmap->size);
+    free(bmap->summary);
+    bmap->summary = NULL;
 }
 
 /* Returns the value of the @n'th bit of the bitmap */
@@ -96,6 +129,9 @@ void bitmap_set(bitmap *bmap, uint64_t n) {
             retry = 0;
         }
     } while (retry);
+
+    if (newValue == BITMAP_FULL_WORD)
+        update_summary(bmap, offset);
 }
 
 /* Sets the n'th bit of the bitmap to false */
@@ -124,6 +160,7 @@ void bitmap_reset(bitmap *bmap, uint64_t n) {
         }
     } while (retry);
 
+    update_summary(bmap, offset);
 }
 
 /* Check the n'th bit value and then sets the n'th bit 
@@ -171,27 +208,99 @@ int bitmap_reserve(bitmap *bmap, bool val, uint64_t n) {
         }
     } while (retry);
 
+    if (val || (newValue == BITMAP_FULL_WORD))
+        update_summary(bmap, offset);
     return 0;
 }
 
-/* Finds the first free "val" in bitmap after start bit 
+/* Scans the words [from, to) of the bitmap for a "val" bit at or after
+ * start and flips it with a single compare and store. With useSummary,
+ * words marked full in the summary are not read.
+ */
+static bool reserve_in_words(bitmap *bmap, bool val, uint64_t start,
+                             uint64_t from, uint64_t to, bool useSummary,
+                             uint64_t &pos) {
+    uint64_t offset = from;
+
+    while (offset < to) {
+        if (useSummary) {
+            uint64_t notFull =
+                ~__atomic_load_n(&bmap->summary[offset / BITSIZE],
+                                 __ATOMIC_SEQ_CST) &
+                (BITMAP_FULL_WORD << (offset % BITSIZE));
+            if (!notFull) {
+                offset = (offset / BITSIZE + 1) * BITSIZE;
+                continue;
+            }
+            offset = (offset / BITSIZE) * BITSIZE + __builtin_ctzll(notFull);
+            if (offset >= to)
+                break;
+        }
+
+        int64_t *addr = (int64_t *)bmap->map + offset;
+        uint64_t value = fam_atomic_64_read(addr);
+        while (true) {
+            uint64_t candidates = val ? value : ~value;
+            if (offset == start / BITSIZE)
+                candidates &= BITMAP_FULL_WORD << (start % BITSIZE);
+            if (!candidates)
+                break;
+
+            uint64_t bit = __builtin_ctzll(candidates);
+            uint64_t newValue = value ^ (1UL << bit);
+            uint64_t result =
+                fam_atomic_64_compare_store(addr, value, newValue);
+            if (result == value) {
+                if (val || (newValue == BITMAP_FULL_WORD))
+                    update_summary(bmap, offset);
+                pos = offset * BITSIZE + bit;
+                return true;
+            }
+            // Lost a race for this word, pick again from its new value
+            value = result;
+        }
+
+        // Filled by another process, record it for the next search
+        if (!val && (value == BITMAP_FULL_WORD))
+            update_summary(bmap, offset);
+        offset++;
+    }
+
+    return false;
+}
+
+/* Finds a free "val" in bitmap after start bit 
  * and set/reset the bit and return the bit.
  * if val was 0, it will be set to 1 and if val is 1, it 
  * will be reset to 0 and bit position will be returned.
+ * The search works a word at a time and starts at the word
+ * of the last reservation of the calling thread, wrapping
+ * around to start, so concurrent callers spread out and do
+ * not rescan the words they filled.
  */
 uint64_t bitmap_find_and_reserve(bitmap *bmap, bool val, uint64_t start) {
-    uint64_t i;
-    uint64_t size = bmap->size;
-
-    /* size is now the Bitmap size in bits */
-    for (i = start, size *= 8; i < size; i++) {
-        if (bitmap_get(bmap, i) == val) {
-            // If bitmap_reserve() fails to reserve the bit,
-            // try next available bit.
-            if (bitmap_reserve(bmap, val, i) == 0) {
-                return i; 
-            }
-        }
+    uint64_t numWords = bmap->size / sizeof(uint64_t);
+    uint64_t startWord = start / BITSIZE;
+    uint64_t firstWord = startWord;
+    uint64_t pos;
+
+    if (startWord >= numWords)
+        return BITMAP_NOTFOUND;
+
+    if ((hintMap == bmap) && (hintWord > startWord) && (hintWord < numWords))
+        firstWord = hintWord;
+
+    bool useSummary = !val && bmap->summary;
+    if (reserve_in_words(bmap, val, start, firstWord, numWords, useSummary,
+                         pos) ||
+        reserve_in_words(bmap, val, start, startWord, firstWord, useSummary,
+                         pos) ||
+        // Words marked full may have been freed by another process
+        (useSummary && reserve_in_words(bmap, val, start, startWord, numWords,
+                                        false, pos))) {
+        hintMap = bmap;
+        hintWord = pos / BITSIZE;
+        return pos;
     }
 
     return BITMAP_NOTFOUND;
@@ -221,3 +330,22 @@ static void set(uint64_t *byte, uint64_t bit) { *byte |= (1UL << bit); }
 static void reset(uint64_t *byte, uint64_t bit) {
     *byte &= (~(1UL << bit));
 }
+
+/* Makes the summary bit of word offset match whether that word is full */
+static void update_summary(bitmap *bmap, uint64_t offset) {
+    if (!bmap->summary)
+        return;
+
+    uint64_t *word = &bmap->summary[offset / BITSIZE];
+    uint64_t mask = 1UL << (offset % BITSIZE);
+    int64_t *addr = (int64_t *)bmap->map + offset;
+
+    if ((uint64_t)fam_atomic_64_read(addr) == BITMAP_FULL_WORD) {
+        __atomic_fetch_or(word, mask, __ATOMIC_SEQ_CST);
+        // A reset of the word may have cleared the summary bit before us
+        if ((uint64_t)fam_atomic_64_read(addr) == BITMAP_FULL_WORD)
+            return;
+    }
+    if (__atomic_load_n(word, __ATOMIC_SEQ_CST) & mask)
+        __atomic_fetch_and(word, ~mask, __ATOMIC_SEQ_CST);
+}
@@ -40,13 +40,22 @@
 
 #define BITSIZE (8 * sizeof(uint64_t))
 #define BITMAP_NOTFOUND -1
+#define BITMAP_FULL_WORD (~0UL)
 
+/*
+ * map holds size bytes of bits, changed with fam_atomic operations so that
+ * it may be shared. summary is an optional, process private index of map
+ * with one bit per word of map, set when that word is full; it lets
+ * bitmap_find_and_reserve() skip 64 full words at a time.
+ */
 typedef struct bitmap {
     void *map;
     uint64_t size;
+    uint64_t *summary;
 } bitmap;
 
 int bitmap_init(bitmap *bmap);
+int bitmap_init_summary(bitmap *bmap);
 void bitmap_free(bitmap *bmap);
 
 bool bitmap_get(bitmap *bmap, uint64_t pos);
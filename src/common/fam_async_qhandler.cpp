@@ -66,16 +66,42 @@ class Fam_Async_QHandler::FamAsyncQHandlerImpl_ {
         Fam_Ops_Info opsInfo;
 
         while (run) {
-            if (queue->pop(opsInfo))
-                decode_and_execute(opsInfo);
+            if (queue->pop(opsInfo)) {
+                // An operation issued after a fence waits until everything
+                // issued before the fence in the same context has completed.
+                // Those were taken off the queue earlier, so they are running
+                // on other consumers and the wait is short.
+                if (opsInfo.ctx) {
+                    std::unique_lock<boost::fibers::mutex> lk(fenceMtx);
+                    while (opsInfo.ctx->get_num_completed_ops() <
+                           opsInfo.fenceBarrier) {
+                        fenceCond.wait(lk);
+                    }
+                }
+                try {
+                    decode_and_execute(opsInfo);
+                } catch (Fam_Exception &e) {
+                    std::cerr << "error: nonblocking operation failed : "
+                              << e.fam_error_msg() << std::endl;
+                }
+            }
         }
     }
 
     void initiate_operation(Fam_Ops_Info opsInfo) {
+        if (opsInfo.ctx) {
+            opsInfo.fenceBarrier = opsInfo.ctx->get_fence_barrier();
+            opsInfo.ctx->inc_num_issued_ops();
+        }
         queue->push(opsInfo);
         return;
     }
 
+    void fence(Fam_Context *famCtx) {
+        famCtx->set_fence_barrier();
+        return;
+    }
+
     void quiet(Fam_Context *famCtx) {
 
         write_quiet(famCtx->get_num_tx_ops());
@@ -136,6 +162,29 @@ class Fam_Async_QHandler::FamAsyncQHandlerImpl_ {
     }
 
     void decode_and_execute(Fam_Ops_Info opsInfo) {
+        // A failed operation is complete as well, or fences behind it would
+        // wait for it forever
+        try {
+            execute(opsInfo);
+        } catch (...) {
+            complete(opsInfo.ctx);
+            throw;
+        }
+        complete(opsInfo.ctx);
+        return;
+    }
+
+    void complete(Fam_Context *famCtx) {
+        if (!famCtx)
+            return;
+        {
+            std::unique_lock<boost::fibers::mutex> lk(fenceMtx);
+            famCtx->inc_num_completed_ops();
+        }
+        fenceCond.notify_all();
+    }
+
+    void execute(Fam_Ops_Info opsInfo) {
         switch (opsInfo.opsType) {
         case WRITE: {
             write_handler(opsInfo.src, opsInfo.dest, opsInfo.nbytes,
@@ -227,8 +276,15 @@ class Fam_Async_QHandler::FamAsyncQHandlerImpl_ {
     }
 
     void copy_handler(void *src, void *dest, uint64_t nbytes, Copy_Tag *tag) {
-        memcpy(dest, src, nbytes);
-        openfam_persist(dest, nbytes);
+        // Copy chunk by chunk so that the progress can be followed
+        for (uint64_t start = 0; start < nbytes; start += FAM_COPY_CHUNK_SIZE) {
+            uint64_t size = nbytes - start;
+            if (size > FAM_COPY_CHUNK_SIZE)
+                size = FAM_COPY_CHUNK_SIZE;
+            openfam_persistent_copy((char *)dest + start,
+                                    (char *)src + start, size);
+            tag->copied.fetch_add(size, boost::memory_order_seq_cst);
+        }
 
         {
             std::unique_lock<boost::fibers::mutex> lk(copyMtx);
@@ -242,8 +298,8 @@ class Fam_Async_QHandler::FamAsyncQHandlerImpl_ {
     boost::lockfree::queue<Fam_Ops_Info> *queue;
     boost::lockfree::queue<Fam_Async_Err *> *readCQ, *writeCQ;
     boost::thread_group consumerThreads;
-    boost::fibers::condition_variable readCond, writeCond, copyCond;
-    boost::fibers::mutex readMtx, writeMtx, copyMtx;
+    boost::fibers::condition_variable readCond, writeCond, copyCond, fenceCond;
+    boost::fibers::mutex readMtx, writeMtx, copyMtx, fenceMtx;
     boost::atomic_uint64_t readCtr, writeCtr, readErrCtr, writeErrCtr;
     boost::atomic<bool> run;
 };
@@ -266,6 +322,10 @@ void Fam_Async_QHandler::quiet(Fam_Context *famCtx) {
     fAsyncQHandler_->quiet(famCtx);
 }
 
+void Fam_Async_QHandler::fence(Fam_Context *famCtx) {
+    fAsyncQHandler_->fence(famCtx);
+}
+
 void Fam_Async_QHandler::write_quiet(uint64_t ctr) {
     fAsyncQHandler_->write_quiet(ctr);
 }
@@ -48,6 +48,8 @@ typedef enum { WRITE = 0, READ, COPY } Fam_Ops_Type;
 
 typedef struct {
     boost::atomic<bool> copyDone;
+    // Bytes copied so far, see fam_copy_progress()
+    boost::atomic<uint64_t> copied;
 } Copy_Tag;
 
 typedef struct {
@@ -60,6 +62,9 @@ typedef struct {
     uint64_t key;
     uint64_t itemSize;
     Copy_Tag *tag;
+    Fam_Context *ctx;
+    // Set by initiate_operation, see Fam_Context::get_fence_barrier()
+    uint64_t fenceBarrier;
 } Fam_Ops_Info;
 
 class Fam_Async_Err {
@@ -84,6 +89,7 @@ class Fam_Async_QHandler {
 
     void initiate_operation(Fam_Ops_Info opsInfo);
     void quiet(Fam_Context *famCtx);
+    void fence(Fam_Context *famCtx);
     void write_quiet(uint64_t ctr);
     void read_quiet(uint64_t ctr);
     void wait_for_copy(void *waitObj);
@@ -45,6 +45,7 @@ class Fam_Context {
         : numTxOps(0), numRxOps(0), isNVMM(true) {
         numLastRxFailCnt = 0;
         numLastTxFailCnt = 0;
+        numIssuedOps = numCompletedOps = fenceBarrier = 0;
         // Initialize ctxRWLock
         famThreadModel = famTM;
         if (famThreadModel == FAM_THREAD_MULTIPLE)
@@ -57,6 +58,7 @@ class Fam_Context {
         isNVMM = false;
         numLastRxFailCnt = 0;
         numLastTxFailCnt = 0;
+        numIssuedOps = numCompletedOps = fenceBarrier = 0;
 
         // Initialize ctxRWLock
         famThreadModel = famTM;
@@ -215,6 +217,37 @@ class Fam_Context {
         __sync_fetch_and_add(&numLastRxFailCnt, cnt);
     }
 
+    /*
+     * Ordering of shared memory nonblocking operations. Every queued
+     * operation is stamped with the fence barrier current at the time it is
+     * issued, and may only execute once the number of completed operations
+     * in this context has reached that barrier. A fence moves the barrier to
+     * the number of operations issued so far.
+     */
+    uint64_t inc_num_issued_ops() {
+        uint64_t one = 1;
+        return __sync_fetch_and_add(&numIssuedOps, one);
+    }
+
+    void inc_num_completed_ops() {
+        uint64_t one = 1;
+        __sync_fetch_and_add(&numCompletedOps, one);
+    }
+
+    uint64_t get_num_completed_ops() {
+        return __atomic_load_n(&numCompletedOps, __ATOMIC_ACQUIRE);
+    }
+
+    uint64_t get_fence_barrier() {
+        return __atomic_load_n(&fenceBarrier, __ATOMIC_ACQUIRE);
+    }
+
+    void set_fence_barrier() {
+        __atomic_store_n(&fenceBarrier,
+                         __atomic_load_n(&numIssuedOps, __ATOMIC_ACQUIRE),
+                         __ATOMIC_RELEASE);
+    }
+
   private:
     struct fid_ep *ep;
     struct fid_cq *txcq;
@@ -227,6 +260,9 @@ class Fam_Context {
     bool isNVMM;
     uint64_t numLastTxFailCnt;
     uint64_t numLastRxFailCnt;
+    uint64_t numIssuedOps;
+    uint64_t numCompletedOps;
+    uint64_t fenceBarrier;
     Fam_Thread_Model famThreadModel;
     pthread_rwlock_t ctxRWLock;
 };
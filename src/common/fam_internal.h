@@ -66,10 +66,17 @@
 
 #include <iostream>
 #include <stdint.h>   // needed for uint64_t etc.
+#include <string.h>
 #include <sys/stat.h> // needed for mode_t
 
 #include <nvmm/fam.h>
 
+#include "fam/fam.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #ifdef __cplusplus
 /** C++ Header
  *  The header is defined as a single interface containing all desired methods
@@ -102,6 +109,159 @@ namespace openfam {
 #define DATAITEMID_BITS 33
 #define DATAITEMID_MASK ((1UL << DATAITEMID_BITS) - 1)
 #define DATAITEMID_SHIFT 1
+/*
+ * Keys of region-wide registrations (memory server run with --regionmr) carry
+ * this data item id. They cover the whole region heap, so their remote
+ * offsets are relative to the start of the region, not of the data item.
+ */
+#define FAM_REGION_KEY_DATAITEMID DATAITEMID_MASK
+#define FAM_KEY_IS_REGION(key)                                                 \
+    (((key) < FAM_FENCE_KEY) &&                                                \
+     ((((key) >> DATAITEMID_SHIFT) & DATAITEMID_MASK) ==                       \
+      FAM_REGION_KEY_DATAITEMID))
+
+// Large copies are done and reported in chunks of this size
+#define FAM_COPY_CHUNK_SIZE (8UL << 20)
+// Memory servers holding a copy of a RAID1 region
+#define FAM_RAID1_COPIES 2
+// Fewest memory servers of a RAID5 region, and its default stripe size
+#define FAM_RAID5_MIN_MEMBERS 3
+#define FAM_RAID5_STRIPE_SIZE (64UL << 10)
+
+// A client confirms a key it has held for this long with the memory server
+// before using it again, if that server drops cold registrations
+#define FAM_MR_KEY_LEASE_MS 1000
+
+/*
+ * Number of member regions behind a region or data item descriptor. Only a
+ * descriptor joined from the members of a striped region or data item has
+ * more than one; a member on its own counts as one.
+ */
+template <typename Descriptor>
+inline uint64_t fam_stripe_count(Descriptor *descriptor) {
+    if (descriptor->get_stripe(0) == descriptor)
+        return 1;
+    return descriptor->get_layout().stripeCount;
+}
+
+/*
+ * Whether a descriptor is joined from the copies of a mirrored region or
+ * data item, each member holding all of it.
+ */
+template <typename Descriptor>
+inline bool fam_is_mirrored(Descriptor *descriptor) {
+    return (fam_stripe_count(descriptor) > 1) &&
+           (descriptor->get_layout().redundancyLevel == RAID1);
+}
+
+/*
+ * Whether a descriptor is joined from the members of a RAID5 region or data
+ * item, which keep a parity stripe for every row of data stripes.
+ */
+template <typename Descriptor>
+inline bool fam_has_parity(Descriptor *descriptor) {
+    return (fam_stripe_count(descriptor) > 1) &&
+           (descriptor->get_layout().redundancyLevel == RAID5);
+}
+
+/*
+ * Number of members whose capacity holds data, the others holding copies or
+ * parity of it.
+ */
+inline uint64_t fam_data_members(Fam_Stripe_Layout layout) {
+    if (layout.redundancyLevel == RAID1)
+        return 1;
+    if (layout.redundancyLevel == RAID5)
+        return layout.stripeCount - 1;
+    return layout.stripeCount;
+}
+
+/*
+ * A RAID5 data item is cut in rows of stripeCount - 1 data stripes and one
+ * parity stripe, the XOR of the data stripes of its row. Each row uses every
+ * member once: the parity of row r is on member r % stripeCount and the data
+ * stripes follow it on the next members, wrapping around. A member holds
+ * stripe r of its part for row r.
+ */
+inline uint64_t fam_parity_of(uint64_t offset, Fam_Stripe_Layout layout,
+                              uint64_t &memberOffset) {
+    uint64_t row = offset / layout.stripeSize / (layout.stripeCount - 1);
+    memberOffset = row * layout.stripeSize + offset % layout.stripeSize;
+    return row % layout.stripeCount;
+}
+
+/*
+ * Bytes of a striped data item of nbytes placed on member index: stripe i of
+ * the data item goes to member i % stripeCount. Every member of a mirrored
+ * region holds the whole data item. The parity stripe of a RAID5 row is as
+ * long as the first data stripe of the row.
+ */
+inline uint64_t fam_stripe_bytes(uint64_t nbytes, Fam_Stripe_Layout layout,
+                                 uint64_t index) {
+    if (layout.redundancyLevel == RAID1)
+        return nbytes;
+    if (layout.redundancyLevel == RAID5) {
+        uint64_t rowBytes = layout.stripeSize * (layout.stripeCount - 1);
+        uint64_t rows = nbytes / rowBytes;
+        uint64_t rest = nbytes % rowBytes;
+        uint64_t parity = rows % layout.stripeCount;
+        uint64_t start = 0;
+        if (index != parity)
+            start = ((index + layout.stripeCount - parity - 1) %
+                     layout.stripeCount) *
+                    layout.stripeSize;
+        uint64_t bytes = rows * layout.stripeSize;
+        if (rest > start)
+            bytes += (rest - start < layout.stripeSize) ? rest - start
+                                                        : layout.stripeSize;
+        return bytes;
+    }
+    uint64_t round = layout.stripeSize * layout.stripeCount;
+    uint64_t bytes = (nbytes / round) * layout.stripeSize;
+    uint64_t rest = nbytes % round;
+    uint64_t start = index * layout.stripeSize;
+    if (rest > start)
+        bytes += (rest - start < layout.stripeSize) ? rest - start
+                                                    : layout.stripeSize;
+    return bytes;
+}
+
+/*
+ * Bytes of a RAID5 data item whose parts on all members add up to
+ * memberBytes, as returned by fam_stripe_bytes.
+ */
+inline uint64_t fam_parity_data_bytes(uint64_t memberBytes,
+                                      Fam_Stripe_Layout layout) {
+    uint64_t rowTotal = layout.stripeSize * layout.stripeCount;
+    uint64_t rest = memberBytes % rowTotal;
+    // The last row holds rest data bytes and a parity stripe of
+    // min(rest, stripeSize) bytes
+    if (rest <= 2 * layout.stripeSize)
+        rest /= 2;
+    else
+        rest -= layout.stripeSize;
+    return memberBytes / rowTotal * layout.stripeSize *
+               (layout.stripeCount - 1) +
+           rest;
+}
+
+/*
+ * Member holding byte offset of a striped data item; memberOffset is set to
+ * the offset of that byte within the part on the member.
+ */
+inline uint64_t fam_stripe_of(uint64_t offset, Fam_Stripe_Layout layout,
+                              uint64_t &memberOffset) {
+    if (layout.redundancyLevel == RAID5) {
+        uint64_t parity = fam_parity_of(offset, layout, memberOffset);
+        uint64_t column =
+            offset / layout.stripeSize % (layout.stripeCount - 1);
+        return (parity + 1 + column) % layout.stripeCount;
+    }
+    uint64_t stripe = offset / layout.stripeSize;
+    memberOffset = (stripe / layout.stripeCount) * layout.stripeSize +
+                   offset % layout.stripeSize;
+    return stripe % layout.stripeCount;
+}
 
 inline void openfam_persist(void *addr, uint64_t size) {
     fam_persist(addr, size);
@@ -113,6 +273,48 @@ inline void openfam_invalidate(void *addr, uint64_t size) {
 #endif
 }
 
+/*
+ * Copy into FAM and make the copy persistent. Bulk copies use non-temporal
+ * stores when available: they bypass the cache, so the data is neither
+ * evicting useful lines nor needs flushing line by line afterwards.
+ */
+inline void openfam_persistent_copy(void *dest, const void *src,
+                                    uint64_t size) {
+#if defined(__SSE2__)
+    char *to = (char *)dest;
+    const char *from = (const char *)src;
+
+    // Unaligned head and tail go through the cache and are flushed
+    uint64_t head = (16 - ((uintptr_t)to & 15)) & 15;
+    if (head > size)
+        head = size;
+    memcpy(to, from, head);
+    openfam_persist(to, head);
+    to += head;
+    from += head;
+    size -= head;
+
+    for (; size >= 64; size -= 64, to += 64, from += 64) {
+        __m128i *out = (__m128i *)to;
+        const __m128i *in = (const __m128i *)from;
+        _mm_stream_si128(out, _mm_loadu_si128(in));
+        _mm_stream_si128(out + 1, _mm_loadu_si128(in + 1));
+        _mm_stream_si128(out + 2, _mm_loadu_si128(in + 2));
+        _mm_stream_si128(out + 3, _mm_loadu_si128(in + 3));
+    }
+    for (; size >= 16; size -= 16, to += 16, from += 16)
+        _mm_stream_si128((__m128i *)to, _mm_loadu_si128((const __m128i *)from));
+
+    memcpy(to, from, size);
+    openfam_persist(to, size);
+    // Order the streaming stores before anything that follows
+    _mm_sfence();
+#else
+    memcpy(dest, src, size);
+    openfam_persist(dest, size);
+#endif
+}
+
 } // namespace openfam
 
 #endif /* end of C/C11 Headers */
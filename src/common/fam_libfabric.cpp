@@ -420,6 +420,36 @@ int fabric_insert_av(const char *addr, struct fid_av *av,
     return 0;
 }
 
+/*
+ * Insert the addresses of several memory nodes into address vector at once.
+ * @param addrs - count addresses of the provider address length, back to back
+ * @param count - number of addresses
+ * @param av - struct fid_av
+ * @param fiAddrs - vector of fi_addr_t, appended in the order of addrs
+ * @return - {true(0), false(1), errNo(<0)}
+ */
+int fabric_insert_av_batch(const char *addrs, size_t count, struct fid_av *av,
+                           std::vector<fi_addr_t> *fiAddrs) {
+    std::vector<fi_addr_t> batchAddrs(count);
+    uint64_t flags = 0;
+    void *context = 0;
+
+    if (!fiAddrs)
+        return -1;
+
+    int num_success;
+    FI_CALL(num_success, fi_av_insert, av, addrs, count, batchAddrs.data(),
+            flags, context);
+
+    if ((num_success < 0) || ((size_t)num_success < count)) {
+        return -1;
+    }
+
+    fiAddrs->insert(fiAddrs->end(), batchAddrs.begin(), batchAddrs.end());
+
+    return 0;
+}
+
 /*
  * Enable and Bind endpoint
  * @param fi - struct fi_info
@@ -829,13 +859,14 @@ int fabric_read_write_multi_msg(uint64_t count, size_t iov_limit,
  *  @param stride - stride size in element
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 int fabric_scatter_stride_blocking(uint64_t key, const void *local,
                                    size_t nbytes, uint64_t first,
                                    uint64_t count, uint64_t stride,
                                    fi_addr_t fiAddr, Fam_Context *famCtx,
-                                   size_t iov_limit) {
+                                   size_t iov_limit, uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -846,7 +877,7 @@ int fabric_scatter_stride_blocking(uint64_t key, const void *local,
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
 
-        rma_iov[i].addr = first * nbytes + (i * stride) * nbytes;
+        rma_iov[i].addr = base + first * nbytes + (i * stride) * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -872,13 +903,15 @@ int fabric_scatter_stride_blocking(uint64_t key, const void *local,
  *  @param offset - offset to the local memory address
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 
 int fabric_gather_stride_blocking(uint64_t key, const void *local,
                                   size_t nbytes, uint64_t first, uint64_t count,
                                   uint64_t stride, fi_addr_t fiAddr,
-                                  Fam_Context *famCtx, size_t iov_limit) {
+                                  Fam_Context *famCtx, size_t iov_limit,
+                                  uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -889,7 +922,7 @@ int fabric_gather_stride_blocking(uint64_t key, const void *local,
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
 
-        rma_iov[i].addr = first * nbytes + (i * stride) * nbytes;
+        rma_iov[i].addr = base + first * nbytes + (i * stride) * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -913,12 +946,14 @@ int fabric_gather_stride_blocking(uint64_t key, const void *local,
  *  @param index - An array containing element indexes.
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 int fabric_scatter_index_blocking(uint64_t key, const void *local,
                                   size_t nbytes, uint64_t *index,
                                   uint64_t count, fi_addr_t fiAddr,
-                                  Fam_Context *famCtx, size_t iov_limit) {
+                                  Fam_Context *famCtx, size_t iov_limit,
+                                  uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -928,7 +963,7 @@ int fabric_scatter_index_blocking(uint64_t key, const void *local,
     for (uint64_t i = 0; i < count; i++) {
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
-        rma_iov[i].addr = index[i] * nbytes;
+        rma_iov[i].addr = base + index[i] * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -952,12 +987,13 @@ int fabric_scatter_index_blocking(uint64_t key, const void *local,
  *  @param index - An array containing element indexes.
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 int fabric_gather_index_blocking(uint64_t key, const void *local, size_t nbytes,
                                  uint64_t *index, uint64_t count,
                                  fi_addr_t fiAddr, Fam_Context *famCtx,
-                                 size_t iov_limit) {
+                                 size_t iov_limit, uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -968,7 +1004,7 @@ int fabric_gather_index_blocking(uint64_t key, const void *local, size_t nbytes,
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
 
-        rma_iov[i].addr = index[i] * nbytes;
+        rma_iov[i].addr = base + index[i] * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -1095,13 +1131,14 @@ void fabric_read_nonblocking(uint64_t key, const void *local, size_t nbytes,
  *  @param stride - stride size in element
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 void fabric_scatter_stride_nonblocking(uint64_t key, const void *local,
                                        size_t nbytes, uint64_t first,
                                        uint64_t count, uint64_t stride,
                                        fi_addr_t fiAddr, Fam_Context *famCtx,
-                                       size_t iov_limit) {
+                                       size_t iov_limit, uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -1110,7 +1147,7 @@ void fabric_scatter_stride_nonblocking(uint64_t key, const void *local,
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
 
-        rma_iov[i].addr = first * nbytes + (i * stride) * nbytes;
+        rma_iov[i].addr = base + first * nbytes + (i * stride) * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -1137,6 +1174,7 @@ void fabric_scatter_stride_nonblocking(uint64_t key, const void *local,
  *  @param offset - offset to the local memory address
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 
@@ -1144,7 +1182,7 @@ void fabric_gather_stride_nonblocking(uint64_t key, const void *local,
                                       size_t nbytes, uint64_t first,
                                       uint64_t count, uint64_t stride,
                                       fi_addr_t fiAddr, Fam_Context *famCtx,
-                                      size_t iov_limit) {
+                                      size_t iov_limit, uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -1153,7 +1191,7 @@ void fabric_gather_stride_nonblocking(uint64_t key, const void *local,
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
 
-        rma_iov[i].addr = first * nbytes + (i * stride) * nbytes;
+        rma_iov[i].addr = base + first * nbytes + (i * stride) * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -1177,12 +1215,14 @@ void fabric_gather_stride_nonblocking(uint64_t key, const void *local,
  *  @param index - An array containing element indexes.
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 void fabric_scatter_index_nonblocking(uint64_t key, const void *local,
                                       size_t nbytes, uint64_t *index,
                                       uint64_t count, fi_addr_t fiAddr,
-                                      Fam_Context *famCtx, size_t iov_limit) {
+                                      Fam_Context *famCtx, size_t iov_limit,
+                                      uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -1190,7 +1230,7 @@ void fabric_scatter_index_nonblocking(uint64_t key, const void *local,
     for (uint64_t i = 0; i < count; i++) {
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
-        rma_iov[i].addr = index[i] * nbytes;
+        rma_iov[i].addr = base + index[i] * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -1214,12 +1254,14 @@ void fabric_scatter_index_nonblocking(uint64_t key, const void *local,
  *  @param index - An array containing element indexes.
  *  @param fiAddr - fi_addr_t address
  *  @param famCtx - Pointer to Fam_Context
+ *  @param base - remote offset the element offsets are relative to
  *  @return - {true(0), false(1), errNo(<0)}
  */
 void fabric_gather_index_nonblocking(uint64_t key, const void *local,
                                      size_t nbytes, uint64_t *index,
                                      uint64_t count, fi_addr_t fiAddr,
-                                     Fam_Context *famCtx, size_t iov_limit) {
+                                     Fam_Context *famCtx, size_t iov_limit,
+                                     uint64_t base) {
 
     struct iovec *iov = new iovec[count];
     struct fi_rma_iov *rma_iov = new fi_rma_iov[count];
@@ -1228,7 +1270,7 @@ void fabric_gather_index_nonblocking(uint64_t key, const void *local,
         iov[i].iov_base = (void *)((uint64_t)local + (i * nbytes));
         iov[i].iov_len = nbytes;
 
-        rma_iov[i].addr = index[i] * nbytes;
+        rma_iov[i].addr = base + index[i] * nbytes;
         rma_iov[i].len = nbytes;
         rma_iov[i].key = key;
     }
@@ -1396,6 +1438,22 @@ void fabric_get_quiet(Fam_Context *famCtx) {
     return;
 }
 
+/*
+ * Reads issued on a context that have not completed yet, as a measure of how
+ * busy the memory server behind it is for this client.
+ */
+uint64_t fabric_pending_reads(Fam_Context *famCtx) {
+    uint64_t rxsuccess = 0;
+    uint64_t rxfail = 0;
+    uint64_t rxcnt = famCtx->get_num_rx_ops();
+
+    FI_CALL(rxsuccess, fi_cntr_read, famCtx->get_rxCntr());
+    FI_CALL(rxfail, fi_cntr_readerr, famCtx->get_rxCntr());
+    if (rxsuccess + rxfail >= rxcnt)
+        return 0;
+    return rxcnt - rxsuccess - rxfail;
+}
+
 void fabric_quiet(Fam_Context *famCtx) {
 
     // Take Fam_Context Write lock
@@ -1582,6 +1640,7 @@ enum Fam_Error get_fam_error(int fabErr) {
     switch (fabErr) {
     case FI_EACCES:
     case FI_EPERM:
+    case FI_EKEYREJECTED:
         return FAM_ERR_NOPERM;
     default:
         return FAM_ERR_LIBFABRIC;
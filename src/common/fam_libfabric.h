@@ -69,6 +69,9 @@ int fabric_initialize_av(struct fi_info *fi, struct fid_domain *domain,
 int fabric_insert_av(const char *addr, struct fid_av *av,
                      std::vector<fi_addr_t> *fiAddrs);
 
+int fabric_insert_av_batch(const char *addrs, size_t count, struct fid_av *av,
+                           std::vector<fi_addr_t> *fiAddrs);
+
 int fabric_enable_bind_ep(struct fi_info *fi, struct fid_av *av,
                           struct fid_eq *eq, struct fid_ep *ep);
 
@@ -83,26 +86,33 @@ int fabric_write(uint64_t key, const void *local, size_t nbytes,
 int fabric_read(uint64_t key, const void *local, size_t nbytes, uint64_t offset,
                 fi_addr_t fiAddr, Fam_Context *famCtx);
 
+int fabric_read_write_multi_msg(uint64_t count, size_t iov_limit,
+                                fi_addr_t fiAddr, Fam_Context *famCtx,
+                                struct iovec *iov, struct fi_rma_iov *rma_iov,
+                                bool write, bool block);
+
 int fabric_scatter_stride_blocking(uint64_t key, const void *local,
                                    size_t nbytes, uint64_t first,
                                    uint64_t count, uint64_t stride,
                                    fi_addr_t fiAddr, Fam_Context *famCtx,
-                                   size_t iov_limit);
+                                   size_t iov_limit, uint64_t base);
 
 int fabric_gather_stride_blocking(uint64_t key, const void *local,
                                   size_t nbytes, uint64_t first, uint64_t count,
                                   uint64_t stride, fi_addr_t fiAddr,
-                                  Fam_Context *famCtx, size_t iov_limit);
+                                  Fam_Context *famCtx, size_t iov_limit,
+                                  uint64_t base);
 
 int fabric_scatter_index_blocking(uint64_t key, const void *local,
                                   size_t nbytes, uint64_t *index,
                                   uint64_t count, fi_addr_t fiAddr,
-                                  Fam_Context *famCtx, size_t iov_limit);
+                                  Fam_Context *famCtx, size_t iov_limit,
+                                  uint64_t base);
 
 int fabric_gather_index_blocking(uint64_t key, const void *local, size_t nbytes,
                                  uint64_t *index, uint64_t count,
                                  fi_addr_t fiAddr, Fam_Context *famCtx,
-                                 size_t iov_limit);
+                                 size_t iov_limit, uint64_t base);
 void fabric_write_nonblocking(uint64_t key, const void *local, size_t nbytes,
                               uint64_t offset, fi_addr_t fiAddr,
                               Fam_Context *famCtx);
@@ -115,28 +125,32 @@ void fabric_scatter_stride_nonblocking(uint64_t key, const void *local,
                                        size_t nbytes, uint64_t first,
                                        uint64_t count, uint64_t stride,
                                        fi_addr_t fiAddr, Fam_Context *famCtx,
-                                       size_t iov_limit);
+                                       size_t iov_limit, uint64_t base);
 
 void fabric_gather_stride_nonblocking(uint64_t key, const void *local,
                                       size_t nbytes, uint64_t first,
                                       uint64_t count, uint64_t stride,
                                       fi_addr_t fiAddr, Fam_Context *famCtx,
-                                      size_t iov_limit);
+                                      size_t iov_limit, uint64_t base);
 
 void fabric_scatter_index_nonblocking(uint64_t key, const void *local,
                                       size_t nbytes, uint64_t *index,
                                       uint64_t count, fi_addr_t fiAddr,
-                                      Fam_Context *famCtx, size_t iov_limit);
+                                      Fam_Context *famCtx, size_t iov_limit,
+                                      uint64_t base);
 
 void fabric_gather_index_nonblocking(uint64_t key, const void *local,
                                      size_t nbytes, uint64_t *index,
                                      uint64_t count, fi_addr_t fiAddr,
-                                     Fam_Context *famCtx, size_t iov_limit);
+                                     Fam_Context *famCtx, size_t iov_limit,
+                                     uint64_t base);
 
 void fabric_fence(fi_addr_t fiAddr, Fam_Context *context);
 
 void fabric_quiet(Fam_Context *context);
 
+uint64_t fabric_pending_reads(Fam_Context *famCtx);
+
 int fabric_retry(Fam_Context *context, int ret, uint64_t *retry_cnt);
 
 int fabric_completion_wait(Fam_Context *famCtx, fi_context *ctx);
@@ -310,7 +310,24 @@ class Fam_Ops {
                        Fam_Descriptor **dest, uint64_t destOffset,
                        uint64_t nbytes) = 0;
 
+    /**
+     * Copy data from one FAM-resident data item into an existing FAM-resident
+     * data item, without allocating a destination data item.
+     * @param src - valid descriptor to source data item in FAM.
+     * @param srcOffset - byte offset within the space defined by the src
+     * descriptor from which memory should be copied.
+     * @param dest - valid descriptor to existing destination data item in FAM.
+     * @param destOffset - byte offset within the space defined by the dest
+     * descriptor to which memory should be copied.
+     * @param nbytes - number of bytes to be copied
+     */
+    virtual void *copy(Fam_Descriptor *src, uint64_t srcOffset,
+                       Fam_Descriptor *dest, uint64_t destOffset,
+                       uint64_t nbytes) = 0;
+
     virtual void wait_for_copy(void *waitObj) = 0;
+
+    virtual uint64_t copy_progress(void *waitObj) = 0;
     // ATOMICS Group
 
     // NON fetching routines
@@ -30,6 +30,7 @@
 #ifndef FAM_OPS_LIBFABRIC_H
 #define FAM_OPS_LIBFABRIC_H
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <string.h>
@@ -37,6 +38,7 @@
 #include <thread>
 #include <vector>
 
+#include <boost/atomic.hpp>
 #include <rdma/fabric.h>
 #include <rdma/fi_atomic.h>
 #include <rdma/fi_cm.h>
@@ -48,6 +50,7 @@
 #include "allocator/fam_allocator.h"
 #include "allocator/fam_allocator_grpc.h"
 #include "common/fam_context.h"
+#include "common/fam_internal.h"
 #include "common/fam_ops.h"
 #include "common/fam_options.h"
 #include "fam/fam.h"
@@ -56,6 +59,11 @@ using namespace std;
 
 using MemServerMap = std::map<uint64_t, std::string>;
 
+// Gets of a mirrored data item at least this large are split between copies
+#define FAM_MIRROR_SPLIT_SIZE (256UL << 10)
+// Parity computed by a RAID5 put before its pieces are issued
+#define FAM_PARITY_BATCH_SIZE (4UL << 20)
+
 namespace openfam {
 
 class Fam_Ops_Libfabric : public Fam_Ops {
@@ -69,6 +77,8 @@ class Fam_Ops_Libfabric : public Fam_Ops {
      * @param source -  to indicate if it is called by a memory node
      * @param provider - libfabric provider
      * @param famTM - Fam Thread Model
+     * @param famCnM - Fam Connect Model, memory servers are inserted into
+     * the address vector all at once in initialize() or each on first use
      * @return - {true(0), false(1), errNo(<0)}
      */
     Fam_Ops_Libfabric(const char *name, const char *service, bool is_source,
@@ -79,7 +89,8 @@ class Fam_Ops_Libfabric : public Fam_Ops {
     Fam_Ops_Libfabric(MemServerMap name, const char *service, bool is_source,
                       char *provider, Fam_Thread_Model famTM,
                       Fam_Allocator *famAlloc,
-                      Fam_Context_Model famCM = FAM_CONTEXT_DEFAULT);
+                      Fam_Context_Model famCM = FAM_CONTEXT_DEFAULT,
+                      Fam_Connect_Model famCnM = FAM_CONNECT_EAGER);
     /**
      * Initialize the libfabric library. This method is required to be the first
      * method called when a process uses the OpenFAM library.
@@ -140,8 +151,13 @@ class Fam_Ops_Libfabric : public Fam_Ops {
     void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor **dest,
                uint64_t destOffset, uint64_t nbytes);
 
+    void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor *dest,
+               uint64_t destOffset, uint64_t nbytes);
+
     void wait_for_copy(void *waitObj);
 
+    uint64_t copy_progress(void *waitObj);
+
     void fence(Fam_Region_Descriptor *descriptor = NULL);
 
     void quiet(Fam_Region_Descriptor *descriptor = NULL);
@@ -317,6 +333,20 @@ class Fam_Ops_Libfabric : public Fam_Ops {
     std::vector<fi_addr_t> *get_fiAddrs() {
         return fiAddrs;
     };
+    /*
+     * Address of a memory server in the address vector. With
+     * FAM_CONNECT_LAZY the server is inserted on its first use.
+     */
+    fi_addr_t get_fiAddr(uint64_t nodeId) {
+        if (serverReady &&
+            !serverReady[nodeId].load(boost::memory_order_acquire))
+            connect_memserver(nodeId);
+        return (*fiAddrs)[nodeId];
+    };
+    bool is_memserver_ready(uint64_t nodeId) {
+        return !serverReady ||
+               serverReady[nodeId].load(boost::memory_order_acquire);
+    };
     std::map<uint64_t, fid_mr *> *get_fiMrs() {
         return fiMrs;
     };
@@ -351,6 +381,46 @@ class Fam_Ops_Libfabric : public Fam_Ops {
 
     Fam_Context *get_context(Fam_Descriptor *descriptor);
 
+    /*
+     * Remote offset of offset within the data item. The keys of region-wide
+     * registrations cover the whole region, so the data item offset is added.
+     */
+    uint64_t get_rma_offset(Fam_Descriptor *descriptor, uint64_t offset) {
+        if (FAM_KEY_IS_REGION(descriptor->get_key()))
+            return descriptor->get_global_descriptor().offset + offset;
+        return offset;
+    }
+
+    /*
+     * Part of a striped data item holding offset, which is changed to the
+     * offset within that part. The first copy of a mirrored data item, which
+     * orders atomics on it. Other data items are returned as they are.
+     */
+    Fam_Descriptor *get_stripe(Fam_Descriptor *descriptor, uint64_t &offset) {
+        if (fam_stripe_count(descriptor) == 1)
+            return descriptor;
+        if (fam_is_mirrored(descriptor))
+            return descriptor->get_stripe(0);
+        Fam_Stripe_Layout layout = descriptor->get_layout();
+        Fam_Descriptor *stripe =
+            descriptor->get_stripe(fam_stripe_of(offset, layout, offset));
+        if (stripe == NULL)
+            throw Fam_Datapath_Exception("Offset beyond the data item");
+        return stripe;
+    }
+
+    /*
+     * Address of another memory server, as returned by its get_addr(), in the
+     * address vector. Used by a memory server writing straight into a peer.
+     */
+    fi_addr_t get_peer_fiAddr(const void *addr, size_t addrLen);
+
+    /*
+     * New endpoint owned by the caller, so that its completions and errors
+     * are not shared with other operations.
+     */
+    Fam_Context *create_context();
+
     void quiet_context(Fam_Context *context);
 
     size_t get_addr_size() {
@@ -362,6 +432,44 @@ class Fam_Ops_Libfabric : public Fam_Ops {
     };
 
   protected:
+    int access_striped(void *local, Fam_Descriptor *descriptor,
+                       uint64_t offset, uint64_t nbytes, bool write,
+                       bool block);
+    int access_mirrored(void *local, Fam_Descriptor *descriptor,
+                        uint64_t offset, uint64_t nbytes, bool write,
+                        bool block);
+    int put_parity(void *local, Fam_Descriptor *descriptor, uint64_t offset,
+                   uint64_t nbytes);
+
+    /*
+     * Atomics on a mirrored data item run on its first copy, and their
+     * updates are then applied to the other copies, all under the CAS lock
+     * of the first copy so that every copy sees them in the same order.
+     * Other data items go to the part holding offset; on a RAID5 data item,
+     * the change made by the atomic is then XORed into the parity of its
+     * row, under the CAS lock of the parity member of the row.
+     */
+    std::vector<Fam_Descriptor *> get_copies(Fam_Descriptor *descriptor,
+                                             uint64_t &offset);
+    Fam_Descriptor *get_write_lock(Fam_Descriptor *descriptor,
+                                   uint64_t offset);
+    void with_locks(std::vector<Fam_Descriptor *> locks,
+                    std::function<void()> op);
+    void order_writes(Fam_Descriptor *descriptor, uint64_t offset,
+                      std::function<void()> op);
+    void update_atomic(Fam_Descriptor *descriptor, uint64_t offset,
+                       void *value, enum fi_op op, enum fi_datatype datatype);
+    void fetch_atomic(Fam_Descriptor *descriptor, uint64_t offset, void *value,
+                      void *result, enum fi_op op, enum fi_datatype datatype);
+    void compare_atomic(Fam_Descriptor *descriptor, uint64_t offset,
+                        void *compare, void *result, void *value, size_t size,
+                        enum fi_datatype datatype);
+    void update_parity(Fam_Descriptor *descriptor, uint64_t offset,
+                       const void *old, const void *value, size_t size);
+    std::string get_memserver_addr(uint64_t nodeId);
+    int connect_memservers();
+    void connect_memserver(uint64_t nodeId);
+
     MemServerMap name;
     char *service;
     char *provider;
@@ -377,14 +485,20 @@ class Fam_Ops_Libfabric : public Fam_Ops {
 
     pthread_mutex_t fiMrLock;
     pthread_mutex_t ctxLock;
+    pthread_mutex_t peerLock;
+    pthread_mutex_t connectLock;
 
     std::vector<fi_addr_t> *fiAddrs;
+    // Set once the address of a memory server is in fiAddrs; NULL on servers
+    boost::atomic<bool> *serverReady;
     std::map<uint64_t, fid_mr *> *fiMrs;
+    std::map<std::string, fi_addr_t> *peerAddrs;
 
     std::map<uint64_t, Fam_Context *> *contexts;
     std::map<uint64_t, Fam_Context *> *defContexts;
     Fam_Thread_Model famThreadModel;
     Fam_Context_Model famContextModel;
+    Fam_Connect_Model famConnectModel;
     Fam_Allocator *famAllocator;
 };
 } // namespace openfam
@@ -48,12 +48,15 @@ enum { FAM_MIN = 0, FAM_MAX, FAM_BOR, FAM_BAND, FAM_BXOR, FAM_SUM };
 
 enum { INT32 = 0, UINT32, INT64, UINT64, FLOAT, DOUBLE };
 
+typedef void (*Fam_Atomic_Handler)(void *dst, const void *src, void *&res);
+
 using namespace std;
 namespace openfam {
 class Fam_Ops_NVMM : public Fam_Ops {
   public:
     Fam_Ops_NVMM(Fam_Thread_Model famTM, Fam_Context_Model famCM,
-                 Fam_Allocator *famAlloc, uint64_t numConsumer);
+                 Fam_Allocator *famAlloc, uint64_t numConsumer,
+                 Fam_Atomic_Model famAM = FAM_ATOMIC_LIBRARY);
     ~Fam_Ops_NVMM();
 
     int initialize();
@@ -107,8 +110,13 @@ class Fam_Ops_NVMM : public Fam_Ops {
     void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor **dest,
                uint64_t destOffset, uint64_t nbytes);
 
+    void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor *dest,
+               uint64_t destOffset, uint64_t nbytes);
+
     void wait_for_copy(void *waitObj);
 
+    uint64_t copy_progress(void *waitObj);
+
     void fence(Fam_Region_Descriptor *descriptor = NULL);
 
     void quiet(Fam_Region_Descriptor *descriptor = NULL);
@@ -283,6 +291,8 @@ class Fam_Ops_NVMM : public Fam_Ops {
 
     void quiet_context(Fam_Context *context);
 
+    void fence_context(Fam_Context *context);
+
   protected:
     Fam_Async_QHandler *asyncQHandler;
 
@@ -292,6 +302,9 @@ class Fam_Ops_NVMM : public Fam_Ops {
     std::map<uint64_t, Fam_Context *> *contexts;
     Fam_Thread_Model famThreadModel;
     Fam_Context_Model famContextModel;
+    Fam_Atomic_Model famAtomicModel;
+    // fam_atomic_readwrite_handlers or fam_cpu_readwrite_handlers
+    Fam_Atomic_Handler (*atomicHandlers)[6];
     Fam_Allocator *famAllocator;
 };
 } // end namespace openfam
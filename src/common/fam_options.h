@@ -68,6 +68,16 @@ typedef enum {
     RUNTIME,
     /**Number of consumer threads in case of shared memory model**/
     NUM_CONSUMER,
+    /** Atomic model for shared memory model, libfam_atomic or CPU atomics */
+    FAM_ATOMIC_MODEL,
+    /** Lease of the client side metadata cache in milliseconds */
+    METADATA_CACHE_LEASE,
+    /** Connect to all memory servers at start or each on first use */
+    FAM_CONNECT_MODEL,
+    /** Policy choosing the memory server of new regions */
+    REGION_PLACEMENT,
+    /** Whether redundancy levels spread regions across memory servers */
+    FAM_REDUNDANCY_MODEL,
     /** END of Option keys */
     END_OPT = -1
 } Fam_Option_Key;
@@ -88,6 +98,20 @@ typedef enum {
 #define FAM_OPTIONS_RUNTIME_PMI2_STR "PMI2"
 #define FAM_OPTIONS_RUNTIME_NONE_STR "NONE"
 
+#define FAM_ATOMIC_LIBRARY_STR "FAM_ATOMIC_LIBRARY"
+#define FAM_ATOMIC_CPU_STR "FAM_ATOMIC_CPU"
+
+#define FAM_CONNECT_EAGER_STR "FAM_CONNECT_EAGER"
+#define FAM_CONNECT_LAZY_STR "FAM_CONNECT_LAZY"
+
+#define FAM_PLACEMENT_HASH_STR "FAM_PLACEMENT_HASH"
+#define FAM_PLACEMENT_CONSISTENT_HASH_STR "FAM_PLACEMENT_CONSISTENT_HASH"
+#define FAM_PLACEMENT_CAPACITY_STR "FAM_PLACEMENT_CAPACITY"
+#define FAM_PLACEMENT_ROUND_ROBIN_STR "FAM_PLACEMENT_ROUND_ROBIN"
+
+#define FAM_REDUNDANCY_MEMSERVER_STR "FAM_REDUNDANCY_MEMSERVER"
+#define FAM_REDUNDANCY_ACROSS_MEMSERVERS_STR "FAM_REDUNDANCY_ACROSS_MEMSERVERS"
+
 typedef enum {
     /** For single threaded applicaiton */
     FAM_THREAD_SERIALIZE = 1,
@@ -100,4 +124,37 @@ typedef enum {
     FAM_CONTEXT_REGION
 } Fam_Context_Model;
 
+typedef enum {
+    /** Atomics through libfam_atomic, works on non-coherent FAM */
+    FAM_ATOMIC_LIBRARY = 1,
+    /** Native CPU atomics, FAM must be cache coherent shared memory */
+    FAM_ATOMIC_CPU
+} Fam_Atomic_Model;
+
+typedef enum {
+    /** Connect to every memory server, all at once, in fam_initialize */
+    FAM_CONNECT_EAGER = 1,
+    /** Connect to a memory server when it is first used */
+    FAM_CONNECT_LAZY
+} Fam_Connect_Model;
+
+typedef enum {
+    /** Hash of the region name modulo the number of memory servers */
+    FAM_PLACEMENT_HASH = 1,
+    /** Consistent hashing of the region name */
+    FAM_PLACEMENT_CONSISTENT_HASH,
+    /** Memory server with the most free space */
+    FAM_PLACEMENT_CAPACITY,
+    /** Memory servers in turn */
+    FAM_PLACEMENT_ROUND_ROBIN
+} Fam_Region_Placement_Policy;
+
+typedef enum {
+    /** The redundancy level is left to the memory server of the region */
+    FAM_REDUNDANCY_MEMSERVER = 1,
+    /** RAID1 regions are mirrored on several memory servers, RAID5 regions
+        striped with parity across them */
+    FAM_REDUNDANCY_ACROSS_MEMSERVERS
+} Fam_Redundancy_Model;
+
 #endif
@@ -28,6 +28,11 @@
  *
  */
 
+#include <stdint.h>
+
+#include "common/fam_options.h"
+#include "nvmm/nvmm_fam_atomic.h"
+
 #define FAM_OP_MIN(dst, src) (dst) > (src)
 #define FAM_OP_MAX(dst, src) (dst) < (src)
 #define FAM_OP_BOR(dst, src) (dst | src)
@@ -223,3 +228,259 @@ void (*fam_atomic_readwrite_handlers[6][6])(void *dst, const void *src,
     {FAM_DEFINE_INT_HANDLERS(READWRITEEXT, NAME, FAM_OP_BXOR)},
     {FAM_DEFINE_ALL_HANDLERS(READWRITEEXT, NAME, FAM_OP_SUM)},
 };
+
+/*
+ * CPU atomics, used with FAM_ATOMIC_CPU atomic model when FAM is ordinary
+ * cache coherent memory. Fetch-op forms map onto the native lock prefixed
+ * instructions; min/max and floating point add retry with a hardware CAS.
+ * The old value is kept in thread local storage so that the pointer returned
+ * through res stays valid after the handler returns.
+ */
+#define FAM_CPU_FETCH_BOR(dst, src) __atomic_fetch_or(dst, src, __ATOMIC_SEQ_CST)
+#define FAM_CPU_FETCH_BAND(dst, src)                                           \
+    __atomic_fetch_and(dst, src, __ATOMIC_SEQ_CST)
+#define FAM_CPU_FETCH_BXOR(dst, src)                                           \
+    __atomic_fetch_xor(dst, src, __ATOMIC_SEQ_CST)
+#define FAM_CPU_FETCH_SUM(dst, src)                                            \
+    __atomic_fetch_add(dst, src, __ATOMIC_SEQ_CST)
+
+#define FAM_DEF_CPU_FETCH_NAME(op, type) fam_cpu_readwrite_##op##_##type,
+#define FAM_DEF_CPU_FETCH_FUNC(op, type)                                       \
+    static void fam_cpu_readwrite_##op##_##type(void *dst, const void *src,    \
+                                                void *&res) {                  \
+        static thread_local type oldValue;                                     \
+        oldValue = op((type *)dst, *(const type *)src);                        \
+        res = (void *)&oldValue;                                               \
+    }
+
+#define FAM_DEF_CPU_CAS_NAME(op, type) fam_cpu_readwrite_##op##_##type,
+#define FAM_DEF_CPU_CAS_FUNC(op, type)                                         \
+    static void fam_cpu_readwrite_##op##_##type(void *dst, const void *src,    \
+                                                void *&res) {                  \
+        static thread_local type oldValue;                                     \
+        type *d = (type *)(dst);                                               \
+        type s = *(const type *)(src);                                         \
+        type val;                                                              \
+        __atomic_load(d, &oldValue, __ATOMIC_RELAXED);                         \
+        do {                                                                   \
+            val = op(oldValue, s);                                             \
+        } while (!__atomic_compare_exchange(d, &oldValue, &val, false,         \
+                                            __ATOMIC_SEQ_CST,                  \
+                                            __ATOMIC_RELAXED));                \
+        res = (void *)&oldValue;                                               \
+    }
+
+#define FAM_DEF_CPU_CAS_CMP_NAME(op, type) fam_cpu_readwrite_##op##_##type,
+#define FAM_DEF_CPU_CAS_CMP_FUNC(op, type)                                     \
+    static void fam_cpu_readwrite_##op##_##type(void *dst, const void *src,    \
+                                                void *&res) {                  \
+        static thread_local type oldValue;                                     \
+        type *d = (type *)(dst);                                               \
+        type s = *(const type *)(src);                                         \
+        __atomic_load(d, &oldValue, __ATOMIC_RELAXED);                         \
+        while (op(oldValue, s)) {                                              \
+            if (__atomic_compare_exchange(d, &oldValue, &s, false,             \
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) \
+                break;                                                         \
+        }                                                                      \
+        res = (void *)&oldValue;                                               \
+    }
+
+#define FAM_DEFINE_CPU_ALL_HANDLERS(ATOMICTYPE, FUNCNAME, op)                  \
+    FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, int32_t)                         \
+        FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, uint32_t)                    \
+            FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, int64_t)                 \
+                FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, uint64_t)            \
+                    FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, float)           \
+                        FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, double)
+
+#define FAM_DEFINE_CPU_INT_HANDLERS(ATOMICTYPE, FUNCNAME, op)                  \
+    FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, int32_t)                         \
+        FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, uint32_t)                    \
+            FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, int64_t)                 \
+                FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, uint64_t)
+
+#define FAM_DEFINE_CPU_FLOAT_HANDLERS(ATOMICTYPE, FUNCNAME, op)                \
+    FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, float)                           \
+        FAM_DEF_CPU_##ATOMICTYPE##_##FUNCNAME(op, double)
+
+FAM_DEFINE_CPU_ALL_HANDLERS(CAS_CMP, FUNC, FAM_OP_MIN)
+FAM_DEFINE_CPU_ALL_HANDLERS(CAS_CMP, FUNC, FAM_OP_MAX)
+FAM_DEFINE_CPU_INT_HANDLERS(FETCH, FUNC, FAM_CPU_FETCH_BOR)
+FAM_DEFINE_CPU_INT_HANDLERS(FETCH, FUNC, FAM_CPU_FETCH_BAND)
+FAM_DEFINE_CPU_INT_HANDLERS(FETCH, FUNC, FAM_CPU_FETCH_BXOR)
+FAM_DEFINE_CPU_INT_HANDLERS(FETCH, FUNC, FAM_CPU_FETCH_SUM)
+FAM_DEFINE_CPU_FLOAT_HANDLERS(CAS, FUNC, FAM_OP_SUM)
+
+void (*fam_cpu_readwrite_handlers[6][6])(void *dst, const void *src,
+                                         void *&res) = {
+    {FAM_DEFINE_CPU_ALL_HANDLERS(CAS_CMP, NAME, FAM_OP_MIN)},
+    {FAM_DEFINE_CPU_ALL_HANDLERS(CAS_CMP, NAME, FAM_OP_MAX)},
+    {FAM_DEFINE_CPU_INT_HANDLERS(FETCH, NAME, FAM_CPU_FETCH_BOR)
+         FAM_DEF_NOOP_NAME FAM_DEF_NOOP_NAME},
+    {FAM_DEFINE_CPU_INT_HANDLERS(FETCH, NAME, FAM_CPU_FETCH_BAND)
+         FAM_DEF_NOOP_NAME FAM_DEF_NOOP_NAME},
+    {FAM_DEFINE_CPU_INT_HANDLERS(FETCH, NAME, FAM_CPU_FETCH_BXOR)
+         FAM_DEF_NOOP_NAME FAM_DEF_NOOP_NAME},
+    {FAM_DEFINE_CPU_INT_HANDLERS(FETCH, NAME, FAM_CPU_FETCH_SUM)
+         FAM_DEFINE_CPU_FLOAT_HANDLERS(CAS, NAME, FAM_OP_SUM)},
+};
+
+/*
+ * Scalar primitives with the same shape as the libfam_atomic calls. They
+ * forward to libfam_atomic unless the FAM_ATOMIC_CPU model is selected.
+ */
+static inline bool openfam_cpu_atomics(Fam_Atomic_Model model) {
+    return (model == FAM_ATOMIC_CPU);
+}
+
+static inline void openfam_atomic_32_write(Fam_Atomic_Model model,
+                                           int32_t *addr, int32_t value) {
+    if (openfam_cpu_atomics(model))
+        __atomic_store_n(addr, value, __ATOMIC_SEQ_CST);
+    else
+        fam_atomic_32_write(addr, value);
+}
+
+static inline void openfam_atomic_64_write(Fam_Atomic_Model model,
+                                           int64_t *addr, int64_t value) {
+    if (openfam_cpu_atomics(model))
+        __atomic_store_n(addr, value, __ATOMIC_SEQ_CST);
+    else
+        fam_atomic_64_write(addr, value);
+}
+
+static inline int32_t openfam_atomic_32_read(Fam_Atomic_Model model,
+                                             int32_t *addr) {
+    if (openfam_cpu_atomics(model))
+        return __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+    return fam_atomic_32_read(addr);
+}
+
+static inline int64_t openfam_atomic_64_read(Fam_Atomic_Model model,
+                                             int64_t *addr) {
+    if (openfam_cpu_atomics(model))
+        return __atomic_load_n(addr, __ATOMIC_SEQ_CST);
+    return fam_atomic_64_read(addr);
+}
+
+static inline int32_t openfam_atomic_32_fetch_add(Fam_Atomic_Model model,
+                                                  int32_t *addr,
+                                                  int32_t value) {
+    if (openfam_cpu_atomics(model))
+        return __atomic_fetch_add(addr, value, __ATOMIC_SEQ_CST);
+    return fam_atomic_32_fetch_add(addr, value);
+}
+
+static inline int64_t openfam_atomic_64_fetch_add(Fam_Atomic_Model model,
+                                                  int64_t *addr,
+                                                  int64_t value) {
+    if (openfam_cpu_atomics(model))
+        return __atomic_fetch_add(addr, value, __ATOMIC_SEQ_CST);
+    return fam_atomic_64_fetch_add(addr, value);
+}
+
+static inline int32_t openfam_atomic_32_swap(Fam_Atomic_Model model,
+                                             int32_t *addr, int32_t value) {
+    if (openfam_cpu_atomics(model))
+        return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+    return fam_atomic_32_swap(addr, value);
+}
+
+static inline int64_t openfam_atomic_64_swap(Fam_Atomic_Model model,
+                                             int64_t *addr, int64_t value) {
+    if (openfam_cpu_atomics(model))
+        return __atomic_exchange_n(addr, value, __ATOMIC_SEQ_CST);
+    return fam_atomic_64_swap(addr, value);
+}
+
+static inline int32_t openfam_atomic_32_compare_store(Fam_Atomic_Model model,
+                                                      int32_t *addr,
+                                                      int32_t compare,
+                                                      int32_t store) {
+    if (openfam_cpu_atomics(model)) {
+        __atomic_compare_exchange_n(addr, &compare, store, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        return compare;
+    }
+    return fam_atomic_32_compare_store(addr, compare, store);
+}
+
+static inline int64_t openfam_atomic_64_compare_store(Fam_Atomic_Model model,
+                                                      int64_t *addr,
+                                                      int64_t compare,
+                                                      int64_t store) {
+    if (openfam_cpu_atomics(model)) {
+        __atomic_compare_exchange_n(addr, &compare, store, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+        return compare;
+    }
+    return fam_atomic_64_compare_store(addr, compare, store);
+}
+
+#if defined(__x86_64__)
+/*
+ * 16 byte compare and exchange using cmpxchg16b directly, so that the build
+ * does not depend on -mcx16 or libatomic. addr must be 16 byte aligned.
+ */
+static inline void fam_cpu_cmpxchg16b(int64_t *addr, int64_t compare[2],
+                                      int64_t store[2], int64_t result[2]) {
+    int64_t low = compare[0];
+    int64_t high = compare[1];
+    __asm__ __volatile__("lock cmpxchg16b %0"
+                         : "+m"(*(volatile int64_t(*)[2])addr), "+a"(low),
+                           "+d"(high)
+                         : "b"(store[0]), "c"(store[1])
+                         : "cc", "memory");
+    result[0] = low;
+    result[1] = high;
+}
+#endif
+
+static inline void openfam_atomic_128_compare_store(Fam_Atomic_Model model,
+                                                    int64_t *addr,
+                                                    int64_t compare[2],
+                                                    int64_t store[2],
+                                                    int64_t result[2]) {
+#if defined(__x86_64__)
+    if (openfam_cpu_atomics(model)) {
+        fam_cpu_cmpxchg16b(addr, compare, store, result);
+        return;
+    }
+#endif
+    fam_atomic_128_compare_store(addr, compare, store, result);
+}
+
+static inline void openfam_atomic_128_read(Fam_Atomic_Model model,
+                                           int64_t *addr, int64_t result[2]) {
+#if defined(__x86_64__)
+    if (openfam_cpu_atomics(model)) {
+        // A CAS of zero with zero never changes memory, but returns the
+        // current value atomically
+        int64_t zero[2] = {0, 0};
+        fam_cpu_cmpxchg16b(addr, zero, zero, result);
+        return;
+    }
+#endif
+    fam_atomic_128_read(addr, result);
+}
+
+static inline void openfam_atomic_128_write(Fam_Atomic_Model model,
+                                            int64_t *addr, int64_t value[2]) {
+#if defined(__x86_64__)
+    if (openfam_cpu_atomics(model)) {
+        int64_t expected[2];
+        int64_t current[2];
+        openfam_atomic_128_read(model, addr, expected);
+        for (;;) {
+            fam_cpu_cmpxchg16b(addr, expected, value, current);
+            if ((current[0] == expected[0]) && (current[1] == expected[1]))
+                break;
+            expected[0] = current[0];
+            expected[1] = current[1];
+        }
+        return;
+    }
+#endif
+    fam_atomic_128_write(addr, value);
+}
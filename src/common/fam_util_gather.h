@@ -0,0 +1,246 @@
+/*
+ * fam_util_gather.h
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#ifndef FAM_UTIL_GATHER_H
+#define FAM_UTIL_GATHER_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "common/fam_internal.h"
+
+namespace openfam {
+
+#define FAM_CACHELINE_SIZE ((uint64_t)64)
+#define FAM_CACHELINE_MASK (~(FAM_CACHELINE_SIZE - 1))
+
+/*
+ * Fam_Range_Coalescer accumulates a sequence of byte ranges and applies
+ * a cache maintenance operation (persist or invalidate) once per run of
+ * adjacent or overlapping cache lines, instead of once per range.
+ */
+class Fam_Range_Coalescer {
+  public:
+    Fam_Range_Coalescer(void (*op)(void *, uint64_t))
+        : rangeOp(op), start(0), end(0) {}
+
+    inline void add(void *addr, uint64_t len) {
+        uint64_t lineStart = (uint64_t)addr & FAM_CACHELINE_MASK;
+        uint64_t lineEnd =
+            ((uint64_t)addr + len + FAM_CACHELINE_SIZE - 1) & FAM_CACHELINE_MASK;
+        if ((end != start) && (lineStart <= end) && (lineEnd >= start)) {
+            if (lineStart < start)
+                start = lineStart;
+            if (lineEnd > end)
+                end = lineEnd;
+            return;
+        }
+        flush();
+        start = lineStart;
+        end = lineEnd;
+    }
+
+    inline void flush() {
+        if (end != start)
+            rangeOp((void *)start, end - start);
+        start = end = 0;
+    }
+
+  private:
+    void (*rangeOp)(void *, uint64_t);
+    uint64_t start;
+    uint64_t end;
+};
+
+/*
+ * Fixed size element kernels. The element size is a compile time constant,
+ * so each memcpy is lowered to a single load/store pair and the loops are
+ * left in a form the compiler can vectorize.
+ */
+template <uint64_t ELEMSIZE>
+inline void fam_gather_strided_kernel(char *local, const char *src,
+                                      uint64_t nElements, uint64_t stride) {
+    uint64_t srcStride = stride * ELEMSIZE;
+    for (uint64_t i = 0; i < nElements; i++)
+        memcpy(local + i * ELEMSIZE, src + i * srcStride, ELEMSIZE);
+}
+
+template <uint64_t ELEMSIZE>
+inline void fam_gather_indexed_kernel(char *local, const char *base,
+                                      uint64_t nElements,
+                                      const uint64_t *elementIndex) {
+    for (uint64_t i = 0; i < nElements; i++)
+        memcpy(local + i * ELEMSIZE, base + elementIndex[i] * ELEMSIZE,
+               ELEMSIZE);
+}
+
+template <uint64_t ELEMSIZE>
+inline void fam_scatter_strided_kernel(const char *local, char *dest,
+                                       uint64_t nElements, uint64_t stride) {
+    uint64_t destStride = stride * ELEMSIZE;
+    for (uint64_t i = 0; i < nElements; i++)
+        memcpy(dest + i * destStride, local + i * ELEMSIZE, ELEMSIZE);
+}
+
+template <uint64_t ELEMSIZE>
+inline void fam_scatter_indexed_kernel(const char *local, char *base,
+                                       uint64_t nElements,
+                                       const uint64_t *elementIndex) {
+    for (uint64_t i = 0; i < nElements; i++)
+        memcpy(base + elementIndex[i] * ELEMSIZE, local + i * ELEMSIZE,
+               ELEMSIZE);
+}
+
+/*
+ * Copy routines used by the shared memory datapath. src/dest point at the
+ * first element in FAM; stride is expressed in elements.
+ */
+inline void fam_gather_strided(void *local, void *src, uint64_t nElements,
+                               uint64_t stride, uint64_t elementSize) {
+    char *l = (char *)local;
+    const char *s = (const char *)src;
+    switch (elementSize) {
+    case 4:
+        fam_gather_strided_kernel<4>(l, s, nElements, stride);
+        break;
+    case 8:
+        fam_gather_strided_kernel<8>(l, s, nElements, stride);
+        break;
+    case 16:
+        fam_gather_strided_kernel<16>(l, s, nElements, stride);
+        break;
+    default:
+        for (uint64_t i = 0; i < nElements; i++)
+            memcpy(l + i * elementSize, s + i * stride * elementSize,
+                   elementSize);
+        break;
+    }
+}
+
+inline void fam_gather_indexed(void *local, void *base, uint64_t nElements,
+                               uint64_t *elementIndex, uint64_t elementSize) {
+    char *l = (char *)local;
+    const char *b = (const char *)base;
+    switch (elementSize) {
+    case 4:
+        fam_gather_indexed_kernel<4>(l, b, nElements, elementIndex);
+        break;
+    case 8:
+        fam_gather_indexed_kernel<8>(l, b, nElements, elementIndex);
+        break;
+    case 16:
+        fam_gather_indexed_kernel<16>(l, b, nElements, elementIndex);
+        break;
+    default:
+        for (uint64_t i = 0; i < nElements; i++)
+            memcpy(l + i * elementSize, b + elementIndex[i] * elementSize,
+                   elementSize);
+        break;
+    }
+}
+
+inline void fam_scatter_strided(void *local, void *dest, uint64_t nElements,
+                                uint64_t stride, uint64_t elementSize) {
+    const char *l = (const char *)local;
+    char *d = (char *)dest;
+    switch (elementSize) {
+    case 4:
+        fam_scatter_strided_kernel<4>(l, d, nElements, stride);
+        break;
+    case 8:
+        fam_scatter_strided_kernel<8>(l, d, nElements, stride);
+        break;
+    case 16:
+        fam_scatter_strided_kernel<16>(l, d, nElements, stride);
+        break;
+    default:
+        for (uint64_t i = 0; i < nElements; i++)
+            memcpy(d + i * stride * elementSize, l + i * elementSize,
+                   elementSize);
+        break;
+    }
+}
+
+inline void fam_scatter_indexed(void *local, void *base, uint64_t nElements,
+                                uint64_t *elementIndex, uint64_t elementSize) {
+    const char *l = (const char *)local;
+    char *b = (char *)base;
+    switch (elementSize) {
+    case 4:
+        fam_scatter_indexed_kernel<4>(l, b, nElements, elementIndex);
+        break;
+    case 8:
+        fam_scatter_indexed_kernel<8>(l, b, nElements, elementIndex);
+        break;
+    case 16:
+        fam_scatter_indexed_kernel<16>(l, b, nElements, elementIndex);
+        break;
+    default:
+        for (uint64_t i = 0; i < nElements; i++)
+            memcpy(b + elementIndex[i] * elementSize, l + i * elementSize,
+                   elementSize);
+        break;
+    }
+}
+
+/*
+ * Apply op over the cache lines touched by a strided or indexed element set.
+ * Runs of neighbouring elements are merged, so dense access patterns result
+ * in a single range-level call.
+ */
+inline void fam_range_op_strided(void (*op)(void *, uint64_t), void *addr,
+                                 uint64_t nElements, uint64_t stride,
+                                 uint64_t elementSize) {
+    if (nElements == 0)
+        return;
+    Fam_Range_Coalescer coalescer(op);
+    char *a = (char *)addr;
+    if (stride * elementSize <= FAM_CACHELINE_SIZE) {
+        // Every cache line of the span holds at least one element
+        coalescer.add(a, (nElements - 1) * stride * elementSize + elementSize);
+    } else {
+        for (uint64_t i = 0; i < nElements; i++)
+            coalescer.add(a + i * stride * elementSize, elementSize);
+    }
+    coalescer.flush();
+}
+
+inline void fam_range_op_indexed(void (*op)(void *, uint64_t), void *base,
+                                 uint64_t nElements, uint64_t *elementIndex,
+                                 uint64_t elementSize) {
+    Fam_Range_Coalescer coalescer(op);
+    char *b = (char *)base;
+    for (uint64_t i = 0; i < nElements; i++)
+        coalescer.add(b + elementIndex[i] * elementSize, elementSize);
+    coalescer.flush();
+}
+
+} // namespace openfam
+
+#endif /* FAM_UTIL_GATHER_H */
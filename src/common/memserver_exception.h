@@ -76,7 +76,8 @@ enum Memserver_Error {
     DATAITEM_NAME_TOO_LONG = -34,
     REGION_RESIZE_NOT_PERMITTED = -35,
     REGION_NOT_MODIFIED = -36,
-    RESIZE_FAILED = -37
+    RESIZE_FAILED = -37,
+    INVALID_ARGUMENT = -38
 };
 
 class Memserver_Exception : public Fam_Exception {
@@ -27,6 +27,8 @@
  * See https://spdx.org/licenses/BSD-3-Clause
  *
  */
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -35,6 +37,7 @@
 #include "allocator/fam_allocator.h"
 #include "allocator/fam_allocator_grpc.h"
 #include "allocator/fam_allocator_nvmm.h"
+#include "allocator/fam_region_placement.h"
 #include "common/fam_libfabric.h"
 #include "common/fam_ops.h"
 #include "common/fam_ops_libfabric.h"
@@ -55,20 +58,25 @@ using namespace std;
  * List of Options supported by this OpenFAM implementation.
  * Defined as static list of option array.
  */
-const char *supportedOptionList[] = { "VERSION",             // index #0
-                                      "DEFAULT_REGION_NAME", // index #1
-                                      "MEMORY_SERVER",       // index #2
-                                      "GRPC_PORT",           // index #3
-                                      "LIBFABRIC_PORT",      // index #4
-                                      "LIBFABRIC_PROVIDER",  // index #5
-                                      "FAM_THREAD_MODEL",    // index #6
-                                      "ALLOCATOR",           // index #7
-                                      "FAM_CONTEXT_MODEL",   // index #8
-                                      "PE_COUNT",            // index #9
-                                      "PE_ID",               // index #10
-                                      "RUNTIME",             // index #11
-                                      "NUM_CONSUMER",        // index #12
-                                      NULL                   // index #13
+const char *supportedOptionList[] = { "VERSION",              // index #0
+                                      "DEFAULT_REGION_NAME",  // index #1
+                                      "MEMORY_SERVER",        // index #2
+                                      "GRPC_PORT",            // index #3
+                                      "LIBFABRIC_PORT",       // index #4
+                                      "LIBFABRIC_PROVIDER",   // index #5
+                                      "FAM_THREAD_MODEL",     // index #6
+                                      "ALLOCATOR",            // index #7
+                                      "FAM_CONTEXT_MODEL",    // index #8
+                                      "PE_COUNT",             // index #9
+                                      "PE_ID",                // index #10
+                                      "RUNTIME",              // index #11
+                                      "NUM_CONSUMER",         // index #12
+                                      "FAM_ATOMIC_MODEL",     // index #13
+                                      "METADATA_CACHE_LEASE", // index #14
+                                      "FAM_CONNECT_MODEL",    // index #15
+                                      "REGION_PLACEMENT",     // index #16
+                                      "FAM_REDUNDANCY_MODEL", // index #17
+                                      NULL                    // index #18
 };
 
 namespace openfam {
@@ -86,6 +94,7 @@ class fam::Impl_ {
         famOps = NULL;
         famAllocator = NULL;
         famRuntime = NULL;
+        regionPlacement = NULL;
         memset((void *)&famOptions, 0, sizeof(Fam_Options));
     }
 
@@ -94,6 +103,8 @@ class fam::Impl_ {
             free(groupName);
         if (famOps)
             delete (famOps);
+        if (regionPlacement)
+            delete regionPlacement;
         if (famAllocator)
             delete famAllocator;
         if (famRuntime)
@@ -116,14 +127,46 @@ class fam::Impl_ {
 
     Fam_Descriptor *fam_lookup(const char *itemName, const char *regionName);
 
+    void fam_lookup_batch(const char **itemNames, const char *regionName,
+                          uint64_t nItems, Fam_Descriptor **items);
+
+    Fam_Region_Descriptor *fam_lookup_region_shared(const char *name);
+
+    Fam_Descriptor *fam_lookup_shared(const char *itemName,
+                                      const char *regionName);
+
+    void fam_export(Fam_Descriptor *descriptor,
+                    Fam_Exported_Descriptor *exported);
+
+    void fam_export(Fam_Region_Descriptor *descriptor,
+                    Fam_Exported_Descriptor *exported);
+
+    Fam_Descriptor *fam_import(Fam_Exported_Descriptor *exported);
+
+    Fam_Region_Descriptor *fam_import_region(Fam_Exported_Descriptor *exported);
+
     Fam_Region_Descriptor *
     fam_create_region(const char *name, uint64_t size, mode_t permissions,
                       Fam_Redundancy_Level redundancyLevel, ...);
 
+    Fam_Region_Descriptor *
+    fam_create_region_on(const char *name, uint64_t size, mode_t permissions,
+                         Fam_Redundancy_Level redundancyLevel,
+                         uint64_t memoryServerId);
+
+    Fam_Region_Descriptor *
+    fam_create_region_striped(const char *name, uint64_t size,
+                              mode_t permissions,
+                              Fam_Redundancy_Level redundancyLevel,
+                              uint64_t stripeCount, uint64_t stripeSize);
+
     void fam_destroy_region(Fam_Region_Descriptor *descriptor);
 
     int fam_resize_region(Fam_Region_Descriptor *descriptor, uint64_t nbytes);
 
+    int fam_set_region_growth(Fam_Region_Descriptor *descriptor,
+                              uint64_t growLimit);
+
     Fam_Descriptor *fam_allocate(uint64_t nbytes, mode_t accessPermissions,
                                  Fam_Region_Descriptor *region);
     Fam_Descriptor *fam_allocate(const char *name, uint64_t nbytes,
@@ -132,6 +175,13 @@ class fam::Impl_ {
 
     void fam_deallocate(Fam_Descriptor *descriptor);
 
+    void fam_allocate_batch(const char **names, uint64_t *nbytes,
+                            mode_t accessPermissions,
+                            Fam_Region_Descriptor *region, uint64_t nItems,
+                            Fam_Descriptor **items);
+
+    void fam_deallocate_batch(Fam_Descriptor **items, uint64_t nItems);
+
     int fam_change_permissions(Fam_Descriptor *descriptor,
                                mode_t accessPermissions);
 
@@ -154,7 +204,8 @@ class fam::Impl_ {
     void fam_put_nonblocking(void *local, Fam_Descriptor *descriptor,
                              uint64_t offset, uint64_t nbytes);
 
-    void *fam_map(Fam_Descriptor *descriptor);
+    void *fam_map(Fam_Descriptor *descriptor,
+                  uint32_t mapFlags = FAM_MAP_DEFAULT);
 
     void fam_unmap(void *local, Fam_Descriptor *descriptor);
 
@@ -193,8 +244,13 @@ class fam::Impl_ {
     void *fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
                    Fam_Descriptor **dest, uint64_t destOffset, uint64_t nbytes);
 
+    void *fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
+                   Fam_Descriptor *dest, uint64_t destOffset, uint64_t nbytes);
+
     void fam_copy_wait(void *waitObj);
 
+    uint64_t fam_copy_progress(void *waitObj);
+
     void fam_set(Fam_Descriptor *descriptor, uint64_t offset, int32_t value);
     void fam_set(Fam_Descriptor *descriptor, uint64_t offset, int64_t value);
     void fam_set(Fam_Descriptor *descriptor, uint64_t offset, int128_t value);
@@ -348,6 +404,7 @@ class fam::Impl_ {
     int validate_fam_options(Fam_Options *options);
     void clean_fam_options();
     int validate_item(Fam_Descriptor *descriptor);
+    int retry_refreshed(Fam_Descriptor *descriptor, std::function<int()> op);
 
   private:
     uid_t uid;
@@ -360,12 +417,93 @@ class fam::Impl_ {
     Fam_Allocator *famAllocator;
     Fam_Thread_Model famThreadModel;
     Fam_Context_Model famContextModel;
+    Fam_Atomic_Model famAtomicModel;
+    Fam_Connect_Model famConnectModel;
+    Fam_Region_Placement_Policy placementPolicy;
+    Fam_Region_Placement *regionPlacement;
+    Fam_Redundancy_Model famRedundancyModel;
     Fam_Runtime *famRuntime;
     uint64_t memoryServerCount;
-    uint64_t generate_memory_server_id(const char *name) {
-        std::uint64_t hashVal = std::hash<std::string> {}
-        (name);
-        return hashVal % memoryServerCount;
+    void lookup_shared(std::function<void(Fam_Exported_Descriptor *)> lookup,
+                       Fam_Exported_Descriptor *exported);
+    void lookup_placed(const char *regionName,
+                       std::function<void(uint64_t)> lookup);
+    bool region_exists(const char *name);
+    bool name_taken(const char *name, uint64_t memoryServerId);
+    Fam_Region_Descriptor *
+    create_region_on(const char *name, uint64_t size, mode_t permissions,
+                     Fam_Redundancy_Level redundancyLevel,
+                     uint64_t memoryServerId,
+                     Fam_Stripe_Layout layout = {0, 1, 0, NONE});
+    uint64_t stripe_server(Fam_Stripe_Layout layout, uint64_t memoryServerId,
+                           uint64_t index);
+    Fam_Region_Descriptor *join_region_stripes(const char *name,
+                                               Fam_Region_Descriptor *found,
+                                               uint64_t memoryServerId);
+    Fam_Descriptor *join_item_stripes(const char *itemName,
+                                      const char *regionName,
+                                      Fam_Descriptor *found,
+                                      uint64_t memoryServerId);
+    Fam_Region_Descriptor *
+    create_members(const char *name, uint64_t memberSize, mode_t permissions,
+                   uint64_t memoryServerId, Fam_Stripe_Layout layout);
+    Fam_Descriptor *allocate_striped(const char *name, uint64_t nbytes,
+                                     mode_t accessPermissions,
+                                     Fam_Region_Descriptor *region);
+
+    // Run op on each member part of a striped region or data item, or on
+    // the descriptor itself if it is not striped
+    template <typename Descriptor, typename Op>
+    void for_each_stripe(Descriptor *descriptor, Op op) {
+        for (uint64_t i = 0; i < fam_stripe_count(descriptor); i++) {
+            Descriptor *stripe = descriptor->get_stripe(i);
+            if (stripe)
+                op(stripe);
+        }
+    }
+
+    // Delete the member descriptors gathered so far, and their array
+    template <typename Descriptor>
+    void delete_stripes(Descriptor **stripes, uint64_t count) {
+        for (uint64_t i = 0; i < count; i++)
+            delete stripes[i];
+        delete[] stripes;
+    }
+
+    // Operations carried out by a single memory server are not available on
+    // striped regions and data items; on mirrored ones they read any copy
+    // and write every copy
+    template <typename Descriptor>
+    void check_not_striped(Descriptor *descriptor) {
+        if ((fam_stripe_count(descriptor) > 1) && !fam_is_mirrored(descriptor))
+            throw Fam_InvalidOption_Exception(
+                "Operation not supported on striped data items");
+    }
+
+    // Mappings only reach one memory server, so neither striped nor
+    // mirrored regions and data items have them
+    template <typename Descriptor>
+    void check_one_member(Descriptor *descriptor) {
+        if (fam_stripe_count(descriptor) > 1)
+            throw Fam_InvalidOption_Exception(
+                "Operation not supported on striped or mirrored data items");
+    }
+
+    // Whether the members of an exported descriptor match its layout; a
+    // region has every member, a data item at least a part on the first
+    bool valid_members(Fam_Exported_Descriptor *exported) {
+        uint64_t count = exported->memberCount;
+        if (count == 0)
+            return true;
+        if ((count > FAM_EXPORT_MAX_MEMBERS) ||
+            (count != exported->layout.stripeCount))
+            return false;
+        for (uint64_t i = 0; i < count; i++) {
+            if (!exported->members[i].present &&
+                ((i == 0) || exported->isRegion))
+                return false;
+        }
+        return true;
     }
     MemServerMap parse_memserver_list(std::string memServer,
                                       std::string delimiter1,
@@ -671,8 +809,10 @@ int fam::Impl_::fam_initialize(const char *grpName, Fam_Options *options) {
         // initialize NVMM client
         famAllocator = new Fam_Allocator_NVMM();
         famOps = new Fam_Ops_NVMM(famThreadModel, famContextModel, famAllocator,
-                                  atoi(famOptions.numConsumer));
+                                  atoi(famOptions.numConsumer), famAtomicModel);
         ret = famOps->initialize();
+        regionPlacement = Fam_Region_Placement::create(
+            placementPolicy, memoryServerCount, famAllocator);
     } else {
         std::string memoryServer = famOptions.memoryServer;
 
@@ -696,12 +836,16 @@ int fam::Impl_::fam_initialize(const char *grpName, Fam_Options *options) {
                 throw Fam_InvalidOption_Exception(message.str().c_str());
             }
         }
-        famAllocator =
-            new Fam_Allocator_Grpc(memoryServerList, atoi(famOptions.grpcPort));
+        famAllocator = new Fam_Allocator_Grpc(
+            memoryServerList, atoi(famOptions.grpcPort),
+            strtoull(famOptions.metadataCacheLease, NULL, 10),
+            famConnectModel == FAM_CONNECT_LAZY);
+        regionPlacement = Fam_Region_Placement::create(
+            placementPolicy, memoryServerCount, famAllocator);
         famOps = new Fam_Ops_Libfabric(
             memoryServerList, famOptions.libfabricPort, false,
             famOptions.libfabricProvider, famThreadModel, famAllocator,
-            famContextModel);
+            famContextModel, famConnectModel);
 
         ret = famOps->initialize();
         if (ret < 0) {
@@ -833,6 +977,97 @@ int fam::Impl_::validate_fam_options(Fam_Options *options) {
     optValueMap->insert(
         { supportedOptionList[NUM_CONSUMER], famOptions.numConsumer });
 
+    if (options && options->famAtomicModel)
+        famOptions.famAtomicModel = strdup(options->famAtomicModel);
+    else
+        famOptions.famAtomicModel = strdup("FAM_ATOMIC_LIBRARY");
+
+    if (strcmp(famOptions.famAtomicModel, FAM_ATOMIC_LIBRARY_STR) == 0)
+        famAtomicModel = FAM_ATOMIC_LIBRARY;
+    else if (strcmp(famOptions.famAtomicModel, FAM_ATOMIC_CPU_STR) == 0)
+        famAtomicModel = FAM_ATOMIC_CPU;
+    else {
+        message << "Invalid value specified for famAtomicModel: "
+                << famOptions.famAtomicModel;
+        throw Fam_InvalidOption_Exception(message.str().c_str());
+    }
+    optValueMap->insert(
+        { supportedOptionList[FAM_ATOMIC_MODEL], famOptions.famAtomicModel });
+
+    if (options && options->metadataCacheLease)
+        famOptions.metadataCacheLease = strdup(options->metadataCacheLease);
+    else
+        famOptions.metadataCacheLease = strdup("0");
+
+    if (strspn(famOptions.metadataCacheLease, "0123456789") !=
+        strlen(famOptions.metadataCacheLease)) {
+        message << "Invalid value specified for metadataCacheLease: "
+                << famOptions.metadataCacheLease;
+        throw Fam_InvalidOption_Exception(message.str().c_str());
+    }
+    optValueMap->insert({ supportedOptionList[METADATA_CACHE_LEASE],
+                          famOptions.metadataCacheLease });
+
+    if (options && options->famConnectModel)
+        famOptions.famConnectModel = strdup(options->famConnectModel);
+    else
+        famOptions.famConnectModel = strdup(FAM_CONNECT_EAGER_STR);
+
+    if (strcmp(famOptions.famConnectModel, FAM_CONNECT_EAGER_STR) == 0)
+        famConnectModel = FAM_CONNECT_EAGER;
+    else if (strcmp(famOptions.famConnectModel, FAM_CONNECT_LAZY_STR) == 0)
+        famConnectModel = FAM_CONNECT_LAZY;
+    else {
+        message << "Invalid value specified for famConnectModel: "
+                << famOptions.famConnectModel;
+        throw Fam_InvalidOption_Exception(message.str().c_str());
+    }
+    optValueMap->insert(
+        { supportedOptionList[FAM_CONNECT_MODEL], famOptions.famConnectModel });
+
+    if (options && options->regionPlacement)
+        famOptions.regionPlacement = strdup(options->regionPlacement);
+    else
+        famOptions.regionPlacement = strdup(FAM_PLACEMENT_HASH_STR);
+
+    if (strcmp(famOptions.regionPlacement, FAM_PLACEMENT_HASH_STR) == 0)
+        placementPolicy = FAM_PLACEMENT_HASH;
+    else if (strcmp(famOptions.regionPlacement,
+                    FAM_PLACEMENT_CONSISTENT_HASH_STR) == 0)
+        placementPolicy = FAM_PLACEMENT_CONSISTENT_HASH;
+    else if (strcmp(famOptions.regionPlacement, FAM_PLACEMENT_CAPACITY_STR) ==
+             0)
+        placementPolicy = FAM_PLACEMENT_CAPACITY;
+    else if (strcmp(famOptions.regionPlacement,
+                    FAM_PLACEMENT_ROUND_ROBIN_STR) == 0)
+        placementPolicy = FAM_PLACEMENT_ROUND_ROBIN;
+    else {
+        message << "Invalid value specified for regionPlacement: "
+                << famOptions.regionPlacement;
+        throw Fam_InvalidOption_Exception(message.str().c_str());
+    }
+    optValueMap->insert(
+        { supportedOptionList[REGION_PLACEMENT], famOptions.regionPlacement });
+
+    if (options && options->famRedundancyModel)
+        famOptions.famRedundancyModel = strdup(options->famRedundancyModel);
+    else
+        famOptions.famRedundancyModel = strdup(FAM_REDUNDANCY_MEMSERVER_STR);
+
+    if (strcmp(famOptions.famRedundancyModel, FAM_REDUNDANCY_MEMSERVER_STR) ==
+        0)
+        famRedundancyModel = FAM_REDUNDANCY_MEMSERVER;
+    else if (strcmp(famOptions.famRedundancyModel,
+                    FAM_REDUNDANCY_ACROSS_MEMSERVERS_STR) == 0)
+        famRedundancyModel = FAM_REDUNDANCY_ACROSS_MEMSERVERS;
+    else {
+        message << "Invalid value specified for famRedundancyModel: "
+                << famOptions.famRedundancyModel;
+        throw Fam_InvalidOption_Exception(message.str().c_str());
+    }
+    optValueMap->insert({ supportedOptionList[FAM_REDUNDANCY_MODEL],
+                          famOptions.famRedundancyModel });
+
     return ret;
 }
 
@@ -863,6 +1098,13 @@ int fam::Impl_::validate_item(Fam_Descriptor *descriptor) {
     uint64_t key = descriptor->get_key();
     Fam_Region_Item_Info itemInfo;
 
+    // A striped data item is accessed through the parts on each member
+    if (fam_stripe_count(descriptor) > 1) {
+        for_each_stripe(descriptor,
+                        [&](Fam_Descriptor *stripe) { validate_item(stripe); });
+        return 0;
+    }
+
     if (key == FAM_KEY_UNINITIALIZED) {
         itemInfo = famAllocator->check_permission_get_info(descriptor);
         descriptor->bind_key(itemInfo.key);
@@ -876,9 +1118,43 @@ int fam::Impl_::validate_item(Fam_Descriptor *descriptor) {
         message << "Invalid Key Passed" << endl;
         throw Fam_InvalidOption_Exception(message.str().c_str());
     }
+
+    // RDMA does not keep a registration warm on a memory server dropping
+    // cold ones; the key is confirmed, and registered again if need be,
+    // once its lease ran out
+    if (famAllocator->keys_leased(descriptor->get_memserver_id())) {
+        uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                           .count();
+        if (now >= descriptor->get_key_expiry()) {
+            famAllocator->refresh_registration(descriptor);
+            descriptor->set_key_expiry(now + FAM_MR_KEY_LEASE_MS * 1000000UL);
+        }
+    }
     return 0;
 }
 
+/*
+ * Run a blocking data path operation on descriptor. Keys are held on a lease
+ * (see validate_item), but an operation stalled past it may still find the
+ * registration dropped and its key rejected. The operation is retried once,
+ * after the memory server registered the data item again.
+ */
+int fam::Impl_::retry_refreshed(Fam_Descriptor *descriptor,
+                                std::function<int()> op) {
+    try {
+        return op();
+    } catch (Fam_Datapath_Exception &e) {
+        if ((e.fam_error() != FAM_ERR_NOPERM) ||
+            (strcmp(famOptions.allocator, FAM_OPTIONS_NVMM_STR) == 0))
+            throw;
+    }
+    for_each_stripe(descriptor, [&](Fam_Descriptor *stripe) {
+        famAllocator->refresh_registration(stripe);
+    });
+    return op();
+}
+
 /**
  * Finalize the fam library. Once finalized, the process can continue work, but
  * it is disconnected from the OpenFAM library functions.
@@ -986,8 +1262,13 @@ const void *fam::Impl_::fam_get_option(char *optionName) {
 Fam_Region_Descriptor *fam::Impl_::fam_lookup_region(const char *name) {
     FAM_CNTR_INC_API(fam_lookup_region);
     FAM_PROFILE_START_ALLOCATOR(fam_lookup_region);
-    uint64_t memoryServerId = generate_memory_server_id(name);
-    auto ret = famAllocator->lookup_region(name, memoryServerId);
+    Fam_Region_Descriptor *ret = NULL;
+    uint64_t foundOn = 0;
+    lookup_placed(name, [&](uint64_t memoryServerId) {
+        ret = famAllocator->lookup_region(name, memoryServerId);
+        foundOn = memoryServerId;
+    });
+    ret = join_region_stripes(name, ret, foundOn);
     FAM_PROFILE_END_ALLOCATOR(fam_lookup_region);
     return ret;
 }
@@ -1006,12 +1287,574 @@ Fam_Descriptor *fam::Impl_::fam_lookup(const char *itemName,
                                        const char *regionName) {
     FAM_CNTR_INC_API(fam_lookup);
     FAM_PROFILE_START_ALLOCATOR(fam_lookup);
-    uint64_t memoryServerId = generate_memory_server_id(regionName);
-    auto ret = famAllocator->lookup(itemName, regionName, memoryServerId);
+    Fam_Descriptor *ret = NULL;
+    uint64_t foundOn = 0;
+    lookup_placed(regionName, [&](uint64_t memoryServerId) {
+        ret = famAllocator->lookup(itemName, regionName, memoryServerId);
+        foundOn = memoryServerId;
+    });
+    ret = join_item_stripes(itemName, regionName, ret, foundOn);
     FAM_PROFILE_END_ALLOCATOR(fam_lookup);
     return ret;
 }
 
+/**
+ * look up several data items of the same region in FAM by name, with a single
+ * request to the memory server holding the region.
+ * @param itemNames - names of the data items
+ * @param regionName - name of the region containing the data items
+ * @param nItems - number of data items to look up
+ * @param items - array filled with the descriptors of the data items
+ * @throws Fam_InvalidOption_Exception - for NULL arguments or nItems == 0
+ * @throws Fam_Allocator_Exception - excptObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_NOTFOUND, FAM_ERR_GRPC
+ * @see #fam_lookup
+ */
+void fam::Impl_::fam_lookup_batch(const char **itemNames,
+                                  const char *regionName, uint64_t nItems,
+                                  Fam_Descriptor **items) {
+    FAM_CNTR_INC_API(fam_lookup_batch);
+    FAM_PROFILE_START_ALLOCATOR(fam_lookup_batch);
+    if ((itemNames == NULL) || (regionName == NULL) || (items == NULL) ||
+        (nItems == 0)) {
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+    for (uint64_t i = 0; i < nItems; i++) {
+        if (itemNames[i] == NULL)
+            throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+    uint64_t foundOn = 0;
+    lookup_placed(regionName, [&](uint64_t memoryServerId) {
+        famAllocator->lookup_batch(itemNames, regionName, nItems,
+                                   memoryServerId, items);
+        foundOn = memoryServerId;
+    });
+    // Parts of the data items of a striped region on the other members are
+    // looked up item by item, as members holding no stripe of a small data
+    // item have no part of it
+    for (uint64_t i = 0; i < nItems; i++) {
+        try {
+            items[i] =
+                join_item_stripes(itemNames[i], regionName, items[i], foundOn);
+        } catch (Fam_Exception &e) {
+            for (uint64_t j = 0; j < nItems; j++) {
+                if (j != i)
+                    delete items[j];
+            }
+            throw;
+        }
+    }
+    FAM_PROFILE_END_ALLOCATOR(fam_lookup_batch);
+    return;
+}
+
+/*
+ * Run lookup on the memory servers that may hold the region, in the order
+ * given by the region placement, until one does not report FAM_ERR_NOTFOUND.
+ * The memory server the region was found on is remembered for later lookups.
+ * Only a missing name is asked of every memory server; even under the hash
+ * policies, fam_create_region_on may have put it off its home server.
+ */
+void fam::Impl_::lookup_placed(const char *regionName,
+                               std::function<void(uint64_t)> lookup) {
+    std::vector<uint64_t> order = regionPlacement->get_lookup_order(regionName);
+    for (size_t i = 0; i < order.size(); i++) {
+        try {
+            lookup(order[i]);
+        } catch (Fam_Exception &e) {
+            if ((e.fam_error() != FAM_ERR_NOTFOUND) || (i + 1 == order.size()))
+                throw;
+            continue;
+        }
+        if (i > 0)
+            regionPlacement->set_location(regionName, order[i]);
+        return;
+    }
+}
+
+/*
+ * Check whether any memory server has a region of this name, whether or not
+ * the caller may access it.
+ */
+bool fam::Impl_::region_exists(const char *name) {
+    for (uint64_t id = 0; id < memoryServerCount; id++) {
+        try {
+            delete famAllocator->lookup_region(name, id);
+        } catch (Fam_Exception &e) {
+            if (e.fam_error() == FAM_ERR_NOTFOUND)
+                continue;
+            if (e.fam_error() != FAM_ERR_NOPERM)
+                throw;
+        }
+        regionPlacement->set_location(name, id);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Check whether creating a region of this name on memoryServerId would
+ * duplicate one on another memory server. Under the hash policies, the home
+ * server of the name rejects a duplicate itself, so a region created there
+ * is only checked against where this process placed the name elsewhere.
+ * Regions created off their home server, by fam_create_region_on or by the
+ * capacity and round robin policies, are checked against every memory
+ * server. With one memory server, the memory server checks the name itself.
+ */
+bool fam::Impl_::name_taken(const char *name, uint64_t memoryServerId) {
+    if (memoryServerCount == 1)
+        return false;
+    uint64_t home = regionPlacement->get_home_server(name);
+    if (((placementPolicy != FAM_PLACEMENT_HASH) &&
+         (placementPolicy != FAM_PLACEMENT_CONSISTENT_HASH)) ||
+        (memoryServerId != home))
+        return region_exists(name);
+
+    uint64_t location = regionPlacement->get_lookup_order(name)[0];
+    if (location == home)
+        return false;
+    try {
+        delete famAllocator->lookup_region(name, location);
+    } catch (Fam_Exception &e) {
+        if (e.fam_error() == FAM_ERR_NOTFOUND)
+            return false;
+        if (e.fam_error() != FAM_ERR_NOPERM)
+            throw;
+    }
+    return true;
+}
+
+/*
+ * Create a region on the given memory server. Each memory server only knows
+ * its own region names, so a region is created only if the name is not
+ * taken elsewhere (see name_taken). Two clients creating the same name at
+ * once on different memory servers may still both succeed. With the
+ * redundancy model FAM_REDUNDANCY_ACROSS_MEMSERVERS, a RAID1 region is
+ * mirrored on the memory servers following the given one, if there are any,
+ * and a RAID5 region is striped with parity across all memory servers, if
+ * there are enough of them.
+ */
+Fam_Region_Descriptor *fam::Impl_::create_region_on(
+    const char *name, uint64_t size, mode_t permissions,
+    Fam_Redundancy_Level redundancyLevel, uint64_t memoryServerId,
+    Fam_Stripe_Layout layout) {
+    if ((redundancyLevel == RAID1) &&
+        (famRedundancyModel == FAM_REDUNDANCY_ACROSS_MEMSERVERS) &&
+        (memoryServerCount > 1)) {
+        uint32_t copies = FAM_RAID1_COPIES;
+        if (copies > memoryServerCount)
+            copies = (uint32_t)memoryServerCount;
+        return create_members(name, size, permissions, memoryServerId,
+                              {0, copies, 0, RAID1});
+    }
+    if ((redundancyLevel == RAID5) &&
+        (famRedundancyModel == FAM_REDUNDANCY_ACROSS_MEMSERVERS) &&
+        (memoryServerCount >= FAM_RAID5_MIN_MEMBERS)) {
+        uint64_t dataMembers = memoryServerCount - 1;
+        return create_members(name, (size + dataMembers - 1) / dataMembers,
+                              permissions, memoryServerId,
+                              {FAM_RAID5_STRIPE_SIZE,
+                               (uint32_t)memoryServerCount, 0, RAID5});
+    }
+
+    if (name_taken(name, memoryServerId))
+        throw Fam_Allocator_Exception(FAM_ERR_ALREADYEXIST,
+                                      "Region already exist");
+
+    auto ret = famAllocator->create_region(name, size, permissions,
+                                           redundancyLevel, memoryServerId,
+                                           layout);
+    if (memoryServerId != regionPlacement->get_home_server(name))
+        regionPlacement->set_location(name, memoryServerId);
+    return ret;
+}
+
+/*
+ * Memory server of member index of a striped region, given the memory server
+ * of the member described by layout. Members sit on consecutive memory
+ * servers, starting from the home server of the region name.
+ */
+uint64_t fam::Impl_::stripe_server(Fam_Stripe_Layout layout,
+                                   uint64_t memoryServerId, uint64_t index) {
+    return (memoryServerId + memoryServerCount +
+            index % memoryServerCount -
+            layout.stripeIndex % memoryServerCount) %
+           memoryServerCount;
+}
+
+/*
+ * Complete the region found on memoryServerId with the other members of its
+ * striped region. Returns found itself if the region is not striped, else a
+ * descriptor owning every member, found included.
+ */
+Fam_Region_Descriptor *
+fam::Impl_::join_region_stripes(const char *name, Fam_Region_Descriptor *found,
+                                uint64_t memoryServerId) {
+    Fam_Stripe_Layout layout = found->get_layout();
+    if (layout.stripeCount <= 1)
+        return found;
+
+    Fam_Region_Descriptor **stripes =
+        new Fam_Region_Descriptor *[layout.stripeCount]();
+    uint64_t i = 0;
+    try {
+        for (i = 0; i < layout.stripeCount; i++) {
+            if (i == layout.stripeIndex)
+                stripes[i] = found;
+            else
+                stripes[i] = famAllocator->lookup_region(
+                    name, stripe_server(layout, memoryServerId, i));
+        }
+    } catch (Fam_Exception &e) {
+        if (layout.stripeIndex >= i)
+            delete found;
+        delete_stripes(stripes, i);
+        throw;
+    }
+
+    uint64_t size = stripes[0]->get_size() * fam_data_members(layout);
+    Fam_Region_Descriptor *ret =
+        new Fam_Region_Descriptor(stripes[0]->get_global_descriptor(), size);
+    layout.stripeIndex = 0;
+    ret->set_layout(layout);
+    ret->set_stripes(stripes);
+    return ret;
+}
+
+/*
+ * Complete the data item found on memoryServerId with its parts on the other
+ * members of its striped region. Members holding no stripe of the data item
+ * have no part of it.
+ */
+Fam_Descriptor *fam::Impl_::join_item_stripes(const char *itemName,
+                                              const char *regionName,
+                                              Fam_Descriptor *found,
+                                              uint64_t memoryServerId) {
+    Fam_Stripe_Layout layout = found->get_layout();
+    if (layout.stripeCount <= 1)
+        return found;
+
+    Fam_Descriptor **stripes = new Fam_Descriptor *[layout.stripeCount]();
+    uint64_t size = 0;
+    uint64_t i = 0;
+    try {
+        for (i = 0; i < layout.stripeCount; i++) {
+            if (i == layout.stripeIndex) {
+                stripes[i] = found;
+            } else {
+                try {
+                    stripes[i] = famAllocator->lookup(
+                        itemName, regionName,
+                        stripe_server(layout, memoryServerId, i));
+                } catch (Fam_Exception &e) {
+                    if (e.fam_error() != FAM_ERR_NOTFOUND)
+                        throw;
+                    continue;
+                }
+            }
+            // Each copy of a mirrored data item holds all of it
+            if ((layout.redundancyLevel != RAID1) || (i == layout.stripeIndex))
+                size += stripes[i]->get_size();
+        }
+    } catch (Fam_Exception &e) {
+        if (layout.stripeIndex >= i)
+            delete found;
+        delete_stripes(stripes, i);
+        throw;
+    }
+    if (layout.redundancyLevel == RAID5)
+        size = fam_parity_data_bytes(size, layout);
+
+    Fam_Descriptor *ret =
+        new Fam_Descriptor(found->get_global_descriptor(), size);
+    layout.stripeIndex = 0;
+    ret->set_layout(layout);
+    ret->set_stripes(stripes);
+    return ret;
+}
+
+/*
+ * Allocate a data item in a striped region: each member holding stripes of
+ * the data item gets a part of it, under the same name.
+ */
+Fam_Descriptor *fam::Impl_::allocate_striped(const char *name, uint64_t nbytes,
+                                             mode_t accessPermissions,
+                                             Fam_Region_Descriptor *region) {
+    Fam_Stripe_Layout layout = region->get_layout();
+    Fam_Descriptor **stripes = new Fam_Descriptor *[layout.stripeCount]();
+    uint64_t i = 0;
+    try {
+        for (i = 0; i < layout.stripeCount; i++) {
+            uint64_t bytes = fam_stripe_bytes(nbytes, layout, i);
+            // Parts are dealt in order, so the remaining members get none
+            if ((bytes == 0) && (i > 0))
+                break;
+            stripes[i] = famAllocator->allocate(name, bytes, accessPermissions,
+                                                region->get_stripe(i));
+        }
+    } catch (Fam_Exception &e) {
+        for (uint64_t j = 0; j < i; j++) {
+            try {
+                famAllocator->deallocate(stripes[j]);
+            } catch (Fam_Exception &ignored) {
+            }
+        }
+        delete_stripes(stripes, i);
+        throw;
+    }
+
+    Fam_Descriptor *ret =
+        new Fam_Descriptor(stripes[0]->get_global_descriptor(), nbytes);
+    ret->set_layout(layout);
+    ret->set_stripes(stripes);
+    return ret;
+}
+
+/*
+ * Run lookup on PE 0 only and pass its result to every PE through the
+ * runtime. A failure on PE 0 is raised on all of them. Without a runtime
+ * there is a single PE, which simply runs lookup.
+ */
+void fam::Impl_::lookup_shared(
+    std::function<void(Fam_Exported_Descriptor *)> lookup,
+    Fam_Exported_Descriptor *exported) {
+    struct {
+        int32_t errorCode;
+        Fam_Exported_Descriptor exported;
+    } result;
+
+    if (famRuntime == NULL) {
+        lookup(exported);
+        return;
+    }
+
+    memset(&result, 0, sizeof(result));
+    if (famRuntime->my_pe() == 0) {
+        // Whatever fails, the other PEs wait for the broadcast
+        try {
+            lookup(&result.exported);
+        } catch (Fam_Exception &e) {
+            result.errorCode = e.fam_error();
+            (void)famRuntime->runtime_broadcast(&result, sizeof(result), 0);
+            throw;
+        } catch (...) {
+            result.errorCode = FAM_ERR_UNKNOWN;
+            (void)famRuntime->runtime_broadcast(&result, sizeof(result), 0);
+            throw;
+        }
+    }
+
+    if (famRuntime->runtime_broadcast(&result, sizeof(result), 0) < 0)
+        throw Fam_Pmi_Exception("Fam runtime broadcast failed");
+    if (result.errorCode != FAM_NO_ERROR)
+        throw Fam_Allocator_Exception((enum Fam_Error)result.errorCode,
+                                      "Shared lookup failed on PE 0");
+    *exported = result.exported;
+}
+
+/**
+ * Collective look up of a region: PE 0 looks it up and broadcasts the result.
+ * @param name - name of the region.
+ * @return - The descriptor to the region.
+ * @throws Fam_Allocator_Exception - excptObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_NOTFOUND, FAM_ERR_GRPC
+ * @throws Fam_Pmi_Exception - if the result could not be broadcast
+ * @see #fam_lookup_region
+ */
+Fam_Region_Descriptor *fam::Impl_::fam_lookup_region_shared(const char *name) {
+    FAM_CNTR_INC_API(fam_lookup_region_shared);
+    FAM_PROFILE_START_ALLOCATOR(fam_lookup_region_shared);
+    Fam_Exported_Descriptor exported;
+    lookup_shared(
+        [&](Fam_Exported_Descriptor *result) {
+            Fam_Region_Descriptor *region = fam_lookup_region(name);
+            fam_export(region, result);
+            delete region;
+        },
+        &exported);
+    auto ret = fam_import_region(&exported);
+    FAM_PROFILE_END_ALLOCATOR(fam_lookup_region_shared);
+    return ret;
+}
+
+/**
+ * Collective look up of a data item: PE 0 looks it up, gets its access key and
+ * broadcasts the result.
+ * @param itemName - name of the data item
+ * @param regionName - name of the region containing the data item
+ * @return descriptor to the data item
+ * @throws Fam_Allocator_Exception - excptObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_NOTFOUND, FAM_ERR_GRPC
+ * @throws Fam_Pmi_Exception - if the result could not be broadcast
+ * @see #fam_lookup
+ */
+Fam_Descriptor *fam::Impl_::fam_lookup_shared(const char *itemName,
+                                              const char *regionName) {
+    FAM_CNTR_INC_API(fam_lookup_shared);
+    FAM_PROFILE_START_ALLOCATOR(fam_lookup_shared);
+    Fam_Exported_Descriptor exported;
+    lookup_shared(
+        [&](Fam_Exported_Descriptor *result) {
+            Fam_Descriptor *item = fam_lookup(itemName, regionName);
+            try {
+                // Resolve the key here, so that no PE has to ask for it
+                validate_item(item);
+            } catch (Fam_Exception &e) {
+                delete item;
+                throw;
+            }
+            fam_export(item, result);
+            delete item;
+        },
+        &exported);
+    auto ret = fam_import(&exported);
+    FAM_PROFILE_END_ALLOCATOR(fam_lookup_shared);
+    return ret;
+}
+
+/**
+ * Write the binary form of a data item descriptor. A striped or mirrored data
+ * item is written with its part on every member.
+ * @param descriptor - descriptor to export
+ * @param exported - filled with the exported form
+ * @throws Fam_InvalidOption_Exception - for NULL arguments, or more than
+ * FAM_EXPORT_MAX_MEMBERS members
+ * @see #fam_import
+ */
+void fam::Impl_::fam_export(Fam_Descriptor *descriptor,
+                            Fam_Exported_Descriptor *exported) {
+    if ((descriptor == NULL) || (exported == NULL))
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    uint64_t memberCount = fam_stripe_count(descriptor);
+    if (memberCount > FAM_EXPORT_MAX_MEMBERS)
+        throw Fam_InvalidOption_Exception("Too many members to export");
+    memset(exported, 0, sizeof(Fam_Exported_Descriptor));
+    exported->version = FAM_EXPORT_VERSION;
+    exported->isRegion = 0;
+    exported->gDescriptor = descriptor->get_global_descriptor();
+    exported->key = descriptor->get_key();
+    exported->size = descriptor->get_size();
+    exported->layout = descriptor->get_layout();
+    if (memberCount == 1)
+        return;
+
+    exported->memberCount = memberCount;
+    for (uint64_t i = 0; i < memberCount; i++) {
+        Fam_Descriptor *stripe = descriptor->get_stripe(i);
+        if (stripe == NULL)
+            continue;
+        exported->members[i] = {1, stripe->get_global_descriptor(),
+                                stripe->get_key(), stripe->get_size()};
+    }
+}
+
+/**
+ * Write the binary form of a region descriptor. A striped or mirrored region
+ * is written with all of its members.
+ * @param descriptor - descriptor to export
+ * @param exported - filled with the exported form
+ * @throws Fam_InvalidOption_Exception - for NULL arguments, or more than
+ * FAM_EXPORT_MAX_MEMBERS members
+ * @see #fam_import_region
+ */
+void fam::Impl_::fam_export(Fam_Region_Descriptor *descriptor,
+                            Fam_Exported_Descriptor *exported) {
+    if ((descriptor == NULL) || (exported == NULL))
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    uint64_t memberCount = fam_stripe_count(descriptor);
+    if (memberCount > FAM_EXPORT_MAX_MEMBERS)
+        throw Fam_InvalidOption_Exception("Too many members to export");
+    memset(exported, 0, sizeof(Fam_Exported_Descriptor));
+    exported->version = FAM_EXPORT_VERSION;
+    exported->isRegion = 1;
+    exported->gDescriptor = descriptor->get_global_descriptor();
+    exported->key = FAM_KEY_UNINITIALIZED;
+    exported->size = descriptor->get_size();
+    exported->layout = descriptor->get_layout();
+    if (memberCount == 1)
+        return;
+
+    exported->memberCount = memberCount;
+    for (uint64_t i = 0; i < memberCount; i++) {
+        Fam_Region_Descriptor *stripe = descriptor->get_stripe(i);
+        exported->members[i] = {1, stripe->get_global_descriptor(),
+                                FAM_KEY_UNINITIALIZED, stripe->get_size()};
+    }
+}
+
+/**
+ * Build a data item descriptor from its binary form.
+ * @param exported - exported form written by fam_export
+ * @return descriptor to the data item
+ * @throws Fam_InvalidOption_Exception - if exported is not a valid exported
+ * data item descriptor
+ * @see #fam_export
+ */
+Fam_Descriptor *fam::Impl_::fam_import(Fam_Exported_Descriptor *exported) {
+    if ((exported == NULL) || (exported->version != FAM_EXPORT_VERSION) ||
+        exported->isRegion || !valid_members(exported))
+        throw Fam_InvalidOption_Exception("Invalid exported descriptor");
+    // NVMM keys come with a base address local to each process, so they are
+    // looked up again on first access
+    bool bindKeys = (strcmp(famOptions.allocator, FAM_OPTIONS_NVMM_STR) != 0);
+    Fam_Descriptor *descriptor =
+        new Fam_Descriptor(exported->gDescriptor, exported->size);
+    if (bindKeys)
+        descriptor->bind_key(exported->key);
+    descriptor->set_layout(exported->layout);
+    if (exported->memberCount == 0)
+        return descriptor;
+
+    // Rebuild the parts on each member, as join_item_stripes does
+    Fam_Descriptor **stripes = new Fam_Descriptor *[exported->memberCount]();
+    for (uint64_t i = 0; i < exported->memberCount; i++) {
+        Fam_Exported_Member *member = &exported->members[i];
+        if (!member->present)
+            continue;
+        stripes[i] = new Fam_Descriptor(member->gDescriptor, member->size);
+        if (bindKeys)
+            stripes[i]->bind_key(member->key);
+        Fam_Stripe_Layout layout = exported->layout;
+        layout.stripeIndex = (uint32_t)i;
+        stripes[i]->set_layout(layout);
+    }
+    descriptor->set_stripes(stripes);
+    return descriptor;
+}
+
+/**
+ * Build a region descriptor from its binary form.
+ * @param exported - exported form written by fam_export
+ * @return descriptor to the region
+ * @throws Fam_InvalidOption_Exception - if exported is not a valid exported
+ * region descriptor
+ * @see #fam_export
+ */
+Fam_Region_Descriptor *
+fam::Impl_::fam_import_region(Fam_Exported_Descriptor *exported) {
+    if ((exported == NULL) || (exported->version != FAM_EXPORT_VERSION) ||
+        !exported->isRegion || !valid_members(exported))
+        throw Fam_InvalidOption_Exception("Invalid exported descriptor");
+    Fam_Region_Descriptor *descriptor =
+        new Fam_Region_Descriptor(exported->gDescriptor, exported->size);
+    descriptor->set_layout(exported->layout);
+    if (exported->memberCount == 0)
+        return descriptor;
+
+    Fam_Region_Descriptor **stripes =
+        new Fam_Region_Descriptor *[exported->memberCount]();
+    for (uint64_t i = 0; i < exported->memberCount; i++) {
+        Fam_Exported_Member *member = &exported->members[i];
+        stripes[i] =
+            new Fam_Region_Descriptor(member->gDescriptor, member->size);
+        Fam_Stripe_Layout layout = exported->layout;
+        layout.stripeIndex = (uint32_t)i;
+        stripes[i]->set_layout(layout);
+    }
+    descriptor->set_stripes(stripes);
+    return descriptor;
+}
+
 // ALLOCATION Group
 
 /**
@@ -1039,13 +1882,132 @@ fam::Impl_::fam_create_region(const char *name, uint64_t size,
                               Fam_Redundancy_Level redundancyLevel, ...) {
     FAM_CNTR_INC_API(fam_create_region);
     FAM_PROFILE_START_ALLOCATOR(fam_create_region);
-    uint64_t memoryServerId = generate_memory_server_id(name);
-    auto ret = famAllocator->create_region(name, size, permissions,
-                                           redundancyLevel, memoryServerId);
+    uint64_t memoryServerId = regionPlacement->place_region(name, size);
+    auto ret = create_region_on(name, size, permissions, redundancyLevel,
+                                memoryServerId);
     FAM_PROFILE_END_ALLOCATOR(fam_create_region);
     return ret;
 }
 
+/**
+ * Allocate a region of FAM on a given memory server.
+ * @param name - name of the region
+ * @param size - size (in bytes) requested for the region
+ * @param permissions - access permissions to be used for the region
+ * @param redundancyLevel - desired redundancy level for the region
+ * @param memoryServerId - id of the memory server to create the region on
+ * @throws Fam_InvalidOption_Exception - for an unknown memory server id
+ * @throws Fam_Allocator_Exception - excptObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_ALREADYEXIST, FAM_ERR_GRPC
+ * @return - Region_Descriptor for the created region
+ * @see #fam_create_region
+ */
+Fam_Region_Descriptor *fam::Impl_::fam_create_region_on(
+    const char *name, uint64_t size, mode_t permissions,
+    Fam_Redundancy_Level redundancyLevel, uint64_t memoryServerId) {
+    FAM_CNTR_INC_API(fam_create_region_on);
+    FAM_PROFILE_START_ALLOCATOR(fam_create_region_on);
+    if (memoryServerId >= memoryServerCount)
+        throw Fam_InvalidOption_Exception("Invalid memory server id");
+    auto ret = create_region_on(name, size, permissions, redundancyLevel,
+                                memoryServerId);
+    FAM_PROFILE_END_ALLOCATOR(fam_create_region_on);
+    return ret;
+}
+
+/**
+ * Allocate a region of FAM striped across several memory servers. The region
+ * is made of stripeCount member regions of the same name, on consecutive
+ * memory servers starting from the home server of the name. With RAID5, one
+ * stripe of every row holds the parity of the others, so the data survives
+ * the loss of one member.
+ * @param name - name of the region
+ * @param size - size (in bytes) requested for the region
+ * @param permissions - access permissions to be used for the region
+ * @param redundancyLevel - desired redundancy level for the region
+ * @param stripeCount - number of memory servers to stripe across
+ * @param stripeSize - bytes placed on a memory server before moving to the
+ * next one
+ * @throws Fam_InvalidOption_Exception - for an invalid stripe count or size,
+ * a RAID1 redundancy level, or fewer than three members for RAID5
+ * @throws Fam_Allocator_Exception - excptObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_ALREADYEXIST, FAM_ERR_GRPC
+ * @return - Region_Descriptor for the created region
+ * @see #fam_create_region
+ */
+Fam_Region_Descriptor *fam::Impl_::fam_create_region_striped(
+    const char *name, uint64_t size, mode_t permissions,
+    Fam_Redundancy_Level redundancyLevel, uint64_t stripeCount,
+    uint64_t stripeSize) {
+    FAM_CNTR_INC_API(fam_create_region_striped);
+    FAM_PROFILE_START_ALLOCATOR(fam_create_region_striped);
+    if ((stripeCount == 0) || (stripeCount > memoryServerCount))
+        throw Fam_InvalidOption_Exception("Invalid stripe count");
+    if ((stripeSize < FAM_STRIPE_SIZE_MIN) ||
+        (stripeSize & (stripeSize - 1)))
+        throw Fam_InvalidOption_Exception("Invalid stripe size");
+    if (redundancyLevel == RAID1)
+        throw Fam_InvalidOption_Exception(
+            "Invalid redundancy level for a striped region");
+    if ((redundancyLevel == RAID5) && (stripeCount < FAM_RAID5_MIN_MEMBERS))
+        throw Fam_InvalidOption_Exception("Invalid stripe count");
+
+    Fam_Stripe_Layout layout = {stripeSize, (uint32_t)stripeCount, 0, NONE};
+    if (redundancyLevel == RAID5)
+        layout.redundancyLevel = RAID5;
+    uint64_t dataMembers = fam_data_members(layout);
+    auto ret = create_members(name, (size + dataMembers - 1) / dataMembers,
+                              permissions,
+                              regionPlacement->get_home_server(name), layout);
+    FAM_PROFILE_END_ALLOCATOR(fam_create_region_striped);
+    return ret;
+}
+
+/*
+ * Create the members of a striped or mirrored region, of memberSize bytes
+ * each, on consecutive memory servers starting from memoryServerId. Either
+ * all of them are created or none is.
+ */
+Fam_Region_Descriptor *
+fam::Impl_::create_members(const char *name, uint64_t memberSize,
+                           mode_t permissions, uint64_t memoryServerId,
+                           Fam_Stripe_Layout layout) {
+    if (name_taken(name, memoryServerId))
+        throw Fam_Allocator_Exception(FAM_ERR_ALREADYEXIST,
+                                      "Region already exist");
+
+    Fam_Region_Descriptor **stripes =
+        new Fam_Region_Descriptor *[layout.stripeCount]();
+    uint64_t i = 0;
+    try {
+        for (i = 0; i < layout.stripeCount; i++) {
+            layout.stripeIndex = (uint32_t)i;
+            stripes[i] = famAllocator->create_region(
+                name, memberSize, permissions, layout.redundancyLevel,
+                (memoryServerId + i) % memoryServerCount, layout);
+        }
+    } catch (Fam_Exception &e) {
+        for (uint64_t j = 0; j < i; j++) {
+            try {
+                famAllocator->destroy_region(stripes[j]);
+            } catch (Fam_Exception &ignored) {
+            }
+        }
+        delete_stripes(stripes, i);
+        throw;
+    }
+    if (memoryServerId != regionPlacement->get_home_server(name))
+        regionPlacement->set_location(name, memoryServerId);
+
+    uint64_t size = memberSize * fam_data_members(layout);
+    auto ret =
+        new Fam_Region_Descriptor(stripes[0]->get_global_descriptor(), size);
+    layout.stripeIndex = 0;
+    ret->set_layout(layout);
+    ret->set_stripes(stripes);
+    return ret;
+}
+
 /**
  * Destroy a region, and all contents within the region. Note that this method
  * call will trigger a delayed free operation to permit other instances
@@ -1059,7 +2021,9 @@ fam::Impl_::fam_create_region(const char *name, uint64_t size,
 void fam::Impl_::fam_destroy_region(Fam_Region_Descriptor *descriptor) {
     FAM_CNTR_INC_API(fam_destroy_region);
     FAM_PROFILE_START_ALLOCATOR(fam_destroy_region);
-    famAllocator->destroy_region(descriptor);
+    for_each_stripe(descriptor, [&](Fam_Region_Descriptor *stripe) {
+        famAllocator->destroy_region(stripe);
+    });
     FAM_PROFILE_END_ALLOCATOR(fam_destroy_region);
     return;
 }
@@ -1081,11 +2045,49 @@ int fam::Impl_::fam_resize_region(Fam_Region_Descriptor *descriptor,
                                   uint64_t nbytes) {
     FAM_CNTR_INC_API(fam_resize_region);
     FAM_PROFILE_START_ALLOCATOR(fam_resize_region);
-    auto ret = famAllocator->resize_region(descriptor, nbytes);
+    uint64_t dataMembers = 1;
+    if (fam_stripe_count(descriptor) > 1)
+        dataMembers = fam_data_members(descriptor->get_layout());
+    int ret = 0;
+    for_each_stripe(descriptor, [&](Fam_Region_Descriptor *stripe) {
+        ret |= famAllocator->resize_region(
+            stripe, (nbytes + dataMembers - 1) / dataMembers);
+    });
+    if (fam_stripe_count(descriptor) > 1)
+        descriptor->set_size(
+            (nbytes + dataMembers - 1) / dataMembers * dataMembers);
     FAM_PROFILE_END_ALLOCATOR(fam_resize_region);
     return ret;
 }
 
+/**
+ * Let a previously created region grow on its own, up to growLimit. The limit
+ * of a striped region is split over its members like its size.
+ * @param descriptor - descriptor associated with the previously created region
+ * @param growLimit - size up to which the region may grow, 0 to turn growth
+ * off
+ * @throws Fam_Allocator_Exception - exceptionObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_NOTFOUND, FAM_ERR_GRPC
+ * @return - 0 on success, 1 for unsuccessful completion, negative number on an
+ * exception
+ * @see #fam_resize_region
+ */
+int fam::Impl_::fam_set_region_growth(Fam_Region_Descriptor *descriptor,
+                                      uint64_t growLimit) {
+    FAM_CNTR_INC_API(fam_set_region_growth);
+    FAM_PROFILE_START_ALLOCATOR(fam_set_region_growth);
+    uint64_t dataMembers = 1;
+    if (fam_stripe_count(descriptor) > 1)
+        dataMembers = fam_data_members(descriptor->get_layout());
+    int ret = 0;
+    for_each_stripe(descriptor, [&](Fam_Region_Descriptor *stripe) {
+        ret |= famAllocator->set_region_growth(
+            stripe, (growLimit + dataMembers - 1) / dataMembers);
+    });
+    FAM_PROFILE_END_ALLOCATOR(fam_set_region_growth);
+    return ret;
+}
+
 /**
  * Allocate some unnamed space within a region. Allocates an area of FAM within
  * a region
@@ -1112,7 +2114,11 @@ Fam_Descriptor *fam::Impl_::fam_allocate(const char *name, uint64_t nbytes,
                                          Fam_Region_Descriptor *region) {
     FAM_CNTR_INC_API(fam_allocate);
     FAM_PROFILE_START_ALLOCATOR(fam_allocate);
-    auto ret = famAllocator->allocate(name, nbytes, accessPermissions, region);
+    Fam_Descriptor *ret;
+    if (region && (fam_stripe_count(region) > 1))
+        ret = allocate_striped(name, nbytes, accessPermissions, region);
+    else
+        ret = famAllocator->allocate(name, nbytes, accessPermissions, region);
     FAM_PROFILE_END_ALLOCATOR(fam_allocate);
     return ret;
 }
@@ -1125,11 +2131,94 @@ Fam_Descriptor *fam::Impl_::fam_allocate(const char *name, uint64_t nbytes,
 void fam::Impl_::fam_deallocate(Fam_Descriptor *descriptor) {
     FAM_CNTR_INC_API(fam_deallocate);
     FAM_PROFILE_START_ALLOCATOR(fam_deallocate);
-    famAllocator->deallocate(descriptor);
+    for_each_stripe(descriptor, [&](Fam_Descriptor *stripe) {
+        famAllocator->deallocate(stripe);
+    });
     FAM_PROFILE_END_ALLOCATOR(fam_deallocate);
     return;
 }
 
+/**
+ * Allocate several data items within a region with a single request to the
+ * memory server. Either all the data items are allocated or none of them is.
+ * @param names - (optional) names of the data items
+ * @param nbytes - sizes of the data items in bytes
+ * @param accessPermissions - permissions associated with the data items
+ * @param region - descriptor of the region within which the data items are
+ * allocated
+ * @param nItems - number of data items to allocate
+ * @param items - array filled with the descriptors of the data items
+ * @throws Fam_InvalidOption_Exception - for NULL arguments or nItems == 0
+ * @see #fam_deallocate_batch()
+ */
+void fam::Impl_::fam_allocate_batch(const char **names, uint64_t *nbytes,
+                                    mode_t accessPermissions,
+                                    Fam_Region_Descriptor *region,
+                                    uint64_t nItems, Fam_Descriptor **items) {
+    FAM_CNTR_INC_API(fam_allocate_batch);
+    FAM_PROFILE_START_ALLOCATOR(fam_allocate_batch);
+    if ((nbytes == NULL) || (region == NULL) || (items == NULL) ||
+        (nItems == 0)) {
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+    if (fam_stripe_count(region) > 1) {
+        // Data items of a striped region are allocated one by one
+        uint64_t i = 0;
+        try {
+            for (i = 0; i < nItems; i++)
+                items[i] = allocate_striped(names ? names[i] : "", nbytes[i],
+                                            accessPermissions, region);
+        } catch (Fam_Exception &e) {
+            for (uint64_t j = 0; j < i; j++) {
+                try {
+                    for_each_stripe(items[j], [&](Fam_Descriptor *stripe) {
+                        famAllocator->deallocate(stripe);
+                    });
+                } catch (Fam_Exception &ignored) {
+                }
+                delete items[j];
+                items[j] = NULL;
+            }
+            throw;
+        }
+    } else {
+        famAllocator->allocate_batch(names, nbytes, nItems, accessPermissions,
+                                     region, items);
+    }
+    FAM_PROFILE_END_ALLOCATOR(fam_allocate_batch);
+    return;
+}
+
+/**
+ * Deallocate several data items, with one request per region.
+ * @param items - descriptors of the data items
+ * @param nItems - number of data items to deallocate
+ * @throws Fam_InvalidOption_Exception - for NULL arguments or nItems == 0
+ * @see #fam_allocate_batch()
+ */
+void fam::Impl_::fam_deallocate_batch(Fam_Descriptor **items,
+                                      uint64_t nItems) {
+    FAM_CNTR_INC_API(fam_deallocate_batch);
+    FAM_PROFILE_START_ALLOCATOR(fam_deallocate_batch);
+    if ((items == NULL) || (nItems == 0)) {
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+    for (uint64_t i = 0; i < nItems; i++) {
+        if (items[i] == NULL)
+            throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+    // Striped data items are deallocated through their parts
+    std::vector<Fam_Descriptor *> parts;
+    for (uint64_t i = 0; i < nItems; i++) {
+        for_each_stripe(items[i], [&](Fam_Descriptor *stripe) {
+            parts.push_back(stripe);
+        });
+    }
+    famAllocator->deallocate_batch(parts.data(), parts.size());
+    FAM_PROFILE_END_ALLOCATOR(fam_deallocate_batch);
+    return;
+}
+
 /**
  * Change permissions associated with a data item descriptor.
  * @param descriptor - descriptor associated with some data item
@@ -1141,7 +2230,10 @@ int fam::Impl_::fam_change_permissions(Fam_Descriptor *descriptor,
                                        mode_t accessPermissions) {
     FAM_CNTR_INC_API(fam_change_permissions);
     FAM_PROFILE_START_ALLOCATOR(fam_change_permissions);
-    auto ret = famAllocator->change_permission(descriptor, accessPermissions);
+    int ret = 0;
+    for_each_stripe(descriptor, [&](Fam_Descriptor *stripe) {
+        ret |= famAllocator->change_permission(stripe, accessPermissions);
+    });
     FAM_PROFILE_END_ALLOCATOR(fam_change_permissions);
     return ret;
 }
@@ -1157,7 +2249,10 @@ int fam::Impl_::fam_change_permissions(Fam_Region_Descriptor *descriptor,
                                        mode_t accessPermissions) {
     FAM_CNTR_INC_API(fam_change_permissions);
     FAM_PROFILE_START_ALLOCATOR(fam_change_permissions);
-    auto ret = famAllocator->change_permission(descriptor, accessPermissions);
+    int ret = 0;
+    for_each_stripe(descriptor, [&](Fam_Region_Descriptor *stripe) {
+        ret |= famAllocator->change_permission(stripe, accessPermissions);
+    });
     FAM_PROFILE_END_ALLOCATOR(fam_change_permissions);
     return ret;
 }
@@ -1200,24 +2295,26 @@ uint64_t fam::Impl_::fam_size(Fam_Region_Descriptor *descriptor) {
  * Map a data item in FAM to the local virtual address space, and return its
  * pointer.
  * @param descriptor - descriptor to be mapped
+ * @param mapFlags - or-ed combination of Fam_Map_Flags
  * @return pointer within the process virtual address space that can be used to
  * directly access the data item in FAM
  * @see #fam_unmap()
  */
-void *fam::Impl_::fam_map(Fam_Descriptor *descriptor) {
+void *fam::Impl_::fam_map(Fam_Descriptor *descriptor, uint32_t mapFlags) {
     void *result = NULL;
     FAM_CNTR_INC_API(fam_map);
     FAM_PROFILE_START_ALLOCATOR(fam_map);
     if (descriptor == NULL) {
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
+    check_one_member(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_map);
 
     FAM_PROFILE_START_OPS(fam_map);
     if (ret == 0) {
         void *address;
-        address = famAllocator->fam_map(descriptor);
+        address = famAllocator->fam_map(descriptor, mapFlags);
         if (address != NULL) {
             descriptor->set_base_address(address);
         }
@@ -1241,6 +2338,7 @@ void fam::Impl_::fam_unmap(void *local, Fam_Descriptor *descriptor) {
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_one_member(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_unmap);
     FAM_PROFILE_START_OPS(fam_unmap);
@@ -1287,7 +2385,9 @@ int fam::Impl_::fam_get_blocking(void *local, Fam_Descriptor *descriptor,
     FAM_PROFILE_START_OPS(fam_get_blocking);
     if (ret == 0) {
         // Read data from FAM region with this key
-        ret = famOps->get_blocking(local, descriptor, offset, nbytes);
+        ret = retry_refreshed(descriptor, [&]() {
+            return famOps->get_blocking(local, descriptor, offset, nbytes);
+        });
     }
     FAM_PROFILE_END_OPS(fam_get_blocking);
     return ret;
@@ -1353,7 +2453,9 @@ int fam::Impl_::fam_put_blocking(void *local, Fam_Descriptor *descriptor,
     FAM_PROFILE_END_ALLOCATOR(fam_put_blocking);
     FAM_PROFILE_START_OPS(fam_put_blocking);
     if (ret == 0) {
-        ret = famOps->put_blocking(local, descriptor, offset, nbytes);
+        ret = retry_refreshed(descriptor, [&]() {
+            return famOps->put_blocking(local, descriptor, offset, nbytes);
+        });
     }
     FAM_PROFILE_END_OPS(fam_put_blocking);
     return ret;
@@ -1417,12 +2519,14 @@ int fam::Impl_::fam_gather_blocking(void *local, Fam_Descriptor *descriptor,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_gather_blocking);
     FAM_PROFILE_START_OPS(fam_gather_blocking);
     if (ret == 0) {
-        ret = famOps->gather_blocking(local, descriptor, nElements,
-                                      firstElement, stride, elementSize);
+        ret = famOps->gather_blocking(local, descriptor->get_stripe(0),
+                                      nElements, firstElement, stride,
+                                      elementSize);
     }
     FAM_PROFILE_END_OPS(fam_gather_blocking);
     return ret;
@@ -1453,12 +2557,13 @@ int fam::Impl_::fam_gather_blocking(void *local, Fam_Descriptor *descriptor,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_gather_blocking);
     FAM_PROFILE_START_OPS(fam_gather_blocking);
     if (ret == 0) {
-        ret = famOps->gather_blocking(local, descriptor, nElements,
-                                      elementIndex, elementSize);
+        ret = famOps->gather_blocking(local, descriptor->get_stripe(0),
+                                      nElements, elementIndex, elementSize);
     }
     FAM_PROFILE_END_OPS(fam_gather_blocking);
     return ret;
@@ -1489,12 +2594,13 @@ void fam::Impl_::fam_gather_nonblocking(void *local, Fam_Descriptor *descriptor,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_gather_nonblocking);
     FAM_PROFILE_START_OPS(fam_gather_nonblocking);
     if (ret == 0) {
-        famOps->gather_nonblocking(local, descriptor, nElements, firstElement,
-                                   stride, elementSize);
+        famOps->gather_nonblocking(local, descriptor->get_stripe(0), nElements,
+                                   firstElement, stride, elementSize);
     }
     FAM_PROFILE_END_OPS(fam_gather_nonblocking);
     return;
@@ -1524,12 +2630,13 @@ void fam::Impl_::fam_gather_nonblocking(void *local, Fam_Descriptor *descriptor,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_gather_nonblocking);
     FAM_PROFILE_START_OPS(fam_gather_nonblocking);
     if (ret == 0) {
-        famOps->gather_nonblocking(local, descriptor, nElements, elementIndex,
-                                   elementSize);
+        famOps->gather_nonblocking(local, descriptor->get_stripe(0), nElements,
+                                   elementIndex, elementSize);
     }
     FAM_PROFILE_END_OPS(fam_gather_nonblocking);
     return;
@@ -1562,12 +2669,15 @@ int fam::Impl_::fam_scatter_blocking(void *local, Fam_Descriptor *descriptor,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_scatter_blocking);
     FAM_PROFILE_START_OPS(fam_scatter_blocking);
     if (ret == 0) {
-        ret = famOps->scatter_blocking(local, descriptor, nElements,
-                                       firstElement, stride, elementSize);
+        for_each_stripe(descriptor, [&](Fam_Descriptor *copy) {
+            ret |= famOps->scatter_blocking(local, copy, nElements,
+                                            firstElement, stride, elementSize);
+        });
     }
     FAM_PROFILE_END_OPS(fam_scatter_blocking);
     return ret;
@@ -1598,12 +2708,15 @@ int fam::Impl_::fam_scatter_blocking(void *local, Fam_Descriptor *descriptor,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_scatter_blocking);
     FAM_PROFILE_START_OPS(fam_scatter_blocking);
     if (ret == 0) {
-        ret = famOps->scatter_blocking(local, descriptor, nElements,
-                                       elementIndex, elementSize);
+        for_each_stripe(descriptor, [&](Fam_Descriptor *copy) {
+            ret |= famOps->scatter_blocking(local, copy, nElements,
+                                            elementIndex, elementSize);
+        });
     }
     FAM_PROFILE_END_OPS(fam_scatter_blocking);
     return ret;
@@ -1637,12 +2750,15 @@ void fam::Impl_::fam_scatter_nonblocking(void *local,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_scatter_nonblocking);
     FAM_PROFILE_START_OPS(fam_scatter_nonblocking);
     if (ret == 0) {
-        famOps->scatter_nonblocking(local, descriptor, nElements, firstElement,
-                                    stride, elementSize);
+        for_each_stripe(descriptor, [&](Fam_Descriptor *copy) {
+            famOps->scatter_nonblocking(local, copy, nElements, firstElement,
+                                        stride, elementSize);
+        });
     }
     FAM_PROFILE_END_OPS(fam_scatter_nonblocking);
     return;
@@ -1674,12 +2790,15 @@ void fam::Impl_::fam_scatter_nonblocking(void *local,
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
 
+    check_not_striped(descriptor);
     int ret = validate_item(descriptor);
     FAM_PROFILE_END_ALLOCATOR(fam_scatter_nonblocking);
     FAM_PROFILE_START_OPS(fam_scatter_nonblocking);
     if (ret == 0) {
-        famOps->scatter_nonblocking(local, descriptor, nElements, elementIndex,
-                                    elementSize);
+        for_each_stripe(descriptor, [&](Fam_Descriptor *copy) {
+            famOps->scatter_nonblocking(local, copy, nElements, elementIndex,
+                                        elementSize);
+        });
     }
     FAM_PROFILE_END_OPS(fam_scatter_nonblocking);
     return;
@@ -1707,12 +2826,53 @@ void *fam::Impl_::fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
     if ((src == NULL) || (nbytes == 0)) {
         throw Fam_InvalidOption_Exception("Invalid Options");
     }
+    // Any copy of a mirrored source will do; the new data item is a single
+    // copy on the memory server of the one read
+    check_not_striped(src);
 
     int ret = validate_item(src);
     FAM_PROFILE_END_ALLOCATOR(fam_copy);
     FAM_PROFILE_START_OPS(fam_copy);
     if (ret == 0) {
-        result = famOps->copy(src, srcOffset, dest, destOffset, nbytes);
+        result = famOps->copy(src->get_stripe(0), srcOffset, dest, destOffset,
+                              nbytes);
+    }
+    FAM_PROFILE_END_OPS(fam_copy);
+    return result;
+}
+
+/**
+ * Copy data from one FAM-resident data item into an existing FAM-resident data
+ * item, without allocating a destination data item.
+ * @param src - valid descriptor to source data item in FAM.
+ * @param srcOffset - byte offset within the space defined by the src descriptor
+ * from which memory should be copied.
+ * @param dest - valid descriptor to existing destination data item in FAM.
+ * @param destOffset - byte offset within the space defined by the dest
+ * descriptor to which memory should be copied.
+ * @param nbytes - number of bytes to be copied
+ */
+void *fam::Impl_::fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
+                           Fam_Descriptor *dest, uint64_t destOffset,
+                           uint64_t nbytes) {
+    void *result = NULL;
+    FAM_CNTR_INC_API(fam_copy);
+    FAM_PROFILE_START_ALLOCATOR(fam_copy);
+    if ((src == NULL) || (dest == NULL) || (nbytes == 0)) {
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+    // Any copy of a mirrored source will do
+    check_not_striped(src);
+    check_one_member(dest);
+
+    int ret = validate_item(src);
+    if (ret == 0)
+        ret = validate_item(dest);
+    FAM_PROFILE_END_ALLOCATOR(fam_copy);
+    FAM_PROFILE_START_OPS(fam_copy);
+    if (ret == 0) {
+        result = famOps->copy(src->get_stripe(0), srcOffset, dest, destOffset,
+                              nbytes);
     }
     FAM_PROFILE_END_OPS(fam_copy);
     return result;
@@ -1730,6 +2890,18 @@ void fam::Impl_::fam_copy_wait(void *waitObj) {
     return;
 }
 
+uint64_t fam::Impl_::fam_copy_progress(void *waitObj) {
+    FAM_CNTR_INC_API(fam_copy_progress);
+    FAM_PROFILE_START_ALLOCATOR(fam_copy_progress);
+    if (waitObj == NULL) {
+        throw Fam_InvalidOption_Exception("Invalid Options");
+    }
+
+    auto ret = famOps->copy_progress(waitObj);
+    FAM_PROFILE_END_ALLOCATOR(fam_copy_progress);
+    return ret;
+}
+
 // ATOMICS Group
 
 // NON fetching routines
@@ -3593,7 +4765,12 @@ uint64_t fam::Impl_::fam_fetch_xor(Fam_Descriptor *descriptor, uint64_t offset,
 void fam::Impl_::fam_fence(Fam_Region_Descriptor *descriptor) {
     FAM_CNTR_INC_API(fam_fence);
     FAM_PROFILE_START_OPS(fam_fence);
-    famOps->fence(descriptor);
+    if (descriptor && (fam_stripe_count(descriptor) > 1))
+        for_each_stripe(descriptor, [&](Fam_Region_Descriptor *stripe) {
+            famOps->fence(stripe);
+        });
+    else
+        famOps->fence(descriptor);
     FAM_PROFILE_END_OPS(fam_fence);
     return;
 }
@@ -3607,7 +4784,12 @@ void fam::Impl_::fam_fence(Fam_Region_Descriptor *descriptor) {
 void fam::Impl_::fam_quiet(Fam_Region_Descriptor *descriptor) {
     FAM_CNTR_INC_API(fam_quiet);
     FAM_PROFILE_START_OPS(fam_quiet);
-    famOps->quiet(descriptor);
+    if (descriptor && (fam_stripe_count(descriptor) > 1))
+        for_each_stripe(descriptor, [&](Fam_Region_Descriptor *stripe) {
+            famOps->quiet(stripe);
+        });
+    else
+        famOps->quiet(descriptor);
     FAM_PROFILE_END_OPS(fam_quiet);
     return;
 }
@@ -3698,6 +4880,89 @@ Fam_Descriptor *fam::fam_lookup(const char *itemName, const char *regionName) {
     return pimpl_->fam_lookup(itemName, regionName);
 }
 
+/**
+ * look up several data items of the same region in FAM by name, with a single
+ * request to the memory server holding the region.
+ * @param itemNames - names of the data items
+ * @param regionName - name of the region containing the data items
+ * @param nItems - number of data items to look up
+ * @param items - array filled with the descriptors of the data items
+ * @throws Fam_InvalidOption_Exception - for NULL arguments or nItems == 0
+ * @throws Fam_Allocator_Exception - excptObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_NOTFOUND, FAM_ERR_GRPC
+ * @see #fam_lookup
+ */
+void fam::fam_lookup_batch(const char **itemNames, const char *regionName,
+                           uint64_t nItems, Fam_Descriptor **items) {
+    pimpl_->fam_lookup_batch(itemNames, regionName, nItems, items);
+}
+
+/**
+ * Collective look up of a region: PE 0 looks it up and broadcasts the result.
+ * @param name - name of the region.
+ * @return - The descriptor to the region.
+ * @see #fam_lookup_region
+ */
+Fam_Region_Descriptor *fam::fam_lookup_region_shared(const char *name) {
+    return pimpl_->fam_lookup_region_shared(name);
+}
+
+/**
+ * Collective look up of a data item: PE 0 looks it up, gets its access key and
+ * broadcasts the result.
+ * @param itemName - name of the data item
+ * @param regionName - name of the region containing the data item
+ * @return descriptor to the data item
+ * @see #fam_lookup
+ */
+Fam_Descriptor *fam::fam_lookup_shared(const char *itemName,
+                                       const char *regionName) {
+    return pimpl_->fam_lookup_shared(itemName, regionName);
+}
+
+/**
+ * Write the binary form of a data item descriptor.
+ * @param descriptor - descriptor to export
+ * @param exported - filled with the exported form
+ * @see #fam_import
+ */
+void fam::fam_export(Fam_Descriptor *descriptor,
+                     Fam_Exported_Descriptor *exported) {
+    pimpl_->fam_export(descriptor, exported);
+}
+
+/**
+ * Write the binary form of a region descriptor.
+ * @param descriptor - descriptor to export
+ * @param exported - filled with the exported form
+ * @see #fam_import_region
+ */
+void fam::fam_export(Fam_Region_Descriptor *descriptor,
+                     Fam_Exported_Descriptor *exported) {
+    pimpl_->fam_export(descriptor, exported);
+}
+
+/**
+ * Build a data item descriptor from its binary form.
+ * @param exported - exported form written by fam_export
+ * @return descriptor to the data item
+ * @see #fam_export
+ */
+Fam_Descriptor *fam::fam_import(Fam_Exported_Descriptor *exported) {
+    return pimpl_->fam_import(exported);
+}
+
+/**
+ * Build a region descriptor from its binary form.
+ * @param exported - exported form written by fam_export
+ * @return descriptor to the region
+ * @see #fam_export
+ */
+Fam_Region_Descriptor *
+fam::fam_import_region(Fam_Exported_Descriptor *exported) {
+    return pimpl_->fam_import_region(exported);
+}
+
 // ALLOCATION Group
 
 /**
@@ -3725,6 +4990,52 @@ fam::fam_create_region(const char *name, uint64_t size, mode_t permissions,
     return pimpl_->fam_create_region(name, size, permissions, redundancyLevel);
 }
 
+/**
+ * Allocate a region of FAM on a given memory server instead of the one
+ * chosen by the REGION_PLACEMENT option.
+ * @param name - name of the region
+ * @param size - size (in bytes) requested for the region
+ * @param permissions - access permissions to be used for the region
+ * @param redundancyLevel - desired redundancy level for the region
+ * @param memoryServerId - id of the memory server to create the region on
+ * @throws Fam_InvalidOption_Exception - for an unknown memory server id
+ * @throws Fam_Allocator_Exception - exceptionObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_ALREADYEXIST, FAM_ERR_GRPC
+ * @return - Region_Descriptor for the created region
+ * @see #fam_create_region
+ */
+Fam_Region_Descriptor *
+fam::fam_create_region_on(const char *name, uint64_t size, mode_t permissions,
+                          Fam_Redundancy_Level redundancyLevel,
+                          uint64_t memoryServerId) {
+    return pimpl_->fam_create_region_on(name, size, permissions,
+                                        redundancyLevel, memoryServerId);
+}
+
+/**
+ * Allocate a region of FAM striped across several memory servers.
+ * @param name - name of the region
+ * @param size - size (in bytes) requested for the region
+ * @param permissions - access permissions to be used for the region
+ * @param redundancyLevel - desired redundancy level for the region
+ * @param stripeCount - number of memory servers to stripe across
+ * @param stripeSize - bytes placed on a memory server before moving to the
+ * next one
+ * @throws Fam_InvalidOption_Exception - for an invalid stripe count or size,
+ * a RAID1 redundancy level, or fewer than three members for RAID5
+ * @throws Fam_Allocator_Exception - exceptionObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_ALREADYEXIST, FAM_ERR_GRPC
+ * @return - Region_Descriptor for the created region
+ * @see #fam_create_region
+ */
+Fam_Region_Descriptor *fam::fam_create_region_striped(
+    const char *name, uint64_t size, mode_t permissions,
+    Fam_Redundancy_Level redundancyLevel, uint64_t stripeCount,
+    uint64_t stripeSize) {
+    return pimpl_->fam_create_region_striped(
+        name, size, permissions, redundancyLevel, stripeCount, stripeSize);
+}
+
 /**
  * Destroy a region, and all contents within the region. Note that this method
  * call will trigger a delayed free operation to permit other instances
@@ -3754,6 +5065,20 @@ int fam::fam_resize_region(Fam_Region_Descriptor *descriptor, uint64_t nbytes) {
     return pimpl_->fam_resize_region(descriptor, nbytes);
 }
 
+/**
+ * Let a previously created region grow on its own, up to a limit.
+ * @param descriptor - descriptor associated with the previously created region
+ * @param growLimit - size up to which the region may grow, 0 to turn growth
+ * off
+ * @return - 0 on success, 1 for unsuccessful completion, negative number on an
+ * exception
+ * @see #fam_resize_region
+ */
+int fam::fam_set_region_growth(Fam_Region_Descriptor *descriptor,
+                               uint64_t growLimit) {
+    return pimpl_->fam_set_region_growth(descriptor, growLimit);
+}
+
 /**
  * Allocate some unnamed space within a region. Allocates an area of FAM within
  * a region
@@ -3789,6 +5114,38 @@ void fam::fam_deallocate(Fam_Descriptor *descriptor) {
     pimpl_->fam_deallocate(descriptor);
 }
 
+/**
+ * Allocate several data items within a region with a single request to the
+ * memory server. Either all the data items are allocated or none of them is.
+ * @param names - (optional) names of the data items
+ * @param nbytes - sizes of the data items in bytes
+ * @param accessPermissions - permissions associated with the data items
+ * @param region - descriptor of the region within which the data items are
+ * allocated
+ * @param nItems - number of data items to allocate
+ * @param items - array filled with the descriptors of the data items
+ * @throws Fam_InvalidOption_Exception - for NULL arguments or nItems == 0
+ * @see #fam_deallocate_batch()
+ */
+void fam::fam_allocate_batch(const char **names, uint64_t *nbytes,
+                             mode_t accessPermissions,
+                             Fam_Region_Descriptor *region, uint64_t nItems,
+                             Fam_Descriptor **items) {
+    pimpl_->fam_allocate_batch(names, nbytes, accessPermissions, region,
+                               nItems, items);
+}
+
+/**
+ * Deallocate several data items, with one request per region.
+ * @param items - descriptors of the data items
+ * @param nItems - number of data items to deallocate
+ * @throws Fam_InvalidOption_Exception - for NULL arguments or nItems == 0
+ * @see #fam_allocate_batch()
+ */
+void fam::fam_deallocate_batch(Fam_Descriptor **items, uint64_t nItems) {
+    pimpl_->fam_deallocate_batch(items, nItems);
+}
+
 /**
  * Change permissions associated with a data item descriptor.
  * @param descriptor - descriptor associated with some data item
@@ -3935,6 +5292,19 @@ void *fam::fam_map(Fam_Descriptor *descriptor) {
     return pimpl_->fam_map(descriptor);
 }
 
+/**
+ * Map a data item in FAM to the local virtual address space, and return its
+ * pointer, applying the given mapping hints.
+ * @param descriptor - descriptor to be mapped
+ * @param mapFlags - or-ed combination of Fam_Map_Flags
+ * @return pointer within the process virtual address space that can be used to
+ * directly access the data item in FAM
+ * @see #fam_unmap()
+ */
+void *fam::fam_map(Fam_Descriptor *descriptor, uint32_t mapFlags) {
+    return pimpl_->fam_map(descriptor, mapFlags);
+}
+
 /**
  * Unmap a data item in FAM from the local virtual address space.
  * @param local - pointer within the process virtual address space to be
@@ -4188,8 +5558,42 @@ void *fam::fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
     return pimpl_->fam_copy(src, srcOffset, dest, destOffset, nbytes);
 }
 
+/**
+ * Copy data from one FAM-resident data item into an existing FAM-resident data
+ * item. No destination data item is allocated; only the range [destOffset,
+ * destOffset + nbytes) of dest is written.
+ * @param src - valid descriptor to source data item in FAM.
+ * @param srcOffset - byte offset within the space defined by the src descriptor
+ * from which memory should be copied.
+ * @param dest - valid descriptor to existing destination data item in FAM.
+ * @param destOffset - byte offset within the space defined by the dest
+ * descriptor to which memory should be copied.
+ * @param nbytes - number of bytes to be copied
+ * @throws Fam_InvalidOption_Exception.
+ * @throws Fam_Allocator_Exception - exceptionObj->fam_error() may return:
+ *         FAM_ERR_NOPERM, FAM_ERR_NOTFOUND, FAM_ERR_OUTOFRANGE,
+ *         FAM_ERR_INVALID, FAM_ERR_GRPC
+ */
+void *fam::fam_copy(Fam_Descriptor *src, uint64_t srcOffset,
+                    Fam_Descriptor *dest, uint64_t destOffset,
+                    uint64_t nbytes) {
+    return pimpl_->fam_copy(src, srcOffset, dest, destOffset, nbytes);
+}
+
 void fam::fam_copy_wait(void *waitObj) { pimpl_->fam_copy_wait(waitObj); }
 
+/**
+ * Report how far a copy operation has got, without waiting for it.
+ * @param waitObj - unique tag to copy operation, as returned by fam_copy
+ * @return - number of bytes already copied
+ * @throws Fam_InvalidOption_Exception - if waitObj is NULL
+ * @throws Fam_Allocator_Exception - exceptionObj->fam_error() may return:
+ *         FAM_ERR_GRPC
+ */
+uint64_t fam::fam_copy_progress(void *waitObj) {
+    return pimpl_->fam_copy_progress(waitObj);
+}
+
 // ATOMICS Group
 
 // NON fetching routines
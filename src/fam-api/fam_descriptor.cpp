@@ -27,6 +27,7 @@
  * See https://spdx.org/licenses/BSD-3-Clause
  *
  */
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -45,25 +46,34 @@ class Fam_Descriptor::FamDescriptorImpl_ {
     FamDescriptorImpl_(Fam_Global_Descriptor globalDesc, uint64_t itemSize) {
         gDescriptor = globalDesc;
         key = FAM_KEY_UNINITIALIZED;
+        keyExpiry.store(0);
         context = NULL;
         base = NULL;
         size = itemSize;
+        layout = {0, 1, 0, NONE};
+        stripes = NULL;
     }
 
     FamDescriptorImpl_(Fam_Global_Descriptor globalDesc) {
         gDescriptor = globalDesc;
         key = FAM_KEY_UNINITIALIZED;
+        keyExpiry.store(0);
         context = NULL;
         base = NULL;
         size = 0;
+        layout = {0, 1, 0, NONE};
+        stripes = NULL;
     }
 
     FamDescriptorImpl_() {
         gDescriptor = { FAM_INVALID_REGION, 0 };
         key = FAM_KEY_UNINITIALIZED;
+        keyExpiry.store(0);
         context = NULL;
         base = NULL;
         size = 0;
+        layout = {0, 1, 0, NONE};
+        stripes = NULL;
     }
 
     ~FamDescriptorImpl_() {
@@ -72,6 +82,7 @@ class Fam_Descriptor::FamDescriptorImpl_ {
         context = NULL;
         base = NULL;
         size = 0;
+        delete_stripes();
     }
 
     Fam_Global_Descriptor get_global_descriptor() { return this->gDescriptor; }
@@ -85,6 +96,10 @@ class Fam_Descriptor::FamDescriptorImpl_ {
 
     uint64_t get_key() { return key; }
 
+    void set_key_expiry(uint64_t expiry) { keyExpiry.store(expiry); }
+
+    uint64_t get_key_expiry() { return keyExpiry.load(); }
+
     void set_context(void *ctx) { context = ctx; }
 
     void *get_context() { return context; }
@@ -104,13 +119,38 @@ class Fam_Descriptor::FamDescriptorImpl_ {
         return (gDescriptor.regionId) >> MEMSERVERID_SHIFT;
     }
 
+    void set_layout(Fam_Stripe_Layout stripeLayout) { layout = stripeLayout; }
+
+    Fam_Stripe_Layout get_layout() { return layout; }
+
+    void set_stripes(Fam_Descriptor **itemStripes) {
+        delete_stripes();
+        stripes = itemStripes;
+    }
+
+    Fam_Descriptor **get_stripes() { return stripes; }
+
   private:
+    void delete_stripes() {
+        if (!stripes)
+            return;
+        for (uint32_t i = 0; i < layout.stripeCount; i++)
+            delete stripes[i];
+        delete[] stripes;
+        stripes = NULL;
+    }
+
     Fam_Global_Descriptor gDescriptor;
     /* libfabric access key*/
     uint64_t key;
+    /* end of the lease on key, 0 if not confirmed yet */
+    std::atomic<uint64_t> keyExpiry;
     void *context;
     void *base;
     uint64_t size;
+    Fam_Stripe_Layout layout;
+    /* parts on each member region of a striped data item, else NULL */
+    Fam_Descriptor **stripes;
 };
 
 Fam_Descriptor::Fam_Descriptor(Fam_Global_Descriptor gDescriptor,
@@ -134,6 +174,14 @@ void Fam_Descriptor::bind_key(uint64_t tempkey) { fdimpl_->bind_key(tempkey); }
 
 uint64_t Fam_Descriptor::get_key() { return fdimpl_->get_key(); }
 
+void Fam_Descriptor::set_key_expiry(uint64_t expiry) {
+    fdimpl_->set_key_expiry(expiry);
+}
+
+uint64_t Fam_Descriptor::get_key_expiry() {
+    return fdimpl_->get_key_expiry();
+}
+
 void Fam_Descriptor::set_context(void *ctx) { fdimpl_->set_context(ctx); }
 
 void *Fam_Descriptor::get_context() { return fdimpl_->get_context(); }
@@ -153,6 +201,21 @@ uint64_t Fam_Descriptor::get_size() { return fdimpl_->get_size(); }
 uint64_t Fam_Descriptor::get_memserver_id() {
     return fdimpl_->get_memserver_id();
 }
+
+void Fam_Descriptor::set_layout(Fam_Stripe_Layout stripeLayout) {
+    fdimpl_->set_layout(stripeLayout);
+}
+
+Fam_Stripe_Layout Fam_Descriptor::get_layout() { return fdimpl_->get_layout(); }
+
+void Fam_Descriptor::set_stripes(Fam_Descriptor **stripes) {
+    fdimpl_->set_stripes(stripes);
+}
+
+Fam_Descriptor *Fam_Descriptor::get_stripe(uint64_t index) {
+    Fam_Descriptor **stripes = fdimpl_->get_stripes();
+    return stripes ? stripes[index] : this;
+}
 /*
  * Internal implementation of Fam_Region_Descriptor
  */
@@ -163,24 +226,31 @@ class Fam_Region_Descriptor::FamRegionDescriptorImpl_ {
         gDescriptor = globalDesc;
         context = NULL;
         size = regionSize;
+        layout = {0, 1, 0, NONE};
+        stripes = NULL;
     }
 
     FamRegionDescriptorImpl_() {
         gDescriptor = { FAM_INVALID_REGION, 0 };
         context = NULL;
         size = 0;
+        layout = {0, 1, 0, NONE};
+        stripes = NULL;
     }
 
     FamRegionDescriptorImpl_(Fam_Global_Descriptor globalDesc) {
         gDescriptor = globalDesc;
         context = NULL;
         size = 0;
+        layout = {0, 1, 0, NONE};
+        stripes = NULL;
     }
 
     ~FamRegionDescriptorImpl_() {
         gDescriptor = { FAM_INVALID_REGION, 0 };
         context = NULL;
         size = 0;
+        delete_stripes();
     }
 
     Fam_Global_Descriptor get_global_descriptor() { return this->gDescriptor; }
@@ -200,10 +270,33 @@ class Fam_Region_Descriptor::FamRegionDescriptorImpl_ {
         return (gDescriptor.regionId) >> MEMSERVERID_SHIFT;
     }
 
+    void set_layout(Fam_Stripe_Layout stripeLayout) { layout = stripeLayout; }
+
+    Fam_Stripe_Layout get_layout() { return layout; }
+
+    void set_stripes(Fam_Region_Descriptor **regionStripes) {
+        delete_stripes();
+        stripes = regionStripes;
+    }
+
+    Fam_Region_Descriptor **get_stripes() { return stripes; }
+
   private:
+    void delete_stripes() {
+        if (!stripes)
+            return;
+        for (uint32_t i = 0; i < layout.stripeCount; i++)
+            delete stripes[i];
+        delete[] stripes;
+        stripes = NULL;
+    }
+
     Fam_Global_Descriptor gDescriptor;
     void *context;
     uint64_t size;
+    Fam_Stripe_Layout layout;
+    /* member regions of a striped region, else NULL */
+    Fam_Region_Descriptor **stripes;
 };
 
 Fam_Region_Descriptor::Fam_Region_Descriptor(Fam_Global_Descriptor gDescriptor,
@@ -241,3 +334,20 @@ uint64_t Fam_Region_Descriptor::get_size() { return frdimpl_->get_size(); }
 uint64_t Fam_Region_Descriptor::get_memserver_id() {
     return frdimpl_->get_memserver_id();
 }
+
+void Fam_Region_Descriptor::set_layout(Fam_Stripe_Layout stripeLayout) {
+    frdimpl_->set_layout(stripeLayout);
+}
+
+Fam_Stripe_Layout Fam_Region_Descriptor::get_layout() {
+    return frdimpl_->get_layout();
+}
+
+void Fam_Region_Descriptor::set_stripes(Fam_Region_Descriptor **stripes) {
+    frdimpl_->set_stripes(stripes);
+}
+
+Fam_Region_Descriptor *Fam_Region_Descriptor::get_stripe(uint64_t index) {
+    Fam_Region_Descriptor **stripes = frdimpl_->get_stripes();
+    return stripes ? stripes[index] : this;
+}
@@ -28,6 +28,7 @@
  *
  */
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iostream>
 #include <sstream>
@@ -35,6 +36,11 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "common/fam_libfabric.h"
 #include "common/fam_ops.h"
@@ -46,12 +52,127 @@ using namespace std;
 
 namespace openfam {
 
+/*
+ * dest ^= src over nbytes, the parity kernel of RAID5 puts. Four vectors are
+ * handled per step, with 256-bit or 128-bit vectors depending on what the
+ * target supports, and the tail a word or a byte at a time.
+ */
+static void fam_xor(char *dest, const char *src, uint64_t nbytes) {
+    uint64_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 * sizeof(__m256i) <= nbytes; i += 4 * sizeof(__m256i)) {
+        for (int v = 0; v < 4; v++) {
+            __m256i *d = (__m256i *)(dest + i) + v;
+            __m256i s = _mm256_loadu_si256((const __m256i *)(src + i) + v);
+            _mm256_storeu_si256(d, _mm256_xor_si256(_mm256_loadu_si256(d), s));
+        }
+    }
+#elif defined(__SSE2__)
+    for (; i + 4 * sizeof(__m128i) <= nbytes; i += 4 * sizeof(__m128i)) {
+        for (int v = 0; v < 4; v++) {
+            __m128i *d = (__m128i *)(dest + i) + v;
+            __m128i s = _mm_loadu_si128((const __m128i *)(src + i) + v);
+            _mm_storeu_si128(d, _mm_xor_si128(_mm_loadu_si128(d), s));
+        }
+    }
+#endif
+    for (; i + sizeof(uint64_t) <= nbytes; i += sizeof(uint64_t)) {
+        uint64_t d, s;
+        memcpy(&d, dest + i, sizeof(d));
+        memcpy(&s, src + i, sizeof(s));
+        d ^= s;
+        memcpy(dest + i, &d, sizeof(d));
+    }
+    for (; i < nbytes; i++)
+        dest[i] ^= src[i];
+}
+
+template <typename T> static T apply_op(T old, T value, enum fi_op op) {
+    switch (op) {
+    case FI_SUM:
+        return old + value;
+    case FI_MIN:
+        return std::min(old, value);
+    case FI_MAX:
+        return std::max(old, value);
+    default:
+        return value;
+    }
+}
+
+/*
+ * Value left in FAM by an atomic of op with value on a location holding old,
+ * as the memory server computes it. Sums of signed integers are done unsigned
+ * so that they wrap the same way.
+ */
+static void apply_atomic(void *result, const void *old, const void *value,
+                         size_t size, enum fi_op op,
+                         enum fi_datatype datatype) {
+    if ((op == FI_BAND) || (op == FI_BOR) || (op == FI_BXOR)) {
+        for (size_t i = 0; i < size; i++) {
+            char o = ((const char *)old)[i];
+            char v = ((const char *)value)[i];
+            if (op == FI_BAND)
+                ((char *)result)[i] = o & v;
+            else if (op == FI_BOR)
+                ((char *)result)[i] = o | v;
+            else
+                ((char *)result)[i] = o ^ v;
+        }
+        return;
+    }
+
+    switch (datatype) {
+    case FI_INT32:
+        if (op != FI_SUM) {
+            *(int32_t *)result =
+                apply_op(*(const int32_t *)old, *(const int32_t *)value, op);
+            break;
+        }
+    // fallthrough
+    case FI_UINT32:
+        *(uint32_t *)result =
+            apply_op(*(const uint32_t *)old, *(const uint32_t *)value, op);
+        break;
+    case FI_INT64:
+        if (op != FI_SUM) {
+            *(int64_t *)result =
+                apply_op(*(const int64_t *)old, *(const int64_t *)value, op);
+            break;
+        }
+    // fallthrough
+    case FI_UINT64:
+        *(uint64_t *)result =
+            apply_op(*(const uint64_t *)old, *(const uint64_t *)value, op);
+        break;
+    case FI_FLOAT:
+        *(float *)result =
+            apply_op(*(const float *)old, *(const float *)value, op);
+        break;
+    case FI_DOUBLE:
+        *(double *)result =
+            apply_op(*(const double *)old, *(const double *)value, op);
+        break;
+    default:
+        throw Fam_Datapath_Exception("Unsupported atomic on a RAID5 data item");
+    }
+}
+
+static size_t atomic_size(enum fi_datatype datatype) {
+    if ((datatype == FI_INT32) || (datatype == FI_UINT32) ||
+        (datatype == FI_FLOAT))
+        return sizeof(uint32_t);
+    return sizeof(uint64_t);
+}
+
 Fam_Ops_Libfabric::~Fam_Ops_Libfabric() {
 
     delete contexts;
     delete defContexts;
     delete fiAddrs;
+    delete[] serverReady;
     delete fiMrs;
+    delete peerAddrs;
     free(service);
     free(provider);
     free(serverAddrName);
@@ -70,10 +191,13 @@ Fam_Ops_Libfabric::Fam_Ops_Libfabric(const char *memServerName,
     isSource = source;
     famThreadModel = famTM;
     famContextModel = famCM;
+    famConnectModel = FAM_CONNECT_EAGER;
     famAllocator = famAlloc;
 
     fiAddrs = new std::vector<fi_addr_t>();
+    serverReady = NULL;
     fiMrs = new std::map<uint64_t, fid_mr *>();
+    peerAddrs = new std::map<std::string, fi_addr_t>();
     contexts = new std::map<uint64_t, Fam_Context *>();
     defContexts = new std::map<uint64_t, Fam_Context *>();
 
@@ -96,7 +220,8 @@ Fam_Ops_Libfabric::Fam_Ops_Libfabric(MemServerMap memServerList,
                                      char *libfabricProvider,
                                      Fam_Thread_Model famTM,
                                      Fam_Allocator *famAlloc,
-                                     Fam_Context_Model famCM) {
+                                     Fam_Context_Model famCM,
+                                     Fam_Connect_Model famCnM) {
     std::ostringstream message;
     name = memServerList;
     service = strdup(libfabricPort);
@@ -104,10 +229,13 @@ Fam_Ops_Libfabric::Fam_Ops_Libfabric(MemServerMap memServerList,
     isSource = source;
     famThreadModel = famTM;
     famContextModel = famCM;
+    famConnectModel = famCnM;
     famAllocator = famAlloc;
 
     fiAddrs = new std::vector<fi_addr_t>();
+    serverReady = NULL;
     fiMrs = new std::map<uint64_t, fid_mr *>();
+    peerAddrs = new std::map<std::string, fi_addr_t>();
     contexts = new std::map<uint64_t, Fam_Context *>();
     defContexts = new std::map<uint64_t, Fam_Context *>();
 
@@ -137,6 +265,7 @@ int Fam_Ops_Libfabric::initialize() {
 
     // Initialize the mutex lock
     (void)pthread_mutex_init(&fiMrLock, NULL);
+    (void)pthread_mutex_init(&peerLock, NULL);
 
     // Initialize the mutex lock
     if (famContextModel == FAM_CONTEXT_REGION)
@@ -157,34 +286,25 @@ int Fam_Ops_Libfabric::initialize() {
             return ret;
         }
     }
+    if (!isSource) {
+        // Addresses are filled in as the memory servers get connected
+        fiAddrs->assign(name.size(), FI_ADDR_NOTAVAIL);
+        serverReady = new boost::atomic<bool>[name.size()];
+        for (nodeId = 0; nodeId < name.size(); nodeId++)
+            serverReady[nodeId].store(false);
+        (void)pthread_mutex_init(&connectLock, NULL);
+
+        if (famConnectModel != FAM_CONNECT_LAZY) {
+            if ((ret = connect_memservers()) < 0)
+                return ret;
+        }
+    }
+
     for (nodeId = 0; nodeId < name.size(); nodeId++) {
 
-        // Insert the memory server address into address vector
-        // Only if it is not source
-        if (!isSource) {
-            // Request memory server address from famAllocator
-            ret = famAllocator->get_addr_size(&serverAddrNameLen, nodeId);
-            if (serverAddrNameLen <= 0) {
-                message << "Fam allocator get_addr_size failed";
-                throw Fam_Allocator_Exception(FAM_ERR_ALLOCATOR,
-                                              message.str().c_str());
-            }
-            serverAddrName = calloc(1, serverAddrNameLen);
-            ret = famAllocator->get_addr(serverAddrName, serverAddrNameLen,
-                                         nodeId);
-            if (ret < 0) {
-                message << "Fam Allocator get_addr failed";
-                throw Fam_Allocator_Exception(FAM_ERR_ALLOCATOR,
-                                              message.str().c_str());
-            }
-            ret = fabric_insert_av((char *)serverAddrName, av, fiAddrs);
-            if (ret < 0) {
-                // TODO: Log error
-                return ret;
-            }
-        } else {
-            // This is memory server. Populate the serverAddrName and
-            // serverAddrNameLen from libfabric
+        // This is memory server. Populate the serverAddrName and
+        // serverAddrNameLen from libfabric
+        if (isSource) {
             Fam_Context *tmpCtx = new Fam_Context(fi, domain, famThreadModel);
             ret = fabric_enable_bind_ep(fi, av, eq, tmpCtx->get_ep());
             if (ret < 0) {
@@ -229,6 +349,98 @@ int Fam_Ops_Libfabric::initialize() {
     return 0;
 }
 
+/*
+ * Address of a memory server, as requested from famAllocator.
+ */
+std::string Fam_Ops_Libfabric::get_memserver_addr(uint64_t nodeId) {
+    std::ostringstream message;
+    size_t addrLen = 0;
+
+    int ret = famAllocator->get_addr_size(&addrLen, nodeId);
+    if (addrLen <= 0) {
+        message << "Fam allocator get_addr_size failed";
+        throw Fam_Allocator_Exception(FAM_ERR_ALLOCATOR, message.str().c_str());
+    }
+    std::string addr(addrLen, '\0');
+    ret = famAllocator->get_addr(&addr[0], addrLen, nodeId);
+    if (ret < 0) {
+        message << "Fam Allocator get_addr failed";
+        throw Fam_Allocator_Exception(FAM_ERR_ALLOCATOR, message.str().c_str());
+    }
+    return addr;
+}
+
+/*
+ * Insert every memory server into the address vector. The addresses are
+ * inserted with a single call when they all have the same length, which is
+ * the case for a single provider.
+ */
+int Fam_Ops_Libfabric::connect_memservers() {
+    std::vector<std::string> addrs;
+    bool sameLen = true;
+    int ret;
+
+    for (uint64_t nodeId = 0; nodeId < name.size(); nodeId++) {
+        addrs.push_back(get_memserver_addr(nodeId));
+        sameLen = sameLen && (addrs[nodeId].size() == addrs[0].size());
+    }
+
+    std::vector<fi_addr_t> newAddrs;
+    if (sameLen) {
+        std::string batch;
+        for (auto &addr : addrs)
+            batch += addr;
+        ret = fabric_insert_av_batch(batch.data(), addrs.size(), av,
+                                     &newAddrs);
+        if (ret < 0)
+            return ret;
+    } else {
+        for (auto &addr : addrs) {
+            ret = fabric_insert_av(addr.data(), av, &newAddrs);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    for (uint64_t nodeId = 0; nodeId < name.size(); nodeId++) {
+        (*fiAddrs)[nodeId] = newAddrs[nodeId];
+        serverReady[nodeId].store(true, boost::memory_order_release);
+    }
+    return 0;
+}
+
+/*
+ * Insert a single memory server into the address vector on its first use.
+ */
+void Fam_Ops_Libfabric::connect_memserver(uint64_t nodeId) {
+    std::ostringstream message;
+
+    if (nodeId >= name.size()) {
+        message << "Fam libfabric: memory server " << nodeId << " not found";
+        throw Fam_Datapath_Exception(message.str().c_str());
+    }
+
+    (void)pthread_mutex_lock(&connectLock);
+    try {
+        // Connected by another thread while waiting for the lock
+        if (!serverReady[nodeId].load()) {
+            std::string addr = get_memserver_addr(nodeId);
+            std::vector<fi_addr_t> newAddrs;
+            if (fabric_insert_av(addr.data(), av, &newAddrs) < 0) {
+                message << "Fam libfabric fabric_insert_av failed for "
+                        << "memory server " << nodeId;
+                throw Fam_Datapath_Exception(message.str().c_str());
+            }
+            (*fiAddrs)[nodeId] = newAddrs[0];
+            serverReady[nodeId].store(true, boost::memory_order_release);
+        }
+    } catch (...) {
+        (void)pthread_mutex_unlock(&connectLock);
+        throw;
+    }
+    (void)pthread_mutex_unlock(&connectLock);
+}
+
 Fam_Context *Fam_Ops_Libfabric::get_context(Fam_Descriptor *descriptor) {
     std::ostringstream message;
     // Case - FAM_CONTEXT_DEFAULT
@@ -274,6 +486,44 @@ Fam_Context *Fam_Ops_Libfabric::get_context(Fam_Descriptor *descriptor) {
     }
 }
 
+fi_addr_t Fam_Ops_Libfabric::get_peer_fiAddr(const void *addr,
+                                             size_t addrLen) {
+    std::ostringstream message;
+    std::string peer((const char *)addr, addrLen);
+    fi_addr_t fiAddr;
+
+    (void)pthread_mutex_lock(&peerLock);
+    auto peerObj = peerAddrs->find(peer);
+    if (peerObj != peerAddrs->end()) {
+        fiAddr = peerObj->second;
+    } else {
+        std::vector<fi_addr_t> peerFiAddrs;
+        int ret = fabric_insert_av(peer.data(), av, &peerFiAddrs);
+        if (ret < 0) {
+            (void)pthread_mutex_unlock(&peerLock);
+            message << "Fam libfabric fabric_insert_av failed for peer";
+            throw Fam_Datapath_Exception(message.str().c_str());
+        }
+        fiAddr = peerFiAddrs[0];
+        peerAddrs->insert({peer, fiAddr});
+    }
+    (void)pthread_mutex_unlock(&peerLock);
+    return fiAddr;
+}
+
+Fam_Context *Fam_Ops_Libfabric::create_context() {
+    std::ostringstream message;
+    Fam_Context *ctx = new Fam_Context(fi, domain, famThreadModel);
+    int ret = fabric_enable_bind_ep(fi, av, eq, ctx->get_ep());
+    if (ret < 0) {
+        delete ctx;
+        message << "Fam libfabric fabric_enable_bind_ep failed: "
+                << fabric_strerror(ret);
+        throw Fam_Datapath_Exception(message.str().c_str());
+    }
+    return ctx;
+}
+
 void Fam_Ops_Libfabric::finalize() {
     fabric_finalize();
     if (fiMrs != NULL) {
@@ -297,6 +547,9 @@ void Fam_Ops_Libfabric::finalize() {
         defContexts->clear();
     }
 
+    if (peerAddrs != NULL)
+        peerAddrs->clear();
+
     if (fi) {
         fi_freeinfo(fi);
         fi = NULL;
@@ -325,15 +578,448 @@ void Fam_Ops_Libfabric::finalize() {
     name.clear();
 }
 
+/*
+ * Put or get on a striped data item. The range is cut at stripe boundaries
+ * and the pieces on each member are issued together without waiting, so that
+ * every memory server holding part of the range moves data at once. Blocking
+ * calls then wait for the contexts used.
+ */
+int Fam_Ops_Libfabric::access_striped(void *local, Fam_Descriptor *descriptor,
+                                      uint64_t offset, uint64_t nbytes,
+                                      bool write, bool block) {
+    Fam_Stripe_Layout layout = descriptor->get_layout();
+    std::vector<std::vector<struct iovec>> iov(layout.stripeCount);
+    std::vector<std::vector<struct fi_rma_iov>> rmaIov(layout.stripeCount);
+
+    for (uint64_t done = 0; done < nbytes;) {
+        uint64_t position = offset + done;
+        uint64_t len = layout.stripeSize - position % layout.stripeSize;
+        if (len > nbytes - done)
+            len = nbytes - done;
+        uint64_t memberOffset;
+        uint64_t index = fam_stripe_of(position, layout, memberOffset);
+        Fam_Descriptor *member = descriptor->get_stripe(index);
+        if (member == NULL)
+            throw Fam_Datapath_Exception("Offset beyond the data item");
+
+        struct iovec piece;
+        piece.iov_base = (char *)local + done;
+        piece.iov_len = len;
+        iov[index].push_back(piece);
+        struct fi_rma_iov rmaPiece;
+        rmaPiece.addr = get_rma_offset(member, memberOffset);
+        rmaPiece.len = len;
+        rmaPiece.key = member->get_key();
+        rmaIov[index].push_back(rmaPiece);
+        done += len;
+    }
+
+    std::vector<Fam_Context *> used;
+    for (uint64_t i = 0; i < layout.stripeCount; i++) {
+        if (iov[i].empty())
+            continue;
+        Fam_Descriptor *member = descriptor->get_stripe(i);
+        Fam_Context *ctx = get_context(member);
+        fabric_read_write_multi_msg(iov[i].size(), fabric_iov_limit,
+                                    get_fiAddr(member->get_memserver_id()),
+                                    ctx, iov[i].data(), rmaIov[i].data(),
+                                    write, false);
+        if (std::find(used.begin(), used.end(), ctx) == used.end())
+            used.push_back(ctx);
+    }
+
+    if (block) {
+        for (auto ctx : used)
+            fabric_quiet(ctx);
+    }
+    return 0;
+}
+
+/*
+ * Put or get on a mirrored data item. A put is written to every copy under
+ * the write lock of the data item, and completes before the lock is
+ * released, even if non-blocking; otherwise two PEs writing the same bytes
+ * could reach the copies in opposite orders and leave them different. A get
+ * goes to the copy whose context has the fewest reads in flight; a large one
+ * is split in contiguous pieces over all the copies instead, so that each
+ * memory server serves part of it.
+ */
+int Fam_Ops_Libfabric::access_mirrored(void *local, Fam_Descriptor *descriptor,
+                                       uint64_t offset, uint64_t nbytes,
+                                       bool write, bool block) {
+    uint64_t itemOffset = offset;
+    std::vector<Fam_Descriptor *> copies = get_copies(descriptor, offset);
+    std::vector<Fam_Context *> used;
+
+    if (write) {
+        order_writes(descriptor, itemOffset, [&]() {
+            for (auto copy : copies)
+                fabric_write_nonblocking(
+                    copy->get_key(), local, nbytes,
+                    get_rma_offset(copy, offset),
+                    get_fiAddr(copy->get_memserver_id()), get_context(copy));
+        });
+        return 0;
+    }
+
+    if (nbytes >= FAM_MIRROR_SPLIT_SIZE) {
+        uint64_t pieceSize = (nbytes + copies.size() - 1) / copies.size();
+        uint64_t done = 0;
+        for (auto copy : copies) {
+            uint64_t len = std::min(pieceSize, nbytes - done);
+            if (len == 0)
+                break;
+            Fam_Context *ctx = get_context(copy);
+            fabric_read_nonblocking(copy->get_key(), (char *)local + done, len,
+                                    get_rma_offset(copy, offset + done),
+                                    get_fiAddr(copy->get_memserver_id()), ctx);
+            done += len;
+            if (std::find(used.begin(), used.end(), ctx) == used.end())
+                used.push_back(ctx);
+        }
+
+        if (block) {
+            for (auto ctx : used)
+                fabric_quiet(ctx);
+        }
+        return 0;
+    }
+
+    Fam_Descriptor *target = copies[0];
+    uint64_t fewest = fabric_pending_reads(get_context(target));
+    for (uint64_t i = 1; (i < copies.size()) && (fewest > 0); i++) {
+        uint64_t pending = fabric_pending_reads(get_context(copies[i]));
+        if (pending < fewest) {
+            fewest = pending;
+            target = copies[i];
+        }
+    }
+
+    uint64_t rmaOffset = get_rma_offset(target, offset);
+    fi_addr_t fiAddr = get_fiAddr(target->get_memserver_id());
+    if (block)
+        return fabric_read(target->get_key(), local, nbytes, rmaOffset, fiAddr,
+                           get_context(target));
+    fabric_read_nonblocking(target->get_key(), local, nbytes, rmaOffset,
+                            fiAddr, get_context(target));
+    return 0;
+}
+
+std::vector<Fam_Descriptor *>
+Fam_Ops_Libfabric::get_copies(Fam_Descriptor *descriptor, uint64_t &offset) {
+    std::vector<Fam_Descriptor *> copies;
+
+    if (!fam_is_mirrored(descriptor)) {
+        copies.push_back(get_stripe(descriptor, offset));
+        return copies;
+    }
+    for (uint64_t i = 0; i < descriptor->get_layout().stripeCount; i++) {
+        Fam_Descriptor *copy = descriptor->get_stripe(i);
+        if (copy)
+            copies.push_back(copy);
+    }
+    if (copies.empty())
+        throw Fam_Datapath_Exception("Mirrored data item has no copy");
+    return copies;
+}
+
+void Fam_Ops_Libfabric::update_atomic(Fam_Descriptor *descriptor,
+                                      uint64_t offset, void *value,
+                                      enum fi_op op,
+                                      enum fi_datatype datatype) {
+    // The parity update needs the value the atomic replaced
+    if (fam_has_parity(descriptor)) {
+        uint64_t old;
+        fetch_atomic(descriptor, offset, value, &old, op, datatype);
+        return;
+    }
+    uint64_t itemOffset = offset;
+    std::vector<Fam_Descriptor *> copies = get_copies(descriptor, offset);
+    order_writes(descriptor, itemOffset, [&]() {
+        for (auto copy : copies)
+            fabric_atomic(copy->get_key(), value, get_rma_offset(copy, offset),
+                          op, datatype, get_fiAddr(copy->get_memserver_id()),
+                          get_context(copy));
+    });
+}
+
+/*
+ * Part of a data item whose CAS lock orders the writes at offset: the first
+ * copy of a mirrored data item, the parity member of the row of a RAID5 one,
+ * else the part holding offset. The 128-bit atomics take the same lock.
+ */
+Fam_Descriptor *Fam_Ops_Libfabric::get_write_lock(Fam_Descriptor *descriptor,
+                                                  uint64_t offset) {
+    if (!fam_has_parity(descriptor))
+        return get_copies(descriptor, offset)[0];
+
+    uint64_t memberOffset;
+    Fam_Descriptor *parity = descriptor->get_stripe(
+        fam_parity_of(offset, descriptor->get_layout(), memberOffset));
+    if (parity == NULL)
+        throw Fam_Datapath_Exception("Offset beyond the data item");
+    return parity;
+}
+
+/*
+ * Run op holding the CAS locks of the given parts of data items. The locks
+ * are taken in the order of their memory servers, so that callers taking
+ * several of them cannot deadlock.
+ */
+void Fam_Ops_Libfabric::with_locks(std::vector<Fam_Descriptor *> locks,
+                                   std::function<void()> op) {
+    std::sort(locks.begin(), locks.end(),
+              [](Fam_Descriptor *a, Fam_Descriptor *b) {
+                  return a->get_memserver_id() < b->get_memserver_id();
+              });
+
+    uint64_t locked = 0;
+    try {
+        for (; locked < locks.size(); locked++)
+            famAllocator->acquire_CAS_lock(locks[locked]);
+        op();
+    } catch (...) {
+        for (uint64_t i = 0; i < locked; i++)
+            famAllocator->release_CAS_lock(locks[i]);
+        throw;
+    }
+    for (auto lock : locks)
+        famAllocator->release_CAS_lock(lock);
+}
+
+/*
+ * Run op, which writes at offset of a data item with puts or atomics, under
+ * the write lock of offset, and wait for the writes to complete before
+ * releasing it. On a mirrored data item, each copy then applies concurrent
+ * writes in the same order, as two puts, or a swap and an add, could
+ * otherwise pass each other on the way to different copies. On a RAID5 one,
+ * the change of the data and of the parity of the row is not interleaved
+ * with that of a put reading them back. Other data items need no lock.
+ */
+void Fam_Ops_Libfabric::order_writes(Fam_Descriptor *descriptor,
+                                     uint64_t offset,
+                                     std::function<void()> op) {
+    if (!fam_is_mirrored(descriptor) && !fam_has_parity(descriptor)) {
+        op();
+        return;
+    }
+
+    uint64_t partOffset = offset;
+    std::vector<Fam_Descriptor *> copies =
+        get_copies(descriptor, partOffset);
+    with_locks({get_write_lock(descriptor, offset)}, [&]() {
+        op();
+        for (auto copy : copies)
+            fabric_quiet(get_context(copy));
+    });
+}
+
+void Fam_Ops_Libfabric::fetch_atomic(Fam_Descriptor *descriptor,
+                                     uint64_t offset, void *value,
+                                     void *result, enum fi_op op,
+                                     enum fi_datatype datatype) {
+    uint64_t itemOffset = offset;
+    std::vector<Fam_Descriptor *> copies = get_copies(descriptor, offset);
+
+    order_writes(descriptor, itemOffset, [&]() {
+        fabric_fetch_atomic(copies[0]->get_key(), value, result,
+                            get_rma_offset(copies[0], offset), op, datatype,
+                            get_fiAddr(copies[0]->get_memserver_id()),
+                            get_context(copies[0]));
+        for (uint64_t i = 1; i < copies.size(); i++)
+            fabric_atomic(copies[i]->get_key(), value,
+                          get_rma_offset(copies[i], offset), op, datatype,
+                          get_fiAddr(copies[i]->get_memserver_id()),
+                          get_context(copies[i]));
+
+        if (fam_has_parity(descriptor)) {
+            uint64_t updated;
+            size_t size = atomic_size(datatype);
+            apply_atomic(&updated, result, value, size, op, datatype);
+            update_parity(descriptor, itemOffset, result, &updated, size);
+        }
+    });
+}
+
+void Fam_Ops_Libfabric::compare_atomic(Fam_Descriptor *descriptor,
+                                       uint64_t offset, void *compare,
+                                       void *result, void *value, size_t size,
+                                       enum fi_datatype datatype) {
+    uint64_t itemOffset = offset;
+    std::vector<Fam_Descriptor *> copies = get_copies(descriptor, offset);
+
+    order_writes(descriptor, itemOffset, [&]() {
+        fabric_compare_atomic(copies[0]->get_key(), compare, result, value,
+                              get_rma_offset(copies[0], offset), FI_CSWAP,
+                              datatype,
+                              get_fiAddr(copies[0]->get_memserver_id()),
+                              get_context(copies[0]));
+        // The other copies and the parity only change if the swap happened
+        if (memcmp(result, compare, size) != 0)
+            return;
+        for (uint64_t i = 1; i < copies.size(); i++)
+            fabric_atomic(copies[i]->get_key(), value,
+                          get_rma_offset(copies[i], offset), FI_ATOMIC_WRITE,
+                          datatype, get_fiAddr(copies[i]->get_memserver_id()),
+                          get_context(copies[i]));
+        update_parity(descriptor, itemOffset, compare, value, size);
+    });
+}
+
+/*
+ * XOR the change of size bytes at offset of a RAID5 data item, from old to
+ * value, into the parity of its row, and wait for it. Callers hold the write
+ * lock of the row, so that the change of the data and of the parity is seen
+ * as one by puts reading them back. Other data items have no parity.
+ */
+void Fam_Ops_Libfabric::update_parity(Fam_Descriptor *descriptor,
+                                      uint64_t offset, const void *old,
+                                      const void *value, size_t size) {
+    if (!fam_has_parity(descriptor))
+        return;
+
+    uint64_t delta[2] = {0, 0};
+    memcpy(delta, old, size);
+    fam_xor((char *)delta, (const char *)value, size);
+    if ((delta[0] == 0) && (delta[1] == 0))
+        return;
+
+    uint64_t memberOffset;
+    Fam_Descriptor *parity = descriptor->get_stripe(
+        fam_parity_of(offset, descriptor->get_layout(), memberOffset));
+    if (parity == NULL)
+        throw Fam_Datapath_Exception("Offset beyond the data item");
+    size_t word = (size < sizeof(uint64_t)) ? size : sizeof(uint64_t);
+    for (size_t done = 0; done < size; done += word)
+        fabric_atomic(parity->get_key(), (char *)delta + done,
+                      get_rma_offset(parity, memberOffset + done), FI_BXOR,
+                      (word == sizeof(uint64_t)) ? FI_UINT64 : FI_UINT32,
+                      get_fiAddr(parity->get_memserver_id()),
+                      get_context(parity));
+    fabric_quiet(get_context(parity));
+}
+
+/*
+ * Put on a RAID5 data item, a batch of rows at a time. The parity of a row
+ * wholly written is the XOR of its new data stripes; for a row only partly
+ * written, the old data and parity are read back first and the change of the
+ * data is XORed into the parity. The data and parity pieces of a batch are
+ * then issued to all members together. The rows of a batch are held under
+ * their write locks meanwhile, so that concurrent puts and atomics on the
+ * same rows keep the parity exact. The parity buffers must outlive the
+ * writes, so the put has completed on return even when non-blocking.
+ */
+int Fam_Ops_Libfabric::put_parity(void *local, Fam_Descriptor *descriptor,
+                                  uint64_t offset, uint64_t nbytes) {
+    Fam_Stripe_Layout layout = descriptor->get_layout();
+    uint64_t stripeSize = layout.stripeSize;
+    uint64_t rowBytes = stripeSize * (layout.stripeCount - 1);
+    uint64_t batchRows = std::max(FAM_PARITY_BATCH_SIZE / stripeSize, 1UL);
+    uint64_t end = offset + nbytes;
+    std::vector<char> parity;
+    std::vector<char> old;
+
+    std::vector<Fam_Context *> used;
+    for (uint64_t i = 0; i < layout.stripeCount; i++) {
+        Fam_Descriptor *member = descriptor->get_stripe(i);
+        if (member == NULL)
+            continue;
+        Fam_Context *ctx = get_context(member);
+        if (std::find(used.begin(), used.end(), ctx) == used.end())
+            used.push_back(ctx);
+    }
+
+    for (uint64_t row = offset / rowBytes; row * rowBytes < end;
+         row += batchRows) {
+        uint64_t lastRow =
+            std::min(row + batchRows, (end + rowBytes - 1) / rowBytes);
+        parity.assign((lastRow - row) * stripeSize, 0);
+
+        // The rows of the batch stay locked until their data and parity are
+        // all written
+        std::vector<Fam_Descriptor *> locks;
+        for (uint64_t r = row; r < lastRow; r++) {
+            Fam_Descriptor *lock =
+                get_write_lock(descriptor, std::max(offset, r * rowBytes));
+            if (std::find(locks.begin(), locks.end(), lock) == locks.end())
+                locks.push_back(lock);
+        }
+
+        with_locks(locks, [&]() {
+            for (uint64_t r = row; r < lastRow; r++) {
+                uint64_t start = std::max(offset, r * rowBytes);
+                uint64_t stop = std::min(end, (r + 1) * rowBytes);
+                char *rowParity = parity.data() + (r - row) * stripeSize;
+                uint64_t memberOffset;
+                Fam_Descriptor *member = descriptor->get_stripe(
+                    fam_parity_of(start, layout, memberOffset));
+                if (member == NULL)
+                    throw Fam_Datapath_Exception(
+                        "Offset beyond the data item");
+                memberOffset -= start % stripeSize;
+
+                // Bytes [lo, hi) of the parity stripe change
+                uint64_t lo = 0;
+                uint64_t hi = stripeSize;
+                if ((stop - start < stripeSize) &&
+                    (start % stripeSize <= (stop - 1) % stripeSize)) {
+                    lo = start % stripeSize;
+                    hi = (stop - 1) % stripeSize + 1;
+                }
+
+                if (stop - start < rowBytes) {
+                    old.resize(stop - start);
+                    fabric_read(member->get_key(), rowParity + lo, hi - lo,
+                                get_rma_offset(member, memberOffset + lo),
+                                get_fiAddr(member->get_memserver_id()),
+                                get_context(member));
+                    access_striped(old.data(), descriptor, start, stop - start,
+                                   false, true);
+                }
+
+                for (uint64_t pos = start; pos < stop;) {
+                    uint64_t len =
+                        std::min(stripeSize - pos % stripeSize, stop - pos);
+                    char *dest = rowParity + pos % stripeSize;
+                    fam_xor(dest, (char *)local + (pos - offset), len);
+                    if (stop - start < rowBytes)
+                        fam_xor(dest, old.data() + (pos - start), len);
+                    pos += len;
+                }
+
+                fabric_write_nonblocking(
+                    member->get_key(), rowParity + lo, hi - lo,
+                    get_rma_offset(member, memberOffset + lo),
+                    get_fiAddr(member->get_memserver_id()),
+                    get_context(member));
+            }
+
+            uint64_t batchStart = std::max(offset, row * rowBytes);
+            uint64_t batchEnd = std::min(end, lastRow * rowBytes);
+            access_striped((char *)local + (batchStart - offset), descriptor,
+                           batchStart, batchEnd - batchStart, true, false);
+            for (auto ctx : used)
+                fabric_quiet(ctx);
+        });
+    }
+    return 0;
+}
+
 int Fam_Ops_Libfabric::put_blocking(void *local, Fam_Descriptor *descriptor,
                                     uint64_t offset, uint64_t nbytes) {
     std::ostringstream message;
+    if (fam_is_mirrored(descriptor))
+        return access_mirrored(local, descriptor, offset, nbytes, true, true);
+    if (fam_has_parity(descriptor))
+        return put_parity(local, descriptor, offset, nbytes);
+    if (fam_stripe_count(descriptor) > 1)
+        return access_striped(local, descriptor, offset, nbytes, true, true);
     // Write data into memory region with this key
     uint64_t key;
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    int ret = fabric_write(key, local, nbytes, offset, (*fiAddr)[nodeId],
+    offset = get_rma_offset(descriptor, offset);
+    int ret = fabric_write(key, local, nbytes, offset, get_fiAddr(nodeId),
                            get_context(descriptor));
     return ret;
 }
@@ -341,12 +1027,16 @@ int Fam_Ops_Libfabric::put_blocking(void *local, Fam_Descriptor *descriptor,
 int Fam_Ops_Libfabric::get_blocking(void *local, Fam_Descriptor *descriptor,
                                     uint64_t offset, uint64_t nbytes) {
     std::ostringstream message;
+    if (fam_is_mirrored(descriptor))
+        return access_mirrored(local, descriptor, offset, nbytes, false, true);
+    if (fam_stripe_count(descriptor) > 1)
+        return access_striped(local, descriptor, offset, nbytes, false, true);
     // Write data into memory region with this key
     uint64_t key;
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    int ret = fabric_read(key, local, nbytes, offset, (*fiAddr)[nodeId],
+    offset = get_rma_offset(descriptor, offset);
+    int ret = fabric_read(key, local, nbytes, offset, get_fiAddr(nodeId),
                           get_context(descriptor));
 
     return ret;
@@ -361,10 +1051,10 @@ int Fam_Ops_Libfabric::gather_blocking(void *local, Fam_Descriptor *descriptor,
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int ret = fabric_gather_stride_blocking(
         key, local, elementSize, firstElement, nElements, stride,
-        (*fiAddr)[nodeId], get_context(descriptor), fabric_iov_limit);
+        get_fiAddr(nodeId), get_context(descriptor), fabric_iov_limit,
+        get_rma_offset(descriptor, 0));
     return ret;
 }
 
@@ -376,10 +1066,10 @@ int Fam_Ops_Libfabric::gather_blocking(void *local, Fam_Descriptor *descriptor,
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int ret = fabric_gather_index_blocking(
-        key, local, elementSize, elementIndex, nElements, (*fiAddr)[nodeId],
-        get_context(descriptor), fabric_iov_limit);
+        key, local, elementSize, elementIndex, nElements, get_fiAddr(nodeId),
+        get_context(descriptor), fabric_iov_limit,
+        get_rma_offset(descriptor, 0));
     return ret;
 }
 
@@ -392,10 +1082,10 @@ int Fam_Ops_Libfabric::scatter_blocking(void *local, Fam_Descriptor *descriptor,
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int ret = fabric_scatter_stride_blocking(
         key, local, elementSize, firstElement, nElements, stride,
-        (*fiAddr)[nodeId], get_context(descriptor), fabric_iov_limit);
+        get_fiAddr(nodeId), get_context(descriptor), fabric_iov_limit,
+        get_rma_offset(descriptor, 0));
     return ret;
 }
 
@@ -407,10 +1097,10 @@ int Fam_Ops_Libfabric::scatter_blocking(void *local, Fam_Descriptor *descriptor,
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int ret = fabric_scatter_index_blocking(
-        key, local, elementSize, elementIndex, nElements, (*fiAddr)[nodeId],
-        get_context(descriptor), fabric_iov_limit);
+        key, local, elementSize, elementIndex, nElements, get_fiAddr(nodeId),
+        get_context(descriptor), fabric_iov_limit,
+        get_rma_offset(descriptor, 0));
     return ret;
 }
 
@@ -418,11 +1108,23 @@ void Fam_Ops_Libfabric::put_nonblocking(void *local, Fam_Descriptor *descriptor,
                                         uint64_t offset, uint64_t nbytes) {
 
     uint64_t key;
+    if (fam_is_mirrored(descriptor)) {
+        access_mirrored(local, descriptor, offset, nbytes, true, false);
+        return;
+    }
+    if (fam_has_parity(descriptor)) {
+        put_parity(local, descriptor, offset, nbytes);
+        return;
+    }
+    if (fam_stripe_count(descriptor) > 1) {
+        access_striped(local, descriptor, offset, nbytes, true, false);
+        return;
+    }
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_write_nonblocking(key, local, nbytes, offset, (*fiAddr)[nodeId],
+    offset = get_rma_offset(descriptor, offset);
+    fabric_write_nonblocking(key, local, nbytes, offset, get_fiAddr(nodeId),
                              get_context(descriptor));
     return;
 }
@@ -430,11 +1132,19 @@ void Fam_Ops_Libfabric::put_nonblocking(void *local, Fam_Descriptor *descriptor,
 void Fam_Ops_Libfabric::get_nonblocking(void *local, Fam_Descriptor *descriptor,
                                         uint64_t offset, uint64_t nbytes) {
     uint64_t key;
+    if (fam_is_mirrored(descriptor)) {
+        access_mirrored(local, descriptor, offset, nbytes, false, false);
+        return;
+    }
+    if (fam_stripe_count(descriptor) > 1) {
+        access_striped(local, descriptor, offset, nbytes, false, false);
+        return;
+    }
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_read_nonblocking(key, local, nbytes, offset, (*fiAddr)[nodeId],
+    offset = get_rma_offset(descriptor, offset);
+    fabric_read_nonblocking(key, local, nbytes, offset, get_fiAddr(nodeId),
                             get_context(descriptor));
     return;
 }
@@ -447,10 +1157,10 @@ void Fam_Ops_Libfabric::gather_nonblocking(
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     fabric_gather_stride_nonblocking(key, local, elementSize, firstElement,
-                                     nElements, stride, (*fiAddr)[nodeId],
-                                     get_context(descriptor), fabric_iov_limit);
+                                     nElements, stride, get_fiAddr(nodeId),
+                                     get_context(descriptor), fabric_iov_limit,
+                                     get_rma_offset(descriptor, 0));
     return;
 }
 
@@ -463,10 +1173,10 @@ void Fam_Ops_Libfabric::gather_nonblocking(void *local,
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     fabric_gather_index_nonblocking(key, local, elementSize, elementIndex,
-                                    nElements, (*fiAddr)[nodeId],
-                                    get_context(descriptor), fabric_iov_limit);
+                                    nElements, get_fiAddr(nodeId),
+                                    get_context(descriptor), fabric_iov_limit,
+                                    get_rma_offset(descriptor, 0));
     return;
 }
 
@@ -478,10 +1188,10 @@ void Fam_Ops_Libfabric::scatter_nonblocking(
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     fabric_scatter_stride_nonblocking(
         key, local, elementSize, firstElement, nElements, stride,
-        (*fiAddr)[nodeId], get_context(descriptor), fabric_iov_limit);
+        get_fiAddr(nodeId), get_context(descriptor), fabric_iov_limit,
+        get_rma_offset(descriptor, 0));
     return;
 }
 
@@ -494,10 +1204,10 @@ void Fam_Ops_Libfabric::scatter_nonblocking(void *local,
 
     key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     fabric_scatter_index_nonblocking(key, local, elementSize, elementIndex,
-                                     nElements, (*fiAddr)[nodeId],
-                                     get_context(descriptor), fabric_iov_limit);
+                                     nElements, get_fiAddr(nodeId),
+                                     get_context(descriptor), fabric_iov_limit,
+                                     get_rma_offset(descriptor, 0));
     return;
 }
 
@@ -507,18 +1217,31 @@ void *Fam_Ops_Libfabric::copy(Fam_Descriptor *src, uint64_t srcOffset,
     return famAllocator->copy(src, srcOffset, dest, destOffset, nbytes);
 }
 
+void *Fam_Ops_Libfabric::copy(Fam_Descriptor *src, uint64_t srcOffset,
+                              Fam_Descriptor *dest, uint64_t destOffset,
+                              uint64_t nbytes) {
+    return famAllocator->copy(src, srcOffset, dest, destOffset, nbytes);
+}
+
 void Fam_Ops_Libfabric::wait_for_copy(void *waitObj) {
     return famAllocator->wait_for_copy(waitObj);
 }
 
-void Fam_Ops_Libfabric::fence(Fam_Region_Descriptor *descriptor) {
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
+uint64_t Fam_Ops_Libfabric::copy_progress(void *waitObj) {
+    return famAllocator->copy_progress(waitObj);
+}
 
+/*
+ * Memory servers not connected yet have had nothing issued to them, so they
+ * are skipped rather than connected just to be fenced.
+ */
+void Fam_Ops_Libfabric::fence(Fam_Region_Descriptor *descriptor) {
     uint64_t nodeId = 0;
     if (famContextModel == FAM_CONTEXT_DEFAULT) {
         for (auto fam_ctx : *defContexts) {
-            fabric_fence((*fiAddr)[nodeId], fam_ctx.second);
-            nodeId++;
+            nodeId = fam_ctx.first;
+            if (is_memserver_ready(nodeId))
+                fabric_fence(get_fiAddr(nodeId), fam_ctx.second);
         }
     } else if (famContextModel == FAM_CONTEXT_REGION) {
         // ctx mutex lock
@@ -528,8 +1251,10 @@ void Fam_Ops_Libfabric::fence(Fam_Region_Descriptor *descriptor) {
             if (descriptor) {
                 nodeId = descriptor->get_memserver_id();
                 Fam_Context *ctx = (Fam_Context *)descriptor->get_context();
-                if (ctx) {
-                    fabric_fence((*fiAddr)[nodeId], ctx);
+                if (!is_memserver_ready(nodeId)) {
+                    // Nothing was issued to this memory server
+                } else if (ctx) {
+                    fabric_fence(get_fiAddr(nodeId), ctx);
                 } else {
                     Fam_Global_Descriptor global =
                         descriptor->get_global_descriptor();
@@ -537,14 +1262,14 @@ void Fam_Ops_Libfabric::fence(Fam_Region_Descriptor *descriptor) {
                     auto ctxObj = contexts->find(regionId);
                     if (ctxObj != contexts->end()) {
                         descriptor->set_context(ctxObj->second);
-                        fabric_fence((*fiAddr)[nodeId], ctxObj->second);
+                        fabric_fence(get_fiAddr(nodeId), ctxObj->second);
                     }
                 }
             } else {
                 for (auto fam_ctx : *contexts) {
-                    fabric_fence(
-                        (*fiAddr)[(fam_ctx.first) >> MEMSERVERID_SHIFT],
-                        fam_ctx.second);
+                    nodeId = fam_ctx.first >> MEMSERVERID_SHIFT;
+                    if (is_memserver_ready(nodeId))
+                        fabric_fence(get_fiAddr(nodeId), fam_ctx.second);
                 }
             }
         } catch (...) {
@@ -605,145 +1330,79 @@ void Fam_Ops_Libfabric::quiet(Fam_Region_Descriptor *descriptor) {
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_ATOMIC_WRITE, FI_INT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_ATOMIC_WRITE,
+                  FI_INT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_ATOMIC_WRITE, FI_INT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_ATOMIC_WRITE,
+                  FI_INT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_ATOMIC_WRITE, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_ATOMIC_WRITE,
+                  FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_ATOMIC_WRITE, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_ATOMIC_WRITE,
+                  FI_UINT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_ATOMIC_WRITE, FI_FLOAT,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_ATOMIC_WRITE,
+                  FI_FLOAT);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_ATOMIC_WRITE, FI_DOUBLE,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_ATOMIC_WRITE,
+                  FI_DOUBLE);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                    int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_SUM, FI_INT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_SUM, FI_INT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                    int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_SUM, FI_INT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_SUM, FI_INT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_SUM, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_SUM, FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_SUM, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_SUM, FI_UINT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                    float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_SUM, FI_FLOAT,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_SUM, FI_FLOAT);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                    double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_SUM, FI_DOUBLE,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_SUM, FI_DOUBLE);
     return;
 }
 
@@ -785,361 +1444,193 @@ void Fam_Ops_Libfabric::atomic_subtract(Fam_Descriptor *descriptor,
 
 void Fam_Ops_Libfabric::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                    int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MIN, FI_INT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MIN, FI_INT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                    int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MIN, FI_INT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MIN, FI_INT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MIN, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MIN, FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MIN, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MIN, FI_UINT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                    float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MIN, FI_FLOAT,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MIN, FI_FLOAT);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                    double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MIN, FI_DOUBLE,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MIN, FI_DOUBLE);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                    int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MAX, FI_INT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MAX, FI_INT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                    int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MAX, FI_INT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MAX, FI_INT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MAX, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MAX, FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MAX, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MAX, FI_UINT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                    float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MAX, FI_FLOAT,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MAX, FI_FLOAT);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                    double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_MAX, FI_DOUBLE,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_MAX, FI_DOUBLE);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_and(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_BAND, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_BAND, FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_and(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_BAND, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_BAND, FI_UINT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_or(Fam_Descriptor *descriptor, uint64_t offset,
                                   uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_BOR, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_BOR, FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_or(Fam_Descriptor *descriptor, uint64_t offset,
                                   uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_BOR, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_BOR, FI_UINT64);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_xor(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_BXOR, FI_UINT32,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_BXOR, FI_UINT32);
     return;
 }
 
 void Fam_Ops_Libfabric::atomic_xor(Fam_Descriptor *descriptor, uint64_t offset,
                                    uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    fabric_atomic(key, (void *)&value, offset, FI_BXOR, FI_UINT64,
-                  (*fiAddr)[nodeId], get_context(descriptor));
+    update_atomic(descriptor, offset, (void *)&value, FI_BXOR, FI_UINT64);
     return;
 }
 
 int32_t Fam_Ops_Libfabric::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                 int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset,
-                        FI_ATOMIC_WRITE, FI_INT32, (*fiAddr)[nodeId],
-                        get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old,
+                 FI_ATOMIC_WRITE, FI_INT32);
     return old;
 }
 
 int64_t Fam_Ops_Libfabric::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                 int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset,
-                        FI_ATOMIC_WRITE, FI_INT64, (*fiAddr)[nodeId],
-                        get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old,
+                 FI_ATOMIC_WRITE, FI_INT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                  uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset,
-                        FI_ATOMIC_WRITE, FI_UINT32, (*fiAddr)[nodeId],
-                        get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old,
+                 FI_ATOMIC_WRITE, FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                  uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset,
-                        FI_ATOMIC_WRITE, FI_UINT64, (*fiAddr)[nodeId],
-                        get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old,
+                 FI_ATOMIC_WRITE, FI_UINT64);
     return old;
 }
 
 float Fam_Ops_Libfabric::swap(Fam_Descriptor *descriptor, uint64_t offset,
                               float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     float old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset,
-                        FI_ATOMIC_WRITE, FI_FLOAT, (*fiAddr)[nodeId],
-                        get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old,
+                 FI_ATOMIC_WRITE, FI_FLOAT);
     return old;
 }
 
 double Fam_Ops_Libfabric::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     double old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset,
-                        FI_ATOMIC_WRITE, FI_DOUBLE, (*fiAddr)[nodeId],
-                        get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old,
+                 FI_ATOMIC_WRITE, FI_DOUBLE);
     return old;
 }
 
 int32_t Fam_Ops_Libfabric::compare_swap(Fam_Descriptor *descriptor,
                                         uint64_t offset, int32_t oldValue,
                                         int32_t newValue) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int32_t old;
-    fabric_compare_atomic(key, (void *)&oldValue, (void *)&old,
-                          (void *)&newValue, offset, FI_CSWAP, FI_INT32,
-                          (*fiAddr)[nodeId], get_context(descriptor));
+    compare_atomic(descriptor, offset, (void *)&oldValue, (void *)&old,
+                   (void *)&newValue, sizeof(old), FI_INT32);
     return old;
 }
 
 int64_t Fam_Ops_Libfabric::compare_swap(Fam_Descriptor *descriptor,
                                         uint64_t offset, int64_t oldValue,
                                         int64_t newValue) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int64_t old;
-    fabric_compare_atomic(key, (void *)&oldValue, (void *)&old,
-                          (void *)&newValue, offset, FI_CSWAP, FI_INT64,
-                          (*fiAddr)[nodeId], get_context(descriptor));
+    compare_atomic(descriptor, offset, (void *)&oldValue, (void *)&old,
+                   (void *)&newValue, sizeof(old), FI_INT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::compare_swap(Fam_Descriptor *descriptor,
                                          uint64_t offset, uint32_t oldValue,
                                          uint32_t newValue) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_compare_atomic(key, (void *)&oldValue, (void *)&old,
-                          (void *)&newValue, offset, FI_CSWAP, FI_UINT32,
-                          (*fiAddr)[nodeId], get_context(descriptor));
+    compare_atomic(descriptor, offset, (void *)&oldValue, (void *)&old,
+                   (void *)&newValue, sizeof(old), FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::compare_swap(Fam_Descriptor *descriptor,
                                          uint64_t offset, uint64_t oldValue,
                                          uint64_t newValue) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_compare_atomic(key, (void *)&oldValue, (void *)&old,
-                          (void *)&newValue, offset, FI_CSWAP, FI_UINT64,
-                          (*fiAddr)[nodeId], get_context(descriptor));
+    compare_atomic(descriptor, offset, (void *)&oldValue, (void *)&old,
+                   (void *)&newValue, sizeof(old), FI_UINT64);
     return old;
 }
 
@@ -1147,44 +1638,55 @@ int128_t Fam_Ops_Libfabric::compare_swap(Fam_Descriptor *descriptor,
                                          uint64_t offset, int128_t oldValue,
                                          int128_t newValue) {
 
+    Fam_Descriptor *item = descriptor;
+    uint64_t itemOffset = offset;
+    std::vector<Fam_Descriptor *> copies = get_copies(descriptor, offset);
+    descriptor = copies[0];
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    Fam_Descriptor *lock = get_write_lock(item, itemOffset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int128_t local;
 
-    famAllocator->acquire_CAS_lock(descriptor);
+    famAllocator->acquire_CAS_lock(lock);
     try {
-        fabric_read(key, &local, sizeof(int128_t), offset, (*fiAddr)[nodeId],
+        fabric_read(key, &local, sizeof(int128_t),
+                    get_rma_offset(descriptor, offset), get_fiAddr(nodeId),
                     get_context(descriptor));
     } catch (...) {
-        famAllocator->release_CAS_lock(descriptor);
+        famAllocator->release_CAS_lock(lock);
         throw;
     }
 
     if (local == oldValue) {
         try {
-            fabric_write(key, &newValue, sizeof(int128_t), offset,
-                         (*fiAddr)[nodeId], get_context(descriptor));
+            for (auto copy : copies)
+                fabric_write(copy->get_key(), &newValue, sizeof(int128_t),
+                             get_rma_offset(copy, offset),
+                             get_fiAddr(copy->get_memserver_id()),
+                             get_context(copy));
+            update_parity(item, itemOffset, &oldValue, &newValue,
+                          sizeof(int128_t));
         } catch (...) {
-            famAllocator->release_CAS_lock(descriptor);
+            famAllocator->release_CAS_lock(lock);
             throw;
         }
     }
-    famAllocator->release_CAS_lock(descriptor);
+    famAllocator->release_CAS_lock(lock);
     return local;
 }
 
 int32_t Fam_Ops_Libfabric::atomic_fetch_int32(Fam_Descriptor *descriptor,
                                               uint64_t offset) {
     std::ostringstream message;
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int32_t result;
     fabric_fetch_atomic(key, (void *)&result, (void *)&result, offset,
-                        FI_ATOMIC_READ, FI_INT32, (*fiAddr)[nodeId],
+                        FI_ATOMIC_READ, FI_INT32, get_fiAddr(nodeId),
                         get_context(descriptor));
     return result;
 }
@@ -1192,13 +1694,14 @@ int32_t Fam_Ops_Libfabric::atomic_fetch_int32(Fam_Descriptor *descriptor,
 int64_t Fam_Ops_Libfabric::atomic_fetch_int64(Fam_Descriptor *descriptor,
                                               uint64_t offset) {
     std::ostringstream message;
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int64_t result;
     fabric_fetch_atomic(key, (void *)&result, (void *)&result, offset,
-                        FI_ATOMIC_READ, FI_INT64, (*fiAddr)[nodeId],
+                        FI_ATOMIC_READ, FI_INT64, get_fiAddr(nodeId),
                         get_context(descriptor));
     return result;
 }
@@ -1206,13 +1709,14 @@ int64_t Fam_Ops_Libfabric::atomic_fetch_int64(Fam_Descriptor *descriptor,
 uint32_t Fam_Ops_Libfabric::atomic_fetch_uint32(Fam_Descriptor *descriptor,
                                                 uint64_t offset) {
     std::ostringstream message;
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t result;
     fabric_fetch_atomic(key, (void *)&result, (void *)&result, offset,
-                        FI_ATOMIC_READ, FI_UINT32, (*fiAddr)[nodeId],
+                        FI_ATOMIC_READ, FI_UINT32, get_fiAddr(nodeId),
                         get_context(descriptor));
     return result;
 }
@@ -1220,13 +1724,14 @@ uint32_t Fam_Ops_Libfabric::atomic_fetch_uint32(Fam_Descriptor *descriptor,
 uint64_t Fam_Ops_Libfabric::atomic_fetch_uint64(Fam_Descriptor *descriptor,
                                                 uint64_t offset) {
     std::ostringstream message;
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t result;
     fabric_fetch_atomic(key, (void *)&result, (void *)&result, offset,
-                        FI_ATOMIC_READ, FI_UINT64, (*fiAddr)[nodeId],
+                        FI_ATOMIC_READ, FI_UINT64, get_fiAddr(nodeId),
                         get_context(descriptor));
     return result;
 }
@@ -1234,13 +1739,14 @@ uint64_t Fam_Ops_Libfabric::atomic_fetch_uint64(Fam_Descriptor *descriptor,
 float Fam_Ops_Libfabric::atomic_fetch_float(Fam_Descriptor *descriptor,
                                             uint64_t offset) {
     std::ostringstream message;
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     float result;
     fabric_fetch_atomic(key, (void *)&result, (void *)&result, offset,
-                        FI_ATOMIC_READ, FI_FLOAT, (*fiAddr)[nodeId],
+                        FI_ATOMIC_READ, FI_FLOAT, get_fiAddr(nodeId),
                         get_context(descriptor));
     return result;
 }
@@ -1248,92 +1754,63 @@ float Fam_Ops_Libfabric::atomic_fetch_float(Fam_Descriptor *descriptor,
 double Fam_Ops_Libfabric::atomic_fetch_double(Fam_Descriptor *descriptor,
                                               uint64_t offset) {
     std::ostringstream message;
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     double result;
     fabric_fetch_atomic(key, (void *)&result, (void *)&result, offset,
-                        FI_ATOMIC_READ, FI_DOUBLE, (*fiAddr)[nodeId],
+                        FI_ATOMIC_READ, FI_DOUBLE, get_fiAddr(nodeId),
                         get_context(descriptor));
     return result;
 }
 
 int32_t Fam_Ops_Libfabric::atomic_fetch_add(Fam_Descriptor *descriptor,
                                             uint64_t offset, int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_SUM,
-                        FI_INT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_SUM,
+                 FI_INT32);
     return old;
 }
 
 int64_t Fam_Ops_Libfabric::atomic_fetch_add(Fam_Descriptor *descriptor,
                                             uint64_t offset, int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_SUM,
-                        FI_INT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_SUM,
+                 FI_INT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::atomic_fetch_add(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_SUM,
-                        FI_UINT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_SUM,
+                 FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::atomic_fetch_add(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_SUM,
-                        FI_UINT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_SUM,
+                 FI_UINT64);
     return old;
 }
 
 float Fam_Ops_Libfabric::atomic_fetch_add(Fam_Descriptor *descriptor,
                                           uint64_t offset, float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     float old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_SUM,
-                        FI_FLOAT, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_SUM,
+                 FI_FLOAT);
     return old;
 }
 
 double Fam_Ops_Libfabric::atomic_fetch_add(Fam_Descriptor *descriptor,
                                            uint64_t offset, double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     double old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_SUM,
-                        FI_DOUBLE, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_SUM,
+                 FI_DOUBLE);
     return old;
 }
 
@@ -1373,235 +1850,145 @@ double Fam_Ops_Libfabric::atomic_fetch_subtract(Fam_Descriptor *descriptor,
 
 int32_t Fam_Ops_Libfabric::atomic_fetch_min(Fam_Descriptor *descriptor,
                                             uint64_t offset, int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MIN,
-                        FI_INT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MIN,
+                 FI_INT32);
     return old;
 }
 
 int64_t Fam_Ops_Libfabric::atomic_fetch_min(Fam_Descriptor *descriptor,
                                             uint64_t offset, int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MIN,
-                        FI_INT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MIN,
+                 FI_INT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::atomic_fetch_min(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MIN,
-                        FI_UINT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MIN,
+                 FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::atomic_fetch_min(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MIN,
-                        FI_UINT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MIN,
+                 FI_UINT64);
     return old;
 }
 
 float Fam_Ops_Libfabric::atomic_fetch_min(Fam_Descriptor *descriptor,
                                           uint64_t offset, float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     float old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MIN,
-                        FI_FLOAT, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MIN,
+                 FI_FLOAT);
     return old;
 }
 
 double Fam_Ops_Libfabric::atomic_fetch_min(Fam_Descriptor *descriptor,
                                            uint64_t offset, double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     double old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MIN,
-                        FI_DOUBLE, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MIN,
+                 FI_DOUBLE);
     return old;
 }
 
 int32_t Fam_Ops_Libfabric::atomic_fetch_max(Fam_Descriptor *descriptor,
                                             uint64_t offset, int32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MAX,
-                        FI_INT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MAX,
+                 FI_INT32);
     return old;
 }
 
 int64_t Fam_Ops_Libfabric::atomic_fetch_max(Fam_Descriptor *descriptor,
                                             uint64_t offset, int64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     int64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MAX,
-                        FI_INT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MAX,
+                 FI_INT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::atomic_fetch_max(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MAX,
-                        FI_UINT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MAX,
+                 FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::atomic_fetch_max(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MAX,
-                        FI_UINT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MAX,
+                 FI_UINT64);
     return old;
 }
 
 float Fam_Ops_Libfabric::atomic_fetch_max(Fam_Descriptor *descriptor,
                                           uint64_t offset, float value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     float old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MAX,
-                        FI_FLOAT, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MAX,
+                 FI_FLOAT);
     return old;
 }
 
 double Fam_Ops_Libfabric::atomic_fetch_max(Fam_Descriptor *descriptor,
                                            uint64_t offset, double value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     double old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_MAX,
-                        FI_DOUBLE, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_MAX,
+                 FI_DOUBLE);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::atomic_fetch_and(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_BAND,
-                        FI_UINT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_BAND,
+                 FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::atomic_fetch_and(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_BAND,
-                        FI_UINT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_BAND,
+                 FI_UINT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::atomic_fetch_or(Fam_Descriptor *descriptor,
                                             uint64_t offset, uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_BOR,
-                        FI_UINT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_BOR,
+                 FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::atomic_fetch_or(Fam_Descriptor *descriptor,
                                             uint64_t offset, uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_BOR,
-                        FI_UINT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_BOR,
+                 FI_UINT64);
     return old;
 }
 
 uint32_t Fam_Ops_Libfabric::atomic_fetch_xor(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint32_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint32_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_BXOR,
-                        FI_UINT32, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_BXOR,
+                 FI_UINT32);
     return old;
 }
 
 uint64_t Fam_Ops_Libfabric::atomic_fetch_xor(Fam_Descriptor *descriptor,
                                              uint64_t offset, uint64_t value) {
-    std::ostringstream message;
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
-
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
     uint64_t old;
-    fabric_fetch_atomic(key, (void *)&value, (void *)&old, offset, FI_BXOR,
-                        FI_UINT64, (*fiAddr)[nodeId], get_context(descriptor));
+    fetch_atomic(descriptor, offset, (void *)&value, (void *)&old, FI_BXOR,
+                 FI_UINT64);
     return old;
 }
 
@@ -1609,37 +1996,52 @@ void Fam_Ops_Libfabric::abort(int status) FAM_OPS_UNIMPLEMENTED(void_);
 
 void Fam_Ops_Libfabric::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                    int128_t value) {
-    uint64_t key = descriptor->get_key();
-    uint64_t nodeId = descriptor->get_memserver_id();
+    uint64_t itemOffset = offset;
+    std::vector<Fam_Descriptor *> copies = get_copies(descriptor, offset);
+    Fam_Descriptor *lock = get_write_lock(descriptor, itemOffset);
 
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    famAllocator->acquire_CAS_lock(descriptor);
+    // The lock orders the writes to every copy, and to the parity
+    famAllocator->acquire_CAS_lock(lock);
     try {
-        fabric_write(key, &value, sizeof(int128_t), offset, (*fiAddr)[nodeId],
-                     get_context(descriptor));
+        int128_t old = 0;
+        if (fam_has_parity(descriptor))
+            fabric_read(copies[0]->get_key(), &old, sizeof(int128_t),
+                        get_rma_offset(copies[0], offset),
+                        get_fiAddr(copies[0]->get_memserver_id()),
+                        get_context(copies[0]));
+        for (auto copy : copies)
+            fabric_write(copy->get_key(), &value, sizeof(int128_t),
+                         get_rma_offset(copy, offset),
+                         get_fiAddr(copy->get_memserver_id()),
+                         get_context(copy));
+        if (fam_has_parity(descriptor))
+            update_parity(descriptor, itemOffset, &old, &value,
+                          sizeof(int128_t));
     } catch (...) {
-        famAllocator->release_CAS_lock(descriptor);
+        famAllocator->release_CAS_lock(lock);
         throw;
     }
-    famAllocator->release_CAS_lock(descriptor);
+    famAllocator->release_CAS_lock(lock);
 }
 
 int128_t Fam_Ops_Libfabric::atomic_fetch_int128(Fam_Descriptor *descriptor,
                                                 uint64_t offset) {
+    Fam_Descriptor *lock = get_write_lock(descriptor, offset);
+    descriptor = get_stripe(descriptor, offset);
     uint64_t key = descriptor->get_key();
     uint64_t nodeId = descriptor->get_memserver_id();
+    offset = get_rma_offset(descriptor, offset);
 
     int128_t local;
-    std::vector<fi_addr_t> *fiAddr = get_fiAddrs();
-    famAllocator->acquire_CAS_lock(descriptor);
+    famAllocator->acquire_CAS_lock(lock);
     try {
-        fabric_read(key, &local, sizeof(int128_t), offset, (*fiAddr)[nodeId],
+        fabric_read(key, &local, sizeof(int128_t), offset, get_fiAddr(nodeId),
                     get_context(descriptor));
     } catch (...) {
-        famAllocator->release_CAS_lock(descriptor);
+        famAllocator->release_CAS_lock(lock);
         throw;
     }
-    famAllocator->release_CAS_lock(descriptor);
+    famAllocator->release_CAS_lock(lock);
     return local;
 }
 
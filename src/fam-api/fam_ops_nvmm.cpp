@@ -41,6 +41,7 @@
 #include "common/fam_ops.h"
 #include "common/fam_ops_nvmm.h"
 #include "common/fam_util_atomic.h"
+#include "common/fam_util_gather.h"
 #include "fam/fam.h"
 #include "fam/fam_exception.h"
 #include "nvmm/nvmm_fam_atomic.h"
@@ -48,10 +49,16 @@
 using namespace std;
 namespace openfam {
 Fam_Ops_NVMM::Fam_Ops_NVMM(Fam_Thread_Model famTM, Fam_Context_Model famCM,
-                           Fam_Allocator *famAlloc, uint64_t numConsumer) {
+                           Fam_Allocator *famAlloc, uint64_t numConsumer,
+                           Fam_Atomic_Model famAM) {
     asyncQHandler = new Fam_Async_QHandler(numConsumer);
     famThreadModel = famTM;
     famContextModel = famCM;
+    famAtomicModel = famAM;
+    if (famAtomicModel == FAM_ATOMIC_CPU)
+        atomicHandlers = fam_cpu_readwrite_handlers;
+    else
+        atomicHandlers = fam_atomic_readwrite_handlers;
     famAllocator = famAlloc;
     contexts = new std::map<uint64_t, Fam_Context *>();
 }
@@ -188,9 +195,6 @@ int Fam_Ops_NVMM::gather_blocking(void *local, Fam_Descriptor *descriptor,
     uint64_t size = descriptor->get_size();
     uint64_t key = descriptor->get_key();
 
-    void *src;
-    void *dest;
-
     if (((firstElement * elementSize) > size) ||
         ((firstElement * elementSize) + elementSize * stride * nElements) >
             size) {
@@ -205,16 +209,14 @@ int Fam_Ops_NVMM::gather_blocking(void *local, Fam_Descriptor *descriptor,
 
     Fam_Context *famCtx = get_context(descriptor);
 
+    void *src = (void *)((uint64_t)base + (firstElement * elementSize));
+
     // Take Fam_Context read lock
     famCtx->aquire_RDLock();
 
-    for (uint64_t i = 0; i < nElements; i++) {
-        src = (void *)((uint64_t)base + ((firstElement * elementSize) +
-                                         elementSize * stride * i));
-        dest = (void *)((uint64_t)local + (i * elementSize));
-        openfam_invalidate(src, elementSize);
-        memcpy(dest, src, elementSize);
-    }
+    fam_range_op_strided(openfam_invalidate, src, nElements, stride,
+                         elementSize);
+    fam_gather_strided(local, src, nElements, stride, elementSize);
 
     // Release Fam_Context read lock
     famCtx->release_lock();
@@ -229,9 +231,6 @@ int Fam_Ops_NVMM::gather_blocking(void *local, Fam_Descriptor *descriptor,
     uint64_t size = descriptor->get_size();
     uint64_t key = descriptor->get_key();
 
-    void *src;
-    void *dest;
-
     uint64_t maxOffset = elementIndex[0];
     for (uint64_t i = 0; i < nElements; i++) {
         if (maxOffset < elementIndex[i])
@@ -253,12 +252,9 @@ int Fam_Ops_NVMM::gather_blocking(void *local, Fam_Descriptor *descriptor,
     // Take Fam_Context read lock
     famCtx->aquire_RDLock();
 
-    for (uint64_t i = 0; i < nElements; i++) {
-        src = (void *)((uint64_t)base + (elementIndex[i] * elementSize));
-        dest = (void *)((uint64_t)local + (i * elementSize));
-        openfam_invalidate(src, elementSize);
-        memcpy(dest, src, elementSize);
-    }
+    fam_range_op_indexed(openfam_invalidate, base, nElements, elementIndex,
+                         elementSize);
+    fam_gather_indexed(local, base, nElements, elementIndex, elementSize);
 
     // Release Fam_Context read lock
     famCtx->release_lock();
@@ -273,9 +269,6 @@ int Fam_Ops_NVMM::scatter_blocking(void *local, Fam_Descriptor *descriptor,
     uint64_t size = descriptor->get_size();
     uint64_t key = descriptor->get_key();
 
-    void *src;
-    void *dest;
-
     if (((firstElement * elementSize) > size) ||
         ((firstElement * elementSize) + elementSize * stride * nElements) >
             size) {
@@ -290,16 +283,14 @@ int Fam_Ops_NVMM::scatter_blocking(void *local, Fam_Descriptor *descriptor,
 
     Fam_Context *famCtx = get_context(descriptor);
 
+    void *dest = (void *)((uint64_t)base + (firstElement * elementSize));
+
     // Take Fam_Context read lock
     famCtx->aquire_RDLock();
 
-    for (uint64_t i = 0; i < nElements; i++) {
-        src = (void *)((uint64_t)local + (i * elementSize));
-        dest = (void *)((uint64_t)base + ((firstElement * elementSize) +
-                                          elementSize * stride * i));
-        memcpy(dest, src, elementSize);
-        openfam_persist(dest, elementSize);
-    }
+    fam_scatter_strided(local, dest, nElements, stride, elementSize);
+    fam_range_op_strided(openfam_persist, dest, nElements, stride,
+                         elementSize);
 
     // Release Fam_Context read lock
     famCtx->release_lock();
@@ -314,9 +305,6 @@ int Fam_Ops_NVMM::scatter_blocking(void *local, Fam_Descriptor *descriptor,
     uint64_t size = descriptor->get_size();
     uint64_t key = descriptor->get_key();
 
-    void *src;
-    void *dest;
-
     uint64_t maxOffset = elementIndex[0];
     for (uint64_t i = 0; i < nElements; i++) {
         if (maxOffset < elementIndex[i])
@@ -338,12 +326,9 @@ int Fam_Ops_NVMM::scatter_blocking(void *local, Fam_Descriptor *descriptor,
     // Take Fam_Context read lock
     famCtx->aquire_RDLock();
 
-    for (uint64_t i = 0; i < nElements; i++) {
-        src = (void *)((uint64_t)local + (i * elementSize));
-        dest = (void *)((uint64_t)base + elementIndex[i] * elementSize);
-        memcpy(dest, src, elementSize);
-        openfam_persist(dest, elementSize);
-    }
+    fam_scatter_indexed(local, base, nElements, elementIndex, elementSize);
+    fam_range_op_indexed(openfam_persist, base, nElements, elementIndex,
+                         elementSize);
 
     // Release Fam_Context read lock
     famCtx->release_lock();
@@ -365,7 +350,8 @@ void Fam_Ops_NVMM::put_nonblocking(void *local, Fam_Descriptor *descriptor,
 
     void *dest = (void *)((uint64_t)base + offset);
     Fam_Ops_Info opsInfo = {WRITE,      local, dest,     nbytes, offset,
-                            upperBound, key,   itemSize, NULL};
+                            upperBound, key,   itemSize, NULL,   famCtx,
+                            0};
     asyncQHandler->initiate_operation(opsInfo);
     famCtx->inc_num_tx_ops();
 
@@ -390,7 +376,8 @@ void Fam_Ops_NVMM::get_nonblocking(void *local, Fam_Descriptor *descriptor,
     void *src = (void *)((uint64_t)base + offset);
 
     Fam_Ops_Info opsInfo = {READ,       src, local,    nbytes, offset,
-                            upperBound, key, itemSize, NULL};
+                            upperBound, key, itemSize, NULL,   famCtx,
+                            0};
     asyncQHandler->initiate_operation(opsInfo);
     famCtx->inc_num_rx_ops();
 
@@ -422,7 +409,8 @@ void Fam_Ops_NVMM::gather_nonblocking(void *local, Fam_Descriptor *descriptor,
                                          elementSize * stride * i));
         dest = (void *)((uint64_t)local + (i * elementSize));
         Fam_Ops_Info opsInfo = {READ,       src, dest,     elementSize, offset,
-                                upperBound, key, itemSize, NULL};
+                                upperBound, key, itemSize, NULL,        famCtx,
+                                0};
         asyncQHandler->initiate_operation(opsInfo);
         famCtx->inc_num_rx_ops();
     }
@@ -456,7 +444,8 @@ void Fam_Ops_NVMM::gather_nonblocking(void *local, Fam_Descriptor *descriptor,
         upperBound = elementIndex[i] + elementSize;
         Fam_Ops_Info opsInfo = {
             READ,       src, dest,     elementSize, elementIndex[i],
-            upperBound, key, itemSize, NULL};
+            upperBound, key, itemSize, NULL,        famCtx,
+            0};
         asyncQHandler->initiate_operation(opsInfo);
         famCtx->inc_num_rx_ops();
     }
@@ -490,7 +479,8 @@ void Fam_Ops_NVMM::scatter_nonblocking(void *local, Fam_Descriptor *descriptor,
         dest = (void *)((uint64_t)base + ((firstElement * elementSize) +
                                           elementSize * stride * i));
         Fam_Ops_Info opsInfo = {WRITE,      src, dest,     elementSize, offset,
-                                upperBound, key, itemSize, NULL};
+                                upperBound, key, itemSize, NULL,        famCtx,
+                                0};
         asyncQHandler->initiate_operation(opsInfo);
         famCtx->inc_num_tx_ops();
     }
@@ -522,7 +512,8 @@ void Fam_Ops_NVMM::scatter_nonblocking(void *local, Fam_Descriptor *descriptor,
         upperBound = elementIndex[i] + elementSize;
         Fam_Ops_Info opsInfo = {
             WRITE,      src, dest,     elementSize, elementIndex[i],
-            upperBound, key, itemSize, NULL};
+            upperBound, key, itemSize, NULL,        famCtx,
+            0};
         asyncQHandler->initiate_operation(opsInfo);
         famCtx->inc_num_tx_ops();
     }
@@ -588,11 +579,8 @@ void Fam_Ops_NVMM::abort(int status) FAM_OPS_UNIMPLEMENTED(void_);
 void *Fam_Ops_NVMM::copy(Fam_Descriptor *src, uint64_t srcOffset,
                          Fam_Descriptor **dest, uint64_t destOffset,
                          uint64_t nbytes) {
-    void *baseSrc = src->get_base_address();
     Fam_Region_Item_Info itemInfo =
         famAllocator->check_permission_get_info(src);
-    Fam_Global_Descriptor gDesc = src->get_global_descriptor();
-    Fam_Region_Descriptor *region = new Fam_Region_Descriptor(gDesc);
 
     if ((srcOffset > itemInfo.size) || ((srcOffset + nbytes) > itemInfo.size)) {
         throw Fam_Allocator_Exception(
@@ -607,16 +595,61 @@ void *Fam_Ops_NVMM::copy(Fam_Descriptor *src, uint64_t srcOffset,
             "Destination offset or size is beyond dataitem boundary");
     }
 
-    *dest = famAllocator->allocate("", itemInfo.size, itemInfo.perm, region);
+    Fam_Region_Descriptor region(src->get_global_descriptor());
+    *dest = famAllocator->allocate("", itemInfo.size, itemInfo.perm, &region);
+
+    return copy(src, srcOffset, *dest, destOffset, nbytes);
+}
+
+void *Fam_Ops_NVMM::copy(Fam_Descriptor *src, uint64_t srcOffset,
+                         Fam_Descriptor *dest, uint64_t destOffset,
+                         uint64_t nbytes) {
+    void *baseSrc = src->get_base_address();
+    void *baseDest = dest->get_base_address();
+    uint64_t destSize = dest->get_size();
+
+    if ((srcOffset > src->get_size()) ||
+        ((srcOffset + nbytes) > src->get_size())) {
+        throw Fam_Allocator_Exception(
+            FAM_ERR_OUTOFRANGE,
+            "Source offset or size is beyond dataitem boundary");
+    }
+
+    if ((destOffset > destSize) || ((destOffset + nbytes) > destSize)) {
+        throw Fam_Allocator_Exception(
+            FAM_ERR_OUTOFRANGE,
+            "Destination offset or size is beyond dataitem boundary");
+    }
+
+    if ((src->get_key() & FAM_READ_KEY_SHM) != FAM_READ_KEY_SHM) {
+        throw Fam_Allocator_Exception(FAM_ERR_NOPERM,
+                                      "not permitted to read from source");
+    }
+
+    if ((dest->get_key() & FAM_WRITE_KEY_SHM) != FAM_WRITE_KEY_SHM) {
+        throw Fam_Allocator_Exception(
+            FAM_ERR_NOPERM, "not permitted to write into destination");
+    }
 
-    void *baseDest = (*dest)->get_base_address();
+    void *srcStart = (void *)((uint64_t)baseSrc + srcOffset);
+    void *destStart = (void *)((uint64_t)baseDest + destOffset);
     Copy_Tag *tag = new Copy_Tag();
     tag->copyDone.store(false, boost::memory_order_seq_cst);
+    tag->copied.store(0, boost::memory_order_seq_cst);
 
-    Fam_Ops_Info opsInfo = {COPY, baseSrc, baseDest,      nbytes, 0,
-                            0,    0,       itemInfo.size, tag};
+    Fam_Context *famCtx = get_context(src);
+
+    // Take Fam_Context read lock
+    famCtx->aquire_RDLock();
+
+    Fam_Ops_Info opsInfo = {COPY, srcStart, destStart, nbytes, 0,
+                            0,    0,        destSize,  tag,    famCtx,
+                            0};
     asyncQHandler->initiate_operation(opsInfo);
 
+    // Release Fam_Context read lock
+    famCtx->release_lock();
+
     return (void *)tag;
 }
 
@@ -624,8 +657,59 @@ void Fam_Ops_NVMM::wait_for_copy(void *waitObj) {
     asyncQHandler->wait_for_copy(waitObj);
 }
 
-void Fam_Ops_NVMM::fence(Fam_Region_Descriptor *descriptor)
-    FAM_OPS_UNIMPLEMENTED(void_);
+uint64_t Fam_Ops_NVMM::copy_progress(void *waitObj) {
+    Copy_Tag *tag = static_cast<Copy_Tag *>(waitObj);
+    return tag->copied.load(boost::memory_order_seq_cst);
+}
+
+void Fam_Ops_NVMM::fence_context(Fam_Context *famCtx) {
+
+    // Take Fam_Context write lock, so that no operation is half issued
+    famCtx->aquire_WRLock();
+
+    asyncQHandler->fence(famCtx);
+
+    // Release Fam_Context write lock
+    famCtx->release_lock();
+
+    return;
+}
+
+/*
+ * fence does not wait for outstanding operations. It only makes the
+ * operations issued after it, in the same context, wait for those issued
+ * before it.
+ */
+void Fam_Ops_NVMM::fence(Fam_Region_Descriptor *descriptor) {
+
+    if (famContextModel == FAM_CONTEXT_DEFAULT) {
+        fence_context(get_defaultCtx());
+        return;
+    } else if (famContextModel == FAM_CONTEXT_REGION) {
+        // ctx mutex lock
+        (void)pthread_mutex_lock(&ctxLock);
+        if (descriptor) {
+            Fam_Context *ctx = (Fam_Context *)descriptor->get_context();
+            if (ctx) {
+                fence_context(ctx);
+            } else {
+                Fam_Global_Descriptor global =
+                    descriptor->get_global_descriptor();
+                uint64_t regionId = global.regionId;
+                auto ctxObj = contexts->find(regionId);
+                if (ctxObj != contexts->end()) {
+                    descriptor->set_context(ctxObj->second);
+                    fence_context(ctxObj->second);
+                }
+            }
+        } else {
+            for (auto fam_ctx : *contexts)
+                fence_context(fam_ctx.second);
+        }
+        // ctx mutex unlock
+        (void)pthread_mutex_unlock(&ctxLock);
+    }
+}
 
 /*
  * Atomic group, libfam_atomic needs the region to be registerd.
@@ -655,7 +739,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
 
-    fam_atomic_32_write((int32_t *)((char *)base + offset), value);
+    openfam_atomic_32_write(famAtomicModel, (int32_t *)((char *)base + offset),
+                            value);
 }
 
 void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
@@ -674,7 +759,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
 
-    fam_atomic_64_write((int64_t *)((char *)base + offset), value);
+    openfam_atomic_64_write(famAtomicModel, (int64_t *)((char *)base + offset),
+                            value);
 }
 
 void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
@@ -695,7 +781,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
 
     int128store oldValueStore;
     oldValueStore.i128 = value;
-    fam_atomic_128_write((int64_t *)((char *)base + offset), oldValueStore.i64);
+    openfam_atomic_128_write(famAtomicModel, (int64_t *)((char *)base + offset),
+                             oldValueStore.i64);
 }
 
 void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
@@ -714,7 +801,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
 
-    fam_atomic_32_write((int32_t *)((char *)base + offset), value);
+    openfam_atomic_32_write(famAtomicModel, (int32_t *)((char *)base + offset),
+                            value);
 }
 
 void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
@@ -733,7 +821,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
 
-    fam_atomic_64_write((int64_t *)((char *)base + offset), value);
+    openfam_atomic_64_write(famAtomicModel, (int64_t *)((char *)base + offset),
+                            value);
 }
 
 void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
@@ -752,7 +841,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     int32_t *buff = reinterpret_cast<int32_t *>(&value);
-    fam_atomic_32_write((int32_t *)((char *)base + offset), *buff);
+    openfam_atomic_32_write(famAtomicModel, (int32_t *)((char *)base + offset),
+                            *buff);
 }
 
 void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
@@ -771,7 +861,8 @@ void Fam_Ops_NVMM::atomic_set(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     int64_t *buff = reinterpret_cast<int64_t *>(&value);
-    fam_atomic_64_write((int64_t *)((char *)base + offset), *buff);
+    openfam_atomic_64_write(famAtomicModel, (int64_t *)((char *)base + offset),
+                            *buff);
 }
 
 void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
@@ -790,7 +881,8 @@ void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
         throw Fam_Datapath_Exception(FAM_ERR_NOPERM,
                                      "not permitted to write into dataitem");
     }
-    fam_atomic_32_fetch_add((int32_t *)((char *)base + offset), value);
+    openfam_atomic_32_fetch_add(famAtomicModel,
+                                (int32_t *)((char *)base + offset), value);
 }
 
 void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
@@ -809,7 +901,8 @@ void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
         throw Fam_Datapath_Exception(FAM_ERR_NOPERM,
                                      "not permitted to write into dataitem");
     }
-    fam_atomic_64_fetch_add((int64_t *)((char *)base + offset), value);
+    openfam_atomic_64_fetch_add(famAtomicModel,
+                                (int64_t *)((char *)base + offset), value);
 }
 
 void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
@@ -828,7 +921,8 @@ void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
         throw Fam_Datapath_Exception(FAM_ERR_NOPERM,
                                      "not permitted to write into dataitem");
     }
-    fam_atomic_32_fetch_add((int32_t *)((char *)base + offset), value);
+    openfam_atomic_32_fetch_add(famAtomicModel,
+                                (int32_t *)((char *)base + offset), value);
 }
 
 void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
@@ -847,7 +941,8 @@ void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
         throw Fam_Datapath_Exception(FAM_ERR_NOPERM,
                                      "not permitted to write into dataitem");
     }
-    fam_atomic_64_fetch_add((int64_t *)((char *)base + offset), value);
+    openfam_atomic_64_fetch_add(famAtomicModel,
+                                (int64_t *)((char *)base + offset), value);
 }
 
 void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
@@ -867,8 +962,8 @@ void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_SUM][FLOAT](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_SUM][FLOAT]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
@@ -888,8 +983,8 @@ void Fam_Ops_NVMM::atomic_add(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_SUM][DOUBLE](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_SUM][DOUBLE]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_subtract(Fam_Descriptor *descriptor, uint64_t offset,
@@ -934,8 +1029,8 @@ void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][INT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][INT32]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
@@ -954,8 +1049,8 @@ void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][INT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][INT64]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
@@ -975,8 +1070,8 @@ void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][UINT32]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
@@ -995,8 +1090,8 @@ void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][UINT64]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1015,8 +1110,8 @@ void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][FLOAT](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][FLOAT]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1036,8 +1131,8 @@ void Fam_Ops_NVMM::atomic_min(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][DOUBLE](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][DOUBLE]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1057,8 +1152,8 @@ void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][INT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][INT32]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1077,8 +1172,8 @@ void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][INT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][INT64]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1098,8 +1193,8 @@ void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][UINT32]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1118,8 +1213,8 @@ void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][UINT64]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1138,8 +1233,8 @@ void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][FLOAT](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][FLOAT]((void *)((char *)base + offset),
+                                   (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1159,8 +1254,8 @@ void Fam_Ops_NVMM::atomic_max(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][DOUBLE](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][DOUBLE]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_and(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1180,8 +1275,8 @@ void Fam_Ops_NVMM::atomic_and(Fam_Descriptor *descriptor, uint64_t offset,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BAND][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BAND][UINT32]((void *)((char *)base + offset),
+                                     (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_and(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1200,8 +1295,8 @@ void Fam_Ops_NVMM::atomic_and(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BAND][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BAND][UINT64]((void *)((char *)base + offset),
+                                     (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_or(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1220,8 +1315,8 @@ void Fam_Ops_NVMM::atomic_or(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BOR][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BOR][UINT32]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_or(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1240,8 +1335,8 @@ void Fam_Ops_NVMM::atomic_or(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BOR][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BOR][UINT64]((void *)((char *)base + offset),
+                                    (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_xor(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1260,8 +1355,8 @@ void Fam_Ops_NVMM::atomic_xor(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BXOR][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BXOR][UINT32]((void *)((char *)base + offset),
+                                     (void *)&value, result);
 }
 
 void Fam_Ops_NVMM::atomic_xor(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1280,8 +1375,8 @@ void Fam_Ops_NVMM::atomic_xor(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BXOR][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BXOR][UINT64]((void *)((char *)base + offset),
+                                     (void *)&value, result);
 }
 
 int32_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1301,8 +1396,9 @@ int32_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to write into dataitem");
     }
 
-    return fam_atomic_32_compare_store((int32_t *)((char *)base + offset),
-                                       oldValue, newValue);
+    return openfam_atomic_32_compare_store(famAtomicModel,
+                                           (int32_t *)((char *)base + offset),
+                                           oldValue, newValue);
 }
 
 int64_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1323,8 +1419,9 @@ int64_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "need both read and write permission");
     }
 
-    return fam_atomic_64_compare_store((int64_t *)((char *)base + offset),
-                                       oldValue, newValue);
+    return openfam_atomic_64_compare_store(famAtomicModel,
+                                           (int64_t *)((char *)base + offset),
+                                           oldValue, newValue);
 }
 
 int128_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1349,9 +1446,10 @@ int128_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
     int128store ResultValueStore;
     oldValueStore.i128 = oldValue;
     newValueStore.i128 = newValue;
-    fam_atomic_128_compare_store((int64_t *)((char *)base + offset),
-                                 oldValueStore.i64, newValueStore.i64,
-                                 ResultValueStore.i64);
+    openfam_atomic_128_compare_store(famAtomicModel,
+                                     (int64_t *)((char *)base + offset),
+                                     oldValueStore.i64, newValueStore.i64,
+                                     ResultValueStore.i64);
     return ResultValueStore.i128;
 }
 
@@ -1372,8 +1470,9 @@ uint32_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "need both read and write permission");
     }
 
-    return fam_atomic_32_compare_store((int32_t *)((char *)base + offset),
-                                       oldValue, newValue);
+    return openfam_atomic_32_compare_store(famAtomicModel,
+                                           (int32_t *)((char *)base + offset),
+                                           oldValue, newValue);
 }
 
 uint64_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1393,8 +1492,9 @@ uint64_t Fam_Ops_NVMM::compare_swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "need both read and write permission");
     }
 
-    return fam_atomic_64_compare_store((int64_t *)((char *)base + offset),
-                                       oldValue, newValue);
+    return openfam_atomic_64_compare_store(famAtomicModel,
+                                           (int64_t *)((char *)base + offset),
+                                           oldValue, newValue);
 }
 
 int32_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1413,7 +1513,8 @@ int32_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_32_swap((int32_t *)((char *)base + offset), value);
+    return openfam_atomic_32_swap(famAtomicModel,
+                                  (int32_t *)((char *)base + offset), value);
 }
 
 int64_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1432,7 +1533,8 @@ int64_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_64_swap((int64_t *)((char *)base + offset), value);
+    return openfam_atomic_64_swap(famAtomicModel,
+                                  (int64_t *)((char *)base + offset), value);
 }
 
 uint32_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1451,7 +1553,8 @@ uint32_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_32_swap((int32_t *)((char *)base + offset), value);
+    return openfam_atomic_32_swap(famAtomicModel,
+                                  (int32_t *)((char *)base + offset), value);
 }
 
 uint64_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1470,7 +1573,8 @@ uint64_t Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_64_swap((int64_t *)((char *)base + offset), value);
+    return openfam_atomic_64_swap(famAtomicModel,
+                                  (int64_t *)((char *)base + offset), value);
 }
 
 float Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
@@ -1491,7 +1595,8 @@ float Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
     }
     int32_t *buff = reinterpret_cast<int32_t *>(&value);
     int32_t result =
-        fam_atomic_32_swap((int32_t *)((char *)base + offset), *buff);
+        openfam_atomic_32_swap(famAtomicModel,
+                               (int32_t *)((char *)base + offset), *buff);
     float *floatResult = reinterpret_cast<float *>(&result);
     return *floatResult;
 }
@@ -1514,7 +1619,8 @@ double Fam_Ops_NVMM::swap(Fam_Descriptor *descriptor, uint64_t offset,
     }
     int64_t *buff = reinterpret_cast<int64_t *>(&value);
     int64_t result =
-        fam_atomic_64_swap((int64_t *)((char *)base + offset), *buff);
+        openfam_atomic_64_swap(famAtomicModel,
+                               (int64_t *)((char *)base + offset), *buff);
     double *doubleResult = reinterpret_cast<double *>(&result);
     return *doubleResult;
 }
@@ -1535,7 +1641,8 @@ int32_t Fam_Ops_NVMM::atomic_fetch_int32(Fam_Descriptor *descriptor,
                                      "not permitted to write into dataitem");
     }
 
-    return fam_atomic_32_read((int32_t *)((char *)base + offset));
+    return openfam_atomic_32_read(famAtomicModel,
+                                  (int32_t *)((char *)base + offset));
 }
 
 int64_t Fam_Ops_NVMM::atomic_fetch_int64(Fam_Descriptor *descriptor,
@@ -1554,7 +1661,8 @@ int64_t Fam_Ops_NVMM::atomic_fetch_int64(Fam_Descriptor *descriptor,
                                      "not permitted to write into dataitem");
     }
 
-    return fam_atomic_64_read((int64_t *)((char *)base + offset));
+    return openfam_atomic_64_read(famAtomicModel,
+                                  (int64_t *)((char *)base + offset));
 }
 
 int128_t Fam_Ops_NVMM::atomic_fetch_int128(Fam_Descriptor *descriptor,
@@ -1575,8 +1683,8 @@ int128_t Fam_Ops_NVMM::atomic_fetch_int128(Fam_Descriptor *descriptor,
 
     int128store ResultValueStore;
 
-    fam_atomic_128_read((int64_t *)((char *)base + offset),
-                        ResultValueStore.i64);
+    openfam_atomic_128_read(famAtomicModel, (int64_t *)((char *)base + offset),
+                            ResultValueStore.i64);
     return ResultValueStore.i128;
 }
 
@@ -1596,7 +1704,8 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_uint32(Fam_Descriptor *descriptor,
                                      "not permitted to write into dataitem");
     }
 
-    return fam_atomic_32_read((int32_t *)((char *)base + offset));
+    return openfam_atomic_32_read(famAtomicModel,
+                                  (int32_t *)((char *)base + offset));
 }
 
 uint64_t Fam_Ops_NVMM::atomic_fetch_uint64(Fam_Descriptor *descriptor,
@@ -1615,7 +1724,8 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_uint64(Fam_Descriptor *descriptor,
                                      "not permitted to write into dataitem");
     }
 
-    return fam_atomic_64_read((int64_t *)((char *)base + offset));
+    return openfam_atomic_64_read(famAtomicModel,
+                                  (int64_t *)((char *)base + offset));
 }
 
 float Fam_Ops_NVMM::atomic_fetch_float(Fam_Descriptor *descriptor,
@@ -1633,7 +1743,8 @@ float Fam_Ops_NVMM::atomic_fetch_float(Fam_Descriptor *descriptor,
         throw Fam_Datapath_Exception(FAM_ERR_NOPERM,
                                      "not permitted to write into dataitem");
     }
-    int32_t buff = fam_atomic_32_read((int32_t *)((char *)base + offset));
+    int32_t buff = openfam_atomic_32_read(famAtomicModel,
+                                          (int32_t *)((char *)base + offset));
     float *result = reinterpret_cast<float *>(&buff);
     return *result;
 }
@@ -1653,7 +1764,8 @@ double Fam_Ops_NVMM::atomic_fetch_double(Fam_Descriptor *descriptor,
         throw Fam_Datapath_Exception(FAM_ERR_NOPERM,
                                      "not permitted to write into dataitem");
     }
-    int64_t buff = fam_atomic_64_read((int64_t *)((char *)base + offset));
+    int64_t buff = openfam_atomic_64_read(famAtomicModel,
+                                          (int64_t *)((char *)base + offset));
     double *result = reinterpret_cast<double *>(&buff);
     return *result;
 }
@@ -1675,7 +1787,9 @@ int32_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_32_fetch_add((int32_t *)((char *)base + offset), value);
+    return openfam_atomic_32_fetch_add(famAtomicModel,
+                                       (int32_t *)((char *)base + offset),
+                                       value);
 }
 
 int64_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
@@ -1695,7 +1809,9 @@ int64_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_64_fetch_add((int64_t *)((char *)base + offset), value);
+    return openfam_atomic_64_fetch_add(famAtomicModel,
+                                       (int64_t *)((char *)base + offset),
+                                       value);
 }
 
 uint32_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
@@ -1715,7 +1831,9 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_32_fetch_add((int32_t *)((char *)base + offset), value);
+    return openfam_atomic_32_fetch_add(famAtomicModel,
+                                       (int32_t *)((char *)base + offset),
+                                       value);
 }
 
 uint64_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
@@ -1735,7 +1853,9 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
                                      "not permitted to either read or write, "
                                      "need both read and write permission");
     }
-    return fam_atomic_64_fetch_add((int64_t *)((char *)base + offset), value);
+    return openfam_atomic_64_fetch_add(famAtomicModel,
+                                       (int64_t *)((char *)base + offset),
+                                       value);
 }
 
 float Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
@@ -1756,8 +1876,8 @@ float Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_SUM][FLOAT](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_SUM][FLOAT]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     float *oldValue = (float *)result;
     return *oldValue;
 }
@@ -1780,8 +1900,8 @@ double Fam_Ops_NVMM::atomic_fetch_add(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_SUM][DOUBLE](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_SUM][DOUBLE]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     double *oldValue = (double *)result;
     return *oldValue;
 }
@@ -1834,8 +1954,8 @@ int32_t Fam_Ops_NVMM::atomic_fetch_min(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][INT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][INT32]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     int32_t *oldValue = (int32_t *)result;
     return *oldValue;
 }
@@ -1857,8 +1977,8 @@ int64_t Fam_Ops_NVMM::atomic_fetch_min(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][INT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][INT64]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     int64_t *oldValue = (int64_t *)result;
     return *oldValue;
 }
@@ -1881,8 +2001,8 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_min(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][UINT32]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     uint32_t *oldValue = (uint32_t *)result;
     return *oldValue;
 }
@@ -1904,8 +2024,8 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_min(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][UINT64]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     uint64_t *oldValue = (uint64_t *)result;
     return *oldValue;
 }
@@ -1927,8 +2047,8 @@ float Fam_Ops_NVMM::atomic_fetch_min(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][FLOAT](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][FLOAT]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     float *oldValue = (float *)result;
     return *oldValue;
 }
@@ -1951,8 +2071,8 @@ double Fam_Ops_NVMM::atomic_fetch_min(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MIN][DOUBLE](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MIN][DOUBLE]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     double *oldValue = (double *)result;
     return *oldValue;
 }
@@ -1975,8 +2095,8 @@ int32_t Fam_Ops_NVMM::atomic_fetch_max(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][INT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][INT32]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     int32_t *oldValue = (int32_t *)result;
     return *oldValue;
 }
@@ -1998,8 +2118,8 @@ int64_t Fam_Ops_NVMM::atomic_fetch_max(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][INT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][INT64]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     int64_t *oldValue = (int64_t *)result;
     return *oldValue;
 }
@@ -2022,8 +2142,8 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_max(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][UINT32]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     uint32_t *oldValue = (uint32_t *)result;
     return *oldValue;
 }
@@ -2045,8 +2165,8 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_max(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][UINT64]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     uint64_t *oldValue = (uint64_t *)result;
     return *oldValue;
 }
@@ -2068,8 +2188,8 @@ float Fam_Ops_NVMM::atomic_fetch_max(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][FLOAT](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][FLOAT]((void *)((char *)base + offset),
+                                   (void *)&value, result);
     float *oldValue = (float *)result;
     return *oldValue;
 }
@@ -2092,8 +2212,8 @@ double Fam_Ops_NVMM::atomic_fetch_max(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_MAX][DOUBLE](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_MAX][DOUBLE]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     double *oldValue = (double *)result;
     return *oldValue;
 }
@@ -2116,8 +2236,8 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_and(Fam_Descriptor *descriptor,
     }
 
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BAND][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BAND][UINT32]((void *)((char *)base + offset),
+                                     (void *)&value, result);
     uint32_t *oldValue = (uint32_t *)result;
     return *oldValue;
 }
@@ -2139,8 +2259,8 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_and(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BAND][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BAND][UINT64]((void *)((char *)base + offset),
+                                     (void *)&value, result);
     uint64_t *oldValue = (uint64_t *)result;
     return *oldValue;
 }
@@ -2162,8 +2282,8 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_or(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BOR][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BOR][UINT32]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     uint32_t *oldValue = (uint32_t *)result;
     return *oldValue;
 }
@@ -2185,8 +2305,8 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_or(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BOR][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BOR][UINT64]((void *)((char *)base + offset),
+                                    (void *)&value, result);
     uint64_t *oldValue = (uint64_t *)result;
     return *oldValue;
 }
@@ -2208,8 +2328,8 @@ uint32_t Fam_Ops_NVMM::atomic_fetch_xor(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BXOR][UINT32](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BXOR][UINT32]((void *)((char *)base + offset),
+                                     (void *)&value, result);
     uint32_t *oldValue = (uint32_t *)result;
     return *oldValue;
 }
@@ -2231,8 +2351,8 @@ uint64_t Fam_Ops_NVMM::atomic_fetch_xor(Fam_Descriptor *descriptor,
                                      "need both read and write permission");
     }
     void *result;
-    fam_atomic_readwrite_handlers[FAM_BXOR][UINT64](
-        (void *)((char *)base + offset), (void *)&value, result);
+    atomicHandlers[FAM_BXOR][UINT64]((void *)((char *)base + offset),
+                                     (void *)&value, result);
     uint64_t *oldValue = (uint64_t *)result;
     return *oldValue;
 }
@@ -54,6 +54,14 @@ int main(int argc, char *argv[]) {
     char *name = strdup("127.0.0.1");
     char *libfabricPort = strdup("7500");
     char *provider = strdup("sockets");
+    uint64_t numCqThreads = FAM_RPC_DEFAULT_CQ_THREADS;
+    uint64_t numBulkThreads = FAM_RPC_DEFAULT_BULK_THREADS;
+    uint64_t numCopyThreads = MEMSERVER_DEFAULT_COPY_THREADS;
+    bool regionMr = false;
+    uint64_t maxMrs = 0;
+    uint64_t slabMaxObjSize = 0;
+    uint64_t numWarmHeaps = 0;
+    uint64_t capacity = 0;
 
     for (int i = 1; i < argc; i++) {
         if ((std::string(argv[i]) == "-h") ||
@@ -73,6 +81,34 @@ int main(int argc, char *argv[]) {
                  << "\t-p/--provider       : Libfabric provider (default value "
                     "is \"sockets\") \n"
                  << "\n"
+                 << "\t-t/--rpcthreads     : Number of RPC completion queue "
+                    "threads (default value is 4) \n"
+                 << "\n"
+                 << "\t-b/--bulkthreads    : Number of threads for copy and "
+                    "region create/destroy/resize (default value is 2) \n"
+                 << "\n"
+                 << "\t-c/--copythreads    : Number of threads sharing the "
+                    "data movement of copies (default value is 4) \n"
+                 << "\n"
+                 << "\t-R/--regionmr       : Register each region once instead "
+                    "of every data item \n"
+                 << "\n"
+                 << "\t-M/--maxmrs         : Number of data item registrations "
+                    "above which the least recently used are dropped (default "
+                    "value is 0, no limit) \n"
+                 << "\n"
+                 << "\t-s/--slabmax        : Largest data item size, in bytes, "
+                    "allocated from per-region slabs (default value is 0, "
+                    "no slabs) \n"
+                 << "\n"
+                 << "\t-w/--warmheaps      : Number of heaps created ahead "
+                    "for each common region size; regions are then also "
+                    "destroyed in the background (default value is 0) \n"
+                 << "\n"
+                 << "\t-C/--capacity       : Bytes of memory offered to "
+                    "regions, reported to clients placing regions by free "
+                    "space (default value is 0, not limited) \n"
+                 << "\n"
                  << endl;
             exit(0);
         } else if ((std::string(argv[i]) == "-m") ||
@@ -87,6 +123,30 @@ int main(int argc, char *argv[]) {
         } else if ((std::string(argv[i]) == "-p") ||
                    (std::string(argv[i]) == "--provider")) {
             provider = strdup(argv[++i]);
+        } else if ((std::string(argv[i]) == "-t") ||
+                   (std::string(argv[i]) == "--rpcthreads")) {
+            numCqThreads = atoi(argv[++i]);
+        } else if ((std::string(argv[i]) == "-b") ||
+                   (std::string(argv[i]) == "--bulkthreads")) {
+            numBulkThreads = atoi(argv[++i]);
+        } else if ((std::string(argv[i]) == "-c") ||
+                   (std::string(argv[i]) == "--copythreads")) {
+            numCopyThreads = atoi(argv[++i]);
+        } else if ((std::string(argv[i]) == "-R") ||
+                   (std::string(argv[i]) == "--regionmr")) {
+            regionMr = true;
+        } else if ((std::string(argv[i]) == "-M") ||
+                   (std::string(argv[i]) == "--maxmrs")) {
+            maxMrs = atoi(argv[++i]);
+        } else if ((std::string(argv[i]) == "-s") ||
+                   (std::string(argv[i]) == "--slabmax")) {
+            slabMaxObjSize = strtoull(argv[++i], NULL, 10);
+        } else if ((std::string(argv[i]) == "-w") ||
+                   (std::string(argv[i]) == "--warmheaps")) {
+            numWarmHeaps = atoi(argv[++i]);
+        } else if ((std::string(argv[i]) == "-C") ||
+                   (std::string(argv[i]) == "--capacity")) {
+            capacity = strtoull(argv[++i], NULL, 10);
         }
     }
 
@@ -98,7 +158,11 @@ int main(int argc, char *argv[]) {
 
     Fam_Rpc_Server *rpcService = NULL;
     try {
-        rpcService = new Fam_Rpc_Server(rpcPort, name, libfabricPort, provider);
+        rpcService = new Fam_Rpc_Server(rpcPort, name, libfabricPort, provider,
+                                        numCqThreads, numBulkThreads,
+                                        numCopyThreads, regionMr, maxMrs,
+                                        slabMaxObjSize, numWarmHeaps,
+                                        capacity);
         rpcService->run();
     } catch (Memserver_Exception &e) {
         if (rpcService) {
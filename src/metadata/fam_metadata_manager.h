@@ -101,6 +101,29 @@ typedef struct {
     //   Fam_Redundancy_Level redundancyLevel;
     GlobalPtr dataItemIdRoot;
     GlobalPtr dataItemNameRoot;
+    /*
+     * Offset of the slab root block in the region heap, 0 if none
+     */
+    uint64_t slabRoot;
+    /*
+     * Member regions of a striped or mirrored region: stripe size, number of
+     * members, position of this one and redundancy level; 0, 1, 0 and NONE
+     * for a region on one memory server
+     */
+    uint64_t stripeSize;
+    uint32_t stripeCount;
+    uint32_t stripeIndex;
+    uint32_t redundancyLevel;
+    /*
+     * Size the region is grown up to in the background as it fills up, 0
+     * if it is not grown
+     */
+    uint64_t growLimit;
+    /*
+     * Size the region was created with, which its heap maps as one range;
+     * a resize maps the bytes it adds elsewhere. 0 if not known
+     */
+    uint64_t baseSize;
 } Fam_Region_Metadata;
 
 /**
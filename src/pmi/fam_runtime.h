@@ -44,6 +44,8 @@ class Fam_Runtime {
     virtual int num_pes(void) = 0;
     virtual int runtime_abort(int exitCode, const char msg[]) = 0;
     virtual int runtime_barrier_all() = 0;
+    // Collective: copy nbytes at buf on rootPe to buf on every other PE
+    virtual int runtime_broadcast(void *buf, size_t nbytes, int rootPe) = 0;
     virtual ~Fam_Runtime() {}
 };
 #endif
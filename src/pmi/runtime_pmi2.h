@@ -42,6 +42,7 @@ class Pmi2_Runtime : public Fam_Runtime {
     int mInitrc;
     int mRank = -1;
     int mNumPEs = 0;
+    uint64_t mNumBcasts = 0;
 
   public:
     /*
@@ -121,6 +122,56 @@ class Pmi2_Runtime : public Fam_Runtime {
         return rc;
     }
 
+    /*
+     * Copies nbytes at buf on rootPe to buf on every other PE. All PEs have
+     * to call it with the same nbytes and rootPe. PMI2 values are strings of
+     * limited length, so the data is hex encoded and spread over several
+     * keys, which are used by this broadcast only.
+     **/
+    int runtime_broadcast(void *buf, size_t nbytes, int rootPe) {
+        char key[PMI2_MAX_KEYLEN];
+        char value[PMI2_MAX_VALLEN];
+        unsigned char *bytes = (unsigned char *)buf;
+        size_t chunkSize = (PMI2_MAX_VALLEN - 1) / 2;
+        unsigned long bcastId = (unsigned long)mNumBcasts++;
+        int len;
+
+        for (size_t start = 0; (mRank == rootPe) && (start < nbytes);
+             start += chunkSize) {
+            size_t size = nbytes - start;
+            if (size > chunkSize)
+                size = chunkSize;
+            for (size_t i = 0; i < size; i++)
+                snprintf(&value[2 * i], 3, "%02x", bytes[start + i]);
+            snprintf(key, sizeof(key), "fam_bcast_%lu_%lu", bcastId,
+                     (unsigned long)(start / chunkSize));
+            if (PMI2_SUCCESS != PMI2_KVS_Put(key, value))
+                return -1;
+        }
+
+        if (PMI2_SUCCESS != PMI2_KVS_Fence())
+            return -1;
+        if (mRank == rootPe)
+            return 0;
+
+        for (size_t start = 0; start < nbytes; start += chunkSize) {
+            size_t size = nbytes - start;
+            if (size > chunkSize)
+                size = chunkSize;
+            snprintf(key, sizeof(key), "fam_bcast_%lu_%lu", bcastId,
+                     (unsigned long)(start / chunkSize));
+            if ((PMI2_SUCCESS != PMI2_KVS_Get(NULL, rootPe, key, value,
+                                              (int)sizeof(value), &len)) ||
+                ((size_t)len != 2 * size))
+                return -1;
+            for (size_t i = 0; i < size; i++) {
+                char hex[3] = { value[2 * i], value[2 * i + 1], 0 };
+                bytes[start + i] = (unsigned char)strtoul(hex, NULL, 16);
+            }
+        }
+        return 0;
+    }
+
     /*
      * Adding a dummy destructor
      */
@@ -41,6 +41,7 @@ class Pmix_Runtime : public Fam_Runtime {
     pmix_status_t mInitrc;
     pmix_rank_t mRank;
     uint32_t mNumPEs;
+    uint64_t mNumBcasts = 0;
 
   public:
     /*
@@ -139,6 +140,50 @@ class Pmix_Runtime : public Fam_Runtime {
         return 0;
     }
 
+    /*
+     * Copies nbytes at buf on rootPe to buf on every other PE. All PEs have
+     * to call it with the same nbytes and rootPe. The data is published in
+     * the PMIx key-value store under a key used by this broadcast only.
+     **/
+    int runtime_broadcast(void *buf, size_t nbytes, int rootPe) {
+        pmix_status_t rc;
+        pmix_proc_t proc;
+        pmix_value_t value;
+        pmix_value_t *val;
+        char key[PMIX_MAX_KEYLEN];
+
+        snprintf(key, sizeof(key), "fam_bcast_%lu",
+                 (unsigned long)mNumBcasts++);
+        if (mRank == (pmix_rank_t)rootPe) {
+            PMIX_VALUE_CONSTRUCT(&value);
+            value.type = PMIX_BYTE_OBJECT;
+            value.data.bo.bytes = (char *)buf;
+            value.data.bo.size = nbytes;
+            if (PMIX_SUCCESS != (rc = PMIx_Put(PMIX_GLOBAL, key, &value)))
+                return -1;
+            if (PMIX_SUCCESS != (rc = PMIx_Commit()))
+                return -1;
+        }
+
+        if (runtime_barrier_all() < 0)
+            return -1;
+        if (mRank == (pmix_rank_t)rootPe)
+            return 0;
+
+        PMIX_PROC_CONSTRUCT(&proc);
+        (void)strncpy(proc.nspace, mProc.nspace, PMIX_MAX_NSLEN);
+        proc.rank = (pmix_rank_t)rootPe;
+        if (PMIX_SUCCESS != (rc = PMIx_Get(&proc, key, NULL, 0, &val)))
+            return -1;
+        if ((val->type != PMIX_BYTE_OBJECT) || (val->data.bo.size != nbytes)) {
+            PMIX_VALUE_RELEASE(val);
+            return -1;
+        }
+        memcpy(buf, val->data.bo.bytes, nbytes);
+        PMIX_VALUE_RELEASE(val);
+        return 0;
+    }
+
     /*
      * Adding a dummy destructor
      */
@@ -0,0 +1,275 @@
+/*
+ * fam_mr_registry.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#include <algorithm>
+#include <chrono>
+
+#include "common/fam_libfabric.h"
+#include "rpc/fam_mr_registry.h"
+
+namespace openfam {
+
+Fam_Mr_Registry::Fam_Mr_Registry(struct fid_domain *domain, uint64_t maxMrs,
+                                 std::function<void()> onEvict)
+    : domain(domain), maxMrs(maxMrs), onEvict(onEvict), stop(false) {
+    numMrs.store(0);
+    numEvicted.store(0);
+    sweep.store(0);
+    shards = new Mr_Shard[FAM_MR_REGISTRY_SHARDS];
+    for (int i = 0; i < FAM_MR_REGISTRY_SHARDS; i++) {
+        shards[i].readers.store(0);
+        for (int j = 0; j < FAM_MR_REGISTRY_BUCKETS; j++)
+            shards[i].buckets[j].store(NULL);
+    }
+
+    sweeper = std::thread(&Fam_Mr_Registry::run, this);
+}
+
+Fam_Mr_Registry::~Fam_Mr_Registry() {
+    {
+        std::lock_guard<std::mutex> guard(stopLock);
+        stop = true;
+    }
+    stopCond.notify_all();
+    sweeper.join();
+
+    deregister_all();
+    delete[] shards;
+}
+
+boost::atomic<Fam_Mr_Registry::Mr_Entry *> &
+Fam_Mr_Registry::get_bucket(uint64_t key, Mr_Shard *&shard) {
+    // Keys differ mostly in the data item id, so mix before picking a slot
+    uint64_t hash = key * 0x9E3779B97F4A7C15UL;
+    shard = &shards[(hash >> 32) % FAM_MR_REGISTRY_SHARDS];
+    return shard->buckets[(hash >> 44) % FAM_MR_REGISTRY_BUCKETS];
+}
+
+Fam_Mr_Registry::Mr_Entry *
+Fam_Mr_Registry::lookup(boost::atomic<Mr_Entry *> &bucket, uint64_t key) {
+    Mr_Entry *entry = bucket.load(boost::memory_order_acquire);
+    while (entry && (entry->key != key))
+        entry = entry->next.load(boost::memory_order_acquire);
+    return entry;
+}
+
+bool Fam_Mr_Registry::find(uint64_t key) {
+    Mr_Shard *shard;
+    boost::atomic<Mr_Entry *> &bucket = get_bucket(key, shard);
+
+    shard->readers.fetch_add(1);
+    Mr_Entry *entry = lookup(bucket, key);
+    if (entry) {
+        // Only write the entry when the sweep changed, to keep hits cheap
+        uint64_t now = sweep.load(boost::memory_order_relaxed);
+        if (entry->lastUse.load(boost::memory_order_relaxed) != now)
+            entry->lastUse.store(now, boost::memory_order_relaxed);
+    }
+    shard->readers.fetch_sub(1);
+
+    return (entry != NULL);
+}
+
+int Fam_Mr_Registry::register_mr(uint64_t key, void *addr, size_t nbytes,
+                                 bool rw, bool pinned) {
+    if (find(key))
+        return 0;
+
+    Mr_Shard *shard;
+    boost::atomic<Mr_Entry *> &bucket = get_bucket(key, shard);
+    std::lock_guard<std::mutex> guard(shard->lock);
+
+    // Registered by another thread since the lookup above
+    if (lookup(bucket, key))
+        return 0;
+
+    fid_mr *mr = 0;
+    uint64_t mrKey = key;
+    int ret = fabric_register_mr(addr, nbytes, &mrKey, domain, rw, mr);
+    if (ret < 0)
+        return ret;
+
+    Mr_Entry *entry = new Mr_Entry();
+    entry->key = key;
+    entry->mr = mr;
+    entry->pinned = pinned;
+    entry->lastUse.store(sweep.load());
+    entry->next.store(bucket.load());
+    bucket.store(entry, boost::memory_order_release);
+    numMrs.fetch_add(1);
+
+    return 0;
+}
+
+int Fam_Mr_Registry::deregister_mr(uint64_t key) {
+    Mr_Shard *shard;
+    boost::atomic<Mr_Entry *> &bucket = get_bucket(key, shard);
+    std::lock_guard<std::mutex> guard(shard->lock);
+
+    return remove(shard, bucket, key);
+}
+
+/*
+ * Unlink and deregister the entry of key. Called with the shard lock held.
+ * Lookups already walking the chain may still hold the entry, so it is only
+ * retired here and freed by reclaim().
+ */
+int Fam_Mr_Registry::remove(Mr_Shard *shard, boost::atomic<Mr_Entry *> &bucket,
+                            uint64_t key) {
+    boost::atomic<Mr_Entry *> *link = &bucket;
+    Mr_Entry *entry = link->load();
+    while (entry && (entry->key != key)) {
+        link = &entry->next;
+        entry = link->load();
+    }
+    if (!entry)
+        return 0;
+
+    int ret = fabric_deregister_mr(entry->mr);
+    if (ret < 0)
+        return ret;
+
+    link->store(entry->next.load());
+    numMrs.fetch_sub(1);
+    shard->retired.push_back(entry);
+    reclaim(shard);
+
+    return 0;
+}
+
+/*
+ * Free the retired entries of a shard if no lookup is running in it. A
+ * lookup starting after this check cannot reach them any more, since they
+ * were unlinked before it. Called with the shard lock held.
+ */
+void Fam_Mr_Registry::reclaim(Mr_Shard *shard) {
+    if (shard->retired.empty() || (shard->readers.load() != 0))
+        return;
+    for (auto entry : shard->retired)
+        delete entry;
+    shard->retired.clear();
+}
+
+void Fam_Mr_Registry::deregister_all() {
+    for (int i = 0; i < FAM_MR_REGISTRY_SHARDS; i++) {
+        Mr_Shard *shard = &shards[i];
+        std::lock_guard<std::mutex> guard(shard->lock);
+        for (int j = 0; j < FAM_MR_REGISTRY_BUCKETS; j++) {
+            Mr_Entry *entry = shard->buckets[j].exchange(NULL);
+            while (entry) {
+                Mr_Entry *next = entry->next.load();
+                (void)fabric_deregister_mr(entry->mr);
+                shard->retired.push_back(entry);
+                numMrs.fetch_sub(1);
+                entry = next;
+            }
+        }
+        reclaim(shard);
+    }
+}
+
+/*
+ * Deregister key unless it was used after lastUse, the sweep in which
+ * evict_cold() saw it last used. Returns whether it was deregistered.
+ */
+bool Fam_Mr_Registry::evict(uint64_t key, uint64_t lastUse) {
+    Mr_Shard *shard;
+    boost::atomic<Mr_Entry *> &bucket = get_bucket(key, shard);
+    std::lock_guard<std::mutex> guard(shard->lock);
+
+    Mr_Entry *entry = lookup(bucket, key);
+    if (!entry || (entry->lastUse.load() != lastUse))
+        return false;
+    return (remove(shard, bucket, key) == 0);
+}
+
+/*
+ * Drop the least recently used registrations once there are more than
+ * maxMrs of them. Those used in the last FAM_MR_REGISTRY_HOLD_SWEEPS sweeps
+ * are kept.
+ */
+void Fam_Mr_Registry::evict_cold() {
+    uint64_t count = numMrs.load();
+    if ((maxMrs == 0) || (count <= maxMrs))
+        return;
+
+    uint64_t now = sweep.load();
+    std::vector<std::pair<uint64_t, uint64_t>> candidates;
+    for (int i = 0; i < FAM_MR_REGISTRY_SHARDS; i++) {
+        std::lock_guard<std::mutex> guard(shards[i].lock);
+        for (int j = 0; j < FAM_MR_REGISTRY_BUCKETS; j++) {
+            Mr_Entry *entry = shards[i].buckets[j].load();
+            for (; entry; entry = entry->next.load()) {
+                uint64_t lastUse = entry->lastUse.load();
+                if (!entry->pinned &&
+                    (lastUse + FAM_MR_REGISTRY_HOLD_SWEEPS < now))
+                    candidates.push_back({lastUse, entry->key});
+            }
+        }
+    }
+
+    uint64_t numEvict = count - (maxMrs - maxMrs / 8);
+    if (numEvict > candidates.size())
+        numEvict = candidates.size();
+    std::nth_element(candidates.begin(), candidates.begin() + numEvict,
+                     candidates.end());
+    uint64_t evicted = 0;
+    for (uint64_t i = 0; i < numEvict; i++) {
+        if (evict(candidates[i].second, candidates[i].first))
+            evicted++;
+    }
+
+    if (evicted) {
+        numEvicted.fetch_add(evicted);
+        if (onEvict)
+            onEvict();
+    }
+}
+
+void Fam_Mr_Registry::run() {
+    std::unique_lock<std::mutex> guard(stopLock);
+    while (!stop) {
+        stopCond.wait_for(guard,
+                          std::chrono::milliseconds(FAM_MR_REGISTRY_SWEEP_MS));
+        if (stop)
+            break;
+        guard.unlock();
+
+        sweep.fetch_add(1);
+        evict_cold();
+        for (int i = 0; i < FAM_MR_REGISTRY_SHARDS; i++) {
+            std::lock_guard<std::mutex> shardGuard(shards[i].lock);
+            reclaim(&shards[i]);
+        }
+
+        guard.lock();
+    }
+}
+
+} // namespace openfam
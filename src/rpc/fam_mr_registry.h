@@ -0,0 +1,146 @@
+/*
+ * fam_mr_registry.h
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+#ifndef FAM_MR_REGISTRY_H_
+#define FAM_MR_REGISTRY_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <rdma/fi_domain.h>
+
+#include "common/fam_internal.h"
+
+// Shards and hash buckets per shard of the registry
+#define FAM_MR_REGISTRY_SHARDS 64
+#define FAM_MR_REGISTRY_BUCKETS 4096
+// Interval of the background sweep dropping cold registrations
+#define FAM_MR_REGISTRY_SWEEP_MS 1000
+// Sweeps a registration is kept after its last use; well beyond the key
+// lease, so that keys clients use without asking the server stay valid
+#define FAM_MR_REGISTRY_HOLD_SWEEPS                                            \
+    (4 * FAM_MR_KEY_LEASE_MS / FAM_MR_REGISTRY_SWEEP_MS)
+
+namespace openfam {
+
+/*
+ * Libfabric memory registrations of a memory server, keyed by access key.
+ *
+ * Keys are spread over shards, each a fixed array of hash chains. Lookups,
+ * the common case once a data item has been touched, walk the chains with
+ * atomic loads only; registering and deregistering take the lock of one
+ * shard. Unlinked entries are freed once no lookup is running in their
+ * shard.
+ *
+ * When maxMrs is set, a background thread deregisters the least recently
+ * used registrations whenever there are more than maxMrs of them, down to
+ * 7/8 of maxMrs. Registrations used in the last FAM_MR_REGISTRY_HOLD_SWEEPS
+ * sweeps are kept. After dropping some, the registry calls onEvict, so that
+ * the memory server can tell clients that the keys they cached may be gone.
+ * A data item is registered again by its next lookup or permission check.
+ * Pinned registrations, e.g. fence memory or whole regions, are never
+ * dropped.
+ *
+ * RDMA traffic does not mark a key as used, so clients of such a server
+ * hold keys on a lease: a key not confirmed by a permission check for
+ * FAM_MR_KEY_LEASE_MS is checked again before its next use. Keys in use
+ * are thereby confirmed long before they could go cold.
+ */
+class Fam_Mr_Registry {
+  public:
+    Fam_Mr_Registry(struct fid_domain *domain, uint64_t maxMrs = 0,
+                    std::function<void()> onEvict = nullptr);
+    ~Fam_Mr_Registry();
+
+    // Check whether key is registered and mark it as used
+    bool find(uint64_t key);
+
+    // Register nbytes at addr under key, unless key is registered already
+    int register_mr(uint64_t key, void *addr, size_t nbytes, bool rw,
+                    bool pinned = false);
+
+    // Deregister key; a key that is not registered is not an error
+    int deregister_mr(uint64_t key);
+
+    void deregister_all();
+
+    // Whether cold registrations are dropped, and keys are held on a lease
+    bool evicts() { return maxMrs != 0; }
+
+    uint64_t get_num_mrs() { return numMrs.load(); }
+    uint64_t get_num_evicted() { return numEvicted.load(); }
+
+  private:
+    struct Mr_Entry {
+        uint64_t key;
+        fid_mr *mr;
+        bool pinned;
+        boost::atomic_uint64_t lastUse;
+        boost::atomic<Mr_Entry *> next;
+    };
+
+    struct Mr_Shard {
+        std::mutex lock;
+        boost::atomic_uint64_t readers;
+        boost::atomic<Mr_Entry *> buckets[FAM_MR_REGISTRY_BUCKETS];
+        std::vector<Mr_Entry *> retired;
+    };
+
+    boost::atomic<Mr_Entry *> &get_bucket(uint64_t key, Mr_Shard *&shard);
+    Mr_Entry *lookup(boost::atomic<Mr_Entry *> &bucket, uint64_t key);
+    int remove(Mr_Shard *shard, boost::atomic<Mr_Entry *> &bucket,
+               uint64_t key);
+    void reclaim(Mr_Shard *shard);
+    bool evict(uint64_t key, uint64_t lastUse);
+    void evict_cold();
+    void run();
+
+    struct fid_domain *domain;
+    uint64_t maxMrs;
+    std::function<void()> onEvict;
+    boost::atomic_uint64_t numMrs;
+    boost::atomic_uint64_t numEvicted;
+    // Advanced by every sweep; lastUse of an entry is the sweep it was used in
+    boost::atomic_uint64_t sweep;
+    Mr_Shard *shards;
+
+    bool stop;
+    std::mutex stopLock;
+    std::condition_variable stopCond;
+    std::thread sweeper;
+};
+
+} // namespace openfam
+
+#endif /* end of FAM_MR_REGISTRY_H_ */
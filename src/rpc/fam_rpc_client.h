@@ -39,12 +39,19 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <boost/atomic.hpp>
+
 #include "fam/fam.h"
 #include "fam/fam_exception.h"
 #include "rpc/fam_rpc.grpc.pb.h"
 
 using namespace std;
 
+// Bounds of the backoff, in microseconds, between attempts to take a CAS lock
+// that another client holds
+#define FAM_CAS_LOCK_MIN_BACKOFF_US 1
+#define FAM_CAS_LOCK_MAX_BACKOFF_US 1000
+
 #define FAM_UNIMPLEMENTED_RPC()                                                \
     {                                                                          \
         cout << "returned from server..." << __func__                          \
@@ -71,19 +78,32 @@ typedef struct {
 
     uint64_t memServerId;
 
+    // Identifies the copy in copy_progress requests on this channel
+    uint64_t copyId;
+
     std::unique_ptr<::grpc::ClientAsyncResponseReader<Fam_Copy_Response>>
         responseReader;
 } Fam_Copy_Tag;
 
 class Fam_Rpc_Client {
   public:
-    Fam_Rpc_Client(const char *name, uint64_t port) {
+    /*
+     * Create the channel to the memory server at name:port. Unless
+     * connectNow is false, also send the start signal; otherwise connect()
+     * or start_connect() has to be called before any other request.
+     */
+    Fam_Rpc_Client(const char *name, uint64_t port, bool connectNow = true) {
         std::ostringstream message;
         std::string name_s(name);
         name_s += ":" + std::to_string(port);
 
         uid = (uint32_t)getuid();
         gid = (uint32_t)getgid();
+        lastCopyId = 0;
+        metadataVersion.store(0);
+        connected.store(false);
+        memServerFabricAddrSize = 0;
+        memServerFabricAddr = NULL;
 
         /** Creating a channel and stub **/
         this->stub = Fam_Rpc::NewStub(
@@ -94,46 +114,81 @@ class Fam_Rpc_Client {
             throw Fam_Allocator_Exception(FAM_ERR_GRPC, message.str().c_str());
         }
 
+        if (connectNow)
+            connect();
+    }
+
+    ~Fam_Rpc_Client() {
         Fam_Request req;
-        Fam_Start_Response res;
+        Fam_Response res;
 
         ::grpc::ClientContext ctx;
+
+        if (connected.load())
+            (void)stub->signal_termination(&ctx, req, &res);
+
+        free(memServerFabricAddr);
+    }
+
+    /**
+     * Send the start signal to the memory server and wait for its reply
+     **/
+    void connect() {
+        Fam_Request req;
+        ::grpc::ClientContext ctx;
+
         /** sending a start signal to server **/
-        ::grpc::Status status = stub->signal_start(&ctx, req, &res);
+        ::grpc::Status status = stub->signal_start(&ctx, req, &startRes);
         if (!status.ok()) {
             throw Fam_Allocator_Exception(FAM_ERR_GRPC,
                                           (status.error_message()).c_str());
         }
-        memServerFabricAddrSize = res.addrnamelen();
-        memServerFabricAddr = (char *)calloc(1, memServerFabricAddrSize);
-
-        uint32_t lastBytes = 0;
-        int lastBytesCount = (int)(memServerFabricAddrSize % sizeof(uint32_t));
-        int readCount = res.addrname_size();
-
-        if (lastBytesCount > 0)
-            readCount -= 1;
+        set_fabric_addr();
+    }
 
-        for (int ndx = 0; ndx < readCount; ndx++) {
-            *((uint32_t *)memServerFabricAddr + ndx) = res.addrname(ndx);
-        }
+    /**
+     * Send the start signal without waiting for the reply, which arrives on
+     * connectCq tagged with this client. Lets a caller connect to many memory
+     * servers at once; finish_connect() has to be called for the reply.
+     **/
+    void start_connect(::grpc::CompletionQueue *connectCq) {
+        Fam_Request req;
+        startReader = stub->PrepareAsyncsignal_start(&startCtx, req, connectCq);
+        startReader->StartCall();
+        startReader->Finish(&startRes, &startStatus, (void *)this);
+    }
 
-        if (lastBytesCount > 0) {
-            lastBytes = res.addrname(readCount);
-            memcpy(((uint32_t *)memServerFabricAddr + readCount), &lastBytes,
-                   lastBytesCount);
+    void finish_connect() {
+        if (!startStatus.ok()) {
+            throw Fam_Allocator_Exception(
+                FAM_ERR_GRPC, (startStatus.error_message()).c_str());
         }
+        set_fabric_addr();
     }
 
-    ~Fam_Rpc_Client() {
-        Fam_Request req;
-        Fam_Response res;
+    bool is_connected() { return connected.load(); }
 
-        ::grpc::ClientContext ctx;
+    // Whether keys of this memory server have to be confirmed after
+    // FAM_MR_KEY_LEASE_MS, as it drops cold registrations
+    bool keys_leased() { return startRes.keylease(); }
 
-        ::grpc::Status status = stub->signal_termination(&ctx, req, &res);
+    /**
+     * Get the bytes the memory server offers to regions, 0 if not limited,
+     * and the bytes of the regions it holds
+     * @see fam_rpc.proto
+     **/
+    void get_memserver_info(uint64_t &capacity, uint64_t &used) {
+        Fam_Request req;
+        Fam_Memserver_Info_Response res;
+        ::grpc::ClientContext ctx;
 
-        free(memServerFabricAddr);
+        ::grpc::Status status = stub->get_memserver_info(&ctx, req, &res);
+        if (!status.ok()) {
+            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                          (status.error_message()).c_str());
+        }
+        capacity = res.capacity();
+        used = res.used();
     }
 
     /**
@@ -142,13 +197,16 @@ class Fam_Rpc_Client {
      * @param nbytes - size of the region
      * @param permissions - Permission with which the region needs to be created
      * @param redundancyLevel - Redundancy level of FAM
+     * @param layout - stripe layout of a member of a striped or mirrored
+     * region
      * @return - pointer to Fam_Region_Descriptor
      * @see fam_rpc.proto
      **/
     Fam_Region_Descriptor *create_region(const char *name, size_t nbytes,
                                          mode_t permission,
                                          Fam_Redundancy_Level redundancyLevel,
-                                         uint64_t memoryServerId) {
+                                         uint64_t memoryServerId,
+                                         Fam_Stripe_Layout layout) {
         Fam_Region_Request req;
         Fam_Region_Response res;
         ::grpc::ClientContext ctx;
@@ -158,6 +216,10 @@ class Fam_Rpc_Client {
         req.set_perm(permission);
         req.set_uid(uid);
         req.set_gid(gid);
+        req.set_stripesize(layout.stripeSize);
+        req.set_stripecount(layout.stripeCount);
+        req.set_stripeindex(layout.stripeIndex);
+        req.set_redundancy(layout.redundancyLevel);
         ::grpc::Status status = stub->create_region(&ctx, req, &res);
 
         if (status.ok()) {
@@ -172,6 +234,7 @@ class Fam_Rpc_Client {
                 globalDescriptor.offset = res.offset();
                 Fam_Region_Descriptor *region =
                     new Fam_Region_Descriptor(globalDescriptor, nbytes);
+                region->set_layout(layout);
                 return region;
             }
         } else {
@@ -199,6 +262,7 @@ class Fam_Rpc_Client {
         ::grpc::Status status = stub->destroy_region(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -234,6 +298,42 @@ class Fam_Rpc_Client {
         ::grpc::Status status = stub->resize_region(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
+            if (res.errorcode()) {
+                throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
+                                              (res.errormsg()).c_str());
+            } else {
+                return FAM_SUCCESS;
+            }
+        } else {
+            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                          (status.error_message()).c_str());
+        }
+    }
+
+    /**
+     * Let a region in FAM grow in the background as it fills up
+     * @param region - Fam region descriptor of the region
+     * @param growLimit - size the region may grow to; 0 stops growth
+     * @return - 1/0
+     * @see fam_rpc.proto
+     **/
+    int set_region_growth(Fam_Region_Descriptor *region, size_t growLimit) {
+        Fam_Region_Request req;
+        Fam_Region_Response res;
+        ::grpc::ClientContext ctx;
+
+        Fam_Global_Descriptor globalDescriptor =
+            region->get_global_descriptor();
+        req.set_regionid(globalDescriptor.regionId & REGIONID_MASK);
+        req.set_size(growLimit);
+        req.set_uid(uid);
+        req.set_gid(gid);
+
+        ::grpc::Status status = stub->set_region_growth(&ctx, req, &res);
+
+        if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -316,6 +416,7 @@ class Fam_Rpc_Client {
         ::grpc::Status status = stub->deallocate(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -349,6 +450,7 @@ class Fam_Rpc_Client {
         ::grpc::Status status = stub->change_region_permission(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -384,6 +486,7 @@ class Fam_Rpc_Client {
             stub->change_dataitem_permission(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -397,7 +500,8 @@ class Fam_Rpc_Client {
     }
 
     Fam_Region_Descriptor *lookup_region(const char *name,
-                                         uint64_t memoryServerId) {
+                                         uint64_t memoryServerId,
+                                         uint64_t *version = NULL) {
         Fam_Region_Request req;
         Fam_Region_Response res;
         ::grpc::ClientContext ctx;
@@ -409,6 +513,7 @@ class Fam_Rpc_Client {
         ::grpc::Status status = stub->lookup_region(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -419,6 +524,11 @@ class Fam_Rpc_Client {
                 globalDescriptor.offset = res.offset();
                 Fam_Region_Descriptor *region =
                     new Fam_Region_Descriptor(globalDescriptor, res.size());
+                region->set_layout(
+                    {res.stripesize(), res.stripecount(), res.stripeindex(),
+                     (Fam_Redundancy_Level)res.redundancy()});
+                if (version)
+                    *version = res.version();
                 return region;
             }
         } else {
@@ -428,7 +538,7 @@ class Fam_Rpc_Client {
     }
 
     Fam_Descriptor *lookup(const char *itemName, const char *regionName,
-                           uint64_t memoryServerId) {
+                           uint64_t memoryServerId, uint64_t *version = NULL) {
         Fam_Dataitem_Request req;
         Fam_Dataitem_Response res;
         ::grpc::ClientContext ctx;
@@ -441,6 +551,7 @@ class Fam_Rpc_Client {
         ::grpc::Status status = stub->lookup(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -451,7 +562,13 @@ class Fam_Rpc_Client {
                 globalDescriptor.offset = res.offset();
                 Fam_Descriptor *dataItem =
                     new Fam_Descriptor(globalDescriptor, res.size());
-                dataItem->bind_key(FAM_KEY_UNINITIALIZED);
+                // The server registers the data item during the lookup
+                dataItem->bind_key(res.key());
+                dataItem->set_layout(
+                    {res.stripesize(), res.stripecount(), res.stripeindex(),
+                     (Fam_Redundancy_Level)res.redundancy()});
+                if (version)
+                    *version = res.version();
                 return dataItem;
             }
         } else {
@@ -460,6 +577,140 @@ class Fam_Rpc_Client {
         }
     }
 
+    /**
+     * Allocate several data items within the specified region in one call
+     * @param names - names of the data items, NULL entries are unnamed
+     * @param nbytes - sizes of the data items
+     * @param nItems - no. of data items
+     * @param permission - permission of the data items
+     * @param region - Fam region descriptor of a region within which data
+     *items need to be created
+     * @param items - array filled with the descriptors of the data items
+     * @see fam_rpc.proto
+     **/
+    void allocate_batch(const char **names, uint64_t *nbytes, uint64_t nItems,
+                        mode_t permission, Fam_Region_Descriptor *region,
+                        Fam_Descriptor **items) {
+        Fam_Dataitem_Batch_Request req;
+        Fam_Dataitem_Batch_Response res;
+        ::grpc::ClientContext ctx;
+
+        Fam_Global_Descriptor globalDescriptor =
+            region->get_global_descriptor();
+        req.set_regionid(globalDescriptor.regionId & REGIONID_MASK);
+        req.set_perm(permission);
+        req.set_uid(uid);
+        req.set_gid(gid);
+        for (uint64_t i = 0; i < nItems; i++) {
+            req.add_name((names && names[i]) ? names[i] : "");
+            req.add_size(nbytes[i]);
+        }
+        uint64_t nodeId = region->get_memserver_id();
+
+        ::grpc::Status status = stub->allocate_batch(&ctx, req, &res);
+
+        if (status.ok()) {
+            if (res.errorcode()) {
+                throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
+                                              (res.errormsg()).c_str());
+            } else if ((uint64_t)res.offset_size() != nItems) {
+                throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                              "Incomplete batch response");
+            } else {
+                globalDescriptor.regionId =
+                    res.regionid() | (nodeId << MEMSERVERID_SHIFT);
+                for (uint64_t i = 0; i < nItems; i++) {
+                    globalDescriptor.offset = res.offset((int)i);
+                    items[i] =
+                        new Fam_Descriptor(globalDescriptor, res.size((int)i));
+                    items[i]->bind_key(res.key((int)i));
+                }
+            }
+        } else {
+            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                          (status.error_message()).c_str());
+        }
+    }
+
+    /**
+     * deallocates several data items of the same region in one call
+     * @param items - Fam data item descriptors which need to be deallocated
+     * @param nItems - no. of data items
+     * @see fam_rpc.proto
+     **/
+    void deallocate_batch(Fam_Descriptor **items, uint64_t nItems) {
+        Fam_Dataitem_Batch_Request req;
+        Fam_Dataitem_Batch_Response res;
+        ::grpc::ClientContext ctx;
+
+        Fam_Global_Descriptor globalDescriptor =
+            items[0]->get_global_descriptor();
+        req.set_regionid(globalDescriptor.regionId & REGIONID_MASK);
+        req.set_uid(uid);
+        req.set_gid(gid);
+        for (uint64_t i = 0; i < nItems; i++)
+            req.add_offset(items[i]->get_global_descriptor().offset);
+
+        ::grpc::Status status = stub->deallocate_batch(&ctx, req, &res);
+
+        if (status.ok()) {
+            update_metadata_version(res.version());
+            if (res.errorcode()) {
+                throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
+                                              (res.errormsg()).c_str());
+            } else {
+                return;
+            }
+        } else {
+            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                          (status.error_message()).c_str());
+        }
+    }
+
+    void lookup_batch(const char **itemNames, const char *regionName,
+                      uint64_t nItems, uint64_t memoryServerId,
+                      Fam_Descriptor **items) {
+        Fam_Dataitem_Batch_Request req;
+        Fam_Dataitem_Batch_Response res;
+        ::grpc::ClientContext ctx;
+
+        req.set_regionname(regionName);
+        req.set_uid(uid);
+        req.set_gid(gid);
+        for (uint64_t i = 0; i < nItems; i++)
+            req.add_name(itemNames[i]);
+
+        ::grpc::Status status = stub->lookup_batch(&ctx, req, &res);
+
+        if (status.ok()) {
+            if (res.errorcode()) {
+                throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
+                                              (res.errormsg()).c_str());
+            } else if (((uint64_t)res.offset_size() != nItems) ||
+                       ((uint64_t)res.key_size() != nItems)) {
+                throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                              "Incomplete batch response");
+            } else {
+                Fam_Global_Descriptor globalDescriptor;
+                globalDescriptor.regionId =
+                    res.regionid() | (memoryServerId << MEMSERVERID_SHIFT);
+                for (uint64_t i = 0; i < nItems; i++) {
+                    globalDescriptor.offset = res.offset((int)i);
+                    items[i] =
+                        new Fam_Descriptor(globalDescriptor, res.size((int)i));
+                    items[i]->bind_key(res.key((int)i));
+                    items[i]->set_layout(
+                        {res.stripesize(), res.stripecount(),
+                         res.stripeindex(),
+                         (Fam_Redundancy_Level)res.redundancy()});
+                }
+            }
+        } else {
+            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                          (status.error_message()).c_str());
+        }
+    }
+
     Fam_Region_Item_Info
     check_permission_get_info(Fam_Region_Descriptor *region) {
         Fam_Region_Request req;
@@ -477,6 +728,7 @@ class Fam_Rpc_Client {
             stub->check_permission_get_region_info(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
@@ -490,7 +742,8 @@ class Fam_Rpc_Client {
         }
     }
 
-    Fam_Region_Item_Info check_permission_get_info(Fam_Descriptor *dataitem) {
+    Fam_Region_Item_Info check_permission_get_info(Fam_Descriptor *dataitem,
+                                                   uint64_t *version = NULL) {
         Fam_Dataitem_Request req;
         Fam_Dataitem_Response res;
         ::grpc::ClientContext ctx;
@@ -507,12 +760,15 @@ class Fam_Rpc_Client {
             stub->check_permission_get_item_info(&ctx, req, &res);
 
         if (status.ok()) {
+            update_metadata_version(res.version());
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
             } else {
                 itemInfo.key = res.key();
                 itemInfo.size = res.size();
+                if (version)
+                    *version = res.version();
                 return itemInfo;
             }
         } else {
@@ -525,8 +781,6 @@ class Fam_Rpc_Client {
                uint64_t destOffset, uint64_t nbytes) {
         Fam_Dataitem_Request req;
         Fam_Dataitem_Response res;
-        Fam_Copy_Request copyReq;
-        Fam_Copy_Response copyRes;
         ::grpc::ClientContext ctx;
 
         Fam_Global_Descriptor srcGlobalDescriptor =
@@ -572,7 +826,42 @@ class Fam_Rpc_Client {
                                           (status.error_message()).c_str());
         }
 
+        return copy(src, srcOffset, *dest, destOffset, nbytes);
+    }
+
+    /*
+     * Copy into an existing destination data item. Only the copy request is
+     * sent; the memory server checks the permissions of both data items.
+     * When the destination is on another memory server, destAddr is the
+     * fabric address of that server: the source server then writes into the
+     * destination through the key of dest, which carries its permission.
+     */
+    void *copy(Fam_Descriptor *src, uint64_t srcOffset, Fam_Descriptor *dest,
+               uint64_t destOffset, uint64_t nbytes,
+               const void *destAddr = NULL, size_t destAddrLen = 0) {
+        Fam_Copy_Request copyReq;
+
+        Fam_Global_Descriptor srcGlobalDescriptor =
+            src->get_global_descriptor();
+        Fam_Global_Descriptor destGlobalDescriptor =
+            dest->get_global_descriptor();
+        uint64_t nodeId = src->get_memserver_id();
+
+        if ((srcOffset + nbytes) > src->get_size()) {
+            throw Fam_Allocator_Exception(
+                FAM_ERR_OUTOFRANGE,
+                "Source offset or size is beyond dataitem boundary");
+        }
+
+        if ((destOffset + nbytes) > dest->get_size()) {
+            throw Fam_Allocator_Exception(
+                FAM_ERR_OUTOFRANGE,
+                "Destination offset or size is beyond dataitem boundary");
+        }
+
         copyReq.set_regionid(srcGlobalDescriptor.regionId & REGIONID_MASK);
+        copyReq.set_destregionid(destGlobalDescriptor.regionId &
+                                 REGIONID_MASK);
         copyReq.set_srcoffset(srcGlobalDescriptor.offset);
         copyReq.set_destoffset(destGlobalDescriptor.offset);
         copyReq.set_srccopystart(srcOffset);
@@ -580,11 +869,17 @@ class Fam_Rpc_Client {
         copyReq.set_gid(gid);
         copyReq.set_uid(uid);
         copyReq.set_copysize(nbytes);
+        if (destAddr != NULL) {
+            copyReq.set_destkey(dest->get_key());
+            copyReq.set_destaddr(destAddr, destAddrLen);
+        }
 
         Fam_Copy_Tag *tag = new Fam_Copy_Tag();
 
         tag->isCompleted = false;
         tag->memServerId = nodeId;
+        tag->copyId = __sync_add_and_fetch(&lastCopyId, 1);
+        copyReq.set_copyid(tag->copyId);
 
         tag->responseReader = stub->PrepareAsynccopy(&tag->ctx, copyReq, &cq);
 
@@ -664,27 +959,76 @@ class Fam_Rpc_Client {
         }
     }
 
+    /*
+     * Bytes of the copy done so far. While the copy runs on the memory
+     * server its progress is asked from there; a copy still queued on the
+     * server reports 0.
+     */
+    uint64_t copy_progress(void *waitObj) {
+        Fam_Copy_Request req;
+        Fam_Copy_Response res;
+        ::grpc::ClientContext ctx;
+
+        Fam_Copy_Tag *tag = static_cast<Fam_Copy_Tag *>(waitObj);
+
+        if (!tag) {
+            throw Fam_Allocator_Exception(FAM_ERR_INVALID, "Copy tag is null");
+        }
+
+        if (tag->isCompleted)
+            return tag->res.copied();
+
+        req.set_copyid(tag->copyId);
+
+        ::grpc::Status status = stub->copy_progress(&ctx, req, &res);
+
+        if (!status.ok()) {
+            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                          (status.error_message()).c_str());
+        }
+        if (res.inprogress())
+            return res.copied();
+
+        // Not running on the server, so either queued there or finished
+        poll_copy_completions();
+        if (tag->isCompleted)
+            return tag->res.copied();
+        return 0;
+    }
+
+    /*
+     * The memory server does not wait for a lock held by another client,
+     * it only reports it; the request is sent again, with a growing backoff,
+     * until the lock is taken.
+     */
     void acquire_CAS_lock(Fam_Descriptor *dataitem) {
         Fam_Dataitem_Request req;
-        Fam_Dataitem_Response res;
-        ::grpc::ClientContext ctx;
+        uint64_t backoff = FAM_CAS_LOCK_MIN_BACKOFF_US;
 
         Fam_Global_Descriptor globalDescriptor =
             dataitem->get_global_descriptor();
         req.set_offset(globalDescriptor.offset);
 
-        ::grpc::Status status = stub->acquire_CAS_lock(&ctx, req, &res);
+        while (true) {
+            Fam_Dataitem_Response res;
+            ::grpc::ClientContext ctx;
 
-        if (status.ok()) {
+            ::grpc::Status status = stub->acquire_CAS_lock(&ctx, req, &res);
+
+            if (!status.ok()) {
+                throw Fam_Allocator_Exception(FAM_ERR_GRPC,
+                                              (status.error_message()).c_str());
+            }
             if (res.errorcode()) {
                 throw Fam_Allocator_Exception((enum Fam_Error)res.errorcode(),
                                               (res.errormsg()).c_str());
-            } else {
-                return;
             }
-        } else {
-            throw Fam_Allocator_Exception(FAM_ERR_GRPC,
-                                          (status.error_message()).c_str());
+            if (res.locked())
+                return;
+
+            usleep(backoff);
+            if (backoff < FAM_CAS_LOCK_MAX_BACKOFF_US)
+                backoff *= 2;
         }
     }
 
@@ -715,13 +1059,76 @@ class Fam_Rpc_Client {
     size_t get_addr_size() { return memServerFabricAddrSize; };
     char *get_addr() { return memServerFabricAddr; };
 
+    /*
+     * Latest metadata version seen in the replies of the memory server. It
+     * moves on with every change to its regions and data items.
+     */
+    uint64_t get_metadata_version() { return metadataVersion.load(); }
+
   private:
+    // Take the fabric address of the memory server from its start reply
+    void set_fabric_addr() {
+        memServerFabricAddrSize = startRes.addrnamelen();
+        memServerFabricAddr = (char *)calloc(1, memServerFabricAddrSize);
+
+        uint32_t lastBytes = 0;
+        int lastBytesCount = (int)(memServerFabricAddrSize % sizeof(uint32_t));
+        int readCount = startRes.addrname_size();
+
+        if (lastBytesCount > 0)
+            readCount -= 1;
+
+        for (int ndx = 0; ndx < readCount; ndx++) {
+            *((uint32_t *)memServerFabricAddr + ndx) = startRes.addrname(ndx);
+        }
+
+        if (lastBytesCount > 0) {
+            lastBytes = startRes.addrname(readCount);
+            memcpy(((uint32_t *)memServerFabricAddr + readCount), &lastBytes,
+                   lastBytesCount);
+        }
+        connected.store(true);
+    }
+
+    void update_metadata_version(uint64_t version) {
+        uint64_t current = metadataVersion.load();
+        while ((version > current) &&
+               !metadataVersion.compare_exchange_weak(current, version))
+            ;
+    }
+
+    /*
+     * Mark the copies whose response has already arrived as completed,
+     * without waiting for the others.
+     */
+    void poll_copy_completions() {
+        void *got_tag;
+        bool ok = false;
+        while (cq.AsyncNext(&got_tag, &ok,
+                            gpr_time_0(GPR_CLOCK_MONOTONIC)) ==
+               ::grpc::CompletionQueue::GOT_EVENT) {
+            Fam_Copy_Tag *tagCompleted = static_cast<Fam_Copy_Tag *>(got_tag);
+            if (tagCompleted)
+                tagCompleted->isCompleted = true;
+        }
+    }
+
     std::unique_ptr<Fam_Rpc::Stub> stub;
     uint32_t uid;
     uint32_t gid;
+    uint64_t lastCopyId;
+    boost::atomic_uint64_t metadataVersion;
 
     size_t memServerFabricAddrSize;
     char *memServerFabricAddr;
+    boost::atomic<bool> connected;
+
+    // State of the start signal sent by start_connect()
+    ::grpc::ClientContext startCtx;
+    Fam_Start_Response startRes;
+    ::grpc::Status startStatus;
+    std::unique_ptr<::grpc::ClientAsyncResponseReader<Fam_Start_Response>>
+        startReader;
 
     ::grpc::CompletionQueue cq;
 };
@@ -28,28 +28,180 @@
  *
  */
 #include "fam_rpc_service_impl.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <unistd.h>
+#include <vector>
 
 #define ADDR_SIZE 20
 
+// Number of server completion queues, each drained by its own thread
+#define FAM_RPC_DEFAULT_CQ_THREADS 4
+// Number of threads running long operations (copy, region create/destroy)
+#define FAM_RPC_DEFAULT_BULK_THREADS 2
+
 using namespace std;
 
 namespace openfam {
 
-typedef Fam_Rpc::WithAsyncMethod_copy<Fam_Rpc_Service_Impl> sType;
+/*
+ * State of one outstanding RPC. The completion queue threads only see this
+ * base class; tag pointers handed to gRPC are always Fam_Rpc_Call_Base *.
+ */
+class Fam_Rpc_Call_Base {
+  public:
+    virtual ~Fam_Rpc_Call_Base() {}
+    // Called from a completion queue thread when the tag is returned.
+    virtual void proceed(bool ok) = 0;
+    // Run the handler and send the response.
+    virtual void execute() = 0;
+};
+
+/*
+ * Fixed pool of threads that runs long operations, so that they never hold
+ * up a completion queue thread serving control-plane RPCs.
+ */
+class Fam_Rpc_Worker_Pool {
+  public:
+    Fam_Rpc_Worker_Pool(uint64_t numThreads) : stop(false) {
+        for (uint64_t i = 0; i < numThreads; i++)
+            workers.push_back(std::thread(&Fam_Rpc_Worker_Pool::run, this));
+    }
+
+    ~Fam_Rpc_Worker_Pool() { shutdown(); }
+
+    void submit(Fam_Rpc_Call_Base *call) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            pending.push_back(call);
+        }
+        cond.notify_one();
+    }
+
+    // Finish the queued calls and join the workers.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (stop)
+                return;
+            stop = true;
+        }
+        cond.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+  private:
+    void run() {
+        while (true) {
+            Fam_Rpc_Call_Base *call;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                cond.wait(guard, [this] { return stop || !pending.empty(); });
+                if (pending.empty())
+                    return;
+                call = pending.front();
+                pending.pop_front();
+            }
+            call->execute();
+        }
+    }
+
+    bool stop;
+    std::mutex lock;
+    std::condition_variable cond;
+    std::deque<Fam_Rpc_Call_Base *> pending;
+    std::vector<std::thread> workers;
+};
+
+/*
+ * Generic state machine for a unary RPC. The handler is the synchronous
+ * implementation in Fam_Rpc_Service_Impl; it is run inline on the completion
+ * queue thread, or on the worker pool when one is given.
+ */
+template <class Req, class Resp> class Fam_Rpc_Call : public Fam_Rpc_Call_Base {
+  public:
+    typedef void (Fam_Rpc::AsyncService::*Request_Fn)(
+        ServerContext *, Req *, ServerAsyncResponseWriter<Resp> *,
+        ::grpc::CompletionQueue *, ServerCompletionQueue *, void *);
+    typedef ::grpc::Status (Fam_Rpc_Service_Impl::*Handler_Fn)(
+        ServerContext *, const Req *, Resp *);
+
+    Fam_Rpc_Call(Fam_Rpc::AsyncService *service, Fam_Rpc_Service_Impl *impl,
+                 ServerCompletionQueue *cq, Fam_Rpc_Worker_Pool *pool,
+                 Request_Fn requestFn, Handler_Fn handler)
+        : service(service), impl(impl), cq(cq), pool(pool),
+          requestFn(requestFn), handler(handler), responder(&ctx),
+          status(PROCESS) {
+        // Ask gRPC for the next request of this method; "this" is the tag.
+        (service->*requestFn)(&ctx, &request, &responder, cq, cq, this);
+    }
+
+    void proceed(bool ok) {
+        if ((status == FINISH) || !ok) {
+            // Either the response went out, or the queue is shutting down.
+            delete this;
+            return;
+        }
+        // Keep one request of this method outstanding on this queue.
+        new Fam_Rpc_Call(service, impl, cq, pool, requestFn, handler);
+        if (pool)
+            pool->submit(this);
+        else
+            execute();
+    }
+
+    void execute() {
+        ::grpc::Status grpcStatus = (impl->*handler)(&ctx, &request, &response);
+        status = FINISH;
+        responder.Finish(response, grpcStatus, this);
+    }
+
+  private:
+    Fam_Rpc::AsyncService *service;
+    Fam_Rpc_Service_Impl *impl;
+    ServerCompletionQueue *cq;
+    Fam_Rpc_Worker_Pool *pool;
+    Request_Fn requestFn;
+    Handler_Fn handler;
+
+    ServerContext ctx;
+    Req request;
+    Resp response;
+    ServerAsyncResponseWriter<Resp> responder;
+
+    enum CallStatus { PROCESS, FINISH };
+    CallStatus status;
+};
 
 class Fam_Rpc_Server {
   public:
     Fam_Rpc_Server(uint64_t rpcPort, char *name, char *libfabricPort,
-                   char *provider)
-        : serverAddress(name), port(rpcPort) {
-        allocator = new Memserver_Allocator();
-        service = new sType();
+                   char *provider,
+                   uint64_t numCqThreads = FAM_RPC_DEFAULT_CQ_THREADS,
+                   uint64_t numBulkThreads = FAM_RPC_DEFAULT_BULK_THREADS,
+                   uint64_t numCopyThreads = MEMSERVER_DEFAULT_COPY_THREADS,
+                   bool regionMr = false, uint64_t maxMrs = 0,
+                   uint64_t slabMaxObjSize = 0, uint64_t numWarmHeaps = 0,
+                   uint64_t capacity = 0)
+        : serverAddress(name), port(rpcPort), numCqThreads(numCqThreads),
+          numBulkThreads(numBulkThreads), bulkPool(NULL) {
+        if (this->numCqThreads == 0)
+            this->numCqThreads = 1;
+        if (this->numBulkThreads == 0)
+            this->numBulkThreads = 1;
+        allocator = new Memserver_Allocator(numCopyThreads, slabMaxObjSize,
+                                            numWarmHeaps, capacity);
+        service = new Fam_Rpc_Service_Impl();
         service->rpc_service_initialize(name, libfabricPort, provider,
-                                        allocator);
+                                        allocator, regionMr, maxMrs);
     }
 
-    ~Fam_Rpc_Server() { delete service; }
+    ~Fam_Rpc_Server() {
+        delete bulkPool;
+        delete service;
+    }
 
     void rpc_server_finalize() { service->rpc_service_finalize(); }
 
@@ -62,13 +214,13 @@ class Fam_Rpc_Server {
         // Listen on the given address without any authentication mechanism.
         builder.AddListeningPort(serverAddress,
                                  grpc::InsecureServerCredentials());
-        // Register "service" as the instance through which we'll communicate
-        // with clients. In this case it corresponds to an *synchronous*
-        // service.
-        builder.RegisterService(service);
+        // Every RPC is served asynchronously through asyncService; the
+        // requests are handed to the methods of "service".
+        builder.RegisterService(&asyncService);
 
-        // Add completion queue
-        cq = builder.AddCompletionQueue();
+        // Add one completion queue per serving thread
+        for (uint64_t i = 0; i < numCqThreads; i++)
+            cqs.push_back(builder.AddCompletionQueue());
 
         // Finally assemble the server.
         server = builder.BuildAndStart();
@@ -76,126 +228,99 @@ class Fam_Rpc_Server {
         cout << "Server listening on " << serverAddress << endl;
 #endif
 
-        // Spawn a seperate thread to handle asynchronous service
-        std::thread async_service_handler(&Fam_Rpc_Server::HandleRpcs<sType>,
-                                          this, service, cq.get(), allocator);
+        bulkPool = new Fam_Rpc_Worker_Pool(numBulkThreads);
+
+        std::vector<std::thread> cqThreads;
+        for (auto &cq : cqs)
+            cqThreads.push_back(
+                std::thread(&Fam_Rpc_Server::HandleRpcs, this, cq.get()));
 
         server->Wait();
-        async_service_handler.join();
+
+        // The server is shut down once its calls, bulk ones included, are
+        // done; then the queues drain, so that no call can be handed to the
+        // pool after it stopped
+        for (auto &cq : cqs)
+            cq->Shutdown();
+        for (auto &cqThread : cqThreads)
+            cqThread.join();
+        bulkPool->shutdown();
     }
 
   private:
-    Memserver_Allocator *allocator;
-    class CallData {
-      public:
-        // Take in the "service" instance (in this case representing an
-        // asynchronous server) and the completion queue "cq" used for
-        // asynchronous communication with the gRPC runtime.
-        CallData(sType *service, ServerCompletionQueue *cq,
-                 Memserver_Allocator *memAlloc)
-            : ret(0), service(service), cq(cq), responder(&ctx),
-              status(CREATE) {
-            allocator = memAlloc;
-            // Invoke the serving logic right away.
-            Proceed();
-        }
+    template <class Svc, class Req, class Resp>
+    void serve(ServerCompletionQueue *cq,
+               void (Svc::*requestFn)(ServerContext *, Req *,
+                                      ServerAsyncResponseWriter<Resp> *,
+                                      ::grpc::CompletionQueue *,
+                                      ServerCompletionQueue *, void *),
+               ::grpc::Status (Fam_Rpc_Service_Impl::*handler)(
+                   ServerContext *, const Req *, Resp *),
+               Fam_Rpc_Worker_Pool *pool) {
+        new Fam_Rpc_Call<Req, Resp>(&asyncService, service, cq, pool,
+                                    requestFn, handler);
+    }
 
-        void Proceed() {
-            if (status == CREATE) {
-                // Make this instance progress to the PROCESS state.
-                status = PROCESS;
-                // As part of the initial CREATE state, we *request* that the
-                // system start processing copy requests. In this request,
-                // "this" acts are the tag uniquely identifying the request (so
-                // that different CallData instances can serve different
-                // requests concurrently), in this case the memory address of
-                // this CallData instance.
-                service->Requestcopy(&ctx, &request, &responder, cq, cq, this);
-            } else if (status == PROCESS) {
-                // Spawn a new CallData instance to serve new clients while we
-                // process the one for this CallData. The instance will
-                // deallocate itself as part of its FINISH state.
-
-                new CallData(service, cq, allocator);
-                // copy the data from source dataitem to target dataitem
-                grpcStatus = Status::OK;
-                try {
-                    ret = allocator->copy(
-                        request.regionid(), request.srcoffset(),
-                        request.srccopystart(), request.destoffset(),
-                        request.destcopystart(), request.uid(), request.gid(),
-                        (size_t)request.copysize());
-                } catch (Memserver_Exception &e) {
-                    response.set_errorcode(e.fam_error());
-                    response.set_errormsg(e.fam_error_msg());
-                    grpcStatus = Status::OK;
-                }
-
-                // And we are done! Let the gRPC runtime know we've finished,
-                // using the memory address of this instance as the uniquely
-                // identifying tag for the event.
-                status = FINISH;
-                responder.Finish(response, grpcStatus, this);
-            } else {
-                GPR_ASSERT(status == FINISH);
-                // Once in the FINISH state, deallocate ourselves (CallData).
-                delete this;
-            }
-        }
+    // Post one outstanding request of every method on the given queue.
+    // Long operations go to the bulk pool, everything else runs inline and
+    // must never block, as the queue has only one thread.
+    void serve_all(ServerCompletionQueue *cq) {
+        typedef Fam_Rpc::AsyncService AS;
+        typedef Fam_Rpc_Service_Impl SI;
+
+        serve(cq, &AS::Requestcreate_region, &SI::create_region, bulkPool);
+        serve(cq, &AS::Requestdestroy_region, &SI::destroy_region, bulkPool);
+        serve(cq, &AS::Requestresize_region, &SI::resize_region, bulkPool);
+        serve(cq, &AS::Requestset_region_growth, &SI::set_region_growth,
+              bulkPool);
+        serve(cq, &AS::Requestcopy, &SI::copy, bulkPool);
+        serve(cq, &AS::Requestcopy_progress, &SI::copy_progress, NULL);
+
+        serve(cq, &AS::Requestallocate, &SI::allocate, NULL);
+        serve(cq, &AS::Requestdeallocate, &SI::deallocate, NULL);
+        serve(cq, &AS::Requestchange_region_permission,
+              &SI::change_region_permission, NULL);
+        serve(cq, &AS::Requestchange_dataitem_permission,
+              &SI::change_dataitem_permission, NULL);
+        serve(cq, &AS::Requestlookup_region, &SI::lookup_region, NULL);
+        serve(cq, &AS::Requestlookup, &SI::lookup, NULL);
+        serve(cq, &AS::Requestallocate_batch, &SI::allocate_batch, NULL);
+        serve(cq, &AS::Requestdeallocate_batch, &SI::deallocate_batch, NULL);
+        serve(cq, &AS::Requestlookup_batch, &SI::lookup_batch, NULL);
+        serve(cq, &AS::Requestcheck_permission_get_region_info,
+              &SI::check_permission_get_region_info, NULL);
+        serve(cq, &AS::Requestcheck_permission_get_item_info,
+              &SI::check_permission_get_item_info, NULL);
+        serve(cq, &AS::Requestacquire_CAS_lock, &SI::acquire_CAS_lock, NULL);
+        serve(cq, &AS::Requestrelease_CAS_lock, &SI::release_CAS_lock, NULL);
+        serve(cq, &AS::Requestsignal_start, &SI::signal_start, NULL);
+        serve(cq, &AS::Requestget_memserver_info, &SI::get_memserver_info,
+              NULL);
+        serve(cq, &AS::Requestsignal_termination, &SI::signal_termination,
+              NULL);
+    }
 
-      private:
-        int ret;
-        ostringstream errString;
-        // The means of communication with the gRPC runtime for an asynchronous
-        // server.
-        sType *service;
-        // The producer-consumer queue where for asynchronous server
-        // notifications.
-        ServerCompletionQueue *cq;
-        // Context for the rpc, allowing to tweak aspects of it such as the use
-        // of compression, authentication, as well as to send metadata back to
-        // the client.
-        ServerContext ctx;
-
-        Memserver_Allocator *allocator;
-        // What we get from the client.
-        Fam_Copy_Request request;
-        // What we send back to the client.
-        Fam_Copy_Response response;
-
-        Status grpcStatus;
-        // The means to get back to the client.
-        ServerAsyncResponseWriter<Fam_Copy_Response> responder;
-
-        // Let's implement a tiny state machine with the following states.
-        enum CallStatus { CREATE, PROCESS, FINISH };
-        CallStatus status; // The current serving state.
-    };
-
-    // This can be run in multiple threads if needed.
-    template <class Service>
-    void HandleRpcs(Service *service, ServerCompletionQueue *cq,
-                    Memserver_Allocator *allocator) {
-        // Spawn a new CallData instance to serve new clients.
-        new CallData(service, cq, allocator);
+    // One instance runs per completion queue.
+    void HandleRpcs(ServerCompletionQueue *cq) {
+        serve_all(cq);
         void *tag; // uniquely identifies a request.
         bool ok;
-        while (true) {
-            // Block waiting to read the next event from the completion queue.
-            // The event is uniquely identified by its tag, which in this case
-            // is the memory address of a CallData instance. The return value of
-            // Next should always be checked. This return value tells us whether
-            // there is any kind of event or cq is shutting down.
-            GPR_ASSERT(cq->Next(&tag, &ok));
-            GPR_ASSERT(ok);
-            static_cast<CallData *>(tag)->Proceed();
+        // Next returns false once the queue is shut down and drained. The
+        // tag is always a Fam_Rpc_Call_Base, which decides what to do next.
+        while (cq->Next(&tag, &ok)) {
+            static_cast<Fam_Rpc_Call_Base *>(tag)->proceed(ok);
         }
     }
+
+    Memserver_Allocator *allocator;
     char *serverAddress;
     uint64_t port;
-    // Fam_Rpc_Service_Impl* sericeImpl;
-    std::unique_ptr<ServerCompletionQueue> cq;
-    sType *service;
+    uint64_t numCqThreads;
+    uint64_t numBulkThreads;
+    Fam_Rpc_Worker_Pool *bulkPool;
+    std::vector<std::unique_ptr<ServerCompletionQueue>> cqs;
+    Fam_Rpc::AsyncService asyncService;
+    Fam_Rpc_Service_Impl *service;
     std::unique_ptr<Server> server;
 };
 
@@ -28,6 +28,7 @@
  *
  */
 #include "fam_rpc_service_impl.h"
+#include <sys/time.h>
 #include <thread>
 #include <unistd.h>
 
@@ -44,12 +45,22 @@ void Fam_Rpc_Service_Impl::progress_thread() {
     }
 }
 void Fam_Rpc_Service_Impl::rpc_service_initialize(
-    char *name, char *service, char *provider, Memserver_Allocator *memAlloc) {
+    char *name, char *service, char *provider, Memserver_Allocator *memAlloc,
+    bool regionMr, uint64_t maxMrs) {
     ostringstream message;
     message << "Error while initializing RPC service : ";
     numClients = 0;
     shouldShutdown = false;
     allocator = memAlloc;
+    this->regionMr = regionMr;
+    // Start from the clock so that clients notice a restarted server: the
+    // seconds above the low 20 bits, the microseconds in them. A restart
+    // starts above every version handed out before, unless that run changed
+    // its metadata a million times a second.
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    metadataVersion.store(((uint64_t)now.tv_sec << 20) |
+                          (uint64_t)now.tv_usec);
     famOps =
         new Fam_Ops_Libfabric(name, service, true, provider,
                               FAM_THREAD_MULTIPLE, NULL, FAM_CONTEXT_DEFAULT);
@@ -63,14 +74,23 @@ void Fam_Rpc_Service_Impl::rpc_service_initialize(
         fi->domain_attr->data_progress == FI_PROGRESS_MANUAL) {
         libfabricProgressMode = FI_PROGRESS_MANUAL;
     }
+    // Clients drop cached keys of a memory server whose version moved on
+    mrRegistry = new Fam_Mr_Registry(
+        famOps->get_domain(), maxMrs,
+        [this]() { metadataVersion.fetch_add(1); });
+    // Clients learn that a region grown in the background changed; its
+    // registration stays, as for a resize
+    allocator->set_resize_hook(
+        [this](uint64_t regionId) { metadataVersion.fetch_add(1); });
     ret = register_fence_memory();
     if (ret < 0) {
         message << "Failed to register memory for fence operation";
         throw Memserver_Exception(FENCE_REG_FAILED, message.str().c_str());
     }
     for (int i = 0; i < CAS_LOCK_CNT; i++) {
-        (void)pthread_mutex_init(&casLock[i], NULL);
+        casLock[i].store(false);
     }
+    (void)pthread_mutex_init(&copyProgressLock, NULL);
     if (libfabricProgressMode == FI_PROGRESS_MANUAL) {
         haltProgress = false;
         progressThread =
@@ -81,9 +101,9 @@ void Fam_Rpc_Service_Impl::rpc_service_initialize(
 void Fam_Rpc_Service_Impl::rpc_service_finalize() {
     allocator->memserver_allocator_finalize();
     deregister_fence_memory();
-    for (int i = 0; i < CAS_LOCK_CNT; i++) {
-        (void)pthread_mutex_destroy(&casLock[i]);
-    }
+    (void)pthread_mutex_destroy(&copyProgressLock);
+    delete mrRegistry;
+    mrRegistry = NULL;
     famOps->finalize();
 }
 
@@ -120,6 +140,7 @@ Fam_Rpc_Service_Impl::signal_start(::grpc::ServerContext *context,
         memcpy(&lastBytes, ((uint32_t *)addr + count), lastBytesCount);
         response->add_addrname(lastBytes);
     }
+    response->set_keylease(mrRegistry->evicts());
 
     return ::grpc::Status::OK;
 }
@@ -132,15 +153,29 @@ Fam_Rpc_Service_Impl::signal_termination(::grpc::ServerContext *context,
     return ::grpc::Status::OK;
 }
 
+::grpc::Status Fam_Rpc_Service_Impl::get_memserver_info(
+    ::grpc::ServerContext *context, const ::Fam_Request *request,
+    ::Fam_Memserver_Info_Response *response) {
+    uint64_t capacity, used;
+
+    allocator->get_memserver_info(capacity, used);
+    response->set_capacity(capacity);
+    response->set_used(used);
+    return ::grpc::Status::OK;
+}
+
 ::grpc::Status
 Fam_Rpc_Service_Impl::create_region(::grpc::ServerContext *context,
                                     const ::Fam_Region_Request *request,
                                     ::Fam_Region_Response *response) {
     uint64_t regionId;
+    Fam_Stripe_Layout layout = {
+        request->stripesize(), request->stripecount(), request->stripeindex(),
+        (Fam_Redundancy_Level)request->redundancy()};
     try {
         allocator->create_region(
             request->name(), regionId, (size_t)request->size(),
-            (mode_t)request->perm(), request->uid(), request->gid());
+            (mode_t)request->perm(), request->uid(), request->gid(), layout);
     } catch (Memserver_Exception &e) {
         response->set_errorcode(e.fam_error());
         response->set_errormsg(e.fam_error_msg());
@@ -165,6 +200,14 @@ Fam_Rpc_Service_Impl::destroy_region(::grpc::ServerContext *context,
         response->set_errormsg(e.fam_error_msg());
         return ::grpc::Status::OK;
     }
+    response->set_version(metadataVersion.fetch_add(1) + 1);
+
+    if (regionMr && (deregister_region_memory(request->regionid()) < 0)) {
+        response->set_errorcode(FAM_ERR_RESOURCE);
+        response->set_errormsg("Error while destroying region : "
+                               "region deregistration failed");
+        return ::grpc::Status::OK;
+    }
 
     // Return status OK
     return ::grpc::Status::OK;
@@ -183,6 +226,10 @@ Fam_Rpc_Service_Impl::resize_region(::grpc::ServerContext *context,
         response->set_errormsg(e.fam_error_msg());
         return ::grpc::Status::OK;
     }
+    // The registration of the region keeps covering the bytes it was created
+    // with, so RMAs in flight are not disturbed; data items in the bytes
+    // added are registered on their own (see register_memory)
+    response->set_version(metadataVersion.fetch_add(1) + 1);
 
     // Return status OK
     return ::grpc::Status::OK;
@@ -277,6 +324,7 @@ Fam_Rpc_Service_Impl::deallocate(::grpc::ServerContext *context,
         response->set_errormsg(e.fam_error_msg());
         return ::grpc::Status::OK;
     }
+    response->set_version(metadataVersion.fetch_add(1) + 1);
 
     int ret = deregister_memory(request->regionid(), request->offset());
 
@@ -292,6 +340,23 @@ Fam_Rpc_Service_Impl::deallocate(::grpc::ServerContext *context,
     return ::grpc::Status::OK;
 }
 
+::grpc::Status Fam_Rpc_Service_Impl::set_region_growth(
+    ::grpc::ServerContext *context, const ::Fam_Region_Request *request,
+    ::Fam_Region_Response *response) {
+    try {
+        allocator->set_region_growth(request->regionid(), request->uid(),
+                                     request->gid(), request->size());
+    } catch (Memserver_Exception &e) {
+        response->set_errorcode(e.fam_error());
+        response->set_errormsg(e.fam_error_msg());
+        return ::grpc::Status::OK;
+    }
+    response->set_version(metadataVersion.fetch_add(1) + 1);
+
+    // Return status OK
+    return ::grpc::Status::OK;
+}
+
 ::grpc::Status Fam_Rpc_Service_Impl::change_region_permission(
     ::grpc::ServerContext *context, const ::Fam_Region_Request *request,
     ::Fam_Region_Response *response) {
@@ -304,6 +369,7 @@ Fam_Rpc_Service_Impl::deallocate(::grpc::ServerContext *context,
         response->set_errormsg(e.fam_error_msg());
         return ::grpc::Status::OK;
     }
+    response->set_version(metadataVersion.fetch_add(1) + 1);
 
     // Return status OK
     return ::grpc::Status::OK;
@@ -321,6 +387,7 @@ Fam_Rpc_Service_Impl::deallocate(::grpc::ServerContext *context,
         response->set_errormsg(e.fam_error_msg());
         return ::grpc::Status::OK;
     }
+    response->set_version(metadataVersion.fetch_add(1) + 1);
 
     // Return status OK
     return ::grpc::Status::OK;
@@ -332,6 +399,9 @@ Fam_Rpc_Service_Impl::lookup_region(::grpc::ServerContext *context,
                                     ::Fam_Region_Response *response) {
     ostringstream message;
     Fam_Region_Metadata region;
+    // Taken before reading the metadata, so that a change racing with this
+    // lookup always carries a newer version than the response
+    response->set_version(metadataVersion.load());
     try {
         allocator->get_region(request->name(), request->uid(), request->gid(),
                               region);
@@ -345,12 +415,14 @@ Fam_Rpc_Service_Impl::lookup_region(::grpc::ServerContext *context,
         response->set_regionid(region.regionId);
         response->set_offset(region.offset);
         response->set_size(region.size);
+        set_stripe_layout(region, response);
         return ::grpc::Status::OK;
     } else if (allocator->check_region_permission(region, 0, request->uid(),
                                                   request->gid())) {
         response->set_regionid(region.regionId);
         response->set_offset(region.offset);
         response->set_size(region.size);
+        set_stripe_layout(region, response);
         return ::grpc::Status::OK;
     } else {
         response->set_errorcode(FAM_ERR_NOPERM);
@@ -366,67 +438,215 @@ Fam_Rpc_Service_Impl::lookup(::grpc::ServerContext *context,
                              const ::Fam_Dataitem_Request *request,
                              ::Fam_Dataitem_Response *response) {
     Fam_DataItem_Metadata dataitem;
+    Fam_Region_Metadata region;
     ostringstream message;
+    response->set_version(metadataVersion.load());
     try {
         allocator->get_dataitem(request->name(), request->regionname(),
                                 request->uid(), request->gid(), dataitem);
+        allocator->get_region(dataitem.regionId, request->uid(),
+                              request->gid(), region);
     } catch (Memserver_Exception &e) {
         response->set_errorcode(e.fam_error());
         response->set_errormsg(e.fam_error_msg());
         return ::grpc::Status::OK;
     }
 
-    if (request->uid() == dataitem.uid) {
-        response->set_regionid(dataitem.regionId);
-        response->set_offset(dataitem.offset);
-        response->set_size(dataitem.size);
-        return ::grpc::Status::OK;
-    } else if (allocator->check_dataitem_permission(dataitem, 0, request->uid(),
-                                                    request->gid())) {
-        response->set_regionid(dataitem.regionId);
-        response->set_offset(dataitem.offset);
-        response->set_size(dataitem.size);
-        return ::grpc::Status::OK;
-    } else {
+    if ((request->uid() != dataitem.uid) &&
+        !allocator->check_dataitem_permission(dataitem, 0, request->uid(),
+                                              request->gid())) {
         response->set_errorcode(FAM_ERR_NOPERM);
         message << "Error while looking up for region : ";
         message << "Region access in not permitted";
         response->set_errormsg(message.str());
         return ::grpc::Status::OK;
     }
-    /*
-void *localPointer = 0;
-int ret;
-try {
-    ret = register_memory(dataitem, localPointer, request->uid(),
-                          request->gid(), key);
-}
-catch (Memserver_Exception &e) {
-    response->set_errorcode(e.fam_error());
-    response->set_errormsg(e.fam_error_msg());
+
+    // Register the data item now and hand out its key, so that the first
+    // access needs no check_permission_get_info round trip. If that fails,
+    // the key stays uninitialized and the first access reports the error.
+    uint64_t key = FAM_KEY_UNINITIALIZED;
+    int ret;
+    try {
+        ret = register_memory(dataitem, NULL, request->uid(), request->gid(),
+                              key);
+    } catch (Memserver_Exception &e) {
+        ret = ITEM_REGISTRATION_FAILED;
+    }
+    if (ret < 0)
+        key = FAM_KEY_UNINITIALIZED;
+
+    response->set_regionid(dataitem.regionId);
+    response->set_offset(dataitem.offset);
+    response->set_size(dataitem.size);
+    response->set_key(key);
+    set_stripe_layout(region, response);
+
+    // Return status OK
     return ::grpc::Status::OK;
 }
 
-if (ret < 0) {
-    if (ret == NOT_PERMITTED) {
-        response->set_errorcode(FAM_ERR_NOPERM);
-        message << "Error while looking up for dataitem : ";
-        message << "No permission, dataitem registration failed";
+::grpc::Status Fam_Rpc_Service_Impl::allocate_batch(
+    ::grpc::ServerContext *context,
+    const ::Fam_Dataitem_Batch_Request *request,
+    ::Fam_Dataitem_Batch_Response *response) {
+    ostringstream message;
+    vector<string> names(request->name().begin(), request->name().end());
+    vector<size_t> sizes(request->size().begin(), request->size().end());
+    vector<Fam_DataItem_Metadata> dataitems;
+    vector<void *> localPointers;
+    try {
+        allocator->allocate_batch(names, request->regionid(), sizes,
+                                  (mode_t)request->perm(), request->uid(),
+                                  request->gid(), dataitems, localPointers);
+    } catch (Memserver_Exception &e) {
+        response->set_errorcode(e.fam_error());
+        response->set_errormsg(e.fam_error_msg());
+        return ::grpc::Status::OK;
+    }
+
+    // Generate and register keys for datapath access
+    int ret = 0;
+    size_t i;
+    for (i = 0; i < dataitems.size(); i++) {
+        uint64_t key = 0;
+        try {
+            ret = register_memory(dataitems[i], localPointers[i],
+                                  request->uid(), request->gid(), key);
+        } catch (Memserver_Exception &) {
+            ret = ITEM_REGISTRATION_FAILED;
+        }
+        if (ret < 0)
+            break;
+        response->add_offset(dataitems[i].offset);
+        response->add_size(dataitems[i].size);
+        response->add_key(key);
+    }
+
+    if (ret < 0) {
+        // Undo the whole batch, so the client sees all or nothing
+        vector<uint64_t> offsets;
+        for (size_t j = 0; j < dataitems.size(); j++) {
+            if (j < i)
+                deregister_memory(request->regionid(), dataitems[j].offset);
+            offsets.push_back(dataitems[j].offset);
+        }
+        try {
+            allocator->deallocate_batch(request->regionid(), offsets,
+                                        request->uid(), request->gid());
+        } catch (Memserver_Exception &) {
+            // Best effort; the registration error is what gets reported
+        }
+        response->clear_offset();
+        response->clear_size();
+        response->clear_key();
+        message << "Error while allocating dataitems : ";
+        if (ret == NOT_PERMITTED) {
+            response->set_errorcode(FAM_ERR_NOPERM);
+            message << "No permission, dataitem registration failed";
+        } else {
+            response->set_errorcode(FAM_ERR_RESOURCE);
+            message << "dataitem registration failed";
+        }
         response->set_errormsg(message.str());
         return ::grpc::Status::OK;
-    } else {
+    }
+
+    response->set_regionid(request->regionid());
+
+    // Return status OK
+    return ::grpc::Status::OK;
+}
+
+::grpc::Status Fam_Rpc_Service_Impl::deallocate_batch(
+    ::grpc::ServerContext *context,
+    const ::Fam_Dataitem_Batch_Request *request,
+    ::Fam_Dataitem_Batch_Response *response) {
+    ostringstream message;
+    vector<uint64_t> offsets(request->offset().begin(),
+                             request->offset().end());
+    try {
+        allocator->deallocate_batch(request->regionid(), offsets,
+                                    request->uid(), request->gid());
+    } catch (Memserver_Exception &e) {
+        response->set_errorcode(e.fam_error());
+        response->set_errormsg(e.fam_error_msg());
+        return ::grpc::Status::OK;
+    }
+    response->set_version(metadataVersion.fetch_add(1) + 1);
+
+    int ret = 0;
+    for (auto offset : offsets) {
+        if (deregister_memory(request->regionid(), offset) < 0)
+            ret = ITEM_DEREGISTRATION_FAILED;
+    }
+
+    if (ret < 0) {
         response->set_errorcode(FAM_ERR_RESOURCE);
-        message << "Error while looking up for dataitem : ";
-        message << "dataitem registration failed";
+        message << "Error while deallocating dataitems : ";
+        message << "dataitem deregistration failed";
         response->set_errormsg(message.str());
         return ::grpc::Status::OK;
     }
+
+    // Return status OK
+    return ::grpc::Status::OK;
 }
-response->set_regionid(dataitem.regionId);
-response->set_offset(dataitem.offset);
-response->set_size(dataitem.size);
-response->set_key(key);
-    */
+
+::grpc::Status Fam_Rpc_Service_Impl::lookup_batch(
+    ::grpc::ServerContext *context,
+    const ::Fam_Dataitem_Batch_Request *request,
+    ::Fam_Dataitem_Batch_Response *response) {
+    ostringstream message;
+    vector<string> names(request->name().begin(), request->name().end());
+    vector<Fam_DataItem_Metadata> dataitems;
+    Fam_Region_Metadata region;
+    try {
+        allocator->get_dataitem_batch(names, request->regionname(),
+                                      request->uid(), request->gid(),
+                                      dataitems);
+        allocator->get_region(request->regionname(), request->uid(),
+                              request->gid(), region);
+    } catch (Memserver_Exception &e) {
+        response->set_errorcode(e.fam_error());
+        response->set_errormsg(e.fam_error_msg());
+        return ::grpc::Status::OK;
+    }
+
+    for (auto &dataitem : dataitems) {
+        if ((request->uid() != dataitem.uid) &&
+            !allocator->check_dataitem_permission(dataitem, 0, request->uid(),
+                                                  request->gid())) {
+            response->clear_offset();
+            response->clear_size();
+            response->clear_key();
+            response->set_errorcode(FAM_ERR_NOPERM);
+            message << "Error while looking up for dataitem : ";
+            message << "Dataitem access in not permitted";
+            response->set_errormsg(message.str());
+            return ::grpc::Status::OK;
+        }
+
+        // Keys are handed out as by lookup; a data item that cannot be
+        // registered gets an uninitialized key, reported on first access
+        uint64_t key = FAM_KEY_UNINITIALIZED;
+        int ret;
+        try {
+            ret = register_memory(dataitem, NULL, request->uid(),
+                                  request->gid(), key);
+        } catch (Memserver_Exception &e) {
+            ret = ITEM_REGISTRATION_FAILED;
+        }
+        if (ret < 0)
+            key = FAM_KEY_UNINITIALIZED;
+
+        response->set_regionid(dataitem.regionId);
+        response->add_offset(dataitem.offset);
+        response->add_size(dataitem.size);
+        response->add_key(key);
+    }
+    set_stripe_layout(region, response);
+
     // Return status OK
     return ::grpc::Status::OK;
 }
@@ -437,6 +657,7 @@ response->set_key(key);
 
     Fam_Region_Metadata region;
     ostringstream message;
+    response->set_version(metadataVersion.load());
     try {
         allocator->get_region(request->regionid(), request->uid(),
                               request->gid(), region);
@@ -467,6 +688,7 @@ response->set_key(key);
     Fam_DataItem_Metadata dataitem;
     uint64_t key;
     ostringstream message;
+    response->set_version(metadataVersion.load());
     try {
         allocator->get_dataitem(request->regionid(), request->offset(),
                                 request->uid(), request->gid(), dataitem);
@@ -516,9 +738,101 @@ response->set_key(key);
 ::grpc::Status Fam_Rpc_Service_Impl::copy(::grpc::ServerContext *context,
                                           const ::Fam_Copy_Request *request,
                                           ::Fam_Copy_Response *response) {
+    // Publish the progress of the copy for copy_progress requests
+    std::pair<string, uint64_t> copyKey(context->peer(), request->copyid());
+    boost::atomic_uint64_t progress(0);
+    pthread_mutex_lock(&copyProgressLock);
+    bool tracked = copyProgress.insert({copyKey, &progress}).second;
+    pthread_mutex_unlock(&copyProgressLock);
+
+    try {
+        if (request->destaddr().empty())
+            allocator->copy(request->regionid(), request->srcoffset(),
+                            request->srccopystart(), request->destregionid(),
+                            request->destoffset(), request->destcopystart(),
+                            request->uid(), request->gid(),
+                            (size_t)request->copysize(), &progress);
+        else
+            remote_copy(request, &progress);
+    } catch (Fam_Exception &e) {
+        response->set_errorcode(e.fam_error());
+        response->set_errormsg(e.fam_error_msg());
+    }
+
+    if (tracked) {
+        pthread_mutex_lock(&copyProgressLock);
+        copyProgress.erase(copyKey);
+        pthread_mutex_unlock(&copyProgressLock);
+    }
+    response->set_copied(progress.load());
+
+    // Return status OK
     return ::grpc::Status::OK;
 }
 
+::grpc::Status
+Fam_Rpc_Service_Impl::copy_progress(::grpc::ServerContext *context,
+                                    const ::Fam_Copy_Request *request,
+                                    ::Fam_Copy_Response *response) {
+    std::pair<string, uint64_t> copyKey(context->peer(), request->copyid());
+    pthread_mutex_lock(&copyProgressLock);
+    auto copy = copyProgress.find(copyKey);
+    if (copy != copyProgress.end()) {
+        response->set_inprogress(true);
+        response->set_copied(copy->second->load());
+    }
+    pthread_mutex_unlock(&copyProgressLock);
+
+    // Return status OK
+    return ::grpc::Status::OK;
+}
+
+/*
+ * Copy into a data item on another memory server. The source is read in place
+ * and written to the destination with RDMA writes using the key the client
+ * was given for it, so the destination server has already checked the write
+ * permission. Writes go out a window of chunks at a time on an endpoint of
+ * their own, and progress advances as each window completes.
+ */
+void Fam_Rpc_Service_Impl::remote_copy(const ::Fam_Copy_Request *request,
+                                       boost::atomic_uint64_t *progress) {
+    uint64_t nbytes = request->copysize();
+    char *srcStart = (char *)allocator->get_copy_source(
+        request->regionid(), request->srcoffset(), request->srccopystart(),
+        request->uid(), request->gid(), (size_t)nbytes);
+    fi_addr_t fiAddr = famOps->get_peer_fiAddr(request->destaddr().data(),
+                                               request->destaddr().size());
+    uint64_t destStart = request->destcopystart();
+    if (FAM_KEY_IS_REGION(request->destkey()))
+        destStart += request->destoffset();
+    Fam_Context *ctx = famOps->create_context();
+    uint64_t done = 0;
+
+    try {
+        while (done < nbytes) {
+            uint64_t windowEnd =
+                done + FAM_COPY_CHUNK_SIZE * FAM_COPY_PIPELINE_DEPTH;
+            if (windowEnd > nbytes)
+                windowEnd = nbytes;
+            for (uint64_t start = done; start < windowEnd;
+                 start += FAM_COPY_CHUNK_SIZE) {
+                uint64_t size = windowEnd - start;
+                if (size > FAM_COPY_CHUNK_SIZE)
+                    size = FAM_COPY_CHUNK_SIZE;
+                fabric_write_nonblocking(request->destkey(), srcStart + start,
+                                         size, destStart + start, fiAddr, ctx);
+            }
+            fabric_quiet(ctx);
+            progress->fetch_add(windowEnd - done);
+            done = windowEnd;
+        }
+    } catch (...) {
+        delete ctx;
+        throw;
+    }
+    delete ctx;
+}
+
 uint64_t Fam_Rpc_Service_Impl::generate_access_key(uint64_t regionId,
                                                    uint64_t dataitemId,
                                                    bool permission) {
@@ -534,8 +848,6 @@ uint64_t Fam_Rpc_Service_Impl::generate_access_key(uint64_t regionId,
 int Fam_Rpc_Service_Impl::register_fence_memory() {
 
     int ret;
-    fiMrs = famOps->get_fiMrs();
-    fid_mr *mr = 0;
     uint64_t key = FAM_FENCE_KEY;
     void *localPointer;
     size_t len = (size_t)sysconf(_SC_PAGESIZE);
@@ -547,20 +859,11 @@ int Fam_Rpc_Service_Impl::register_fence_memory() {
     }
 
     // register the memory location with libfabric
-    pthread_mutex_lock(famOps->get_mr_lock());
-    auto mrObj = fiMrs->find(key);
-    if (mrObj == fiMrs->end()) {
-        ret = fabric_register_mr(localPointer, len, &key, famOps->get_domain(),
-                                 1, mr);
-        if (ret < 0) {
-            pthread_mutex_unlock(famOps->get_mr_lock());
-            cout << "error: memory register failed" << endl;
-            return ITEM_REGISTRATION_FAILED;
-        }
-
-        fiMrs->insert({key, mr});
+    ret = mrRegistry->register_mr(key, localPointer, len, 1, true);
+    if (ret < 0) {
+        cout << "error: memory register failed" << endl;
+        return ITEM_REGISTRATION_FAILED;
     }
-    pthread_mutex_unlock(famOps->get_mr_lock());
     // Return status OK
     return 0;
 }
@@ -569,75 +872,108 @@ int Fam_Rpc_Service_Impl::register_memory(Fam_DataItem_Metadata dataitem,
                                           void *localPointer, uint32_t uid,
                                           uint32_t gid, uint64_t &key) {
     uint64_t dataitemId = dataitem.offset / MIN_OBJ_SIZE;
-    fiMrs = famOps->get_fiMrs();
-    fid_mr *mr = 0;
+    bool rw;
     int ret = 0;
+
+    if (allocator->check_dataitem_permission(dataitem, 1, uid, gid)) {
+        rw = 1;
+    } else if (allocator->check_dataitem_permission(dataitem, 0, uid, gid)) {
+        rw = 0;
+    } else {
+        cout << "error: Not permitted to register dataitem" << endl;
+        return NOT_PERMITTED;
+    }
+
+    // With region-wide registrations, the data item permissions decide
+    // whether the read-only or the read-write key of its region is handed
+    // out, and the client addresses the item at its offset in the region
+    if (regionMr && in_region_mr(dataitem))
+        return register_region_mr(dataitem.regionId, rw, key);
+
+    key = generate_access_key(dataitem.regionId, dataitemId, rw);
+    // Already registered, the common case, is answered without locking
+    if (mrRegistry->find(key))
+        return 0;
+
     if (!localPointer) {
         localPointer =
             allocator->get_local_pointer(dataitem.regionId, dataitem.offset);
     }
 
-    if (allocator->check_dataitem_permission(dataitem, 1, uid, gid)) {
-        key = generate_access_key(dataitem.regionId, dataitemId, 1);
-        // register the data item with required permission with libfabric
-        pthread_mutex_lock(famOps->get_mr_lock());
-        auto mrObj = fiMrs->find(key);
-        if (mrObj == fiMrs->end()) {
-            ret = fabric_register_mr(localPointer, dataitem.size, &key,
-                                     famOps->get_domain(), 1, mr);
-            if (ret < 0) {
-                pthread_mutex_unlock(famOps->get_mr_lock());
-                cout << "error: memory register failed" << endl;
-                return ITEM_REGISTRATION_FAILED;
-            }
+    // register the data item with required permission with libfabric
+    ret = mrRegistry->register_mr(key, localPointer, dataitem.size, rw);
+    if (ret < 0) {
+        cout << "error: memory register failed" << endl;
+        return ITEM_REGISTRATION_FAILED;
+    }
+    // Return status OK
+    return 0;
+}
 
-            fiMrs->insert({key, mr});
-        }
-        pthread_mutex_unlock(famOps->get_mr_lock());
-        // Return status OK
-        return 0;
-    } else if (allocator->check_dataitem_permission(dataitem, 0, uid, gid)) {
-        key = generate_access_key(dataitem.regionId, dataitemId, 0);
-        // register the data item with required permission with libfabric
-        pthread_mutex_lock(famOps->get_mr_lock());
-        auto mrObj = fiMrs->find(key);
-        if (mrObj == fiMrs->end()) {
-            ret = fabric_register_mr(localPointer, dataitem.size, &key,
-                                     famOps->get_domain(), 0, mr);
-            if (ret < 0) {
-                pthread_mutex_unlock(famOps->get_mr_lock());
-                cout << "error: memory register failed" << endl;
-                return ITEM_REGISTRATION_FAILED;
-            }
+/*
+ * Whether the region-wide registration covers the data item: it lies in the
+ * bytes the region was created with. The heap of a resized region is not
+ * one range of memory, so the bytes a resize adds are not part of it.
+ */
+bool Fam_Rpc_Service_Impl::in_region_mr(Fam_DataItem_Metadata &dataitem) {
+    Fam_Region_Metadata region;
+    allocator->get_region(dataitem.regionId, 0, 0, region);
+    return (dataitem.offset + dataitem.size <= region.baseSize);
+}
 
-            fiMrs->insert({key, mr});
-        }
-        pthread_mutex_unlock(famOps->get_mr_lock());
-        // Return status OK
+/*
+ * Register the heap of a region as created with the given access, unless it
+ * is registered already. It is never registered again, so RMAs through its
+ * key are not disturbed by a resize. Region registrations are pinned in the
+ * registry.
+ */
+int Fam_Rpc_Service_Impl::register_region_mr(uint64_t regionId, bool rw,
+                                             uint64_t &key) {
+    Fam_Region_Metadata region;
+    void *localPointer;
+    int ret;
+
+    key = generate_access_key(regionId, FAM_REGION_KEY_DATAITEMID, rw);
+    if (mrRegistry->find(key))
         return 0;
-    } else {
-        cout << "error: Not permitted to register dataitem" << endl;
-        return NOT_PERMITTED;
+
+    // NVMM maps the heap of a region as created as one range at offset 0
+    allocator->get_region(regionId, 0, 0, region);
+    localPointer = allocator->get_local_pointer(regionId, 0);
+    ret = mrRegistry->register_mr(key, localPointer, region.baseSize, rw, true);
+    if (ret < 0) {
+        cout << "error: memory register failed" << endl;
+        return ITEM_REGISTRATION_FAILED;
     }
+    return 0;
 }
 
-int Fam_Rpc_Service_Impl::deregister_fence_memory() {
-
+/*
+ * Drop the registrations of a region, when it is destroyed
+ */
+int Fam_Rpc_Service_Impl::deregister_region_memory(uint64_t regionId) {
     int ret = 0;
-    uint64_t key = FAM_FENCE_KEY;
-    pthread_mutex_lock(famOps->get_mr_lock());
-    auto mr = fiMrs->find(key);
-    if (mr != fiMrs->end()) {
-        ret = fabric_deregister_mr(mr->second);
+
+    for (int rw = 0; rw <= 1; rw++) {
+        uint64_t key =
+            generate_access_key(regionId, FAM_REGION_KEY_DATAITEMID, rw);
+        ret = mrRegistry->deregister_mr(key);
         if (ret < 0) {
-            pthread_mutex_unlock(famOps->get_mr_lock());
             cout << "error: memory deregister failed" << endl;
             return ITEM_DEREGISTRATION_FAILED;
         }
-        fiMrs->erase(mr);
     }
 
-    pthread_mutex_unlock(famOps->get_mr_lock());
+    return 0;
+}
+
+int Fam_Rpc_Service_Impl::deregister_fence_memory() {
+
+    int ret = mrRegistry->deregister_mr(FAM_FENCE_KEY);
+    if (ret < 0) {
+        cout << "error: memory deregister failed" << endl;
+        return ITEM_DEREGISTRATION_FAILED;
+    }
     return 0;
 }
 
@@ -648,30 +984,16 @@ int Fam_Rpc_Service_Impl::deregister_memory(uint64_t regionId,
     uint64_t rKey = generate_access_key(regionId, dataitemId, 0);
     uint64_t rwKey = generate_access_key(regionId, dataitemId, 1);
 
-    pthread_mutex_lock(famOps->get_mr_lock());
-    auto rMr = fiMrs->find(rKey);
-    auto rwMr = fiMrs->find(rwKey);
-    if (rMr != fiMrs->end()) {
-        ret = fabric_deregister_mr(rMr->second);
-        if (ret < 0) {
-            pthread_mutex_unlock(famOps->get_mr_lock());
-            cout << "error: memory deregister failed" << endl;
-            return ITEM_DEREGISTRATION_FAILED;
-        }
-        fiMrs->erase(rMr);
-    }
-
-    if (rwMr != fiMrs->end()) {
-        ret = fabric_deregister_mr(rwMr->second);
-        if (ret < 0) {
-            pthread_mutex_unlock(famOps->get_mr_lock());
-            cout << "error: memory deregister failed" << endl;
-            return ITEM_DEREGISTRATION_FAILED;
-        }
-        fiMrs->erase(rwMr);
+    // A region registration stays until the region is destroyed; data items
+    // it does not cover have their own, and a key that was not registered is
+    // not an error
+    ret = mrRegistry->deregister_mr(rKey);
+    if (ret == 0)
+        ret = mrRegistry->deregister_mr(rwKey);
+    if (ret < 0) {
+        cout << "error: memory deregister failed" << endl;
+        return ITEM_DEREGISTRATION_FAILED;
     }
-
-    pthread_mutex_unlock(famOps->get_mr_lock());
     return 0;
 }
 
@@ -680,7 +1002,11 @@ Fam_Rpc_Service_Impl::acquire_CAS_lock(::grpc::ServerContext *context,
                                        const ::Fam_Dataitem_Request *request,
                                        ::Fam_Dataitem_Response *response) {
     int idx = LOCKHASH(request->offset());
-    pthread_mutex_lock(&casLock[idx]);
+    bool held = false;
+    // A lock held by another client is not waited for here, where it would
+    // stop the queue serving its release; the client asks again
+    response->set_locked(casLock[idx].compare_exchange_strong(
+        held, true, boost::memory_order_acquire));
 
     // Return status OK
     return ::grpc::Status::OK;
@@ -691,7 +1017,7 @@ Fam_Rpc_Service_Impl::release_CAS_lock(::grpc::ServerContext *context,
                                        const ::Fam_Dataitem_Request *request,
                                        ::Fam_Dataitem_Response *response) {
     int idx = LOCKHASH(request->offset());
-    pthread_mutex_unlock(&casLock[idx]);
+    casLock[idx].store(false, boost::memory_order_release);
 
     // Return status OK
     return ::grpc::Status::OK;
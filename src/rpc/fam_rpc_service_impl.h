@@ -41,6 +41,7 @@
 #include "allocator/memserver_allocator.h"
 #include "allocator/rbtree.h"
 #include "metadata/fam_metadata_manager.h"
+#include "rpc/fam_mr_registry.h"
 #include "rpc/fam_rpc.grpc.pb.h"
 
 #include "common/fam_internal.h"
@@ -58,6 +59,8 @@ namespace openfam {
 #define ITEM_DEREGISTRATION_FAILED -5
 
 #define CAS_LOCK_CNT 128
+// Chunks of a copy to another memory server written before waiting on them
+#define FAM_COPY_PIPELINE_DEPTH 4
 #define LOCKHASH(offset) (offset >> 7) % CAS_LOCK_CNT
 
 using namespace std;
@@ -84,7 +87,8 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
     ~Fam_Rpc_Service_Impl();
 
     void rpc_service_initialize(char *name, char *service, char *provider,
-                                Memserver_Allocator *memAlloc);
+                                Memserver_Allocator *memAlloc,
+                                bool regionMr = false, uint64_t maxMrs = 0);
 
     void rpc_service_finalize();
 
@@ -96,6 +100,11 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
                                       const ::Fam_Request *request,
                                       ::Fam_Response *response) override;
 
+    ::grpc::Status
+    get_memserver_info(::grpc::ServerContext *context,
+                       const ::Fam_Request *request,
+                       ::Fam_Memserver_Info_Response *response) override;
+
     ::grpc::Status create_region(::grpc::ServerContext *context,
                                  const ::Fam_Region_Request *request,
                                  ::Fam_Region_Response *response) override;
@@ -108,6 +117,11 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
                                  const ::Fam_Region_Request *request,
                                  ::Fam_Region_Response *response) override;
 
+    ::grpc::Status
+    set_region_growth(::grpc::ServerContext *context,
+                      const ::Fam_Region_Request *request,
+                      ::Fam_Region_Response *response) override;
+
     ::grpc::Status allocate(::grpc::ServerContext *context,
                             const ::Fam_Dataitem_Request *request,
                             ::Fam_Dataitem_Response *response) override;
@@ -133,6 +147,21 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
                           const ::Fam_Dataitem_Request *request,
                           ::Fam_Dataitem_Response *response) override;
 
+    ::grpc::Status
+    allocate_batch(::grpc::ServerContext *context,
+                   const ::Fam_Dataitem_Batch_Request *request,
+                   ::Fam_Dataitem_Batch_Response *response) override;
+
+    ::grpc::Status
+    deallocate_batch(::grpc::ServerContext *context,
+                     const ::Fam_Dataitem_Batch_Request *request,
+                     ::Fam_Dataitem_Batch_Response *response) override;
+
+    ::grpc::Status
+    lookup_batch(::grpc::ServerContext *context,
+                 const ::Fam_Dataitem_Batch_Request *request,
+                 ::Fam_Dataitem_Batch_Response *response) override;
+
     ::grpc::Status
     check_permission_get_region_info(::grpc::ServerContext *context,
                                      const ::Fam_Region_Request *request,
@@ -147,6 +176,10 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
                         const ::Fam_Copy_Request *request,
                         ::Fam_Copy_Response *response) override;
 
+    ::grpc::Status copy_progress(::grpc::ServerContext *context,
+                                 const ::Fam_Copy_Request *request,
+                                 ::Fam_Copy_Response *response) override;
+
     ::grpc::Status acquire_CAS_lock(::grpc::ServerContext *context,
                                     const ::Fam_Dataitem_Request *request,
                                     ::Fam_Dataitem_Response *response) override;
@@ -159,6 +192,11 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
     uint64_t port;
     Memserver_Allocator *allocator;
     Fam_Ops_Libfabric *famOps;
+    // Register each region heap once instead of every data item
+    bool regionMr;
+    Fam_Mr_Registry *mrRegistry;
+    // Advanced on every change that may invalidate metadata cached by clients
+    boost::atomic_uint64_t metadataVersion;
     int libfabricProgressMode;
     std::thread progressThread;
     boost::atomic<bool> haltProgress;
@@ -166,21 +204,45 @@ class Fam_Rpc_Service_Impl : public Fam_Rpc::Service {
 
     int numClients;
     bool shouldShutdown;
-    pthread_mutex_t casLock[CAS_LOCK_CNT];
+    // Held by a client between acquire_CAS_lock and release_CAS_lock; not
+    // a mutex, as the completion queue threads serving them must not block
+    boost::atomic<bool> casLock[CAS_LOCK_CNT];
 
-    std::map<uint64_t, fid_mr *> *fiMrs;
+    // Bytes done by the copies in progress, keyed by client peer and copy id
+    std::map<std::pair<string, uint64_t>, boost::atomic_uint64_t *>
+        copyProgress;
+    pthread_mutex_t copyProgressLock;
 
     uint64_t generate_access_key(uint64_t regionId, uint64_t dataitemId,
                                  bool permission);
 
+    void remote_copy(const ::Fam_Copy_Request *request,
+                     boost::atomic_uint64_t *progress);
+
     int deregister_memory(uint64_t regionId, uint64_t offset);
 
     int register_memory(Fam_DataItem_Metadata dataitem, void *localPointer,
                         uint32_t uid, uint32_t gid, uint64_t &key);
 
+    bool in_region_mr(Fam_DataItem_Metadata &dataitem);
+
+    int register_region_mr(uint64_t regionId, bool rw, uint64_t &key);
+
+    int deregister_region_memory(uint64_t regionId);
+
     int register_fence_memory();
 
     int deregister_fence_memory();
+
+    // Copy the stripe layout of a region into a region or dataitem response
+    template <typename Response>
+    void set_stripe_layout(const Fam_Region_Metadata &region,
+                           Response *response) {
+        response->set_stripesize(region.stripeSize);
+        response->set_stripecount(region.stripeCount);
+        response->set_stripeindex(region.stripeIndex);
+        response->set_redundancy(region.redundancyLevel);
+    }
 };
 
 } // namespace openfam
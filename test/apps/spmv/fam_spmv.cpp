@@ -78,7 +78,9 @@ Fam_Region_Descriptor *spmv_fam_initialize(void) {
 char *spmv_fam_read(Fam_Descriptor *dataitem, uint64_t offset, uint64_t size) {
     char *local = NULL;
     try {
-        local = (char *)my_fam->fam_map(dataitem);
+        // CSR arrays are scanned end to end, fault them in up front
+        local = (char *)my_fam->fam_map(dataitem,
+                                        FAM_MAP_PREFAULT | FAM_MAP_HUGEPAGE);
     } catch (...) {
         cout << "fam map failed" << endl;
         return NULL;
@@ -77,6 +77,57 @@ TEST(FamAllocator, AllocatorSuccess) {
     free((void *)firstItem);
 }
 
+#define MERGE_REGION_SIZE (1UL << 20)
+// Larger than what slabs serve, so that the data items come from the heap
+#define MERGE_ITEM_SIZE (160UL << 10)
+#define MERGE_MAX_ITEMS 16
+
+// Test case 2 - space freed in small data items is allocated again as one
+// large data item. That only succeeds once the free space is merged, and
+// less was freed than merges the heap in the background, so the allocation
+// has to wait for a merge of its region.
+TEST(FamAllocator, ReallocateAfterMergeSuccess) {
+    Fam_Region_Descriptor *desc;
+    Fam_Descriptor *item[MERGE_MAX_ITEMS];
+    Fam_Descriptor *largeItem;
+    const char *testRegion = get_uniq_str("test", my_fam);
+
+    EXPECT_NO_THROW(desc = my_fam->fam_create_region(
+                        testRegion, MERGE_REGION_SIZE, 0777, NONE));
+    EXPECT_NE((void *)NULL, desc);
+
+    // Fill the region
+    int numItems = 0;
+    while (numItems < MERGE_MAX_ITEMS) {
+        try {
+            item[numItems] =
+                my_fam->fam_allocate(MERGE_ITEM_SIZE, 0777, desc);
+        } catch (Fam_Exception &e) {
+            break;
+        }
+        numItems++;
+    }
+    EXPECT_LE(2, numItems);
+    EXPECT_GT(MERGE_MAX_ITEMS, numItems);
+
+    for (int i = 0; i < numItems; i++) {
+        EXPECT_NO_THROW(my_fam->fam_deallocate(item[i]));
+        delete item[i];
+    }
+
+    EXPECT_NO_THROW(largeItem =
+                        my_fam->fam_allocate(2 * MERGE_ITEM_SIZE, 0777, desc));
+    EXPECT_NE((void *)NULL, largeItem);
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(largeItem));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+
+    delete largeItem;
+    delete desc;
+
+    free((void *)testRegion);
+}
+
 int main(int argc, char **argv) {
     int ret;
     ::testing::InitGoogleTest(&argc, argv);
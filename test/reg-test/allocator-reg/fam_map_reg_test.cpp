@@ -84,6 +84,95 @@ TEST(FamPutGet, PutGetSuccess) {
     free((void *)firstItem);
 }
 
+#define MAP_ITEM_SIZE 65536
+
+// Test case 2 - each map flag, and all of them together, give a mapping
+// through which the data item can be written and read back.
+TEST(FamMap, MapFlagsSuccess) {
+    Fam_Region_Descriptor *desc;
+    Fam_Descriptor *item;
+    const char *testRegion = get_uniq_str("test", my_fam);
+    const char *firstItem = get_uniq_str("first", my_fam);
+    uint32_t flags[] = {FAM_MAP_DEFAULT,
+                        FAM_MAP_PREFAULT,
+                        FAM_MAP_HUGEPAGE,
+                        FAM_MAP_SEQUENTIAL,
+                        FAM_MAP_RANDOM,
+                        FAM_MAP_PREFAULT | FAM_MAP_HUGEPAGE |
+                            FAM_MAP_SEQUENTIAL};
+    char *local = (char *)malloc(MAP_ITEM_SIZE);
+    char *back = (char *)malloc(MAP_ITEM_SIZE);
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 1048576, 0777, NONE));
+    ASSERT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(
+        item = my_fam->fam_allocate(firstItem, MAP_ITEM_SIZE, 0777, desc));
+    ASSERT_NE((void *)NULL, item);
+
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        void *base = NULL;
+        EXPECT_NO_THROW(base = my_fam->fam_map(item, flags[i]));
+        ASSERT_NE((void *)NULL, base);
+
+        memset(local, 'a' + (int)i, MAP_ITEM_SIZE);
+        memcpy(base, local, MAP_ITEM_SIZE);
+        EXPECT_NO_THROW(my_fam->fam_get_blocking(back, item, 0, MAP_ITEM_SIZE));
+        EXPECT_EQ(0, memcmp(local, back, MAP_ITEM_SIZE));
+
+        EXPECT_NO_THROW(my_fam->fam_unmap(base, item));
+    }
+
+    // A read-only data item is prefaulted for reading, and holds what was
+    // written before
+    EXPECT_NO_THROW(my_fam->fam_change_permissions(item, 0444));
+    void *base = NULL;
+    EXPECT_NO_THROW(base = my_fam->fam_map(item, FAM_MAP_PREFAULT |
+                                                     FAM_MAP_SEQUENTIAL));
+    ASSERT_NE((void *)NULL, base);
+    EXPECT_EQ(0, memcmp(local, base, MAP_ITEM_SIZE));
+    EXPECT_NO_THROW(my_fam->fam_unmap(base, item));
+    EXPECT_NO_THROW(my_fam->fam_change_permissions(item, 0777));
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+
+    delete item;
+    delete desc;
+    free(local);
+    free(back);
+    free((void *)testRegion);
+    free((void *)firstItem);
+}
+
+// Test case 3 - mapping a data item that was deallocated fails, whatever
+// the flags.
+TEST(FamMap, MapDeallocatedFailure) {
+    Fam_Region_Descriptor *desc;
+    Fam_Descriptor *item;
+    const char *testRegion = get_uniq_str("test", my_fam);
+    const char *firstItem = get_uniq_str("first", my_fam);
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 1048576, 0777, NONE));
+    ASSERT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(
+        item = my_fam->fam_allocate(firstItem, MAP_ITEM_SIZE, 0777, desc));
+    ASSERT_NE((void *)NULL, item);
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+
+    EXPECT_THROW(my_fam->fam_map(item, FAM_MAP_DEFAULT), Fam_Exception);
+    EXPECT_THROW(my_fam->fam_map(item, FAM_MAP_PREFAULT | FAM_MAP_HUGEPAGE),
+                 Fam_Exception);
+
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+
+    delete item;
+    delete desc;
+    free((void *)testRegion);
+    free((void *)firstItem);
+}
+
 int main(int argc, char **argv) {
     int ret;
     ::testing::InitGoogleTest(&argc, argv);
@@ -30,6 +30,7 @@
 #include <fam/fam_exception.h>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -263,7 +264,88 @@ TEST(FamResize, MultiPeAllocationResizeSuccess) {
     free((void *)secondItem);
 }
 
-// Test case 5 - trying to resize a region which has only read permission
+#define RMA_ITEM_SIZE 4096
+#define RMA_ROUNDS 200
+
+typedef struct {
+    Fam_Descriptor *item;
+    int errors;
+} RmaInfo;
+
+// Puts and gets on a data item, each round with its own pattern
+void *famRmaLoop(void *arg) {
+    RmaInfo *info = (RmaInfo *)arg;
+    char *local = new char[RMA_ITEM_SIZE];
+    char *back = new char[RMA_ITEM_SIZE];
+
+    for (int i = 0; i < RMA_ROUNDS; i++) {
+        memset(local, 'a' + (i % 26), RMA_ITEM_SIZE);
+        try {
+            my_fam->fam_put_blocking(local, info->item, 0, RMA_ITEM_SIZE);
+            my_fam->fam_get_blocking(back, info->item, 0, RMA_ITEM_SIZE);
+            if (memcmp(local, back, RMA_ITEM_SIZE) != 0)
+                info->errors++;
+        } catch (Fam_Exception &e) {
+            info->errors++;
+        }
+    }
+
+    delete[] local;
+    delete[] back;
+    pthread_exit(NULL);
+}
+
+// Test case 5 - RMAs to a data item carry on while its region is resized,
+// and data items in the space added hold their data.
+TEST(FamResize, ResizeDuringRmaSuccess) {
+    Fam_Region_Descriptor *desc;
+    Fam_Descriptor *item = NULL;
+    Fam_Descriptor *added = NULL;
+    const char *testRegion = get_uniq_str("test1", my_fam);
+    pthread_t thr;
+    RmaInfo info;
+    char *local = new char[RMA_ITEM_SIZE];
+    char *back = new char[RMA_ITEM_SIZE];
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 8192, 0777, NONE));
+    ASSERT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(item = my_fam->fam_allocate(RMA_ITEM_SIZE, 0777, desc));
+    ASSERT_NE((void *)NULL, item);
+
+    info.item = item;
+    info.errors = 0;
+    ASSERT_EQ(0, pthread_create(&thr, NULL, famRmaLoop, &info));
+    for (uint64_t size = 16384; size <= 1048576; size *= 2)
+        EXPECT_NO_THROW(my_fam->fam_resize_region(desc, size));
+    pthread_join(thr, NULL);
+    EXPECT_EQ(0, info.errors);
+
+    // The region started too small for this data item
+    EXPECT_NO_THROW(added = my_fam->fam_allocate(524288, 0777, desc));
+    ASSERT_NE((void *)NULL, added);
+    memset(local, 'z', RMA_ITEM_SIZE);
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, added,
+                                             524288 - RMA_ITEM_SIZE,
+                                             RMA_ITEM_SIZE));
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, added,
+                                             524288 - RMA_ITEM_SIZE,
+                                             RMA_ITEM_SIZE));
+    EXPECT_EQ(0, memcmp(local, back, RMA_ITEM_SIZE));
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(added));
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+
+    delete added;
+    delete item;
+    delete desc;
+    delete[] local;
+    delete[] back;
+    free((void *)testRegion);
+}
+
+// Test case 6 - trying to resize a region which has only read permission
 // and expect resize to fail.
 TEST(FamResize, ResizeNoPerm) {
     Fam_Region_Descriptor *desc;
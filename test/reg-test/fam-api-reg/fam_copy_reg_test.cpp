@@ -203,6 +203,178 @@ TEST(FamCopy, CopyFailLenOutOfRange) {
     free((void *)firstItem);
 }
 
+// Test case 5 - fam_copy into an existing data item, partial range (success).
+TEST(FamCopy, CopyToExistingSuccess) {
+    Fam_Region_Descriptor *desc;
+    Fam_Descriptor *item, *dest;
+    char *local = strdup("Test message");
+    const char *testRegion = get_uniq_str("test", my_fam);
+    const char *firstItem = get_uniq_str("first", my_fam);
+    const char *secondItem = get_uniq_str("second", my_fam);
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 8192, 0777, RAID1));
+    EXPECT_NE((void *)NULL, desc);
+
+    // Allocating data items in the created region
+    EXPECT_NO_THROW(item = my_fam->fam_allocate(firstItem, 128, 0777, desc));
+    EXPECT_NE((void *)NULL, item);
+    EXPECT_NO_THROW(dest = my_fam->fam_allocate(secondItem, 64, 0777, desc));
+    EXPECT_NE((void *)NULL, dest);
+
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, 13));
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, dest, 0, 13));
+
+    // Copy "message" over "Test" at the start of the smaller destination
+    void *waitObj;
+    EXPECT_NO_THROW(waitObj = my_fam->fam_copy(item, 5, dest, 0, 4));
+    EXPECT_NE((void *)NULL, waitObj);
+    EXPECT_NO_THROW(my_fam->fam_copy_wait(waitObj));
+
+    char *local2 = (char *)malloc(20);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(local2, dest, 0, 13));
+    EXPECT_STREQ("mess message", local2);
+
+    // Range beyond the end of the destination is rejected
+    EXPECT_THROW(my_fam->fam_copy(item, 0, dest, 60, 13),
+                 Fam_Allocator_Exception);
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(dest));
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+
+    delete dest;
+    delete item;
+    delete desc;
+
+    free(local2);
+    free((void *)testRegion);
+    free((void *)firstItem);
+    free((void *)secondItem);
+}
+
+// Test case 6 - copy spanning several chunks, with progress (success).
+TEST(FamCopy, CopyLargeWithProgressSuccess) {
+    Fam_Region_Descriptor *desc;
+    Fam_Descriptor *item, *dest;
+    uint64_t itemSize = (20UL << 20) + 100;
+    const char *testRegion = get_uniq_str("test", my_fam);
+    const char *firstItem = get_uniq_str("first", my_fam);
+    const char *secondItem = get_uniq_str("second", my_fam);
+
+    EXPECT_NO_THROW(desc = my_fam->fam_create_region(testRegion, 64UL << 20,
+                                                     0777, RAID1));
+    EXPECT_NE((void *)NULL, desc);
+
+    EXPECT_NO_THROW(item =
+                        my_fam->fam_allocate(firstItem, itemSize, 0777, desc));
+    EXPECT_NE((void *)NULL, item);
+    EXPECT_NO_THROW(dest =
+                        my_fam->fam_allocate(secondItem, itemSize, 0777, desc));
+    EXPECT_NE((void *)NULL, dest);
+
+    char *local = (char *)malloc(itemSize);
+    for (uint64_t i = 0; i < itemSize; i++)
+        local[i] = (char)(i % 251);
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, itemSize));
+
+    void *waitObj;
+    uint64_t progress = 0;
+    EXPECT_NO_THROW(waitObj = my_fam->fam_copy(item, 0, dest, 0, itemSize));
+    EXPECT_NE((void *)NULL, waitObj);
+    EXPECT_NO_THROW(progress = my_fam->fam_copy_progress(waitObj));
+    EXPECT_LE(progress, itemSize);
+    EXPECT_NO_THROW(my_fam->fam_copy_wait(waitObj));
+
+    char *local2 = (char *)malloc(itemSize);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(local2, dest, 0, itemSize));
+    EXPECT_EQ(0, memcmp(local, local2, itemSize));
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(dest));
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+
+    delete dest;
+    delete item;
+    delete desc;
+
+    free(local);
+    free(local2);
+    free((void *)testRegion);
+    free((void *)firstItem);
+    free((void *)secondItem);
+}
+
+// Test case 7 - copy between data items on different memory servers
+// (success).
+TEST(FamCopy, CopyAcrossMemoryServersSuccess) {
+    Fam_Region_Descriptor *srcRegion, *destRegion;
+    Fam_Descriptor *item, *dest;
+    uint64_t itemSize = (20UL << 20) + 100;
+    const char *firstRegion = get_uniq_str("test_src", my_fam);
+    const char *secondRegion = get_uniq_str("test_dest", my_fam);
+    const char *firstItem = get_uniq_str("first", my_fam);
+    const char *secondItem = get_uniq_str("second", my_fam);
+
+    if (get_memserver_count(my_fam) < 2) {
+        GTEST_SKIP();
+    }
+
+    EXPECT_NO_THROW(srcRegion = my_fam->fam_create_region_on(
+                        firstRegion, 64UL << 20, 0777, NONE, 0));
+    EXPECT_NE((void *)NULL, srcRegion);
+    EXPECT_NO_THROW(destRegion = my_fam->fam_create_region_on(
+                        secondRegion, 64UL << 20, 0777, NONE, 1));
+    EXPECT_NE((void *)NULL, destRegion);
+
+    EXPECT_NO_THROW(
+        item = my_fam->fam_allocate(firstItem, itemSize, 0777, srcRegion));
+    EXPECT_NE((void *)NULL, item);
+    EXPECT_NO_THROW(
+        dest = my_fam->fam_allocate(secondItem, itemSize, 0777, destRegion));
+    EXPECT_NE((void *)NULL, dest);
+    EXPECT_NE(item->get_memserver_id(), dest->get_memserver_id());
+
+    char *local = (char *)malloc(itemSize);
+    for (uint64_t i = 0; i < itemSize; i++)
+        local[i] = (char)(i % 251);
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, itemSize));
+
+    // The whole item, over several pipelined writes
+    void *waitObj;
+    EXPECT_NO_THROW(waitObj = my_fam->fam_copy(item, 0, dest, 0, itemSize));
+    EXPECT_NE((void *)NULL, waitObj);
+    EXPECT_NO_THROW(my_fam->fam_copy_wait(waitObj));
+
+    char *local2 = (char *)malloc(itemSize);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(local2, dest, 0, itemSize));
+    EXPECT_EQ(0, memcmp(local, local2, itemSize));
+
+    // An unaligned range, back from the destination server
+    EXPECT_NO_THROW(waitObj = my_fam->fam_copy(dest, 13, item, 7, 4099));
+    EXPECT_NO_THROW(my_fam->fam_copy_wait(waitObj));
+    memmove(local + 7, local + 13, 4099);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(local2, item, 0, itemSize));
+    EXPECT_EQ(0, memcmp(local, local2, itemSize));
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(dest));
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(destRegion));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(srcRegion));
+
+    delete dest;
+    delete item;
+    delete destRegion;
+    delete srcRegion;
+
+    free(local);
+    free(local2);
+    free((void *)firstRegion);
+    free((void *)secondRegion);
+    free((void *)firstItem);
+    free((void *)secondItem);
+}
+
 int main(int argc, char **argv) {
     int ret;
     ::testing::InitGoogleTest(&argc, argv);
@@ -30,6 +30,7 @@
 #include <fam/fam_exception.h>
 #include <gtest/gtest.h>
 #include <iostream>
+#include <set>
 #include <stdio.h>
 #include <string.h>
 
@@ -212,6 +213,363 @@ TEST(FamMMTest, FamAllocateUnnamedItemSuccess) {
     free((void *)testRegion);
 }
 
+TEST(FamMMTest, FamAllocateLookupDeallocateBatchSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Descriptor *items[4];
+    Fam_Descriptor *found[4];
+    uint64_t sizes[4] = {1024, 2048, 4096, 8192};
+    const char *names[4];
+    const char *testRegion = get_uniq_str("mm_test", my_fam);
+
+    for (int i = 0; i < 4; i++)
+        names[i] = get_uniq_str(("mm_batch" + to_string(i)).c_str(), my_fam);
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 1048576, 0777, RAID1));
+    EXPECT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(
+        my_fam->fam_allocate_batch(names, sizes, 0777, desc, 4, items));
+    EXPECT_NO_THROW(my_fam->fam_lookup_batch(names, testRegion, 4, found));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(sizes[i], found[i]->get_size());
+        EXPECT_EQ(items[i]->get_global_descriptor().offset,
+                  found[i]->get_global_descriptor().offset);
+        delete found[i];
+    }
+
+    // A duplicate name fails the whole batch and allocates nothing
+    EXPECT_THROW(my_fam->fam_allocate_batch(names, sizes, 0777, desc, 4, found),
+                 Fam_Allocator_Exception);
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate_batch(items, 4));
+    EXPECT_THROW(my_fam->fam_lookup_batch(names, testRegion, 4, found),
+                 Fam_Allocator_Exception);
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete desc;
+    for (int i = 0; i < 4; i++) {
+        delete items[i];
+        free((void *)names[i]);
+    }
+    free((void *)testRegion);
+}
+
+TEST(FamMMTest, FamCreateRegionOnLookupSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Region_Descriptor *found = NULL;
+    const char *testRegion = get_uniq_str("mm_test", my_fam);
+
+    EXPECT_NO_THROW(desc = my_fam->fam_create_region_on(testRegion, 1048576,
+                                                        0777, RAID1, 0));
+    EXPECT_NE((void *)NULL, desc);
+    EXPECT_EQ((uint64_t)0, desc->get_memserver_id());
+
+    // Found by name wherever the placement policy would have put it
+    EXPECT_NO_THROW(found = my_fam->fam_lookup_region(testRegion));
+    EXPECT_EQ(desc->get_global_descriptor().regionId,
+              found->get_global_descriptor().regionId);
+    delete found;
+
+    EXPECT_THROW(my_fam->fam_create_region(testRegion, 1048576, 0777, RAID1),
+                 Fam_Allocator_Exception);
+    EXPECT_THROW(
+        my_fam->fam_create_region_on(testRegion, 1048576, 0777, RAID1, 1024),
+        Fam_InvalidOption_Exception);
+
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete desc;
+    free((void *)testRegion);
+}
+
+TEST(FamMMTest, FamCreateRegionStripedSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Region_Descriptor *found = NULL;
+    Fam_Descriptor *item = NULL;
+    const char *testRegion = get_uniq_str("mm_test", my_fam);
+    const char *testItem = get_uniq_str("mm_striped", my_fam);
+    char local[12288];
+    char back[12288];
+
+    EXPECT_THROW(my_fam->fam_create_region_striped(testRegion, 1048576, 0777,
+                                                   NONE, 0, 4096),
+                 Fam_InvalidOption_Exception);
+    EXPECT_THROW(my_fam->fam_create_region_striped(testRegion, 1048576, 0777,
+                                                   NONE, 1, 5000),
+                 Fam_InvalidOption_Exception);
+    EXPECT_THROW(my_fam->fam_create_region_striped(testRegion, 1048576, 0777,
+                                                   RAID1, 1, 4096),
+                 Fam_InvalidOption_Exception);
+    EXPECT_THROW(my_fam->fam_create_region_striped(testRegion, 1048576, 0777,
+                                                   RAID5, 1, 4096),
+                 Fam_InvalidOption_Exception);
+    EXPECT_NO_THROW(desc = my_fam->fam_create_region_striped(
+                        testRegion, 1048576, 0777, NONE, 1, 4096));
+    EXPECT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(found = my_fam->fam_lookup_region(testRegion));
+    EXPECT_EQ(desc->get_global_descriptor().regionId,
+              found->get_global_descriptor().regionId);
+    delete found;
+
+    EXPECT_NO_THROW(item = my_fam->fam_allocate(testItem, sizeof(local), 0777,
+                                                desc));
+    EXPECT_NE((void *)NULL, item);
+    for (uint64_t i = 0; i < sizeof(local); i++)
+        local[i] = (char)i;
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, sizeof(local)));
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, item, 0, sizeof(back)));
+    EXPECT_EQ(0, memcmp(local, back, sizeof(local)));
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete item;
+    delete desc;
+    free((void *)testRegion);
+    free((void *)testItem);
+}
+
+#define STRIPE_SIZE 4096
+
+TEST(FamMMTest, FamCreateRegionStripedAcrossServersSuccess) {
+    uint64_t stripeCount = get_memserver_count(my_fam);
+    if (stripeCount < 2) {
+        GTEST_SKIP();
+    }
+
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Descriptor *item = NULL;
+    const char *testRegion = get_uniq_str("mm_test", my_fam);
+    const char *testItem = get_uniq_str("mm_striped", my_fam);
+    // Three rounds of stripes over all members and a short last stripe
+    uint64_t nbytes = 3 * stripeCount * STRIPE_SIZE + 100;
+    char *local = new char[nbytes];
+    char *back = new char[nbytes];
+
+    EXPECT_NO_THROW(desc = my_fam->fam_create_region_striped(
+                        testRegion, 1048576, 0777, NONE, stripeCount,
+                        STRIPE_SIZE));
+    EXPECT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(item = my_fam->fam_allocate(testItem, nbytes, 0777, desc));
+    EXPECT_NE((void *)NULL, item);
+    EXPECT_EQ(nbytes, item->get_size());
+
+    for (uint64_t i = 0; i < nbytes; i++)
+        local[i] = (char)(i % 251);
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, nbytes));
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, item, 0, nbytes));
+    EXPECT_EQ(0, memcmp(local, back, nbytes));
+
+    // A put and a get starting and ending within stripes
+    for (uint64_t i = 4000; i < 4000 + 2 * STRIPE_SIZE; i++)
+        local[i] = (char)(i % 13);
+    EXPECT_NO_THROW(
+        my_fam->fam_put_blocking(local + 4000, item, 4000, 2 * STRIPE_SIZE));
+    memset(back, 0, nbytes);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back + 10, item, 10, nbytes - 20));
+    EXPECT_EQ(0, memcmp(local + 10, back + 10, nbytes - 20));
+
+    // Stripe i of the data item is the first stripe of member i, each member
+    // on a memory server of its own
+    std::set<uint64_t> memservers;
+    for (uint64_t i = 0; i < stripeCount; i++) {
+        Fam_Descriptor *member = item->get_stripe(i);
+        ASSERT_NE((void *)NULL, member);
+        memservers.insert(member->get_memserver_id());
+        EXPECT_NO_THROW(my_fam->fam_get_blocking(back, member, 0, STRIPE_SIZE));
+        EXPECT_EQ(0, memcmp(local + i * STRIPE_SIZE, back, STRIPE_SIZE));
+    }
+    EXPECT_EQ(stripeCount, memservers.size());
+
+    // Exported with all members, the data item and region come back whole
+    Fam_Exported_Descriptor exported;
+    Fam_Descriptor *imported = NULL;
+    Fam_Region_Descriptor *region = NULL;
+    EXPECT_NO_THROW(my_fam->fam_export(item, &exported));
+    EXPECT_NO_THROW(imported = my_fam->fam_import(&exported));
+    ASSERT_NE((void *)NULL, imported);
+    EXPECT_EQ(nbytes, imported->get_size());
+    EXPECT_EQ(stripeCount, (uint64_t)imported->get_layout().stripeCount);
+    for (uint64_t i = 0; i < stripeCount; i++) {
+        EXPECT_EQ(item->get_stripe(i)->get_global_descriptor().regionId,
+                  imported->get_stripe(i)->get_global_descriptor().regionId);
+        EXPECT_EQ(item->get_stripe(i)->get_global_descriptor().offset,
+                  imported->get_stripe(i)->get_global_descriptor().offset);
+    }
+    memset(back, 0, nbytes);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, imported, 0, nbytes));
+    EXPECT_EQ(0, memcmp(local, back, nbytes));
+    delete imported;
+
+    EXPECT_NO_THROW(my_fam->fam_export(desc, &exported));
+    EXPECT_NO_THROW(region = my_fam->fam_import_region(&exported));
+    ASSERT_NE((void *)NULL, region);
+    EXPECT_EQ(desc->get_size(), region->get_size());
+    for (uint64_t i = 0; i < stripeCount; i++)
+        EXPECT_EQ(desc->get_stripe(i)->get_memserver_id(),
+                  region->get_stripe(i)->get_memserver_id());
+    delete region;
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete item;
+    delete desc;
+    delete[] local;
+    delete[] back;
+    free((void *)testRegion);
+    free((void *)testItem);
+}
+
+TEST(FamMMTest, FamSetRegionGrowthSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Region_Descriptor *found = NULL;
+    Fam_Descriptor *item[8];
+    const char *testRegion = get_uniq_str("mm_test", my_fam);
+    char *local = new char[524288];
+    char *back = new char[524288];
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 1048576, 0777, NONE));
+    EXPECT_NE((void *)NULL, desc);
+    EXPECT_EQ(0, my_fam->fam_set_region_growth(desc, 8 * 1048576));
+
+    // Together the data items need more space than the region started with
+    for (int i = 0; i < 8; i++) {
+        EXPECT_NO_THROW(item[i] = my_fam->fam_allocate(524288, 0777, desc));
+        ASSERT_NE((void *)NULL, item[i]);
+    }
+
+    // The region grew, within its growth limit
+    EXPECT_NO_THROW(found = my_fam->fam_lookup_region(testRegion));
+    ASSERT_NE((void *)NULL, found);
+    EXPECT_LT((uint64_t)1048576, found->get_size());
+    EXPECT_GE((uint64_t)8 * 1048576, found->get_size());
+
+    // Data items in the space the region grew by hold their data
+    for (int i = 0; i < 8; i++) {
+        memset(local, 'a' + i, 524288);
+        EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item[i], 0, 524288));
+    }
+    for (int i = 0; i < 8; i++) {
+        memset(local, 'a' + i, 524288);
+        EXPECT_NO_THROW(my_fam->fam_get_blocking(back, item[i], 0, 524288));
+        EXPECT_EQ(0, memcmp(local, back, 524288));
+    }
+
+    for (int i = 0; i < 8; i++) {
+        EXPECT_NO_THROW(my_fam->fam_deallocate(item[i]));
+        delete item[i];
+    }
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete found;
+    delete desc;
+    delete[] local;
+    delete[] back;
+    free((void *)testRegion);
+}
+
+TEST(FamMMTest, FamExportImportLookupSharedSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Region_Descriptor *region = NULL;
+    Fam_Descriptor *item = NULL;
+    Fam_Descriptor *imported = NULL;
+    Fam_Exported_Descriptor exported;
+    const char *testRegion = get_uniq_str("mm_test", my_fam);
+    const char *testItem = get_uniq_str("mm_export", my_fam);
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, 1048576, 0777, RAID1));
+    EXPECT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(item = my_fam->fam_allocate(testItem, 1024, 0777, desc));
+    EXPECT_NE((void *)NULL, item);
+
+    EXPECT_NO_THROW(my_fam->fam_export(item, &exported));
+    EXPECT_NO_THROW(imported = my_fam->fam_import(&exported));
+    EXPECT_EQ(item->get_global_descriptor().regionId,
+              imported->get_global_descriptor().regionId);
+    EXPECT_EQ(item->get_global_descriptor().offset,
+              imported->get_global_descriptor().offset);
+    EXPECT_EQ(item->get_size(), imported->get_size());
+    EXPECT_THROW(my_fam->fam_import_region(&exported),
+                 Fam_InvalidOption_Exception);
+    delete imported;
+
+    EXPECT_NO_THROW(my_fam->fam_export(desc, &exported));
+    EXPECT_NO_THROW(region = my_fam->fam_import_region(&exported));
+    EXPECT_EQ(desc->get_global_descriptor().regionId,
+              region->get_global_descriptor().regionId);
+    delete region;
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete item;
+    delete desc;
+    free((void *)testItem);
+    free((void *)testRegion);
+}
+
+TEST(FamMMTest, FamLookupSharedSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Region_Descriptor *region = NULL;
+    Fam_Descriptor *item = NULL;
+    Fam_Descriptor *shared = NULL;
+    Fam_Descriptor *found = NULL;
+    const char *testRegion = get_shared_str("mm_shared", my_fam);
+    const char *testItem = get_shared_str("mm_shared_item", my_fam);
+    bool isRoot = (get_pe_id(my_fam) == 0);
+    char local[1024];
+    char back[1024];
+
+    for (uint64_t i = 0; i < sizeof(local); i++)
+        local[i] = (char)(i * 7);
+
+    // PE 0 creates the region and data item that every PE then looks up
+    if (isRoot) {
+        EXPECT_NO_THROW(desc = my_fam->fam_create_region(testRegion, 1048576,
+                                                         0777, NONE));
+        EXPECT_NE((void *)NULL, desc);
+        EXPECT_NO_THROW(
+            item = my_fam->fam_allocate(testItem, sizeof(local), 0777, desc));
+        EXPECT_NE((void *)NULL, item);
+        EXPECT_NO_THROW(
+            my_fam->fam_put_blocking(local, item, 0, sizeof(local)));
+    }
+    my_fam->fam_barrier_all();
+
+    // Every PE gets what PE 0 looked up, the same as its own lookup
+    EXPECT_NO_THROW(region = my_fam->fam_lookup_region_shared(testRegion));
+    EXPECT_NO_THROW(shared = my_fam->fam_lookup_shared(testItem, testRegion));
+    EXPECT_NO_THROW(found = my_fam->fam_lookup(testItem, testRegion));
+    EXPECT_EQ(found->get_global_descriptor().regionId,
+              region->get_global_descriptor().regionId);
+    EXPECT_EQ(found->get_global_descriptor().regionId,
+              shared->get_global_descriptor().regionId);
+    EXPECT_EQ(found->get_global_descriptor().offset,
+              shared->get_global_descriptor().offset);
+    EXPECT_EQ(found->get_memserver_id(), shared->get_memserver_id());
+    EXPECT_EQ(sizeof(local), shared->get_size());
+    if (isRoot) {
+        EXPECT_EQ(item->get_global_descriptor().regionId,
+                  shared->get_global_descriptor().regionId);
+        EXPECT_EQ(item->get_global_descriptor().offset,
+                  shared->get_global_descriptor().offset);
+    }
+
+    memset(back, 0, sizeof(back));
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, shared, 0, sizeof(back)));
+    EXPECT_EQ(0, memcmp(local, back, sizeof(local)));
+    delete found;
+    delete shared;
+    delete region;
+    my_fam->fam_barrier_all();
+
+    if (isRoot) {
+        EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+        EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+        delete item;
+        delete desc;
+    }
+    free((void *)testItem);
+    free((void *)testRegion);
+}
+
 TEST(FamMMNegativeTest, FamCreateGreaterBignameRegionFailure) {
     const char *testRegion =
         get_uniq_str("testtesttesttesttesttesttesttesttesttest", my_fam);
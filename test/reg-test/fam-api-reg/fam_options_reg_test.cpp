@@ -64,6 +64,12 @@ TEST(FamOption, GetDefaultOptionList) {
         EXPECT_STREQ(optList[9], "PE_COUNT");
         EXPECT_STREQ(optList[10], "PE_ID");
         EXPECT_STREQ(optList[11], "RUNTIME");
+        EXPECT_STREQ(optList[12], "NUM_CONSUMER");
+        EXPECT_STREQ(optList[13], "FAM_ATOMIC_MODEL");
+        EXPECT_STREQ(optList[14], "METADATA_CACHE_LEASE");
+        EXPECT_STREQ(optList[15], "FAM_CONNECT_MODEL");
+        EXPECT_STREQ(optList[16], "REGION_PLACEMENT");
+        EXPECT_STREQ(optList[17], "FAM_REDUNDANCY_MODEL");
     }
 }
 
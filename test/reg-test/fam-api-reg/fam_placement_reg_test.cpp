@@ -0,0 +1,170 @@
+/*
+ * fam_placement_reg_test.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+
+#include <fam/fam_exception.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <set>
+#include <stdio.h>
+#include <string.h>
+
+#include <fam/fam.h>
+
+#include "common/fam_test_config.h"
+
+#define REGION_SIZE (1UL << 20)
+#define MESSAGE_SIZE 64
+
+using namespace std;
+using namespace openfam;
+
+fam *my_fam;
+Fam_Options fam_opts;
+uint64_t memserverCount;
+char *placement;
+
+// Test case 1 - regions placed by the policy are found by name with their
+// data, and a policy placing by name places a name on the same memory
+// server again.
+TEST(FamPlacement, CreateLookupSuccess) {
+    std::set<uint64_t> usedServers;
+
+    for (uint64_t i = 0; i < 2 * memserverCount; i++) {
+        Fam_Region_Descriptor *desc = NULL;
+        Fam_Region_Descriptor *found = NULL;
+        Fam_Descriptor *item = NULL;
+        Fam_Descriptor *foundItem = NULL;
+        const char *testRegion = get_uniq_str("placement", my_fam);
+        const char *testItem = get_uniq_str("placement_item", my_fam);
+        char local[MESSAGE_SIZE];
+        char back[MESSAGE_SIZE];
+
+        EXPECT_NO_THROW(desc = my_fam->fam_create_region(
+                            testRegion, REGION_SIZE, 0777, NONE));
+        ASSERT_NE((void *)NULL, desc);
+        uint64_t memserverId = desc->get_memserver_id();
+        EXPECT_GT(memserverCount, memserverId);
+        usedServers.insert(memserverId);
+
+        EXPECT_NO_THROW(item = my_fam->fam_allocate(testItem, MESSAGE_SIZE,
+                                                    0777, desc));
+        snprintf(local, MESSAGE_SIZE, "placed on %lu", memserverId);
+        EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, MESSAGE_SIZE));
+
+        EXPECT_NO_THROW(found = my_fam->fam_lookup_region(testRegion));
+        ASSERT_NE((void *)NULL, found);
+        EXPECT_EQ(desc->get_global_descriptor().regionId,
+                  found->get_global_descriptor().regionId);
+        EXPECT_EQ(memserverId, found->get_memserver_id());
+
+        EXPECT_NO_THROW(foundItem = my_fam->fam_lookup(testItem, testRegion));
+        ASSERT_NE((void *)NULL, foundItem);
+        EXPECT_EQ(memserverId, foundItem->get_memserver_id());
+        memset(back, 0, MESSAGE_SIZE);
+        EXPECT_NO_THROW(
+            my_fam->fam_get_blocking(back, foundItem, 0, MESSAGE_SIZE));
+        EXPECT_STREQ(local, back);
+
+        EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+        EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+        delete foundItem;
+        delete item;
+        delete found;
+        delete desc;
+
+        if ((strcmp(placement, "FAM_PLACEMENT_HASH") == 0) ||
+            (strcmp(placement, "FAM_PLACEMENT_CONSISTENT_HASH") == 0)) {
+            EXPECT_NO_THROW(desc = my_fam->fam_create_region(
+                                testRegion, REGION_SIZE, 0777, NONE));
+            ASSERT_NE((void *)NULL, desc);
+            EXPECT_EQ(memserverId, desc->get_memserver_id());
+            EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+            delete desc;
+        }
+        free((void *)testRegion);
+        free((void *)testItem);
+    }
+
+    // Round robin takes every memory server in turn
+    if (strcmp(placement, "FAM_PLACEMENT_ROUND_ROBIN") == 0) {
+        EXPECT_EQ(memserverCount, usedServers.size());
+    }
+}
+
+// Test case 2 - a name is only created once, wherever the region of that
+// name was placed.
+TEST(FamPlacement, CreateExistingNameFail) {
+    for (uint64_t id = 0; id < memserverCount; id++) {
+        Fam_Region_Descriptor *desc = NULL;
+        const char *testRegion = get_uniq_str("placement", my_fam);
+
+        EXPECT_NO_THROW(desc = my_fam->fam_create_region_on(
+                            testRegion, REGION_SIZE, 0777, NONE, id));
+        ASSERT_NE((void *)NULL, desc);
+        EXPECT_EQ(id, desc->get_memserver_id());
+
+        // Whether or not id is the home server of the name
+        EXPECT_THROW(
+            my_fam->fam_create_region(testRegion, REGION_SIZE, 0777, NONE),
+            Fam_Allocator_Exception);
+        for (uint64_t other = 0; other < memserverCount; other++) {
+            EXPECT_THROW(my_fam->fam_create_region_on(
+                             testRegion, REGION_SIZE, 0777, NONE, other),
+                         Fam_Allocator_Exception);
+        }
+
+        EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+        delete desc;
+        free((void *)testRegion);
+    }
+}
+
+// The placement policy is given as the first argument, FAM_PLACEMENT_HASH
+// by default.
+int main(int argc, char **argv) {
+    int ret;
+    ::testing::InitGoogleTest(&argc, argv);
+
+    my_fam = new fam();
+
+    init_fam_options(&fam_opts);
+    placement = strdup((argc > 1) ? argv[1] : "FAM_PLACEMENT_HASH");
+    fam_opts.regionPlacement = placement;
+
+    EXPECT_NO_THROW(my_fam->fam_initialize("default", &fam_opts));
+    memserverCount = get_memserver_count(my_fam);
+
+    ret = RUN_ALL_TESTS();
+
+    EXPECT_NO_THROW(my_fam->fam_finalize("default"));
+    free(placement);
+
+    return ret;
+}
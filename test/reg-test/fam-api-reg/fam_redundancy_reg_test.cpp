@@ -0,0 +1,320 @@
+/*
+ * fam_redundancy_reg_test.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+
+#include <fam/fam_exception.h>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <fam/fam.h>
+
+#include "common/fam_internal.h"
+#include "common/fam_test_config.h"
+
+#define REGION_SIZE (1UL << 20)
+#define ITEM_SIZE 12288
+// Threads putting to the same mirrored data item, and puts of each
+#define NUM_WRITERS 4
+#define NUM_PUTS 50
+
+using namespace std;
+using namespace openfam;
+
+fam *my_fam;
+Fam_Options fam_opts;
+uint64_t memserverCount;
+
+// Test case 1 - puts and atomics on a mirrored data item reach both copies,
+// which stay equal, and either can be copied from.
+TEST(FamRedundancy, FamCreateRegionMirroredSuccess) {
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Descriptor *item = NULL;
+    Fam_Descriptor *dup = NULL;
+    const char *testRegion = get_uniq_str("redundancy", my_fam);
+    const char *testItem = get_uniq_str("mirrored", my_fam);
+    char *local = new char[ITEM_SIZE];
+    char *back = new char[ITEM_SIZE];
+    char *other = new char[ITEM_SIZE];
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, REGION_SIZE, 0777, RAID1));
+    ASSERT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(item =
+                        my_fam->fam_allocate(testItem, ITEM_SIZE, 0777, desc));
+    ASSERT_NE((void *)NULL, item);
+    EXPECT_EQ((uint64_t)ITEM_SIZE, item->get_size());
+
+    for (uint64_t i = 0; i < ITEM_SIZE; i++)
+        local[i] = (char)i;
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local, item, 0, ITEM_SIZE));
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, item, 0, ITEM_SIZE));
+    EXPECT_EQ(0, memcmp(local, back, ITEM_SIZE));
+
+    EXPECT_NO_THROW(my_fam->fam_set(item, 0, (int64_t)10));
+    EXPECT_NO_THROW(my_fam->fam_add(item, 0, (int64_t)5));
+    EXPECT_EQ(15, my_fam->fam_fetch_int64(item, 0));
+    EXPECT_EQ(15, my_fam->fam_compare_swap(item, 0, (int64_t)15, (int64_t)20));
+    EXPECT_EQ(20, my_fam->fam_fetch_int64(item, 0));
+    EXPECT_NO_THROW(my_fam->fam_set(item, 8, (int64_t)25));
+    EXPECT_EQ(25, my_fam->fam_swap(item, 8, (int64_t)30));
+    EXPECT_EQ(30, my_fam->fam_fetch_add(item, 8, (int64_t)1));
+    // A failed compare and swap changes neither copy
+    EXPECT_EQ(31, my_fam->fam_compare_swap(item, 8, (int64_t)0, (int64_t)40));
+
+    // Each copy holds all of the data item, the same on both
+    Fam_Descriptor *first = item->get_stripe(0);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back, first, 0, ITEM_SIZE));
+    EXPECT_EQ(20, *(int64_t *)back);
+    EXPECT_EQ(31, *(int64_t *)(back + 8));
+    EXPECT_EQ(0, memcmp(local + 16, back + 16, ITEM_SIZE - 16));
+    if (memserverCount > 1) {
+        Fam_Descriptor *second = item->get_stripe(1);
+        ASSERT_NE(first, second);
+        EXPECT_NE(first->get_memserver_id(), second->get_memserver_id());
+        EXPECT_NO_THROW(my_fam->fam_get_blocking(other, second, 0, ITEM_SIZE));
+        EXPECT_EQ(0, memcmp(back, other, ITEM_SIZE));
+    }
+
+    // A mirrored data item can be copied from, not into
+    void *waitObj = NULL;
+    EXPECT_NO_THROW(waitObj = my_fam->fam_copy(item, 0, &dup, 0, ITEM_SIZE));
+    EXPECT_NO_THROW(my_fam->fam_copy_wait(waitObj));
+    ASSERT_NE((void *)NULL, dup);
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(other, dup, 0, ITEM_SIZE));
+    EXPECT_EQ(0, memcmp(back, other, ITEM_SIZE));
+    if (memserverCount > 1) {
+        EXPECT_THROW(my_fam->fam_copy(dup, 0, item, 0, ITEM_SIZE),
+                     Fam_Exception);
+    }
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(dup));
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete dup;
+    delete item;
+    delete desc;
+    delete[] local;
+    delete[] back;
+    delete[] other;
+    free((void *)testRegion);
+    free((void *)testItem);
+}
+
+/*
+ * Check that each parity stripe of a RAID5 data item of nbytes is the XOR of
+ * the data stripes of its row, reading the part on every member.
+ */
+static void check_parity(Fam_Descriptor *item, uint64_t nbytes) {
+    Fam_Stripe_Layout layout = item->get_layout();
+    uint64_t stripeSize = layout.stripeSize;
+    uint64_t rowBytes = stripeSize * (layout.stripeCount - 1);
+    vector<vector<char>> parts(layout.stripeCount);
+
+    for (uint64_t i = 0; i < layout.stripeCount; i++) {
+        parts[i].resize(fam_stripe_bytes(nbytes, layout, i));
+        if (parts[i].empty())
+            continue;
+        ASSERT_NE((void *)NULL, item->get_stripe(i));
+        EXPECT_NO_THROW(my_fam->fam_get_blocking(
+            parts[i].data(), item->get_stripe(i), 0, parts[i].size()));
+    }
+
+    for (uint64_t row = 0; row * rowBytes < nbytes; row++) {
+        uint64_t parity = row % layout.stripeCount;
+        for (uint64_t i = 0; i < stripeSize; i++) {
+            uint64_t pos = row * stripeSize + i;
+            if (pos >= parts[parity].size())
+                break;
+            char expected = 0;
+            for (uint64_t m = 0; m < layout.stripeCount; m++) {
+                if ((m != parity) && (pos < parts[m].size()))
+                    expected ^= parts[m][pos];
+            }
+            ASSERT_EQ(expected, parts[parity][pos])
+                << "row " << row << " byte " << i;
+        }
+    }
+}
+
+// Test case 2 - the parity of a RAID5 data item stays the XOR of its data,
+// after puts of whole rows, of parts of rows and across stripes, and after
+// atomics.
+TEST(FamRedundancy, FamCreateRegionParitySuccess) {
+    if (memserverCount < FAM_RAID5_MIN_MEMBERS) {
+        GTEST_SKIP();
+    }
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Descriptor *item = NULL;
+    const char *testRegion = get_uniq_str("redundancy", my_fam);
+    const char *testItem = get_uniq_str("parity", my_fam);
+    uint64_t rowBytes = FAM_RAID5_STRIPE_SIZE * (memserverCount - 1);
+    // Two whole rows and a short last one
+    uint64_t nbytes = 2 * rowBytes + FAM_RAID5_STRIPE_SIZE + 100;
+    vector<char> local(nbytes);
+    vector<char> back(nbytes);
+
+    EXPECT_NO_THROW(desc = my_fam->fam_create_region(
+                        testRegion, 4 * nbytes, 0777, RAID5));
+    ASSERT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(item = my_fam->fam_allocate(testItem, nbytes, 0777, desc));
+    ASSERT_NE((void *)NULL, item);
+    EXPECT_EQ(nbytes, item->get_size());
+    EXPECT_EQ(memserverCount, (uint64_t)item->get_layout().stripeCount);
+
+    for (uint64_t i = 0; i < nbytes; i++)
+        local[i] = (char)(i * 7 + 1);
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local.data(), item, 0, nbytes));
+    check_parity(item, nbytes);
+
+    // Part of a stripe, then a piece across a stripe boundary
+    for (uint64_t i = 0; i < nbytes; i++)
+        local[i] = (char)(i * 13 + 5);
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local.data() + 1000, item, 1000,
+                                             2000));
+    check_parity(item, nbytes);
+    uint64_t cross = rowBytes + FAM_RAID5_STRIPE_SIZE - 300;
+    EXPECT_NO_THROW(my_fam->fam_put_blocking(local.data() + cross, item,
+                                             cross, 600));
+    check_parity(item, nbytes);
+
+    // Atomics change the parity of their row as well
+    EXPECT_NO_THROW(my_fam->fam_set(item, 8, (int64_t)12345));
+    EXPECT_NO_THROW(my_fam->fam_add(item, rowBytes + 16, (int64_t)77));
+    EXPECT_NO_THROW(my_fam->fam_compare_swap(item, 8, (int64_t)12345,
+                                             (int64_t)-1));
+    check_parity(item, nbytes);
+
+    // The data reads back as put
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(back.data(), item, 0, nbytes));
+    EXPECT_EQ(-1, *(int64_t *)(back.data() + 8));
+    EXPECT_EQ(0, memcmp(local.data() + 1000, back.data() + 1000, 2000));
+    EXPECT_EQ(0, memcmp(local.data() + cross, back.data() + cross, 600));
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete item;
+    delete desc;
+    free((void *)testRegion);
+    free((void *)testItem);
+}
+
+typedef struct {
+    Fam_Descriptor *item;
+    char pattern;
+    bool blocking;
+} PutInfo;
+
+void *famPutPattern(void *arg) {
+    PutInfo *info = (PutInfo *)arg;
+    vector<char> local(ITEM_SIZE, info->pattern);
+
+    for (int i = 0; i < NUM_PUTS; i++) {
+        if (info->blocking) {
+            EXPECT_NO_THROW(my_fam->fam_put_blocking(local.data(), info->item,
+                                                     0, ITEM_SIZE));
+        } else {
+            EXPECT_NO_THROW(my_fam->fam_put_nonblocking(
+                local.data(), info->item, 0, ITEM_SIZE));
+            EXPECT_NO_THROW(my_fam->fam_quiet());
+        }
+    }
+    return NULL;
+}
+
+// Test case 3 - concurrent puts of different data to the same mirrored data
+// item leave both copies equal, holding the data of one of the puts.
+TEST(FamRedundancy, FamMirroredConcurrentPutSuccess) {
+    if (memserverCount < 2) {
+        GTEST_SKIP();
+    }
+    Fam_Region_Descriptor *desc = NULL;
+    Fam_Descriptor *item = NULL;
+    const char *testRegion = get_uniq_str("redundancy", my_fam);
+    const char *testItem = get_uniq_str("concurrent", my_fam);
+    pthread_t writers[NUM_WRITERS];
+    PutInfo infos[NUM_WRITERS];
+    vector<char> first(ITEM_SIZE);
+    vector<char> second(ITEM_SIZE);
+
+    EXPECT_NO_THROW(
+        desc = my_fam->fam_create_region(testRegion, REGION_SIZE, 0777, RAID1));
+    ASSERT_NE((void *)NULL, desc);
+    EXPECT_NO_THROW(item =
+                        my_fam->fam_allocate(testItem, ITEM_SIZE, 0777, desc));
+    ASSERT_NE((void *)NULL, item);
+
+    for (int i = 0; i < NUM_WRITERS; i++) {
+        infos[i] = {item, (char)(i + 1), (i % 2) == 0};
+        pthread_create(&writers[i], NULL, famPutPattern, &infos[i]);
+    }
+    for (int i = 0; i < NUM_WRITERS; i++)
+        pthread_join(writers[i], NULL);
+
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(first.data(), item->get_stripe(0),
+                                             0, ITEM_SIZE));
+    EXPECT_NO_THROW(my_fam->fam_get_blocking(
+        second.data(), item->get_stripe(1), 0, ITEM_SIZE));
+    EXPECT_EQ(first, second);
+    // Puts to the same bytes are not interleaved within a copy either
+    EXPECT_EQ(vector<char>(ITEM_SIZE, first[0]), first);
+    EXPECT_LE(1, first[0]);
+    EXPECT_GE(NUM_WRITERS, first[0]);
+
+    EXPECT_NO_THROW(my_fam->fam_deallocate(item));
+    EXPECT_NO_THROW(my_fam->fam_destroy_region(desc));
+    delete item;
+    delete desc;
+    free((void *)testRegion);
+    free((void *)testItem);
+}
+
+int main(int argc, char **argv) {
+    int ret;
+    ::testing::InitGoogleTest(&argc, argv);
+
+    my_fam = new fam();
+
+    init_fam_options(&fam_opts);
+    fam_opts.famRedundancyModel = strdup("FAM_REDUNDANCY_ACROSS_MEMSERVERS");
+
+    EXPECT_NO_THROW(my_fam->fam_initialize("default", &fam_opts));
+    memserverCount = get_memserver_count(my_fam);
+
+    ret = RUN_ALL_TESTS();
+
+    EXPECT_NO_THROW(my_fam->fam_finalize("default"));
+    free(fam_opts.famRedundancyModel);
+    delete my_fam;
+
+    return ret;
+}
@@ -0,0 +1,115 @@
+/*
+ * fam_heap_keeper_reg_test.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "allocator/memserver_allocator.h"
+#include "common/memserver_exception.h"
+
+using namespace std;
+using namespace openfam;
+
+#define TEST_NUM_WARM_HEAPS 2
+#define TEST_REGION_SIZE (4UL << 20)
+// Less than the warm pool would take for both region sizes
+#define TEST_CAPACITY (16 * TEST_REGION_SIZE)
+#define TEST_NUM_ROUNDS 8
+#define TEST_ITEM_SIZE 4096
+
+Memserver_Allocator *memAllocator;
+uint32_t uid, gid;
+
+// Test case#1 - regions of two sizes created and destroyed in turn, most of
+// them on heaps from the warm pool, start out empty and hold their data.
+TEST(MemserverHeapKeeper, CreateDestroySuccess) {
+    string name = "keeper_" + to_string(getpid());
+    uint64_t capacity, used, usedBefore;
+    // Regions left by other tests count as well
+    memAllocator->get_memserver_info(capacity, usedBefore);
+
+    for (int round = 0; round < TEST_NUM_ROUNDS; round++) {
+        size_t nbytes = TEST_REGION_SIZE << (round % 2);
+        uint64_t regionId;
+        EXPECT_NO_THROW(memAllocator->create_region(name, regionId, nbytes,
+                                                    0777, uid, gid));
+        Fam_Region_Metadata region;
+        EXPECT_NO_THROW(memAllocator->get_region(name, uid, gid, region));
+        EXPECT_EQ(regionId, region.regionId);
+        EXPECT_EQ(nbytes, region.size);
+
+        // A data item of the same name as in the last round can be
+        // allocated, so no metadata is left over from it
+        uint64_t offset;
+        Fam_DataItem_Metadata dataitem;
+        void *localPointer = NULL;
+        EXPECT_NO_THROW(memAllocator->allocate("item", regionId,
+                                               TEST_ITEM_SIZE, offset, 0777,
+                                               uid, gid, dataitem,
+                                               localPointer));
+        ASSERT_NE((void *)NULL, localPointer);
+        memset(localPointer, round, TEST_ITEM_SIZE);
+        for (int i = 0; i < TEST_ITEM_SIZE; i++)
+            EXPECT_EQ((char)round, ((char *)localPointer)[i]);
+
+        memAllocator->get_memserver_info(capacity, used);
+        EXPECT_EQ((uint64_t)TEST_CAPACITY, capacity);
+        EXPECT_EQ(usedBefore + nbytes, used);
+
+        EXPECT_NO_THROW(memAllocator->destroy_region(regionId, uid, gid));
+        EXPECT_THROW(memAllocator->get_region(name, uid, gid, region),
+                     Memserver_Exception);
+
+        // Give the heap keeper time to refill the pool
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    memAllocator->get_memserver_info(capacity, used);
+    EXPECT_EQ(usedBefore, used);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    uid = (uint32_t)getuid();
+    gid = (uint32_t)getgid();
+    memAllocator =
+        new Memserver_Allocator(0, 0, TEST_NUM_WARM_HEAPS, TEST_CAPACITY);
+
+    int ret = RUN_ALL_TESTS();
+
+    memAllocator->memserver_allocator_finalize();
+    delete memAllocator;
+    return ret;
+}
@@ -0,0 +1,150 @@
+/*
+ * fam_mr_registry_reg_test.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include <fam/fam.h>
+#include <fam/fam_exception.h>
+
+#include "common/fam_ops_libfabric.h"
+#include "rpc/fam_mr_registry.h"
+
+#include "common/fam_test_config.h"
+
+#define TEST_MAX_MRS 16
+#define TEST_NUM_MRS 64
+
+using namespace std;
+using namespace openfam;
+
+Fam_Ops_Libfabric *famOps;
+
+// Test case#1 - registrations beyond maxMrs are dropped, least recently used
+// first, and the registry reports it.
+TEST(FamMrRegistry, EvictColdSuccess) {
+    uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    char *buffer = (char *)aligned_alloc(pageSize, TEST_NUM_MRS * pageSize);
+    std::atomic<uint64_t> numEvictHooks(0);
+    Fam_Mr_Registry *registry =
+        new Fam_Mr_Registry(famOps->get_domain(), TEST_MAX_MRS,
+                            [&numEvictHooks]() { numEvictHooks++; });
+
+    EXPECT_EQ(0, registry->register_mr(1, buffer, pageSize, true, true));
+    for (uint64_t i = 2; i < TEST_NUM_MRS; i++) {
+        EXPECT_EQ(0, registry->register_mr(i, buffer + i * pageSize, pageSize,
+                                           (i % 2) == 0));
+    }
+    // Registering a key again is a no-op
+    EXPECT_EQ(0, registry->register_mr(2, buffer, pageSize, true));
+    EXPECT_EQ((uint64_t)TEST_NUM_MRS - 1, registry->get_num_mrs());
+
+    // Keep key 2 in use over several sweeps while the others go cold
+    for (int i = 0; i < (FAM_MR_REGISTRY_HOLD_SWEEPS + 4) * 10; i++) {
+        EXPECT_TRUE(registry->find(2));
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(FAM_MR_REGISTRY_SWEEP_MS / 10));
+    }
+
+    EXPECT_LE(registry->get_num_mrs(), (uint64_t)TEST_MAX_MRS);
+    EXPECT_EQ(TEST_NUM_MRS - 1 - registry->get_num_mrs(),
+              registry->get_num_evicted());
+    EXPECT_LT((uint64_t)0, numEvictHooks.load());
+    // Pinned and recently used registrations stay
+    EXPECT_TRUE(registry->find(1));
+    EXPECT_TRUE(registry->find(2));
+
+    // A dropped key can be registered again
+    uint64_t dropped = 0;
+    for (uint64_t i = 3; (i < TEST_NUM_MRS) && !dropped; i++) {
+        if (!registry->find(i))
+            dropped = i;
+    }
+    EXPECT_NE((uint64_t)0, dropped);
+    EXPECT_EQ(0, registry->register_mr(dropped, buffer + dropped * pageSize,
+                                       pageSize, true));
+    EXPECT_TRUE(registry->find(dropped));
+
+    EXPECT_EQ(0, registry->deregister_mr(dropped));
+    EXPECT_FALSE(registry->find(dropped));
+    // Deregistering a key that is not registered is not an error
+    EXPECT_EQ(0, registry->deregister_mr(dropped));
+
+    delete registry;
+    free(buffer);
+}
+
+// Test case#2 - without maxMrs nothing is dropped.
+TEST(FamMrRegistry, NoEvictionSuccess) {
+    uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    char *buffer = (char *)aligned_alloc(pageSize, TEST_NUM_MRS * pageSize);
+    Fam_Mr_Registry *registry = new Fam_Mr_Registry(famOps->get_domain());
+
+    for (uint64_t i = 1; i <= TEST_NUM_MRS; i++) {
+        EXPECT_EQ(0, registry->register_mr(i, buffer + (i - 1) * pageSize,
+                                           pageSize, true));
+    }
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(3 * FAM_MR_REGISTRY_SWEEP_MS));
+    EXPECT_EQ((uint64_t)TEST_NUM_MRS, registry->get_num_mrs());
+    EXPECT_EQ((uint64_t)0, registry->get_num_evicted());
+
+    registry->deregister_all();
+    EXPECT_EQ((uint64_t)0, registry->get_num_mrs());
+
+    delete registry;
+    free(buffer);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    const char *name = "127.0.0.1";
+    const char *service = "1500";
+    char *provider = strdup(TEST_LIBFABRIC_PROVIDER);
+
+    famOps = new Fam_Ops_Libfabric(name, service, true, provider,
+                                   FAM_THREAD_MULTIPLE, NULL,
+                                   FAM_CONTEXT_DEFAULT);
+    if (famOps->initialize() < 0) {
+        cout << "Libfabric initialization failed" << endl;
+        return -1;
+    }
+
+    int ret = RUN_ALL_TESTS();
+
+    famOps->finalize();
+    delete famOps;
+    free(provider);
+    return ret;
+}
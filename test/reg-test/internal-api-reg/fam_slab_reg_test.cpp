@@ -0,0 +1,218 @@
+/*
+ * fam_slab_reg_test.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+
+#include <gtest/gtest.h>
+#include <set>
+#include <stdint.h>
+#include <string.h>
+
+#include <nvmm/error_code.h>
+#include <nvmm/heap.h>
+#include <nvmm/memory_manager.h>
+
+#include "allocator/memserver_slab.h"
+#include "common/fam_internal.h"
+
+using namespace std;
+using namespace nvmm;
+using namespace openfam;
+
+// Pool ids below MEMSERVER_REGIONID_START are never given to regions
+#define TEST_SLAB_POOL_ID (MEMSERVER_REGIONID_START - 1)
+#define TEST_SLAB_MIN_OBJ_SIZE 128
+#define TEST_SLAB_MAX_OBJ_SIZE 4096
+#define TEST_SLAB_HEAP_SIZE (16 * MEMSERVER_SLAB_CHUNK_SIZE)
+
+MemoryManager *memoryManager;
+Heap *heap;
+
+static Heap *create_test_heap(size_t nbytes) {
+    Heap *newHeap = NULL;
+    (void)memoryManager->DestroyHeap((PoolId)TEST_SLAB_POOL_ID);
+    if (memoryManager->CreateHeap((PoolId)TEST_SLAB_POOL_ID, nbytes,
+                                  TEST_SLAB_MIN_OBJ_SIZE) != NO_ERROR)
+        return NULL;
+    if (memoryManager->FindHeap((PoolId)TEST_SLAB_POOL_ID, &newHeap) !=
+        NO_ERROR)
+        return NULL;
+    if (newHeap->Open() != NO_ERROR) {
+        delete newHeap;
+        return NULL;
+    }
+    return newHeap;
+}
+
+static void destroy_test_heap(Heap *oldHeap) {
+    if (oldHeap) {
+        oldHeap->Close();
+        delete oldHeap;
+    }
+    (void)memoryManager->DestroyHeap((PoolId)TEST_SLAB_POOL_ID);
+}
+
+// Test case#1 - objects of each size are allocated from slabs and freed back.
+TEST(MemserverSlab, AllocFreeSuccess) {
+    heap = create_test_heap(TEST_SLAB_HEAP_SIZE);
+    ASSERT_NE((Heap *)NULL, heap);
+    uint64_t rootOffset =
+        Memserver_Slab::create_root(heap, TEST_SLAB_MIN_OBJ_SIZE);
+    ASSERT_NE((uint64_t)0, rootOffset);
+    Memserver_Slab *slab = new Memserver_Slab(
+        heap, rootOffset, TEST_SLAB_MIN_OBJ_SIZE, TEST_SLAB_MAX_OBJ_SIZE);
+
+    set<uint64_t> offsets;
+    for (uint64_t size = 1; size <= TEST_SLAB_MAX_OBJ_SIZE; size *= 2) {
+        for (int i = 0; i < 16; i++) {
+            uint64_t offset = slab->alloc(size);
+            EXPECT_NE((uint64_t)0, offset);
+            // Every object is distinct and writable
+            EXPECT_TRUE(offsets.insert(offset).second);
+            memset(heap->OffsetToLocal(offset), (int)i, size);
+        }
+    }
+    // Larger objects are not served from slabs
+    EXPECT_EQ((uint64_t)0, slab->alloc(TEST_SLAB_MAX_OBJ_SIZE + 1));
+
+    for (auto offset : offsets)
+        EXPECT_TRUE(slab->free(offset));
+
+    // Space taken from the heap directly does not belong to a slab
+    uint64_t heapOffset = heap->AllocOffset(2 * MEMSERVER_SLAB_MAX_OBJ_SIZE);
+    EXPECT_NE((uint64_t)0, heapOffset);
+    EXPECT_FALSE(slab->free(heapOffset));
+    heap->Free(heapOffset);
+
+    // A region without slabs allocates nothing from them
+    Memserver_Slab *noSlab = new Memserver_Slab(
+        heap, 0, TEST_SLAB_MIN_OBJ_SIZE, TEST_SLAB_MAX_OBJ_SIZE);
+    EXPECT_EQ((uint64_t)0, noSlab->alloc(TEST_SLAB_MIN_OBJ_SIZE));
+    EXPECT_FALSE(noSlab->free(*offsets.begin()));
+
+    delete noSlab;
+    delete slab;
+    destroy_test_heap(heap);
+}
+
+// Test case#2 - a freed object is handed out again, and objects in use are
+// not, also after the slabs are loaded again from the heap.
+TEST(MemserverSlab, ReuseAfterFreeSuccess) {
+    heap = create_test_heap(TEST_SLAB_HEAP_SIZE);
+    ASSERT_NE((Heap *)NULL, heap);
+    uint64_t rootOffset =
+        Memserver_Slab::create_root(heap, TEST_SLAB_MIN_OBJ_SIZE);
+    ASSERT_NE((uint64_t)0, rootOffset);
+    Memserver_Slab *slab = new Memserver_Slab(
+        heap, rootOffset, TEST_SLAB_MIN_OBJ_SIZE, TEST_SLAB_MAX_OBJ_SIZE);
+
+    uint64_t first = slab->alloc(200);
+    uint64_t second = slab->alloc(200);
+    EXPECT_NE((uint64_t)0, first);
+    EXPECT_NE((uint64_t)0, second);
+    EXPECT_NE(first, second);
+
+    EXPECT_TRUE(slab->free(first));
+    EXPECT_EQ(first, slab->alloc(256));
+
+    // Load the slabs again, as after a restart of the memory server
+    EXPECT_TRUE(slab->free(first));
+    delete slab;
+    slab = new Memserver_Slab(heap, rootOffset, TEST_SLAB_MIN_OBJ_SIZE,
+                              TEST_SLAB_MAX_OBJ_SIZE);
+
+    set<uint64_t> offsets;
+    bool reused = false;
+    for (int i = 0; i < 64; i++) {
+        uint64_t offset = slab->alloc(200);
+        EXPECT_NE((uint64_t)0, offset);
+        EXPECT_NE(second, offset);
+        reused |= (offset == first);
+        offsets.insert(offset);
+    }
+    EXPECT_TRUE(reused);
+
+    for (auto offset : offsets)
+        EXPECT_TRUE(slab->free(offset));
+    EXPECT_TRUE(slab->free(second));
+
+    delete slab;
+    destroy_test_heap(heap);
+}
+
+// Test case#3 - once no chunk can be taken from the heap, a full size class
+// returns 0 and the data item is allocated from the heap instead.
+TEST(MemserverSlab, FullSlabFallbackSuccess) {
+    heap = create_test_heap(TEST_SLAB_HEAP_SIZE);
+    ASSERT_NE((Heap *)NULL, heap);
+    uint64_t rootOffset =
+        Memserver_Slab::create_root(heap, TEST_SLAB_MIN_OBJ_SIZE);
+    ASSERT_NE((uint64_t)0, rootOffset);
+    Memserver_Slab *slab = new Memserver_Slab(
+        heap, rootOffset, TEST_SLAB_MIN_OBJ_SIZE, TEST_SLAB_MAX_OBJ_SIZE);
+
+    // Keep some space back, so that the heap still has room when the slabs
+    // no longer do
+    uint64_t spare = heap->AllocOffset(MEMSERVER_SLAB_MAX_OBJ_SIZE);
+    ASSERT_NE((uint64_t)0, spare);
+
+    set<uint64_t> offsets;
+    uint64_t maxObjects = TEST_SLAB_HEAP_SIZE / TEST_SLAB_MAX_OBJ_SIZE;
+    uint64_t offset;
+    while ((offset = slab->alloc(TEST_SLAB_MAX_OBJ_SIZE)) != 0) {
+        EXPECT_TRUE(offsets.insert(offset).second);
+        ASSERT_LE(offsets.size(), maxObjects);
+    }
+    EXPECT_LT((uint64_t)0, offsets.size());
+    EXPECT_EQ((uint64_t)0, slab->alloc(TEST_SLAB_MAX_OBJ_SIZE));
+
+    heap->Free(spare);
+    uint64_t heapOffset = heap->AllocOffset(TEST_SLAB_MAX_OBJ_SIZE);
+    EXPECT_NE((uint64_t)0, heapOffset);
+    EXPECT_FALSE(slab->free(heapOffset));
+    heap->Free(heapOffset);
+
+    // Freeing one object makes room in the full size class again
+    uint64_t last = *offsets.rbegin();
+    EXPECT_TRUE(slab->free(last));
+    EXPECT_EQ(last, slab->alloc(TEST_SLAB_MAX_OBJ_SIZE));
+
+    for (auto offset : offsets)
+        EXPECT_TRUE(slab->free(offset));
+
+    delete slab;
+    destroy_test_heap(heap);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    StartNVMM();
+    memoryManager = MemoryManager::GetInstance();
+
+    return RUN_ALL_TESTS();
+}
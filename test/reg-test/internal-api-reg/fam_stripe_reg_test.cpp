@@ -0,0 +1,289 @@
+/*
+ * fam_stripe_reg_test.cpp
+ * Copyright (c) 2019 Hewlett Packard Enterprise Development, LP. All rights
+ * reserved. Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ *    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ *    INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * See https://spdx.org/licenses/BSD-3-Clause
+ *
+ */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <set>
+#include <stdint.h>
+#include <utility>
+
+#include "common/fam_internal.h"
+
+using namespace std;
+using namespace openfam;
+
+/*
+ * Check that every byte of a data item of nbytes maps to a distinct byte
+ * within the part of its member, and that the parts add up to the data item.
+ */
+static void check_layout(uint64_t nbytes, Fam_Stripe_Layout layout) {
+    set<pair<uint64_t, uint64_t>> placed;
+    uint64_t total = 0;
+
+    for (uint64_t i = 0; i < layout.stripeCount; i++)
+        total += fam_stripe_bytes(nbytes, layout, i);
+    EXPECT_EQ(nbytes, total);
+
+    for (uint64_t offset = 0; offset < nbytes; offset++) {
+        uint64_t memberOffset;
+        uint64_t member = fam_stripe_of(offset, layout, memberOffset);
+        ASSERT_GT(layout.stripeCount, member);
+        EXPECT_GT(fam_stripe_bytes(nbytes, layout, member), memberOffset);
+        EXPECT_TRUE(placed.insert({member, memberOffset}).second);
+    }
+}
+
+/*
+ * Check that the data and parity bytes of a RAID5 data item of nbytes each
+ * map to a distinct byte within the part of its member, that every data byte
+ * of a row shares its position with a byte of the parity of the row, and
+ * that the parts add up to the data item and its parity.
+ */
+static void check_parity_layout(uint64_t nbytes, Fam_Stripe_Layout layout) {
+    set<pair<uint64_t, uint64_t>> placed;
+    uint64_t rowBytes = layout.stripeSize * (layout.stripeCount - 1);
+    uint64_t parityBytes = 0;
+
+    for (uint64_t offset = 0; offset < nbytes; offset++) {
+        uint64_t memberOffset, parityOffset;
+        uint64_t member = fam_stripe_of(offset, layout, memberOffset);
+        uint64_t parity = fam_parity_of(offset, layout, parityOffset);
+        ASSERT_GT(layout.stripeCount, member);
+        EXPECT_NE(parity, member);
+        EXPECT_EQ(parityOffset, memberOffset);
+        EXPECT_GT(fam_stripe_bytes(nbytes, layout, member), memberOffset);
+        EXPECT_TRUE(placed.insert({member, memberOffset}).second);
+    }
+
+    for (uint64_t row = 0; row * rowBytes < nbytes; row++) {
+        uint64_t length = min(nbytes - row * rowBytes, layout.stripeSize);
+        for (uint64_t i = 0; i < length; i++) {
+            uint64_t parityOffset;
+            uint64_t parity =
+                fam_parity_of(row * rowBytes + i, layout, parityOffset);
+            EXPECT_EQ(row % layout.stripeCount, parity);
+            EXPECT_GT(fam_stripe_bytes(nbytes, layout, parity), parityOffset);
+            EXPECT_TRUE(placed.insert({parity, parityOffset}).second);
+        }
+        parityBytes += length;
+    }
+
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < layout.stripeCount; i++)
+        total += fam_stripe_bytes(nbytes, layout, i);
+    EXPECT_EQ(nbytes + parityBytes, total);
+    EXPECT_EQ(nbytes, fam_parity_data_bytes(total, layout));
+}
+
+// Test case#1 - stripes go to the members in turn, each member holding its
+// stripes one after the other.
+TEST(FamStripeLayout, StripeOfSuccess) {
+    Fam_Stripe_Layout layout = {4096, 3, 0, NONE};
+    uint64_t memberOffset;
+
+    EXPECT_EQ((uint64_t)0, fam_stripe_of(0, layout, memberOffset));
+    EXPECT_EQ((uint64_t)0, memberOffset);
+    EXPECT_EQ((uint64_t)0, fam_stripe_of(4095, layout, memberOffset));
+    EXPECT_EQ((uint64_t)4095, memberOffset);
+    EXPECT_EQ((uint64_t)1, fam_stripe_of(4096, layout, memberOffset));
+    EXPECT_EQ((uint64_t)0, memberOffset);
+    EXPECT_EQ((uint64_t)2, fam_stripe_of(2 * 4096 + 7, layout, memberOffset));
+    EXPECT_EQ((uint64_t)7, memberOffset);
+    // The second round of stripes follows the first on each member
+    EXPECT_EQ((uint64_t)0, fam_stripe_of(3 * 4096 + 9, layout, memberOffset));
+    EXPECT_EQ((uint64_t)4096 + 9, memberOffset);
+    EXPECT_EQ((uint64_t)1, fam_stripe_of(4 * 4096, layout, memberOffset));
+    EXPECT_EQ((uint64_t)4096, memberOffset);
+}
+
+// Test case#2 - bytes of each member, with a short last round.
+TEST(FamStripeLayout, StripeBytesSuccess) {
+    Fam_Stripe_Layout layout = {4096, 3, 0, NONE};
+
+    for (uint64_t i = 0; i < 3; i++)
+        EXPECT_EQ((uint64_t)0, fam_stripe_bytes(0, layout, i));
+
+    // Less than a stripe is all on the first member
+    EXPECT_EQ((uint64_t)100, fam_stripe_bytes(100, layout, 0));
+    EXPECT_EQ((uint64_t)0, fam_stripe_bytes(100, layout, 1));
+    EXPECT_EQ((uint64_t)0, fam_stripe_bytes(100, layout, 2));
+
+    // Two rounds, the second ending in the middle of the second stripe
+    uint64_t nbytes = 3 * 4096 + 4096 + 100;
+    EXPECT_EQ((uint64_t)2 * 4096, fam_stripe_bytes(nbytes, layout, 0));
+    EXPECT_EQ((uint64_t)4096 + 100, fam_stripe_bytes(nbytes, layout, 1));
+    EXPECT_EQ((uint64_t)4096, fam_stripe_bytes(nbytes, layout, 2));
+
+    // Whole rounds only
+    for (uint64_t i = 0; i < 3; i++)
+        EXPECT_EQ((uint64_t)2 * 4096, fam_stripe_bytes(6 * 4096, layout, i));
+
+    // Every copy of a mirrored data item holds all of it
+    Fam_Stripe_Layout mirrored = {0, 2, 0, RAID1};
+    EXPECT_EQ((uint64_t)12345, fam_stripe_bytes(12345, mirrored, 0));
+    EXPECT_EQ((uint64_t)12345, fam_stripe_bytes(12345, mirrored, 1));
+}
+
+// Test case#3 - the stripe math covers every byte once, whatever the size.
+TEST(FamStripeLayout, LayoutCoversDataItemSuccess) {
+    Fam_Stripe_Layout layouts[] = {{16, 1, 0, NONE},
+                                   {16, 2, 0, NONE},
+                                   {16, 3, 0, NONE},
+                                   {32, 4, 0, NONE}};
+
+    for (auto layout : layouts) {
+        for (uint64_t nbytes : {(uint64_t)0, (uint64_t)1, (uint64_t)15,
+                                (uint64_t)16, (uint64_t)17, (uint64_t)100,
+                                layout.stripeSize * layout.stripeCount,
+                                5 * layout.stripeSize * layout.stripeCount +
+                                    3})
+            check_layout(nbytes, layout);
+    }
+}
+
+// Test case#4 - members holding data.
+TEST(FamStripeLayout, DataMembersSuccess) {
+    EXPECT_EQ((uint64_t)4, fam_data_members({4096, 4, 0, NONE}));
+    EXPECT_EQ((uint64_t)1, fam_data_members({0, 2, 0, RAID1}));
+    EXPECT_EQ((uint64_t)3, fam_data_members({4096, 4, 0, RAID5}));
+}
+
+// Test case#5 - the parity of each row moves to the next member, and its
+// data stripes follow it.
+TEST(FamStripeLayout, ParityOfSuccess) {
+    Fam_Stripe_Layout layout = {4096, 3, 0, RAID5};
+    uint64_t memberOffset;
+
+    EXPECT_EQ((uint64_t)0, fam_parity_of(0, layout, memberOffset));
+    EXPECT_EQ((uint64_t)0, memberOffset);
+    EXPECT_EQ((uint64_t)0, fam_parity_of(5000, layout, memberOffset));
+    EXPECT_EQ((uint64_t)5000 - 4096, memberOffset);
+    EXPECT_EQ((uint64_t)1, fam_parity_of(8192, layout, memberOffset));
+    EXPECT_EQ((uint64_t)4096, memberOffset);
+    EXPECT_EQ((uint64_t)0, fam_parity_of(3 * 8192 + 7, layout, memberOffset));
+    EXPECT_EQ((uint64_t)3 * 4096 + 7, memberOffset);
+
+    EXPECT_EQ((uint64_t)1, fam_stripe_of(0, layout, memberOffset));
+    EXPECT_EQ((uint64_t)0, memberOffset);
+    EXPECT_EQ((uint64_t)2, fam_stripe_of(4096 + 9, layout, memberOffset));
+    EXPECT_EQ((uint64_t)9, memberOffset);
+    EXPECT_EQ((uint64_t)2, fam_stripe_of(8192, layout, memberOffset));
+    EXPECT_EQ((uint64_t)4096, memberOffset);
+    EXPECT_EQ((uint64_t)0, fam_stripe_of(3 * 4096, layout, memberOffset));
+    EXPECT_EQ((uint64_t)4096, memberOffset);
+    EXPECT_EQ((uint64_t)0, fam_stripe_of(2 * 8192, layout, memberOffset));
+    EXPECT_EQ((uint64_t)2 * 4096, memberOffset);
+}
+
+// Test case#6 - bytes of each member of a RAID5 data item, whose short last
+// row has a parity stripe as long as its first data stripe.
+TEST(FamStripeLayout, ParityStripeBytesSuccess) {
+    Fam_Stripe_Layout layout = {4096, 3, 0, RAID5};
+
+    for (uint64_t i = 0; i < 3; i++)
+        EXPECT_EQ((uint64_t)0, fam_stripe_bytes(0, layout, i));
+
+    // Two whole rows
+    for (uint64_t i = 0; i < 3; i++)
+        EXPECT_EQ((uint64_t)2 * 4096, fam_stripe_bytes(2 * 8192, layout, i));
+
+    // A last row shorter than a stripe, its parity on member 2
+    uint64_t nbytes = 2 * 8192 + 100;
+    EXPECT_EQ((uint64_t)2 * 4096 + 100, fam_stripe_bytes(nbytes, layout, 0));
+    EXPECT_EQ((uint64_t)2 * 4096, fam_stripe_bytes(nbytes, layout, 1));
+    EXPECT_EQ((uint64_t)2 * 4096 + 100, fam_stripe_bytes(nbytes, layout, 2));
+
+    // A last row ending in its second data stripe
+    nbytes = 2 * 8192 + 5000;
+    EXPECT_EQ((uint64_t)3 * 4096, fam_stripe_bytes(nbytes, layout, 0));
+    EXPECT_EQ((uint64_t)2 * 4096 + 904, fam_stripe_bytes(nbytes, layout, 1));
+    EXPECT_EQ((uint64_t)3 * 4096, fam_stripe_bytes(nbytes, layout, 2));
+}
+
+// Test case#7 - the size of a RAID5 data item is found back from the bytes
+// of all its parts.
+TEST(FamStripeLayout, ParityDataBytesSuccess) {
+    Fam_Stripe_Layout layout = {4096, 3, 0, RAID5};
+
+    EXPECT_EQ((uint64_t)0, fam_parity_data_bytes(0, layout));
+    EXPECT_EQ((uint64_t)2 * 8192, fam_parity_data_bytes(6 * 4096, layout));
+    EXPECT_EQ((uint64_t)2 * 8192 + 100,
+              fam_parity_data_bytes(6 * 4096 + 200, layout));
+    EXPECT_EQ((uint64_t)2 * 8192 + 4096,
+              fam_parity_data_bytes(6 * 4096 + 2 * 4096, layout));
+    EXPECT_EQ((uint64_t)2 * 8192 + 5000,
+              fam_parity_data_bytes(6 * 4096 + 5000 + 4096, layout));
+}
+
+// Test case#8 - a put crossing a stripe boundary changes two data members of
+// the same row, and the parity of that row only.
+TEST(FamStripeLayout, ParityCrossStripeSuccess) {
+    Fam_Stripe_Layout layout = {4096, 3, 0, RAID5};
+    uint64_t memberOffset, parityOffset;
+    set<uint64_t> members;
+    set<uint64_t> parities;
+
+    for (uint64_t offset = 8192 + 4000; offset < 8192 + 4200; offset++) {
+        members.insert(fam_stripe_of(offset, layout, memberOffset));
+        parities.insert(fam_parity_of(offset, layout, parityOffset));
+        EXPECT_EQ(parityOffset, memberOffset);
+    }
+    EXPECT_EQ((set<uint64_t>{0, 2}), members);
+    EXPECT_EQ((set<uint64_t>{1}), parities);
+
+    // The last byte of the first stripe and the first of the second share
+    // no parity byte
+    fam_parity_of(8192 + 4095, layout, parityOffset);
+    EXPECT_EQ((uint64_t)4096 + 4095, parityOffset);
+    fam_parity_of(8192 + 4096, layout, parityOffset);
+    EXPECT_EQ((uint64_t)4096, parityOffset);
+}
+
+// Test case#9 - the RAID5 stripe math covers every data and parity byte
+// once, whatever the size.
+TEST(FamStripeLayout, ParityLayoutCoversDataItemSuccess) {
+    Fam_Stripe_Layout layouts[] = {
+        {16, 3, 0, RAID5}, {16, 4, 0, RAID5}, {32, 5, 0, RAID5}};
+
+    for (auto layout : layouts) {
+        uint64_t rowBytes = layout.stripeSize * (layout.stripeCount - 1);
+        for (uint64_t nbytes :
+             {(uint64_t)0, (uint64_t)1, (uint64_t)15, (uint64_t)16,
+              (uint64_t)17, (uint64_t)100, rowBytes, rowBytes + 1,
+              rowBytes + layout.stripeSize + 3,
+              layout.stripeCount * rowBytes + 5})
+            check_parity_layout(nbytes, layout);
+    }
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -48,7 +48,7 @@ int main(int argc, char *argv[]) {
 
     void *buf = malloc(10 * sizeof(int64_t));
     bmap->size = 10 * sizeof(int64_t);
-    bmap->map = &buf;
+    bmap->map = buf;
 
     ret = bitmap_init(bmap);
     if (ret) {
@@ -177,6 +177,45 @@ int main(int argc, char *argv[]) {
         fail++;
     }
 
+    for (i = 0; i < 64 * 10; i++) {
+        bitmap_reset(bmap, i);
+    }
+    for (i = 0; i < 64 * 10; i++) {
+        pos = bitmap_find_and_reserve(bmap, 0, 0);
+        if (pos != (int64_t)i) {
+            cout << "reserve: Expected " << i << ", but got " << pos << endl;
+            fail++;
+        }
+    }
+    pos = bitmap_find_and_reserve(bmap, 0, 0);
+    if (pos != -1) {
+        cout << "reserve: Expected -1, but got " << pos << endl;
+        fail++;
+    }
+
+    // Freed bits behind the last reservation are found again
+    bitmap_reset(bmap, 70);
+    pos = bitmap_find_and_reserve(bmap, 0, 0);
+    if (pos != 70) {
+        cout << "reserve: Expected 70, but got " << pos << endl;
+        fail++;
+    }
+    bitmap_reset(bmap, 300);
+    pos = bitmap_find_and_reserve(bmap, 0, 0);
+    if (pos != 300) {
+        cout << "reserve: Expected 300, but got " << pos << endl;
+        fail++;
+    }
+
+    // A bit freed without going through bitmap_reset, as another process
+    // sharing the bitmap would, is found although the summary says full
+    fam_atomic_64_write((int64_t *)bmap->map + 2, ~(1L << 5));
+    pos = bitmap_find_and_reserve(bmap, 0, 0);
+    if (pos != 64 * 2 + 5) {
+        cout << "reserve: Expected 133, but got " << pos << endl;
+        fail++;
+    }
+
     cout << "Test completed" << endl;
 
     if (fail != 0) {